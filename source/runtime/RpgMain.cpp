@@ -1,6 +1,8 @@
+#include "core/RpgAllocator.h"
 #include "core/RpgCommandLine.h"
 #include "core/RpgConsoleSystem.h"
 #include "core/RpgFilePath.h"
+#include "core/RpgProfiler.h"
 #include "core/RpgThreadPool.h"
 #include "core/RpgTimer.h"
 #include "core/RpgD3D12.h"
@@ -12,12 +14,14 @@
 #include "shader/RpgShaderManager.h"
 #include "render/RpgRenderPipeline.h"
 #include "engine/RpgEngine.h"
+#include "engine/RpgHeadless.h"
 #include <windowsx.h>
 #include <hidusage.h>
 
 
 #ifdef RPG_BUILD_DEBUG
 #include "../test/core/RpgTestCore.h"
+#include "../test/physics/RpgTestPhysics.h"
 #endif // RPG_BUILD_DEBUG
 
 
@@ -284,19 +288,43 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 	RpgFileSystem::Initialize();
 
 
+	// TODO: Read config from <RpgGame.config>
+
+	// TODO: Steam init
+
+	RpgThreadPool::Initialize(1);
+	RpgFrameAllocator::Initialize();
+
+
 #ifdef RPG_BUILD_DEBUG
-	// Run tests
+	// Run tests. Thread pool is initialized, tests may submit tasks
 	{
 		RpgTest::Core::Execute();
+		RpgTest::Physics::Execute();
 	}
 #endif // RPG_BUILD_DEBUG
 
 
-	// TODO: Read config from <RpgGame.config>
+	// Headless simulation. No window, D3D12 and render thread
+	if (RpgCommandLine::HasCommand("headless"))
+	{
+		const int exitCode = RpgHeadless::Run();
 
-	// TODO: Steam init
+		RpgFrameAllocator::Shutdown();
+		RpgThreadPool::Shutdown();
+		RpgPlatformProcess::Shutdown();
+
+#if RPG_PROFILER_ENABLED
+		RpgProfiler::Shutdown();
+#endif // RPG_PROFILER_ENABLED
+
+		delete g_ConsoleSystem;
+
+		RpgPlatformLog::Shutdown();
+
+		return exitCode;
+	}
 
-	RpgThreadPool::Initialize(1);
 
 	RpgD3D12::Initialize();
 	RpgShaderManager::Initialize();
@@ -408,18 +436,24 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 	
 	MSG msg{};
 
+	RPG_PROFILE_THREAD_NAME("Main");
+
 	while (bRunning)
 	{
 		QueryPerformanceCounter(&fpsFrameStart);
 
-		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			RPG_PROFILE_SCOPE("RpgMain_PumpMessages");
 
-			if (msg.message == WM_QUIT)
+			while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 			{
-				bRunning = false;
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+
+				if (msg.message == WM_QUIT)
+				{
+					bRunning = false;
+				}
 			}
 		}
 
@@ -437,10 +471,13 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 
 		if (g_Engine->IsWindowMinimized())
 		{
+			RPG_PROFILE_SCOPE("RpgMain_WaitMinimized");
 			Sleep(30);
 		}
 		else if (fpsLimit > 0)
 		{
+			RPG_PROFILE_SCOPE("RpgMain_WaitFpsLimit");
+
 			const float targetFrameMs = 1000.0f / fpsLimit;
 			float remainingMs = 0.0f;
 
@@ -458,6 +495,10 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 			while (remainingMs > 0.000333f);
 		}
 
+#if RPG_PROFILER_ENABLED
+		RpgProfiler::EndFrame();
+#endif // RPG_PROFILER_ENABLED
+
 		++FrameCounter;
 	}
 
@@ -477,10 +518,17 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 	RpgRenderPipeline::Shutdown();
 	RpgD3D12::Shutdown();
 
+	RpgFrameAllocator::Shutdown();
 	RpgThreadPool::Shutdown();
 	RpgPlatformProcess::Shutdown();
 
+#if RPG_PROFILER_ENABLED
+	RpgProfiler::Shutdown();
+#endif // RPG_PROFILER_ENABLED
+
 	delete g_ConsoleSystem;
 
+	RpgPlatformLog::Shutdown();
+
 	return 0;
 }
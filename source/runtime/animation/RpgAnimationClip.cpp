@@ -32,11 +32,12 @@ void RpgAnimationClip::LoadFromAssetFile(const RpgString& filePath) noexcept
 
 void RpgAnimationClip::AddTrack(const RpgAnimationTrack& in_Track) noexcept
 {
+	const RpgNameId boneNameId(in_Track.BoneName);
 	bool bShouldAdd = true;
 
 	for (int t = 0; t < Tracks.GetCount(); ++t)
 	{
-		if (Tracks[t].BoneName == in_Track.BoneName)
+		if (Tracks[t].BoneNameId == boneNameId)
 		{
 			bShouldAdd = false;
 			break;
@@ -48,6 +49,7 @@ void RpgAnimationClip::AddTrack(const RpgAnimationTrack& in_Track) noexcept
 	if (bShouldAdd)
 	{
 		Tracks.AddValue(in_Track);
+		Tracks[Tracks.GetCount() - 1].BoneNameId = boneNameId;
 	}
 }
 
@@ -61,7 +63,7 @@ bool RpgAnimationClip::CheckSkeletonCompatibility(const RpgAnimationSkeleton* sk
 
 	for (int t = 0; t < Tracks.GetCount(); ++t)
 	{
-		const int boneIndex = skeleton->GetBoneIndex(Tracks[t].BoneName);
+		const int boneIndex = skeleton->GetBoneIndex(Tracks[t].BoneNameId);
 
 		if (boneIndex == RPG_SKELETON_BONE_INDEX_INVALID)
 		{
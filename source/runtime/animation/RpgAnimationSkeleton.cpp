@@ -8,6 +8,7 @@ RpgAnimationSkeleton::RpgAnimationSkeleton(const RpgName& name) noexcept
 
 	Name = name;
 	BoneNames.Reserve(16);
+	BoneNameIds.Reserve(16);
 	BoneParentIndices.Reserve(16);
 	BoneInverseBindPoseTransforms.Reserve(16);
 }
@@ -2,6 +2,7 @@
 
 #include "core/RpgMath.h"
 #include "core/RpgString.h"
+#include "core/RpgNameTable.h"
 #include "core/RpgPointer.h"
 
 
@@ -92,6 +93,8 @@ public:
 
 	inline int AddBone(const RpgMatrixTransform& localTransform) noexcept
 	{
+		RPG_MEMORY_SCOPE_TAG(TAG_ANIMATION);
+
 		const int boneIndex = BoneLocalTransforms.GetCount();
 
 		BoneLocalTransforms.AddValue(localTransform);
@@ -169,6 +172,7 @@ public:
 		RPG_Check(index != parentIndex);
 
 		BoneNames.AddValue(name);
+		BoneNameIds.AddValue(RpgNameId(name));
 		BoneParentIndices.AddValue(parentIndex);
 		BoneInverseBindPoseTransforms.AddValue(boneInverseBindPoseTransform);
 		BindPose.AddBone(boneLocalTransform);
@@ -198,6 +202,13 @@ public:
 		return (index == RPG_INDEX_INVALID) ? RPG_SKELETON_BONE_INDEX_INVALID : index;
 	}
 
+	// Faster than GetBoneIndex by RpgName, compares integers only
+	inline int GetBoneIndex(const RpgNameId& nameId) const noexcept
+	{
+		const int index = BoneNameIds.FindIndexByValue(nameId);
+		return (index == RPG_INDEX_INVALID) ? RPG_SKELETON_BONE_INDEX_INVALID : index;
+	}
+
 	inline const RpgName& GetBoneName(int boneIndex) const noexcept
 	{
 		RPG_CheckV(boneIndex >= 0 && boneIndex < BoneNames.GetCount(), "Invalid bone index (%i)", boneIndex);
@@ -231,6 +242,7 @@ public:
 private:
 	RpgName Name;
 	RpgArray<RpgName> BoneNames;
+	RpgArray<RpgNameId> BoneNameIds;
 	RpgArray<int> BoneParentIndices;
 	RpgArray<RpgMatrixTransform> BoneInverseBindPoseTransforms;
 	RpgAnimationPose BindPose;
@@ -251,6 +263,9 @@ struct RpgAnimationTrack
 {
 	RpgName BoneName;
 
+	// Interned BoneName, assigned by RpgAnimationClip::AddTrack
+	RpgNameId BoneNameId;
+
 
 	struct FKeyPosition
 	{
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/world/RpgComponent.h"
+#include "core/world/RpgWorldSnapshotAsset.h"
 #include "../RpgAnimationTypes.h"
 
 
@@ -13,6 +14,8 @@ class RpgAnimationComponent_AnimSkeletonPose
 	RPG_COMPONENT_TYPE("RpgComponent (Animation) - AnimSkeletonPose")
 
 public:
+	static constexpr uint32_t SNAPSHOT_VERSION = 2;
+
 	RpgSharedAnimationClip Clip;
 	float PlayRate;
 	bool bLoopAnim;
@@ -35,6 +38,38 @@ public:
 	}
 
 
+	// Clip and skeleton are saved by name, they must be registered in RpgWorldSnapshotAsset to be resolved on load
+	inline void Serialize(RpgStreamWriter& writer) const noexcept
+	{
+		RpgWorldSnapshotAsset<RpgAnimationSkeleton>::Write(writer, Skeleton);
+		RpgWorldSnapshotAsset<RpgAnimationClip>::Write(writer, Clip);
+		writer.Write(PlayRate);
+		writer.Write(bLoopAnim);
+		writer.Write(bPauseAnim);
+		writer.Write(AnimTimer);
+	}
+
+
+	inline void Deserialize(RpgStreamReader& reader) noexcept
+	{
+		RpgSharedAnimationSkeleton skeleton;
+		RpgWorldSnapshotAsset<RpgAnimationSkeleton>::Read(reader, skeleton);
+		SetSkeleton(skeleton);
+
+		RpgWorldSnapshotAsset<RpgAnimationClip>::Read(reader, Clip);
+		reader.Read(PlayRate);
+		reader.Read(bLoopAnim);
+		reader.Read(bPauseAnim);
+		reader.Read(AnimTimer);
+	}
+
+
+	[[nodiscard]] inline bool IsSnapshotSupported() const noexcept
+	{
+		return RpgWorldSnapshotAsset<RpgAnimationSkeleton>::IsRegistered(Skeleton) && RpgWorldSnapshotAsset<RpgAnimationClip>::IsRegistered(Clip);
+	}
+
+
 	inline void SetSkeleton(const RpgSharedAnimationSkeleton& in_Skeleton) noexcept
 	{
 		if (Skeleton != in_Skeleton)
@@ -18,6 +18,13 @@ RpgAnimationWorldSubsystem::RpgAnimationWorldSubsystem() noexcept
 }
 
 
+void RpgAnimationWorldSubsystem::DeclareAccess(RpgWorldSubsystemAccess& out_Access) const noexcept
+{
+	// Tick pose tasks are waited in Render
+	out_Access.WriteComponent<RpgAnimationComponent_AnimSkeletonPose>();
+}
+
+
 void RpgAnimationWorldSubsystem::StartPlay() noexcept
 {
 	bTickAnimationPose = true;
@@ -37,47 +44,31 @@ void RpgAnimationWorldSubsystem::TickUpdate(float deltaTime) noexcept
 		return;
 	}
 
-	RpgWorld* world = GetWorld();
-
-	RpgThreadTask* submitTasks[TASK_COUNT];
-
-	// Reset tasks
-	for (int i = 0; i < TASK_COUNT; ++i)
+	// Normally waited in Render. Headless world has no render, wait previous tick here
+	if (TaskTickPose.IsRunning())
 	{
-		RpgAnimationTask_TickPose& task = TaskTickPoses[i];
-		task.Reset();
-		task.World = world;
-		task.DeltaTime = deltaTime;
-		task.GlobalPlayRate = GlobalPlayRate;
-
-		submitTasks[i] = &task;
+		TaskTickPose.Wait();
 	}
 
-	// Distribute tasks
-	int taskIndex = 0;
-
-	for (auto it = world->Component_CreateIterator<RpgAnimationComponent_AnimSkeletonPose>(); it; ++it)
-	{
-		RpgAnimationTask_TickPose& task = TaskTickPoses[taskIndex];
-		task.AnimationComponents.AddValue(&it.GetValue());
-		taskIndex = (taskIndex + 1) % TASK_COUNT;
-	}
+	// Task splits components over worker threads
+	TaskTickPose.Reset();
+	TaskTickPose.World = GetWorld();
+	TaskTickPose.DeltaTime = deltaTime;
+	TaskTickPose.GlobalPlayRate = GlobalPlayRate;
 
-	RpgThreadPool::SubmitTasks(submitTasks, TASK_COUNT);
+	RpgThreadTask* submitTask = &TaskTickPose;
+	RpgThreadPool::SubmitTasks(&submitTask, 1);
 }
 
 
 void RpgAnimationWorldSubsystem::Render(int frameIndex, RpgRenderer* renderer) noexcept
 {
-	RpgThreadTask* waitTasks[TASK_COUNT];
-	for (int i = 0; i < TASK_COUNT; ++i)
+	// wait task tick pose finished
+	if (TaskTickPose.IsRunning())
 	{
-		waitTasks[i] = &TaskTickPoses[i];
+		TaskTickPose.Wait();
 	}
 
-	// wait all task tick pose finished
-	RPG_THREAD_TASK_WaitAll(waitTasks, TASK_COUNT);
-
 
 #ifndef RPG_BUILD_SHIPPING
 	RpgWorld* world = GetWorld();
@@ -94,7 +85,7 @@ void RpgAnimationWorldSubsystem::Render(int frameIndex, RpgRenderer* renderer) n
 				continue;
 			}
 			
-			const RpgMatrixTransform gameObjectWorldMatrix = world->GameObject_GetWorldTransformMatrix(comp.GameObject);
+			const RpgMatrixTransform gameObjectWorldMatrix = world->GameObject_GetInterpolatedWorldTransformMatrix(comp.GameObject);
 			const RpgArray<int>& boneParentIndices = comp.Skeleton->GetBoneParentIndices();
 			const RpgArray<RpgMatrixTransform>& bonePoseTransforms = comp.FinalPose.GetBonePoseTransforms();
 			const int boneCount = boneParentIndices.GetCount();
@@ -16,6 +16,7 @@ public:
 	RpgAnimationWorldSubsystem() noexcept;
 
 protected:
+	virtual void DeclareAccess(RpgWorldSubsystemAccess& out_Access) const noexcept override;
 	virtual void StartPlay() noexcept override;
 	virtual void StopPlay() noexcept override;
 	virtual void TickUpdate(float deltaTime) noexcept override;
@@ -23,8 +24,7 @@ protected:
 
 
 private:
-	static constexpr int TASK_COUNT = 4;
-	RpgAnimationTask_TickPose TaskTickPoses[TASK_COUNT];
+	RpgAnimationTask_TickPose TaskTickPose;
 	bool bTickAnimationPose;
 
 };
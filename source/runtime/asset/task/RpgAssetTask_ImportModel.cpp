@@ -107,6 +107,8 @@ void RpgAssetTask_ImportModel::Reset() noexcept
 
 void RpgAssetTask_ImportModel::Execute() noexcept
 {
+	RPG_MEMORY_SCOPE_TAG(TAG_ASSET);
+
 	RPG_Check(SourceFilePath.IsFilePath());
 
 	Assimp::Importer assimpImporter;
@@ -311,6 +311,8 @@ void RpgAssetTask_ImportTexture::Reset() noexcept
 
 void RpgAssetTask_ImportTexture::Execute() noexcept
 {
+	RPG_MEMORY_SCOPE_TAG(TAG_TEXTURE);
+
 	RPG_Check(SourceFilePath.IsFilePath() || SourceEmbedded.Data);
 
 	if (SourceFilePath.IsFilePath())
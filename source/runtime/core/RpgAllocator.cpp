@@ -0,0 +1,292 @@
+#include "RpgAllocator.h"
+#include <atomic>
+
+
+// Size of first arena block. When arena runs out of space a new block is added, on reset all blocks are merged into single block
+#define RPG_FRAME_ALLOCATOR_DEFAULT_BLOCK_SIZE		(1024 * 1024)
+
+#define RPG_FRAME_ALLOCATOR_ALIGNMENT				16
+
+
+
+namespace RpgFrameAllocator
+{
+	struct FBlock
+	{
+		uint8_t* Data{ nullptr };
+		size_t Size{ 0 };
+		size_t Offset{ 0 };
+	};
+
+
+	// Blocks are chained, only the last block is used for allocation
+	#define RPG_FRAME_ALLOCATOR_MAX_BLOCK	32
+
+
+	struct FArena
+	{
+		std::atomic<bool> Lock{ false };
+		FBlock Blocks[RPG_FRAME_ALLOCATOR_MAX_BLOCK];
+		int BlockCount{ 0 };
+
+		// Last allocation, can grow in place
+		uint8_t* LastAllocation{ nullptr };
+
+		size_t UsedBytes{ 0 };
+		size_t PeakUsedBytes{ 0 };
+		int AllocationCount{ 0 };
+		std::atomic<uint32_t> Generation{ 1 };
+	};
+
+	static FArena Arenas[RPG_FRAME_BUFFERING];
+	static std::atomic<int> CurrentFrameIndex{ 0 };
+
+
+
+	class FScopedLock
+	{
+	public:
+		FScopedLock(FArena& in_Arena) noexcept
+			: Arena(in_Arena)
+		{
+			while (Arena.Lock.exchange(true, std::memory_order_acquire))
+			{
+				while (Arena.Lock.load(std::memory_order_relaxed))
+				{
+					YieldProcessor();
+				}
+			}
+		}
+
+		~FScopedLock() noexcept
+		{
+			Arena.Lock.store(false, std::memory_order_release);
+		}
+
+	private:
+		FArena& Arena;
+	};
+
+
+	static inline size_t AlignSize(size_t value) noexcept
+	{
+		return (value + RPG_FRAME_ALLOCATOR_ALIGNMENT - 1) & ~static_cast<size_t>(RPG_FRAME_ALLOCATOR_ALIGNMENT - 1);
+	}
+
+
+	static void Arena_AddBlock(FArena& arena, size_t minSizeBytes) noexcept
+	{
+		RPG_CheckV(arena.BlockCount < RPG_FRAME_ALLOCATOR_MAX_BLOCK, "RpgFrameAllocator: Exceeds maximum block count!");
+
+		size_t blockSize = arena.BlockCount > 0 ? arena.Blocks[arena.BlockCount - 1].Size * 2 : RPG_FRAME_ALLOCATOR_DEFAULT_BLOCK_SIZE;
+
+		if (blockSize < minSizeBytes)
+		{
+			blockSize = AlignSize(minSizeBytes);
+		}
+
+		FBlock& block = arena.Blocks[arena.BlockCount++];
+		block.Data = reinterpret_cast<uint8_t*>(RpgPlatformMemory::MemMallocAlignedTag(blockSize, RPG_FRAME_ALLOCATOR_ALIGNMENT, RpgPlatformMemory::TAG_FRAME_ARENA));
+		block.Size = blockSize;
+		block.Offset = 0;
+
+		RPG_Check(block.Data);
+	}
+
+
+	static void Arena_FreeBlocks(FArena& arena) noexcept
+	{
+		for (int i = 0; i < arena.BlockCount; ++i)
+		{
+			RpgPlatformMemory::MemFree(arena.Blocks[i].Data);
+			arena.Blocks[i] = FBlock();
+		}
+
+		arena.BlockCount = 0;
+		arena.LastAllocation = nullptr;
+	}
+
+
+	static inline void* Arena_Allocate(FArena& arena, size_t sizeBytes) noexcept
+	{
+		sizeBytes = AlignSize(sizeBytes > 0 ? sizeBytes : 1);
+
+		if (arena.BlockCount == 0 || arena.Blocks[arena.BlockCount - 1].Offset + sizeBytes > arena.Blocks[arena.BlockCount - 1].Size)
+		{
+			Arena_AddBlock(arena, sizeBytes);
+		}
+
+		FBlock& block = arena.Blocks[arena.BlockCount - 1];
+		uint8_t* alloc = block.Data + block.Offset;
+		block.Offset += sizeBytes;
+
+		arena.LastAllocation = alloc;
+		arena.UsedBytes += sizeBytes;
+		++arena.AllocationCount;
+
+		if (arena.UsedBytes > arena.PeakUsedBytes)
+		{
+			arena.PeakUsedBytes = arena.UsedBytes;
+		}
+
+		return alloc;
+	}
+
+};
+
+
+void RpgFrameAllocator::Initialize() noexcept
+{
+	for (int f = 0; f < RPG_FRAME_BUFFERING; ++f)
+	{
+		FArena& arena = Arenas[f];
+		FScopedLock lock(arena);
+
+		if (arena.BlockCount == 0)
+		{
+			Arena_AddBlock(arena, RPG_FRAME_ALLOCATOR_DEFAULT_BLOCK_SIZE);
+		}
+	}
+}
+
+
+void RpgFrameAllocator::Shutdown() noexcept
+{
+	for (int f = 0; f < RPG_FRAME_BUFFERING; ++f)
+	{
+		FArena& arena = Arenas[f];
+		FScopedLock lock(arena);
+
+		Arena_FreeBlocks(arena);
+		arena.UsedBytes = 0;
+		arena.AllocationCount = 0;
+		arena.Generation.fetch_add(1, std::memory_order_release);
+	}
+}
+
+
+void RpgFrameAllocator::Reset(int frameIndex) noexcept
+{
+	RPG_Check(frameIndex >= 0 && frameIndex < RPG_FRAME_BUFFERING);
+
+	FArena& arena = Arenas[frameIndex];
+	{
+		FScopedLock lock(arena);
+
+		// Merge blocks into single block large enough for the previous frame, steady state has no block allocation
+		if (arena.BlockCount > 1)
+		{
+			size_t totalSize = 0;
+
+			for (int i = 0; i < arena.BlockCount; ++i)
+			{
+				totalSize += arena.Blocks[i].Size;
+			}
+
+			Arena_FreeBlocks(arena);
+			Arena_AddBlock(arena, totalSize);
+		}
+		else if (arena.BlockCount == 1)
+		{
+			arena.Blocks[0].Offset = 0;
+		}
+
+		arena.LastAllocation = nullptr;
+		arena.UsedBytes = 0;
+		arena.AllocationCount = 0;
+		arena.Generation.fetch_add(1, std::memory_order_release);
+	}
+
+	CurrentFrameIndex.store(frameIndex, std::memory_order_release);
+}
+
+
+int RpgFrameAllocator::GetFrameIndex() noexcept
+{
+	return CurrentFrameIndex.load(std::memory_order_acquire);
+}
+
+
+uint32_t RpgFrameAllocator::GetGeneration(int frameIndex) noexcept
+{
+	RPG_Check(frameIndex >= 0 && frameIndex < RPG_FRAME_BUFFERING);
+	return Arenas[frameIndex].Generation.load(std::memory_order_acquire);
+}
+
+
+void* RpgFrameAllocator::Allocate(int frameIndex, size_t sizeBytes) noexcept
+{
+	RPG_Check(frameIndex >= 0 && frameIndex < RPG_FRAME_BUFFERING);
+
+	FArena& arena = Arenas[frameIndex];
+	FScopedLock lock(arena);
+
+	return Arena_Allocate(arena, sizeBytes);
+}
+
+
+void* RpgFrameAllocator::Reallocate(int frameIndex, void* prevAlloc, size_t prevSizeBytes, size_t newSizeBytes) noexcept
+{
+	RPG_Check(frameIndex >= 0 && frameIndex < RPG_FRAME_BUFFERING);
+
+	FArena& arena = Arenas[frameIndex];
+	FScopedLock lock(arena);
+
+	if (prevAlloc == nullptr)
+	{
+		return Arena_Allocate(arena, newSizeBytes);
+	}
+
+	const size_t alignedPrevSize = AlignSize(prevSizeBytes > 0 ? prevSizeBytes : 1);
+	const size_t alignedNewSize = AlignSize(newSizeBytes > 0 ? newSizeBytes : 1);
+
+	if (alignedNewSize <= alignedPrevSize)
+	{
+		return prevAlloc;
+	}
+
+	// Grow in place if it's the last allocation and there's enough space left in the block
+	if (prevAlloc == arena.LastAllocation)
+	{
+		FBlock& block = arena.Blocks[arena.BlockCount - 1];
+		const size_t addSize = alignedNewSize - alignedPrevSize;
+
+		if (block.Offset + addSize <= block.Size)
+		{
+			block.Offset += addSize;
+			arena.UsedBytes += addSize;
+
+			if (arena.UsedBytes > arena.PeakUsedBytes)
+			{
+				arena.PeakUsedBytes = arena.UsedBytes;
+			}
+
+			return prevAlloc;
+		}
+	}
+
+	void* newAlloc = Arena_Allocate(arena, newSizeBytes);
+	RpgPlatformMemory::MemCopy(newAlloc, prevAlloc, prevSizeBytes);
+
+	return newAlloc;
+}
+
+
+void RpgFrameAllocator::GetStats(int frameIndex, FStats& out_Stats) noexcept
+{
+	RPG_Check(frameIndex >= 0 && frameIndex < RPG_FRAME_BUFFERING);
+
+	FArena& arena = Arenas[frameIndex];
+	FScopedLock lock(arena);
+
+	out_Stats.UsedBytes = arena.UsedBytes;
+	out_Stats.PeakUsedBytes = arena.PeakUsedBytes;
+	out_Stats.BlockCount = arena.BlockCount;
+	out_Stats.AllocationCount = arena.AllocationCount;
+	out_Stats.ReservedBytes = 0;
+
+	for (int i = 0; i < arena.BlockCount; ++i)
+	{
+		out_Stats.ReservedBytes += arena.Blocks[i].Size;
+	}
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "RpgPlatform.h"
+
+
+
+// ========================================================================================================================= //
+// ALLOCATOR - DEFAULT
+// ========================================================================================================================= //
+// General purpose heap allocator. Used by containers by default
+class RpgAllocatorDefault
+{
+public:
+	[[nodiscard]] inline void* Reallocate(void* prevAlloc, size_t prevSizeBytes, size_t newSizeBytes) noexcept
+	{
+		return RpgPlatformMemory::MemRealloc(prevAlloc, newSizeBytes);
+	}
+
+	inline void Free(void* alloc) noexcept
+	{
+		RpgPlatformMemory::MemFree(alloc);
+	}
+
+};
+
+
+
+
+// ========================================================================================================================= //
+// ALLOCATOR - TAGGED
+// ========================================================================================================================= //
+// General purpose heap allocator. Memory is accounted to <TAG> regardless of the thread memory tag
+template<RpgPlatformMemory::ETag TAG>
+class RpgAllocatorTagged
+{
+public:
+	[[nodiscard]] inline void* Reallocate(void* prevAlloc, size_t prevSizeBytes, size_t newSizeBytes) noexcept
+	{
+		return RpgPlatformMemory::MemReallocTag(prevAlloc, newSizeBytes, TAG);
+	}
+
+	inline void Free(void* alloc) noexcept
+	{
+		RpgPlatformMemory::MemFree(alloc);
+	}
+
+};
+
+
+
+
+// ========================================================================================================================= //
+// ALLOCATOR - FRAME
+// ========================================================================================================================= //
+// Linear (bump) arena for each frame index [0, RPG_FRAME_BUFFERING).
+// Arena is reset in bulk when the frame index is reused, everything allocated from it becomes invalid.
+// Allocation is thread-safe.
+namespace RpgFrameAllocator
+{
+	struct FStats
+	{
+		// Bytes allocated since last reset
+		size_t UsedBytes{ 0 };
+
+		// Bytes reserved by arena blocks
+		size_t ReservedBytes{ 0 };
+
+		// Highest used bytes since initialized
+		size_t PeakUsedBytes{ 0 };
+
+		// Number of arena blocks
+		int BlockCount{ 0 };
+
+		// Number of allocations since last reset
+		int AllocationCount{ 0 };
+	};
+
+
+	void Initialize() noexcept;
+	void Shutdown() noexcept;
+
+
+	// Reset arena of <frameIndex> and make it the current frame index.
+	// Caller must make sure nothing (main thread, render thread, tasks) is still using memory from previous use of <frameIndex>.
+	// @param frameIndex - Frame index
+	// @returns None
+	void Reset(int frameIndex) noexcept;
+
+
+	// Get frame index set by the last Reset
+	// @returns Current frame index
+	[[nodiscard]] int GetFrameIndex() noexcept;
+
+
+	// Get reset generation of arena <frameIndex>. Used to detect memory from previous use of the frame index
+	// @returns Generation number
+	[[nodiscard]] uint32_t GetGeneration(int frameIndex) noexcept;
+
+
+	// Allocate memory from arena <frameIndex>
+	// @param frameIndex - Frame index
+	// @param sizeBytes - Size in bytes
+	// @returns Pointer to allocated memory (16 bytes aligned)
+	[[nodiscard]] void* Allocate(int frameIndex, size_t sizeBytes) noexcept;
+
+
+	// Reallocate memory from arena <frameIndex>. Grows in place if <prevAlloc> is the last allocation of the arena
+	// @param frameIndex - Frame index
+	// @param prevAlloc - Previous allocation from the same arena (can be nullptr)
+	// @param prevSizeBytes - Size of previous allocation
+	// @param newSizeBytes - New size in bytes
+	// @returns Pointer to allocated memory (16 bytes aligned)
+	[[nodiscard]] void* Reallocate(int frameIndex, void* prevAlloc, size_t prevSizeBytes, size_t newSizeBytes) noexcept;
+
+
+	// Get arena stats of <frameIndex>
+	// @param frameIndex - Frame index
+	// @param out_Stats - Output stats
+	// @returns None
+	void GetStats(int frameIndex, FStats& out_Stats) noexcept;
+
+}; // RpgFrameAllocator
+
+
+
+// Container allocator that draws from frame arena. Free is no-op, memory is released when frame arena reset.
+// Default constructed allocator uses the current frame index (RpgFrameAllocator::GetFrameIndex) each time container allocates from empty.
+// Use explicit frame index when filling data for other frame (e.g. render thread).
+// Container must be emptied with Clear(true) before the frame index is reused.
+class RpgAllocatorFrame
+{
+public:
+	RpgAllocatorFrame() noexcept
+		: FrameIndex(RPG_INDEX_INVALID)
+		, Generation(0)
+		, bCurrentFrame(true)
+	{
+	}
+
+	explicit RpgAllocatorFrame(int in_FrameIndex) noexcept
+		: FrameIndex(in_FrameIndex)
+		, Generation(0)
+		, bCurrentFrame(false)
+	{
+		RPG_Check(FrameIndex >= 0 && FrameIndex < RPG_FRAME_BUFFERING);
+	}
+
+
+	[[nodiscard]] inline void* Reallocate(void* prevAlloc, size_t prevSizeBytes, size_t newSizeBytes) noexcept
+	{
+		if (prevAlloc == nullptr)
+		{
+			if (bCurrentFrame)
+			{
+				FrameIndex = RpgFrameAllocator::GetFrameIndex();
+			}
+
+			Generation = RpgFrameAllocator::GetGeneration(FrameIndex);
+		}
+		else
+		{
+			RPG_CheckV(Generation == RpgFrameAllocator::GetGeneration(FrameIndex), "RpgAllocatorFrame: Memory is from previous use of frame index (%i). Container must be cleared with Clear(true) before frame index is reused!", FrameIndex);
+		}
+
+		return RpgFrameAllocator::Reallocate(FrameIndex, prevAlloc, prevSizeBytes, newSizeBytes);
+	}
+
+	inline void Free(void* alloc) noexcept
+	{
+		// Released in bulk when frame arena reset
+	}
+
+
+	[[nodiscard]] inline int GetFrameIndex() const noexcept
+	{
+		return FrameIndex;
+	}
+
+
+private:
+	int FrameIndex;
+	uint32_t Generation;
+	bool bCurrentFrame;
+
+};
@@ -31,12 +31,22 @@ void RpgConsoleSystem::AddLogMessage(const char* message, RpgColor color) noexce
 		return;
 	}
 
-	const int length = RpgPlatformString::CStringLength(message);
+	int length = RpgPlatformString::CStringLength(message);
 	if (length == 0)
 	{
 		return;
 	}
 
+	if (length >= RPG_CONSOLE_LOG_BUFFER_MAX_SIZE / 2)
+	{
+		length = RPG_CONSOLE_LOG_BUFFER_MAX_SIZE / 2 - 1;
+	}
+
+	if (LogBuffer.GetCount() + length + 1 > RPG_CONSOLE_LOG_BUFFER_MAX_SIZE)
+	{
+		RemoveOldestLogMessages(LogBuffer.GetCount() + length + 1 - RPG_CONSOLE_LOG_BUFFER_MAX_SIZE / 2);
+	}
+
 	FLogInfo& info = LogInfos.Add();
 	info.BufferIndex = LogBuffer.GetCount();
 	info.BufferCount = length + 1; // with null terminator
@@ -47,6 +57,39 @@ void RpgConsoleSystem::AddLogMessage(const char* message, RpgColor color) noexce
 }
 
 
+void RpgConsoleSystem::RemoveOldestLogMessages(int minRemoveBytes) noexcept
+{
+	int removeLogCount = 0;
+	int removeBytes = 0;
+
+	while (removeLogCount < LogInfos.GetCount() && removeBytes < minRemoveBytes)
+	{
+		removeBytes += LogInfos[removeLogCount].BufferCount;
+		++removeLogCount;
+	}
+
+	if (removeLogCount == 0)
+	{
+		return;
+	}
+
+	if (removeLogCount == LogInfos.GetCount())
+	{
+		LogInfos.Clear();
+		LogBuffer.Clear();
+		return;
+	}
+
+	LogInfos.RemoveAtRange(0, removeLogCount);
+	LogBuffer.RemoveAtRange(0, removeBytes);
+
+	for (int i = 0; i < LogInfos.GetCount(); ++i)
+	{
+		LogInfos[i].BufferIndex -= removeBytes;
+	}
+}
+
+
 void RpgConsoleSystem::AddLogCategoryMessage(const RpgPlatformLog::FCategory& category, RpgPlatformLog::EVerbosity verbosity, const char* message) noexcept
 {
 	if (verbosity < category.Verbosity || category.Verbosity < RpgPlatformLog::GetGlobalVerbosity())
@@ -6,6 +6,9 @@
 
 #define RPG_CONSOLE_MESSAGE_FORMAT_MAX_COUNT	1024
 
+// Maximum bytes of console log messages. When exceeded, oldest messages are removed until half of it
+#define RPG_CONSOLE_LOG_BUFFER_MAX_SIZE			(256 * 1024)
+
 
 typedef RpgArrayInline<RpgName, 8> RpgConsoleCommandParams;
 
@@ -105,7 +108,11 @@ public:
 
 
 private:
-	RpgArray<char, 128> LogBuffer;
+	void RemoveOldestLogMessages(int minRemoveBytes) noexcept;
+
+
+private:
+	RpgArray<char, 128, RpgAllocatorTagged<RpgPlatformMemory::TAG_LOG>> LogBuffer;
 	RpgArray<FLogInfo> LogInfos;
 
 	RpgArray<RpgName> RegisteredCommands;
@@ -60,7 +60,7 @@ namespace RpgD3D12
 
     static void* D3D12MA_Alloc(size_t size, size_t alignment, void*) noexcept
     {
-        return RpgPlatformMemory::MemMallocAligned(size, alignment);
+        return RpgPlatformMemory::MemMallocAlignedTag(size, alignment, RpgPlatformMemory::TAG_GPU);
     }
 
     static void D3D12MA_Free(void* data, void*) noexcept
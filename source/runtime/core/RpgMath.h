@@ -532,6 +532,13 @@ public:
 		return DirectX::XMQuaternionSlerp(a.Xmm, b.Xmm, t);
 	}
 
+	static inline float DotProduct(const RpgQuaternion& a, const RpgQuaternion& b) noexcept
+	{
+		float dot = 0.0f;
+		DirectX::XMStoreFloat(&dot, DirectX::XMQuaternionDot(a.Xmm, b.Xmm));
+		return dot;
+	}
+
 	static inline RpgVector3 RotateVector(const RpgQuaternion& q, const RpgVector3& v) noexcept
 	{
 		RpgVector3 result = v.GetNormalize();
@@ -0,0 +1,334 @@
+#include "RpgNameTable.h"
+#include <atomic>
+
+
+#define RPG_NAME_TABLE_CHUNK_SIZE	(1 << RPG_NAME_TABLE_CHUNK_SHIFT)
+
+
+
+namespace RpgNameTable
+{
+	static FEntry EmptyEntry = {};
+
+	static FEntry* Chunks[RPG_NAME_TABLE_MAX_CHUNK];
+	static std::atomic<int> EntryCount{ 1 };
+
+	// Open addressing table of entry indices (0 is empty slot). Capacity is power of two, kept at most half full
+	static uint32_t* HashSlots = nullptr;
+	static int HashCapacity = 0;
+
+	static SRWLOCK Lock = SRWLOCK_INIT;
+
+
+
+	static inline bool EntryEquals(const FEntry& entry, uint64_t hash, const char* cstr, int length) noexcept
+	{
+		if (entry.Hash != hash || entry.Length != length)
+		{
+			return false;
+		}
+
+		for (int i = 0; i < length; ++i)
+		{
+			if (tolower(static_cast<unsigned char>(entry.Chars[i])) != tolower(static_cast<unsigned char>(cstr[i])))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+
+	// Lock must be held (shared or exclusive)
+	static int FindNoLock(uint64_t hash, const char* cstr, int length) noexcept
+	{
+		if (HashCapacity == 0)
+		{
+			return RPG_INDEX_INVALID;
+		}
+
+		const int mask = HashCapacity - 1;
+		int slot = static_cast<int>(hash & mask);
+
+		while (HashSlots[slot] != 0)
+		{
+			const uint32_t index = HashSlots[slot];
+
+			if (EntryEquals(GetEntry(index), hash, cstr, length))
+			{
+				return static_cast<int>(index);
+			}
+
+			slot = (slot + 1) & mask;
+		}
+
+		return RPG_INDEX_INVALID;
+	}
+
+
+	// Exclusive lock must be held
+	static void InsertSlotNoLock(uint32_t index, uint64_t hash) noexcept
+	{
+		const int mask = HashCapacity - 1;
+		int slot = static_cast<int>(hash & mask);
+
+		while (HashSlots[slot] != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		HashSlots[slot] = index;
+	}
+
+
+	// Exclusive lock must be held
+	static void GrowNoLock() noexcept
+	{
+		const int newCapacity = (HashCapacity > 0) ? HashCapacity * 2 : 1024;
+
+		uint32_t* newSlots = reinterpret_cast<uint32_t*>(RpgPlatformMemory::MemMallocTag(sizeof(uint32_t) * newCapacity, RpgPlatformMemory::TAG_STRING));
+		RPG_Check(newSlots);
+		RpgPlatformMemory::MemZero(newSlots, sizeof(uint32_t) * newCapacity);
+
+		uint32_t* oldSlots = HashSlots;
+		const int oldCapacity = HashCapacity;
+
+		HashSlots = newSlots;
+		HashCapacity = newCapacity;
+
+		for (int i = 0; i < oldCapacity; ++i)
+		{
+			if (oldSlots[i] != 0)
+			{
+				InsertSlotNoLock(oldSlots[i], GetEntry(oldSlots[i]).Hash);
+			}
+		}
+
+		if (oldSlots)
+		{
+			RpgPlatformMemory::MemFree(oldSlots);
+		}
+	}
+
+
+	// Exclusive lock must be held
+	static uint32_t AddNoLock(uint64_t hash, const char* cstr, int length) noexcept
+	{
+		const int index = EntryCount.load(std::memory_order_relaxed);
+		// Entry index must stay valid in all builds, names are keyed by it
+		RPG_RuntimeErrorCheck(index < RPG_NAME_TABLE_MAX_CHUNK * RPG_NAME_TABLE_CHUNK_SIZE, "RpgNameTable: Exceeds maximum entry count!");
+
+		const int chunkIndex = index >> RPG_NAME_TABLE_CHUNK_SHIFT;
+
+		if (Chunks[chunkIndex] == nullptr)
+		{
+			Chunks[chunkIndex] = reinterpret_cast<FEntry*>(RpgPlatformMemory::MemMallocTag(sizeof(FEntry) * RPG_NAME_TABLE_CHUNK_SIZE, RpgPlatformMemory::TAG_STRING));
+			RPG_Check(Chunks[chunkIndex]);
+		}
+
+		FEntry& entry = Chunks[chunkIndex][index & (RPG_NAME_TABLE_CHUNK_SIZE - 1)];
+		entry.Hash = hash;
+		entry.Length = length;
+		RpgPlatformMemory::MemCopy(entry.Chars, cstr, length);
+		entry.Chars[length] = '\0';
+
+		if ((index + 1) * 2 > HashCapacity)
+		{
+			GrowNoLock();
+		}
+
+		InsertSlotNoLock(static_cast<uint32_t>(index), hash);
+		EntryCount.store(index + 1, std::memory_order_release);
+
+		return static_cast<uint32_t>(index);
+	}
+
+};
+
+
+uint32_t RpgNameTable::Intern(const char* cstr, int length) noexcept
+{
+	if (cstr == nullptr || length <= 0)
+	{
+		return 0;
+	}
+
+	if (length > RPG_NAME_MAX_COUNT - 1)
+	{
+		length = RPG_NAME_MAX_COUNT - 1;
+	}
+
+	const uint64_t hash = RpgPlatformString::CStringHash(cstr, length, true);
+
+	AcquireSRWLockShared(&Lock);
+	int index = FindNoLock(hash, cstr, length);
+	ReleaseSRWLockShared(&Lock);
+
+	if (index != RPG_INDEX_INVALID)
+	{
+		return static_cast<uint32_t>(index);
+	}
+
+	AcquireSRWLockExclusive(&Lock);
+
+	// Other thread may add it between locks
+	index = FindNoLock(hash, cstr, length);
+
+	if (index == RPG_INDEX_INVALID)
+	{
+		index = static_cast<int>(AddNoLock(hash, cstr, length));
+	}
+
+	ReleaseSRWLockExclusive(&Lock);
+
+	return static_cast<uint32_t>(index);
+}
+
+
+int RpgNameTable::Find(const char* cstr, int length) noexcept
+{
+	if (cstr == nullptr || length <= 0)
+	{
+		return 0;
+	}
+
+	if (length > RPG_NAME_MAX_COUNT - 1)
+	{
+		length = RPG_NAME_MAX_COUNT - 1;
+	}
+
+	const uint64_t hash = RpgPlatformString::CStringHash(cstr, length, true);
+
+	AcquireSRWLockShared(&Lock);
+	const int index = FindNoLock(hash, cstr, length);
+	ReleaseSRWLockShared(&Lock);
+
+	return index;
+}
+
+
+const RpgNameTable::FEntry& RpgNameTable::GetEntry(uint32_t index) noexcept
+{
+	if (index == 0)
+	{
+		return EmptyEntry;
+	}
+
+	RPG_Check(static_cast<int>(index) < EntryCount.load(std::memory_order_acquire));
+
+	return Chunks[index >> RPG_NAME_TABLE_CHUNK_SHIFT][index & (RPG_NAME_TABLE_CHUNK_SIZE - 1)];
+}
+
+
+int RpgNameTable::GetCount() noexcept
+{
+	return EntryCount.load(std::memory_order_acquire);
+}
+
+
+
+
+// Split trailing "_<number>" suffix. Number with leading zero ("Bone_01") is part of base string, otherwise it could not round trip
+static int NameId_SplitNumber(const char* cstr, int length, uint32_t& out_Number) noexcept
+{
+	out_Number = 0;
+
+	int digitCount = 0;
+
+	while (digitCount < length && cstr[length - 1 - digitCount] >= '0' && cstr[length - 1 - digitCount] <= '9')
+	{
+		++digitCount;
+	}
+
+	const int separatorIndex = length - 1 - digitCount;
+
+	if (digitCount == 0 || digitCount > 9 || separatorIndex < 1 || cstr[separatorIndex] != '_')
+	{
+		return length;
+	}
+
+	const char* digits = cstr + separatorIndex + 1;
+
+	if (digits[0] == '0' && digitCount > 1)
+	{
+		return length;
+	}
+
+	uint32_t number = 0;
+
+	for (int i = 0; i < digitCount; ++i)
+	{
+		number = number * 10 + static_cast<uint32_t>(digits[i] - '0');
+	}
+
+	out_Number = number + 1;
+
+	return separatorIndex;
+}
+
+
+RpgNameId::RpgNameId(const char* cstr) noexcept
+	: Index(0)
+	, Number(0)
+{
+	const int length = cstr ? RpgPlatformString::CStringLength(cstr) : 0;
+
+	if (length > 0)
+	{
+		const int baseLength = NameId_SplitNumber(cstr, length, Number);
+		Index = RpgNameTable::Intern(cstr, baseLength);
+	}
+}
+
+
+int RpgNameId::ToCString(char* dst, int maxCount) const noexcept
+{
+	RPG_Check(dst && maxCount > 0);
+
+	const RpgNameTable::FEntry& entry = RpgNameTable::GetEntry(Index);
+	const int written = (Number > 0) ? snprintf(dst, maxCount, "%s_%u", entry.Chars, Number - 1) : snprintf(dst, maxCount, "%s", entry.Chars);
+
+	return (written < maxCount) ? written : maxCount - 1;
+}
+
+
+RpgName RpgNameId::ToName() const noexcept
+{
+	char buffer[RPG_NAME_MAX_COUNT];
+	ToCString(buffer, RPG_NAME_MAX_COUNT);
+
+	return buffer;
+}
+
+
+RpgString RpgNameId::ToString() const noexcept
+{
+	char buffer[RPG_NAME_MAX_COUNT + 16];
+	ToCString(buffer, RPG_NAME_MAX_COUNT + 16);
+
+	return RpgString(buffer);
+}
+
+
+RpgNameId RpgNameId::Find(const char* cstr) noexcept
+{
+	RpgNameId result;
+
+	const int length = cstr ? RpgPlatformString::CStringLength(cstr) : 0;
+
+	if (length > 0)
+	{
+		uint32_t number = 0;
+		const int baseLength = NameId_SplitNumber(cstr, length, number);
+		const int index = RpgNameTable::Find(cstr, baseLength);
+
+		if (index != RPG_INDEX_INVALID)
+		{
+			result.Index = static_cast<uint32_t>(index);
+			result.Number = number;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "RpgString.h"
+
+
+// Entries per table chunk. Chunks are never reallocated, entry address is stable
+#define RPG_NAME_TABLE_CHUNK_SHIFT		12
+
+// Maximum chunks. Maximum unique names = RPG_NAME_TABLE_MAX_CHUNK * (1 << RPG_NAME_TABLE_CHUNK_SHIFT)
+#define RPG_NAME_TABLE_MAX_CHUNK		256
+
+
+
+// Global table of unique names. Lookup is case-insensitive, entry keeps the casing of the first interned string.
+// Thread-safe. Entries are never removed, table lives until process exit.
+namespace RpgNameTable
+{
+	struct FEntry
+	{
+		// Case-folded XXH3 hash of Chars
+		uint64_t Hash;
+
+		int Length;
+		char Chars[RPG_NAME_MAX_COUNT];
+	};
+
+
+	// Find or add string into table
+	// @param cstr - String, longer than (RPG_NAME_MAX_COUNT - 1) is truncated
+	// @param length - String length
+	// @returns Entry index. 0 for empty string. Exceeding maximum entry count is fatal runtime error in all builds
+	[[nodiscard]] extern uint32_t Intern(const char* cstr, int length) noexcept;
+
+	// Find string without adding it into table
+	// @returns Entry index. 0 for empty string, RPG_INDEX_INVALID if not found
+	[[nodiscard]] extern int Find(const char* cstr, int length) noexcept;
+
+	[[nodiscard]] extern const FEntry& GetEntry(uint32_t index) noexcept;
+
+	// Number of entries (including empty name at index 0)
+	[[nodiscard]] extern int GetCount() noexcept;
+
+};
+
+
+
+// Interned name. Entry index into RpgNameTable plus optional number suffix.
+// Number is stored as suffix + 1, so 0 means no suffix ("Bone_3" is stored as entry "Bone" with number 4, "Bone" with number 0).
+// Compare and hash do not touch string data. Construct from string once (interning takes the table lock), then keep RpgNameId around.
+class RpgNameId
+{
+public:
+	RpgNameId() noexcept
+		: Index(0)
+		, Number(0)
+	{
+	}
+
+	RpgNameId(const char* cstr) noexcept;
+
+	RpgNameId(const RpgName& name) noexcept
+		: RpgNameId(*name)
+	{
+	}
+
+
+public:
+	inline bool operator==(const RpgNameId& rhs) const noexcept
+	{
+		return Index == rhs.Index && Number == rhs.Number;
+	}
+
+	inline bool operator!=(const RpgNameId& rhs) const noexcept
+	{
+		return Index != rhs.Index || Number != rhs.Number;
+	}
+
+
+public:
+	inline bool IsNone() const noexcept
+	{
+		return Index == 0 && Number == 0;
+	}
+
+	inline uint32_t GetIndex() const noexcept
+	{
+		return Index;
+	}
+
+	// @returns Number suffix + 1, 0 if name has no number suffix
+	inline uint32_t GetNumber() const noexcept
+	{
+		return Number;
+	}
+
+	// @returns Base string without number suffix
+	inline const char* GetBaseCString() const noexcept
+	{
+		return RpgNameTable::GetEntry(Index).Chars;
+	}
+
+	inline uint64_t GetHash() const noexcept
+	{
+		return RpgNameTable::GetEntry(Index).Hash ^ (static_cast<uint64_t>(Number) * 0x9E3779B97F4A7C15ull);
+	}
+
+	// Write full name (with number suffix) into buffer
+	// @returns Number of characters written (excluding null terminator)
+	int ToCString(char* dst, int maxCount) const noexcept;
+
+	RpgName ToName() const noexcept;
+
+	RpgString ToString() const noexcept;
+
+
+	// Find interned name without adding it into table
+	// @returns Interned name, or None if base string never interned
+	[[nodiscard]] static RpgNameId Find(const char* cstr) noexcept;
+
+
+private:
+	uint32_t Index;
+	uint32_t Number;
+
+};
+
+
+inline uint64_t Rpg_GetHash(const RpgNameId& value) noexcept
+{
+	return value.GetHash();
+}
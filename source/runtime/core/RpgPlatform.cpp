@@ -1,11 +1,419 @@
 #include "RpgPlatform.h"
 #include <mimalloc-new-delete.h>
+#include <atomic>
+
+#define XXH_STATIC_LINKING_ONLY
+#include "thirdparty/xxhash/xxhash.h"
 
 
 
 // ========================================================================================================================= //
 // PLATFORM - MEMORY
 // ========================================================================================================================= //
+namespace RpgPlatformMemory
+{
+	static const char* TAG_NAMES[TAG_MAX_COUNT] =
+	{
+		"Untagged",
+		"String",
+		"Log",
+		"Asset",
+		"Mesh",
+		"Texture",
+		"World",
+		"Animation",
+		"Physics",
+		"Render",
+		"GPU",
+		"GUI",
+		"FrameArena",
+	};
+
+};
+
+
+const char* RpgPlatformMemory::GetTagName(ETag tag) noexcept
+{
+	return tag < TAG_MAX_COUNT ? TAG_NAMES[tag] : "Invalid";
+}
+
+
+
+#if RPG_MEMORY_TRACKING
+
+
+// Maximum threads with their own counters. Other threads share single counters (atomic add)
+#define RPG_MEMORY_MAX_THREAD_COUNTERS		64
+
+#define RPG_MEMORY_HEADER_SIZE				16
+#define RPG_MEMORY_HEADER_MAGIC				0x524D
+
+
+namespace RpgPlatformMemory
+{
+	// Placed right before each tracked allocation
+	struct FAllocHeader
+	{
+		uint64_t SizeBytes;
+
+		// Offset from mimalloc block to user pointer
+		uint32_t Offset;
+
+		uint8_t Tag;
+		uint8_t Reserved;
+		uint16_t Magic;
+	};
+	static_assert(sizeof(FAllocHeader) == RPG_MEMORY_HEADER_SIZE, "RpgPlatformMemory: Invalid FAllocHeader size!");
+
+
+	struct FTagCounters
+	{
+		std::atomic<uint64_t> AllocBytes;
+		std::atomic<uint64_t> FreeBytes;
+		std::atomic<uint64_t> AllocCount;
+		std::atomic<uint64_t> FreeCount;
+	};
+
+
+	// Counters are written only by owner thread, other threads only read them
+	struct alignas(64) FThreadCounters
+	{
+		FTagCounters Tags[TAG_MAX_COUNT];
+	};
+
+	static FThreadCounters ThreadCounters[RPG_MEMORY_MAX_THREAD_COUNTERS];
+	static FThreadCounters SharedCounters;
+	static std::atomic<int> ThreadCounterCount;
+
+	static thread_local FThreadCounters* ThisThreadCounters = nullptr;
+	static thread_local ETag ThisThreadTag = TAG_UNTAGGED;
+
+
+	// Frame sample
+	static SRWLOCK FrameStatsLock = SRWLOCK_INIT;
+	static FTagStats FrameStats[TAG_MAX_COUNT];
+	static uint64_t PrevFrameAllocBytes[TAG_MAX_COUNT];
+	static uint64_t PrevFrameFreeBytes[TAG_MAX_COUNT];
+	static uint64_t PrevFrameAllocCount[TAG_MAX_COUNT];
+
+
+
+	static inline FThreadCounters* GetThreadCounters() noexcept
+	{
+		if (ThisThreadCounters == nullptr)
+		{
+			const int index = ThreadCounterCount.fetch_add(1, std::memory_order_relaxed);
+			ThisThreadCounters = (index < RPG_MEMORY_MAX_THREAD_COUNTERS) ? &ThreadCounters[index] : &SharedCounters;
+		}
+
+		return ThisThreadCounters;
+	}
+
+
+	static inline void Counter_Add(std::atomic<uint64_t>& counter, uint64_t value, bool bShared) noexcept
+	{
+		if (bShared)
+		{
+			counter.fetch_add(value, std::memory_order_relaxed);
+		}
+		else
+		{
+			// Single writer, no need for locked add
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+	}
+
+
+	static inline void Track_Alloc(uint8_t tag, uint64_t sizeBytes) noexcept
+	{
+		FThreadCounters* counters = GetThreadCounters();
+		const bool bShared = (counters == &SharedCounters);
+		FTagCounters& tagCounters = counters->Tags[tag];
+		Counter_Add(tagCounters.AllocBytes, sizeBytes, bShared);
+		Counter_Add(tagCounters.AllocCount, 1, bShared);
+	}
+
+
+	static inline void Track_Free(uint8_t tag, uint64_t sizeBytes) noexcept
+	{
+		FThreadCounters* counters = GetThreadCounters();
+		const bool bShared = (counters == &SharedCounters);
+		FTagCounters& tagCounters = counters->Tags[tag];
+		Counter_Add(tagCounters.FreeBytes, sizeBytes, bShared);
+		Counter_Add(tagCounters.FreeCount, 1, bShared);
+	}
+
+
+	static inline FAllocHeader* GetHeader(void* alloc) noexcept
+	{
+		FAllocHeader* header = reinterpret_cast<FAllocHeader*>(alloc) - 1;
+		RPG_CheckV(header->Magic == RPG_MEMORY_HEADER_MAGIC, "RpgPlatformMemory: Memory (%p) is not allocated by RpgPlatformMemory or corrupted!", alloc);
+
+		return header;
+	}
+
+
+	static inline void* Tracked_Malloc(size_t sizeBytes, size_t alignmentBytes, ETag tag) noexcept
+	{
+		// mimalloc already returns 16 bytes aligned memory
+		const size_t offset = (alignmentBytes > RPG_MEMORY_HEADER_SIZE) ? alignmentBytes : RPG_MEMORY_HEADER_SIZE;
+		uint8_t* block = reinterpret_cast<uint8_t*>((alignmentBytes > RPG_MEMORY_HEADER_SIZE) ? mi_malloc_aligned(sizeBytes + offset, alignmentBytes) : mi_malloc(sizeBytes + offset));
+
+		if (block == nullptr)
+		{
+			return nullptr;
+		}
+
+		void* alloc = block + offset;
+		FAllocHeader* header = reinterpret_cast<FAllocHeader*>(alloc) - 1;
+		header->SizeBytes = sizeBytes;
+		header->Offset = static_cast<uint32_t>(offset);
+		header->Tag = tag;
+		header->Reserved = 0;
+		header->Magic = RPG_MEMORY_HEADER_MAGIC;
+
+		Track_Alloc(tag, sizeBytes);
+
+		return alloc;
+	}
+
+
+	static inline void* Tracked_Realloc(void* prevAlloc, size_t newSizeBytes, ETag tag, bool bKeepPrevTag) noexcept
+	{
+		if (prevAlloc == nullptr)
+		{
+			return Tracked_Malloc(newSizeBytes, RPG_MEMORY_HEADER_SIZE, tag);
+		}
+
+		FAllocHeader* header = GetHeader(prevAlloc);
+		const uint64_t prevSizeBytes = header->SizeBytes;
+		const uint8_t prevTag = header->Tag;
+		const uint8_t newTag = bKeepPrevTag ? prevTag : tag;
+
+		if (header->Offset != RPG_MEMORY_HEADER_SIZE)
+		{
+			// Over-aligned allocation can not be reallocated in place
+			void* newAlloc = Tracked_Malloc(newSizeBytes, RPG_MEMORY_HEADER_SIZE, static_cast<ETag>(newTag));
+
+			if (newAlloc)
+			{
+				memcpy(newAlloc, prevAlloc, (prevSizeBytes < newSizeBytes) ? prevSizeBytes : newSizeBytes);
+				Track_Free(prevTag, prevSizeBytes);
+				mi_free(reinterpret_cast<uint8_t*>(prevAlloc) - header->Offset);
+			}
+
+			return newAlloc;
+		}
+
+		uint8_t* block = reinterpret_cast<uint8_t*>(mi_realloc(reinterpret_cast<uint8_t*>(prevAlloc) - RPG_MEMORY_HEADER_SIZE, newSizeBytes + RPG_MEMORY_HEADER_SIZE));
+
+		if (block == nullptr)
+		{
+			return nullptr;
+		}
+
+		void* alloc = block + RPG_MEMORY_HEADER_SIZE;
+		header = reinterpret_cast<FAllocHeader*>(alloc) - 1;
+		header->SizeBytes = newSizeBytes;
+		header->Tag = newTag;
+
+		Track_Free(prevTag, prevSizeBytes);
+		Track_Alloc(newTag, newSizeBytes);
+
+		return alloc;
+	}
+
+
+	static inline void GatherCounters(uint64_t* out_AllocBytes, uint64_t* out_FreeBytes, uint64_t* out_AllocCount, uint64_t* out_FreeCount) noexcept
+	{
+		int threadCount = ThreadCounterCount.load(std::memory_order_relaxed);
+		if (threadCount > RPG_MEMORY_MAX_THREAD_COUNTERS)
+		{
+			threadCount = RPG_MEMORY_MAX_THREAD_COUNTERS;
+		}
+
+		for (int t = 0; t < TAG_MAX_COUNT; ++t)
+		{
+			const FTagCounters& shared = SharedCounters.Tags[t];
+			out_AllocBytes[t] = shared.AllocBytes.load(std::memory_order_relaxed);
+			out_FreeBytes[t] = shared.FreeBytes.load(std::memory_order_relaxed);
+			out_AllocCount[t] = shared.AllocCount.load(std::memory_order_relaxed);
+			out_FreeCount[t] = shared.FreeCount.load(std::memory_order_relaxed);
+
+			for (int i = 0; i < threadCount; ++i)
+			{
+				const FTagCounters& counters = ThreadCounters[i].Tags[t];
+				out_AllocBytes[t] += counters.AllocBytes.load(std::memory_order_relaxed);
+				out_FreeBytes[t] += counters.FreeBytes.load(std::memory_order_relaxed);
+				out_AllocCount[t] += counters.AllocCount.load(std::memory_order_relaxed);
+				out_FreeCount[t] += counters.FreeCount.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+};
+
+
+void* RpgPlatformMemory::MemMalloc(size_t sizeBytes) noexcept
+{
+	return Tracked_Malloc(sizeBytes, RPG_MEMORY_HEADER_SIZE, ThisThreadTag);
+}
+
+
+void* RpgPlatformMemory::MemMallocAligned(size_t sizeBytes, size_t alignmentBytes) noexcept
+{
+	return Tracked_Malloc(sizeBytes, alignmentBytes, ThisThreadTag);
+}
+
+
+void* RpgPlatformMemory::MemRealloc(void* prevAlloc, size_t newSizeBytes) noexcept
+{
+	return Tracked_Realloc(prevAlloc, newSizeBytes, ThisThreadTag, true);
+}
+
+
+void* RpgPlatformMemory::MemRecalloc(void* prevAlloc, int count, size_t sizeBytes) noexcept
+{
+	const size_t prevSizeBytes = prevAlloc ? GetHeader(prevAlloc)->SizeBytes : 0;
+	const size_t newSizeBytes = static_cast<size_t>(count) * sizeBytes;
+	uint8_t* alloc = reinterpret_cast<uint8_t*>(Tracked_Realloc(prevAlloc, newSizeBytes, ThisThreadTag, true));
+
+	if (alloc && newSizeBytes > prevSizeBytes)
+	{
+		memset(alloc + prevSizeBytes, 0, newSizeBytes - prevSizeBytes);
+	}
+
+	return alloc;
+}
+
+
+void RpgPlatformMemory::MemFree(void* alloc) noexcept
+{
+	if (alloc == nullptr)
+	{
+		return;
+	}
+
+	FAllocHeader* header = GetHeader(alloc);
+	Track_Free(header->Tag, header->SizeBytes);
+	header->Magic = 0;
+
+	mi_free(reinterpret_cast<uint8_t*>(alloc) - header->Offset);
+}
+
+
+void* RpgPlatformMemory::MemMallocTag(size_t sizeBytes, ETag tag) noexcept
+{
+	return Tracked_Malloc(sizeBytes, RPG_MEMORY_HEADER_SIZE, tag);
+}
+
+
+void* RpgPlatformMemory::MemMallocAlignedTag(size_t sizeBytes, size_t alignmentBytes, ETag tag) noexcept
+{
+	return Tracked_Malloc(sizeBytes, alignmentBytes, tag);
+}
+
+
+void* RpgPlatformMemory::MemReallocTag(void* prevAlloc, size_t newSizeBytes, ETag tag) noexcept
+{
+	return Tracked_Realloc(prevAlloc, newSizeBytes, tag, false);
+}
+
+
+RpgPlatformMemory::ETag RpgPlatformMemory::SetThreadTag(ETag tag) noexcept
+{
+	const ETag prevTag = ThisThreadTag;
+	ThisThreadTag = tag;
+
+	return prevTag;
+}
+
+
+RpgPlatformMemory::ETag RpgPlatformMemory::GetThreadTag() noexcept
+{
+	return ThisThreadTag;
+}
+
+
+void RpgPlatformMemory::UpdateFrameStats() noexcept
+{
+	uint64_t allocBytes[TAG_MAX_COUNT];
+	uint64_t freeBytes[TAG_MAX_COUNT];
+	uint64_t allocCount[TAG_MAX_COUNT];
+	uint64_t freeCount[TAG_MAX_COUNT];
+	GatherCounters(allocBytes, freeBytes, allocCount, freeCount);
+
+	AcquireSRWLockExclusive(&FrameStatsLock);
+
+	for (int t = 0; t < TAG_MAX_COUNT; ++t)
+	{
+		FTagStats& stats = FrameStats[t];
+		stats.LiveBytes = static_cast<int64_t>(allocBytes[t] - freeBytes[t]);
+		stats.LiveCount = static_cast<int64_t>(allocCount[t] - freeCount[t]);
+		stats.AllocCount = allocCount[t];
+		stats.FreeCount = freeCount[t];
+
+		if (stats.LiveBytes > stats.PeakBytes)
+		{
+			stats.PeakBytes = stats.LiveBytes;
+		}
+
+		stats.FrameAllocBytes = allocBytes[t] - PrevFrameAllocBytes[t];
+		stats.FrameFreeBytes = freeBytes[t] - PrevFrameFreeBytes[t];
+		stats.FrameAllocCount = allocCount[t] - PrevFrameAllocCount[t];
+
+		PrevFrameAllocBytes[t] = allocBytes[t];
+		PrevFrameFreeBytes[t] = freeBytes[t];
+		PrevFrameAllocCount[t] = allocCount[t];
+	}
+
+	ReleaseSRWLockExclusive(&FrameStatsLock);
+}
+
+
+void RpgPlatformMemory::GetSnapshot(FSnapshot& out_Snapshot) noexcept
+{
+	uint64_t allocBytes[TAG_MAX_COUNT];
+	uint64_t freeBytes[TAG_MAX_COUNT];
+	uint64_t allocCount[TAG_MAX_COUNT];
+	uint64_t freeCount[TAG_MAX_COUNT];
+	GatherCounters(allocBytes, freeBytes, allocCount, freeCount);
+
+	out_Snapshot.Total = FTagStats();
+
+	AcquireSRWLockShared(&FrameStatsLock);
+
+	for (int t = 0; t < TAG_MAX_COUNT; ++t)
+	{
+		FTagStats& stats = out_Snapshot.Tags[t];
+		stats = FrameStats[t];
+		stats.LiveBytes = static_cast<int64_t>(allocBytes[t] - freeBytes[t]);
+		stats.LiveCount = static_cast<int64_t>(allocCount[t] - freeCount[t]);
+		stats.AllocCount = allocCount[t];
+		stats.FreeCount = freeCount[t];
+
+		if (stats.LiveBytes > stats.PeakBytes)
+		{
+			stats.PeakBytes = stats.LiveBytes;
+		}
+
+		FTagStats& total = out_Snapshot.Total;
+		total.LiveBytes += stats.LiveBytes;
+		total.PeakBytes += stats.PeakBytes;
+		total.LiveCount += stats.LiveCount;
+		total.AllocCount += stats.AllocCount;
+		total.FreeCount += stats.FreeCount;
+		total.FrameAllocBytes += stats.FrameAllocBytes;
+		total.FrameFreeBytes += stats.FrameFreeBytes;
+		total.FrameAllocCount += stats.FrameAllocCount;
+	}
+
+	ReleaseSRWLockShared(&FrameStatsLock);
+}
+
+
+#else
+
 void* RpgPlatformMemory::MemMalloc(size_t sizeBytes) noexcept
 {
 	return mi_malloc(sizeBytes);
@@ -36,6 +444,61 @@ void RpgPlatformMemory::MemFree(void* alloc) noexcept
 }
 
 
+void* RpgPlatformMemory::MemMallocTag(size_t sizeBytes, ETag tag) noexcept
+{
+	return mi_malloc(sizeBytes);
+}
+
+
+void* RpgPlatformMemory::MemMallocAlignedTag(size_t sizeBytes, size_t alignmentBytes, ETag tag) noexcept
+{
+	return mi_malloc_aligned(sizeBytes, alignmentBytes);
+}
+
+
+void* RpgPlatformMemory::MemReallocTag(void* prevAlloc, size_t newSizeBytes, ETag tag) noexcept
+{
+	return mi_realloc(prevAlloc, newSizeBytes);
+}
+
+
+RpgPlatformMemory::ETag RpgPlatformMemory::SetThreadTag(ETag tag) noexcept
+{
+	return TAG_UNTAGGED;
+}
+
+
+RpgPlatformMemory::ETag RpgPlatformMemory::GetThreadTag() noexcept
+{
+	return TAG_UNTAGGED;
+}
+
+
+void RpgPlatformMemory::UpdateFrameStats() noexcept
+{
+}
+
+
+void RpgPlatformMemory::GetSnapshot(FSnapshot& out_Snapshot) noexcept
+{
+	out_Snapshot = FSnapshot();
+}
+
+#endif // RPG_MEMORY_TRACKING
+
+
+static void Rpg_MimallocStatsOutput(const char* msg, void* arg)
+{
+	RpgPlatformLog::OutputMessage(RpgPlatformConsole::OUTPUT_COLOR_DEFAULT, msg);
+}
+
+
+void RpgPlatformMemory::OutputAllocatorStats() noexcept
+{
+	mi_stats_print_out(Rpg_MimallocStatsOutput, nullptr);
+}
+
+
 void RpgPlatformMemory::MemCopy(void* dst, const void* src, size_t sizeBytes) noexcept
 {
 	memcpy(dst, src, sizeBytes);
@@ -62,216 +525,1202 @@ void RpgPlatformMemory::MemZero(void* data, size_t sizeBytes) noexcept
 
 
 
-// ========================================================================================================================= //
-// PLATFORM - STRING
-// ========================================================================================================================= //
-int RpgPlatformString::CStringLength(const char* cstr) noexcept
-{
-	return static_cast<int>(strlen(cstr));
-}
+// ========================================================================================================================= //
+// PLATFORM - STRING
+// ========================================================================================================================= //
+int RpgPlatformString::CStringLength(const char* cstr) noexcept
+{
+	return static_cast<int>(strlen(cstr));
+}
+
+
+bool RpgPlatformString::CStringCompare(const char* cstrA, const char* cstrB, bool bIgnoreCase) noexcept
+{
+	if (cstrA == nullptr && cstrB == nullptr)
+	{
+		return true;
+	}
+
+	if ((cstrA && cstrB == nullptr) || (cstrA == nullptr && cstrB))
+	{
+		return false;
+	}
+
+	const int lenA = CStringLength(cstrA);
+	const int lenB = CStringLength(cstrB);
+
+	if (lenA != lenB)
+	{
+		return false;
+	}
+
+	if (bIgnoreCase)
+	{
+		for (int i = 0; i < lenA; ++i)
+		{
+			if (tolower(cstrA[i]) != tolower(cstrB[i]))
+			{
+				return false;
+			}
+		}
+	}
+
+	return strcmp(cstrA, cstrB) == 0;
+}
+
+
+void RpgPlatformString::CStringCopy(char* dst, const char* src) noexcept
+{
+	strcpy(dst, src);
+}
+
+
+void RpgPlatformString::CStringToWide(wchar_t* dst, const char* src, size_t maxBufferCount) noexcept
+{
+	mbstowcs(dst, src, maxBufferCount);
+}
+
+
+void RpgPlatformString::CStringToLower(char* cstr, int len) noexcept
+{
+	RPG_Assert(cstr);
+	RPG_Assert(len > 0);
+
+	for (int i = 0; i < len; ++i)
+	{
+		cstr[i] = static_cast<char>(tolower(cstr[i]));
+	}
+}
+
+
+int RpgPlatformString::CStringToInt(const char* cstr) noexcept
+{
+	return cstr ? atoi(cstr) : 0;
+}
+
+
+float RpgPlatformString::CStringToFloat(const char* cstr) noexcept
+{
+	return cstr ? static_cast<float>(atof(cstr)) : 0.0f;
+}
+
+
+uint64_t RpgPlatformString::CStringHash(const char* cstr, bool bIgnoreCase) noexcept
+{
+	return CStringHash(cstr, CStringLength(cstr), bIgnoreCase);
+}
+
+
+uint64_t RpgPlatformString::CStringHash(const char* cstr, int len, bool bIgnoreCase) noexcept
+{
+	if (cstr == nullptr || len <= 0)
+	{
+		return 0;
+	}
+
+	if (!bIgnoreCase)
+	{
+		return XXH3_64bits(cstr, static_cast<size_t>(len));
+	}
+
+	// Short strings (names) are folded into single buffer
+	char lower[128];
+
+	if (len <= static_cast<int>(sizeof(lower)))
+	{
+		for (int i = 0; i < len; ++i)
+		{
+			lower[i] = static_cast<char>(tolower(static_cast<unsigned char>(cstr[i])));
+		}
+
+		return XXH3_64bits(lower, static_cast<size_t>(len));
+	}
+
+	XXH3_state_t state;
+	XXH3_64bits_reset(&state);
+
+	for (int offset = 0; offset < len; offset += static_cast<int>(sizeof(lower)))
+	{
+		const int count = (len - offset < static_cast<int>(sizeof(lower))) ? (len - offset) : static_cast<int>(sizeof(lower));
+
+		for (int i = 0; i < count; ++i)
+		{
+			lower[i] = static_cast<char>(tolower(static_cast<unsigned char>(cstr[offset + i])));
+		}
+
+		XXH3_64bits_update(&state, lower, static_cast<size_t>(count));
+	}
+
+	return XXH3_64bits_digest(&state);
+}
+
+
+int RpgPlatformString::WStringLength(const wchar_t* wstr) noexcept
+{
+	return static_cast<int>(wcslen(wstr));
+}
+
+
+void RpgPlatformString::WStringToMultibyte(char* dst, const wchar_t* wstr, size_t maxBufferCount) noexcept
+{
+	wcstombs(dst, wstr, maxBufferCount);
+}
+
+
+
+
+// ========================================================================================================================= //
+// PLATFORM - CONSOLE
+// ========================================================================================================================= //
+#define RPG_WINDOWS_CONSOLE_DEFAULT_ATTRIBUTES		(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE | FOREGROUND_INTENSITY)
+
+
+namespace RpgPlatformConsole
+{
+	static bool bInitialized = false;
+	static std::atomic<FInterruptCallback> InterruptCallback;
+
+
+	static BOOL WINAPI ConsoleCtrlHandler(DWORD ctrlType)
+	{
+		if (ctrlType != CTRL_C_EVENT && ctrlType != CTRL_BREAK_EVENT && ctrlType != CTRL_CLOSE_EVENT)
+		{
+			return FALSE;
+		}
+
+		FInterruptCallback callback = InterruptCallback.load(std::memory_order_acquire);
+
+		if (callback == nullptr)
+		{
+			return FALSE;
+		}
+
+		callback();
+
+		return TRUE;
+	}
+
+};
+
+
+void RpgPlatformConsole::Initialize() noexcept
+{
+	if (bInitialized)
+	{
+		return;
+	}
+
+	// Check if console already exists
+	HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	if (consoleHandle == NULL || consoleHandle == INVALID_HANDLE_VALUE)
+	{
+		if (AllocConsole())
+		{
+			consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+		}
+	}
+
+	// Double check console handle
+	if (consoleHandle == NULL || consoleHandle == INVALID_HANDLE_VALUE)
+	{
+		OutputDebugStringA("ERROR: Initialize console failed!\n");
+		return;
+	}
+
+	HWND consoleWindow = GetConsoleWindow();
+	if (consoleWindow == NULL || consoleWindow == INVALID_HANDLE_VALUE)
+	{
+		OutputDebugStringA("ERROR: Fail to get console window!\n");
+		return;
+	}
+
+	SetWindowPos(consoleWindow, NULL, 16, 16, 1280, 480, SWP_SHOWWINDOW);
+
+	bInitialized = true;
+}
+
+
+void RpgPlatformConsole::OutputMessage(const char* message, int messageLength, EOutputColor color) noexcept
+{
+	if (!bInitialized || message == nullptr || messageLength == 0)
+	{
+		return;
+	}
+
+	HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+	if (consoleHandle == NULL || consoleHandle == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	WORD attributes = RPG_WINDOWS_CONSOLE_DEFAULT_ATTRIBUTES;
+
+	switch (color)
+	{
+		case OUTPUT_COLOR_GREEN: attributes = FOREGROUND_GREEN | FOREGROUND_INTENSITY; break;
+		case OUTPUT_COLOR_YELLOW: attributes = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY; break;
+		case OUTPUT_COLOR_RED: attributes = FOREGROUND_RED | FOREGROUND_INTENSITY; break;
+		default: break;
+	}
+
+	SetConsoleTextAttribute(consoleHandle, attributes);
+	WriteConsoleA(consoleHandle, message, static_cast<DWORD>(messageLength), NULL, NULL);
+	SetConsoleTextAttribute(consoleHandle, RPG_WINDOWS_CONSOLE_DEFAULT_ATTRIBUTES);
+}
+
+
+void RpgPlatformConsole::SetInterruptCallback(FInterruptCallback callback) noexcept
+{
+	const FInterruptCallback prevCallback = InterruptCallback.exchange(callback, std::memory_order_acq_rel);
+
+	if (prevCallback == nullptr && callback)
+	{
+		SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+	}
+	else if (prevCallback && callback == nullptr)
+	{
+		SetConsoleCtrlHandler(ConsoleCtrlHandler, FALSE);
+	}
+}
+
+
+
+
+// ========================================================================================================================= //
+// PLATFORM - LOG
+// ========================================================================================================================= //
+namespace RpgPlatformLog
+{
+	enum ERecordType : uint8_t
+	{
+		// Preformatted text
+		RECORD_MESSAGE = 0,
+
+		// Category message. Format pointer + packed arguments, formatted by writer thread
+		RECORD_CATEGORY
+	};
+
+
+	struct alignas(64) FSlot
+	{
+		std::atomic<uint64_t> Sequence;
+		const char* CategoryName;
+		const char* Format;
+
+		// Payload that does not fit into slot
+		uint8_t* HeapPayload;
+
+		uint32_t PayloadSize;
+		ERecordType Type;
+		EVerbosity Verbosity;
+		RpgPlatformConsole::EOutputColor Color;
+		uint8_t Payload[RPG_LOG_QUEUE_SLOT_SIZE - 40];
+	};
+	static_assert(sizeof(FSlot) == RPG_LOG_QUEUE_SLOT_SIZE, "RpgPlatformLog: Invalid queue slot size!");
+	static_assert((RPG_LOG_QUEUE_CAPACITY & (RPG_LOG_QUEUE_CAPACITY - 1)) == 0, "RpgPlatformLog: Queue capacity must be power of two!");
+
+
+	static EVerbosity GlobalVerbosity;
+	static HANDLE OutputFileHandle;
+	static bool bInitialized;
+
+	// Single consumer lock. Held by writer thread while draining the queue, or by any thread when writing output synchronously
+	static SRWLOCK OutputLock = SRWLOCK_INIT;
+
+	// File output is batched. Guarded by OutputLock
+	static char OutputFileBuffer[RPG_LOG_OUTPUT_FILE_BUFFER_SIZE];
+	static int OutputFileBufferSize;
+
+	// Bounded MPSC queue (sequence per slot)
+	static FSlot QueueSlots[RPG_LOG_QUEUE_CAPACITY];
+	static std::atomic<uint64_t> QueueEnqueuePosition;
+	static std::atomic<uint64_t> QueueDequeuePosition;
+	static std::atomic<uint32_t> QueueDroppedCount;
+
+	static HANDLE WriterThread;
+	static HANDLE WriterWakeEvent;
+	static std::atomic<bool> bWriterRunning;
+	static std::atomic<bool> bWriterWaiting;
+
+	// True while messages go through the queue. False before initialize, after shutdown, or if writer thread failed to start
+	static std::atomic<bool> bAsync;
+
+	static LPTOP_LEVEL_EXCEPTION_FILTER PrevUnhandledExceptionFilter;
+
+
+
+	static RpgPlatformConsole::EOutputColor GetVerbosityColor(EVerbosity verbosity) noexcept
+	{
+		switch (verbosity)
+		{
+			case VERBOSITY_DEBUG: return RpgPlatformConsole::OUTPUT_COLOR_GREEN;
+			case VERBOSITY_WARN: return RpgPlatformConsole::OUTPUT_COLOR_YELLOW;
+			case VERBOSITY_ERROR: return RpgPlatformConsole::OUTPUT_COLOR_RED;
+			default: break;
+		}
+
+		return RpgPlatformConsole::OUTPUT_COLOR_DEFAULT;
+	}
+
+
+
+	// ---------------------------------------------------------------------------------------------------------------- //
+	// 	Format arguments packing
+	// ---------------------------------------------------------------------------------------------------------------- //
+	enum EArgType : uint8_t
+	{
+		ARG_PERCENT = 0,
+		ARG_INT,
+		ARG_UINT,
+		ARG_CHAR,
+		ARG_DOUBLE,
+		ARG_POINTER,
+		ARG_STRING,
+		ARG_WSTRING,
+		ARG_COUNT_WRITTEN
+	};
+
+
+	enum EArgLength : uint8_t
+	{
+		LENGTH_DEFAULT = 0,
+		LENGTH_HH,
+		LENGTH_H,
+		LENGTH_L,
+		LENGTH_LL,
+		LENGTH_SIZE,
+		LENGTH_LONG_DOUBLE
+	};
+
+
+	struct FFormatSpec
+	{
+		char Flags[8];
+		int FlagCount;
+		int Width;
+		int Precision;
+		bool bWidthArg;
+		bool bPrecisionArg;
+		EArgLength Length;
+		EArgType Type;
+		char Conversion;
+
+		// Number of characters including '%'
+		int SpecLength;
+	};
+
+
+	static inline bool Format_IsDigit(char c) noexcept
+	{
+		return c >= '0' && c <= '9';
+	}
+
+
+	// Parse printf conversion specification
+	// @param spec - Pointer to '%'
+	// @param out_Spec - Output spec
+	// @returns False if conversion is not supported
+	static bool Format_ParseSpec(const char* spec, FFormatSpec& out_Spec) noexcept
+	{
+		out_Spec.FlagCount = 0;
+		out_Spec.Width = -1;
+		out_Spec.Precision = -1;
+		out_Spec.bWidthArg = false;
+		out_Spec.bPrecisionArg = false;
+		out_Spec.Length = LENGTH_DEFAULT;
+
+		const char* c = spec + 1;
+
+		if (*c == '%')
+		{
+			out_Spec.Type = ARG_PERCENT;
+			out_Spec.Conversion = '%';
+			out_Spec.SpecLength = 2;
+			return true;
+		}
+
+		while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0')
+		{
+			if (out_Spec.FlagCount < 5)
+			{
+				out_Spec.Flags[out_Spec.FlagCount++] = *c;
+			}
+
+			++c;
+		}
+
+		if (*c == '*')
+		{
+			out_Spec.bWidthArg = true;
+			++c;
+		}
+		else if (Format_IsDigit(*c))
+		{
+			out_Spec.Width = 0;
+
+			while (Format_IsDigit(*c))
+			{
+				out_Spec.Width = out_Spec.Width * 10 + (*c - '0');
+				++c;
+			}
+		}
+
+		if (*c == '.')
+		{
+			++c;
+
+			if (*c == '*')
+			{
+				out_Spec.bPrecisionArg = true;
+				++c;
+			}
+			else
+			{
+				out_Spec.Precision = 0;
+
+				while (Format_IsDigit(*c))
+				{
+					out_Spec.Precision = out_Spec.Precision * 10 + (*c - '0');
+					++c;
+				}
+			}
+		}
+
+		switch (*c)
+		{
+			case 'h':
+			{
+				++c;
+				out_Spec.Length = LENGTH_H;
+
+				if (*c == 'h')
+				{
+					++c;
+					out_Spec.Length = LENGTH_HH;
+				}
+
+				break;
+			}
+
+			case 'l':
+			{
+				++c;
+				out_Spec.Length = LENGTH_L;
+
+				if (*c == 'l')
+				{
+					++c;
+					out_Spec.Length = LENGTH_LL;
+				}
+
+				break;
+			}
+
+			case 'j': ++c; out_Spec.Length = LENGTH_LL; break;
+			case 'z': case 't': ++c; out_Spec.Length = LENGTH_SIZE; break;
+			case 'L': ++c; out_Spec.Length = LENGTH_LONG_DOUBLE; break;
+
+			case 'I':
+			{
+				++c;
+
+				if (c[0] == '6' && c[1] == '4')
+				{
+					c += 2;
+					out_Spec.Length = LENGTH_LL;
+				}
+				else if (c[0] == '3' && c[1] == '2')
+				{
+					c += 2;
+				}
+				else
+				{
+					out_Spec.Length = LENGTH_SIZE;
+				}
+
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		out_Spec.Conversion = *c;
+
+		switch (*c)
+		{
+			case 'd': case 'i': out_Spec.Type = ARG_INT; break;
+			case 'u': case 'o': case 'x': case 'X': out_Spec.Type = ARG_UINT; break;
+			case 'c': out_Spec.Type = ARG_CHAR; break;
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': out_Spec.Type = ARG_DOUBLE; break;
+			case 'p': out_Spec.Type = ARG_POINTER; break;
+			case 's': out_Spec.Type = (out_Spec.Length == LENGTH_L) ? ARG_WSTRING : ARG_STRING; break;
+			case 'S': out_Spec.Type = ARG_WSTRING; break;
+			case 'n': out_Spec.Type = ARG_COUNT_WRITTEN; break;
+			default: return false;
+		}
+
+		out_Spec.SpecLength = static_cast<int>(c - spec) + 1;
+
+		return true;
+	}
+
+
+	// Build printf spec for single packed value. Integers are packed as 64-bit, wide strings are packed as narrow strings
+	static void Format_BuildSpec(const FFormatSpec& spec, int width, int precision, char* out_Spec, int specBufferSize) noexcept
+	{
+		int n = 0;
+		out_Spec[n++] = '%';
+
+		for (int i = 0; i < spec.FlagCount; ++i)
+		{
+			out_Spec[n++] = spec.Flags[i];
+		}
+
+		// Negative width argument means left-justify
+		if (spec.bWidthArg && width < 0)
+		{
+			out_Spec[n++] = '-';
+			width = -width;
+		}
+
+		if (width >= 0)
+		{
+			n += snprintf(out_Spec + n, specBufferSize - n, "%i", width);
+		}
+
+		if (precision >= 0)
+		{
+			n += snprintf(out_Spec + n, specBufferSize - n, ".%i", precision);
+		}
+
+		if (spec.Type == ARG_INT || spec.Type == ARG_UINT)
+		{
+			out_Spec[n++] = 'l';
+			out_Spec[n++] = 'l';
+		}
+
+		out_Spec[n++] = (spec.Type == ARG_WSTRING) ? 's' : spec.Conversion;
+		out_Spec[n] = '\0';
+	}
+
+
+	struct FPackWriter
+	{
+		uint8_t* Data;
+		int Capacity;
+		int Size;
+	};
+
+
+	static inline bool Pack_Write(FPackWriter& writer, const void* data, int sizeBytes) noexcept
+	{
+		if (writer.Size + sizeBytes > writer.Capacity)
+		{
+			return false;
+		}
+
+		RpgPlatformMemory::MemCopy(writer.Data + writer.Size, data, sizeBytes);
+		writer.Size += sizeBytes;
+
+		return true;
+	}
+
+
+	static inline bool Pack_WriteString(FPackWriter& writer, const char* str) noexcept
+	{
+		const uint32_t length = static_cast<uint32_t>(strlen(str));
+
+		return Pack_Write(writer, &length, sizeof(uint32_t)) && Pack_Write(writer, str, length + 1);
+	}
+
+
+	// Copy arguments referenced by <format> into byte buffer. Strings are copied, they may not outlive the call
+	// @param format - Format string
+	// @param args - Arguments
+	// @param out_Data - Output buffer
+	// @param capacity - Size of output buffer
+	// @param out_Size - Number of bytes written
+	// @returns False if arguments does not fit or format is not supported
+	static bool Format_PackArgs(const char* format, va_list args, uint8_t* out_Data, int capacity, int& out_Size) noexcept
+	{
+		FPackWriter writer{ out_Data, capacity, 0 };
+		out_Size = 0;
+
+		const char* c = format;
+
+		while (*c)
+		{
+			if (*c != '%')
+			{
+				++c;
+				continue;
+			}
+
+			FFormatSpec spec;
+			if (!Format_ParseSpec(c, spec))
+			{
+				return false;
+			}
+
+			c += spec.SpecLength;
+
+			if (spec.Type == ARG_PERCENT)
+			{
+				continue;
+			}
+
+			if (spec.bWidthArg)
+			{
+				const int64_t width = va_arg(args, int);
+				if (!Pack_Write(writer, &width, sizeof(int64_t))) return false;
+			}
+
+			if (spec.bPrecisionArg)
+			{
+				const int64_t precision = va_arg(args, int);
+				if (!Pack_Write(writer, &precision, sizeof(int64_t))) return false;
+			}
+
+			bool bSuccess = true;
+
+			switch (spec.Type)
+			{
+				case ARG_INT:
+				{
+					int64_t value = 0;
+
+					switch (spec.Length)
+					{
+						case LENGTH_HH: value = static_cast<signed char>(va_arg(args, int)); break;
+						case LENGTH_H: value = static_cast<short>(va_arg(args, int)); break;
+						case LENGTH_L: value = va_arg(args, long); break;
+						case LENGTH_LL: value = va_arg(args, long long); break;
+						case LENGTH_SIZE: value = va_arg(args, ptrdiff_t); break;
+						default: value = va_arg(args, int); break;
+					}
+
+					bSuccess = Pack_Write(writer, &value, sizeof(int64_t));
+					break;
+				}
+
+				case ARG_UINT:
+				{
+					uint64_t value = 0;
+
+					switch (spec.Length)
+					{
+						case LENGTH_HH: value = static_cast<unsigned char>(va_arg(args, unsigned int)); break;
+						case LENGTH_H: value = static_cast<unsigned short>(va_arg(args, unsigned int)); break;
+						case LENGTH_L: value = va_arg(args, unsigned long); break;
+						case LENGTH_LL: value = va_arg(args, unsigned long long); break;
+						case LENGTH_SIZE: value = va_arg(args, size_t); break;
+						default: value = va_arg(args, unsigned int); break;
+					}
+
+					bSuccess = Pack_Write(writer, &value, sizeof(uint64_t));
+					break;
+				}
+
+				case ARG_CHAR:
+				{
+					const int64_t value = va_arg(args, int);
+					bSuccess = Pack_Write(writer, &value, sizeof(int64_t));
+					break;
+				}
+
+				case ARG_DOUBLE:
+				{
+					const double value = (spec.Length == LENGTH_LONG_DOUBLE) ? static_cast<double>(va_arg(args, long double)) : va_arg(args, double);
+					bSuccess = Pack_Write(writer, &value, sizeof(double));
+					break;
+				}
+
+				case ARG_POINTER:
+				case ARG_COUNT_WRITTEN:
+				{
+					const uint64_t value = reinterpret_cast<uintptr_t>(va_arg(args, void*));
+					bSuccess = Pack_Write(writer, &value, sizeof(uint64_t));
+					break;
+				}
+
+				case ARG_STRING:
+				{
+					const char* str = va_arg(args, const char*);
+					bSuccess = Pack_WriteString(writer, str ? str : "(null)");
+					break;
+				}
+
+				case ARG_WSTRING:
+				{
+					const wchar_t* wstr = va_arg(args, const wchar_t*);
+
+					char temp[RPG_LOG_CATEGORY_MAX_FORMAT];
+					snprintf(temp, RPG_LOG_CATEGORY_MAX_FORMAT, "%ls", wstr ? wstr : L"(null)");
+
+					bSuccess = Pack_WriteString(writer, temp);
+					break;
+				}
+
+				default:
+					break;
+			}
+
+			if (!bSuccess)
+			{
+				return false;
+			}
+		}
+
+		out_Size = writer.Size;
+
+		return true;
+	}
+
+
+	struct FPackReader
+	{
+		const uint8_t* Data;
+		int Size;
+		int Offset;
+	};
+
+
+	static inline bool Pack_Read(FPackReader& reader, void* out_Data, int sizeBytes) noexcept
+	{
+		if (reader.Offset + sizeBytes > reader.Size)
+		{
+			return false;
+		}
+
+		RpgPlatformMemory::MemCopy(out_Data, reader.Data + reader.Offset, sizeBytes);
+		reader.Offset += sizeBytes;
+
+		return true;
+	}
+
+
+	static inline const char* Pack_ReadString(FPackReader& reader) noexcept
+	{
+		uint32_t length = 0;
+
+		if (!Pack_Read(reader, &length, sizeof(uint32_t)) || reader.Offset + static_cast<int>(length) + 1 > reader.Size)
+		{
+			return nullptr;
+		}
+
+		const char* str = reinterpret_cast<const char*>(reader.Data + reader.Offset);
+		reader.Offset += static_cast<int>(length) + 1;
+
+		return str;
+	}
+
+
+	// Format text from <format> and arguments packed by Format_PackArgs
+	// @returns Text length
+	static int Format_UnpackArgs(const char* format, const uint8_t* data, int dataSize, char* out_Text, int capacity) noexcept
+	{
+		FPackReader reader{ data, dataSize, 0 };
+		int length = 0;
+
+		const char* c = format;
+
+		while (*c && length < capacity - 1)
+		{
+			if (*c != '%')
+			{
+				out_Text[length++] = *c++;
+				continue;
+			}
+
+			FFormatSpec spec;
+			if (!Format_ParseSpec(c, spec))
+			{
+				break;
+			}
+
+			c += spec.SpecLength;
+
+			if (spec.Type == ARG_PERCENT)
+			{
+				out_Text[length++] = '%';
+				continue;
+			}
+
+			int64_t width = spec.Width;
+			int64_t precision = spec.Precision;
+
+			if ((spec.bWidthArg && !Pack_Read(reader, &width, sizeof(int64_t))) || (spec.bPrecisionArg && !Pack_Read(reader, &precision, sizeof(int64_t))))
+			{
+				break;
+			}
+
+			// Negative precision argument is taken as if precision were omitted
+			if (spec.bPrecisionArg && precision < 0)
+			{
+				precision = -1;
+			}
+
+			char specBuffer[32];
+			Format_BuildSpec(spec, static_cast<int>(width), static_cast<int>(precision), specBuffer, sizeof(specBuffer));
+
+			char* out = out_Text + length;
+			const int remaining = capacity - length;
+			int written = 0;
+
+			switch (spec.Type)
+			{
+				case ARG_INT:
+				{
+					int64_t value = 0;
+					if (!Pack_Read(reader, &value, sizeof(int64_t))) return length;
+					written = snprintf(out, remaining, specBuffer, static_cast<long long>(value));
+					break;
+				}
+
+				case ARG_UINT:
+				{
+					uint64_t value = 0;
+					if (!Pack_Read(reader, &value, sizeof(uint64_t))) return length;
+					written = snprintf(out, remaining, specBuffer, static_cast<unsigned long long>(value));
+					break;
+				}
+
+				case ARG_CHAR:
+				{
+					int64_t value = 0;
+					if (!Pack_Read(reader, &value, sizeof(int64_t))) return length;
+					written = snprintf(out, remaining, specBuffer, static_cast<int>(value));
+					break;
+				}
+
+				case ARG_DOUBLE:
+				{
+					double value = 0.0;
+					if (!Pack_Read(reader, &value, sizeof(double))) return length;
+					written = snprintf(out, remaining, specBuffer, value);
+					break;
+				}
+
+				case ARG_POINTER:
+				{
+					uint64_t value = 0;
+					if (!Pack_Read(reader, &value, sizeof(uint64_t))) return length;
+					written = snprintf(out, remaining, specBuffer, reinterpret_cast<void*>(static_cast<uintptr_t>(value)));
+					break;
+				}
+
+				case ARG_COUNT_WRITTEN:
+				{
+					// Not supported, pointer is ignored
+					uint64_t value = 0;
+					if (!Pack_Read(reader, &value, sizeof(uint64_t))) return length;
+					break;
+				}
+
+				case ARG_STRING:
+				case ARG_WSTRING:
+				{
+					const char* str = Pack_ReadString(reader);
+					if (str == nullptr) return length;
+					written = snprintf(out, remaining, specBuffer, str);
+					break;
+				}
+
+				default:
+					break;
+			}
+
+			if (written > 0)
+			{
+				length += (written < remaining) ? written : remaining - 1;
+			}
+		}
 
+		out_Text[length] = '\0';
 
-bool RpgPlatformString::CStringCompare(const char* cstrA, const char* cstrB, bool bIgnoreCase) noexcept
-{
-	if (cstrA == nullptr && cstrB == nullptr)
-	{
-		return true;
+		return length;
 	}
 
-	if ((cstrA && cstrB == nullptr) || (cstrA == nullptr && cstrB))
-	{
-		return false;
-	}
 
-	const int lenA = CStringLength(cstrA);
-	const int lenB = CStringLength(cstrB);
 
-	if (lenA != lenB)
+	// ---------------------------------------------------------------------------------------------------------------- //
+	// 	Output
+	// ---------------------------------------------------------------------------------------------------------------- //
+	// Must hold OutputLock
+	static void Output_FlushFile() noexcept
 	{
-		return false;
+		if (OutputFileBufferSize > 0 && OutputFileHandle && OutputFileHandle != INVALID_HANDLE_VALUE)
+		{
+			WriteFile(OutputFileHandle, OutputFileBuffer, OutputFileBufferSize, NULL, NULL);
+		}
+
+		OutputFileBufferSize = 0;
 	}
 
-	if (bIgnoreCase)
+
+	// Must hold OutputLock. <text> must be null terminated
+	static void Output_Write(RpgPlatformConsole::EOutputColor color, const char* text, int length) noexcept
 	{
-		for (int i = 0; i < lenA; ++i)
+		OutputDebugString(text);
+		RpgPlatformConsole::OutputMessage(text, length, color);
+
+		if (OutputFileHandle == NULL || OutputFileHandle == INVALID_HANDLE_VALUE)
 		{
-			if (tolower(cstrA[i]) != tolower(cstrB[i]))
-			{
-				return false;
-			}
+			return;
 		}
-	}
 
-	return strcmp(cstrA, cstrB) == 0;
-}
+		if (OutputFileBufferSize + length > RPG_LOG_OUTPUT_FILE_BUFFER_SIZE)
+		{
+			Output_FlushFile();
+		}
 
+		if (length > RPG_LOG_OUTPUT_FILE_BUFFER_SIZE)
+		{
+			WriteFile(OutputFileHandle, text, length, NULL, NULL);
+		}
+		else
+		{
+			RpgPlatformMemory::MemCopy(OutputFileBuffer + OutputFileBufferSize, text, length);
+			OutputFileBufferSize += length;
+		}
+	}
 
-void RpgPlatformString::CStringCopy(char* dst, const char* src) noexcept
-{
-	strcpy(dst, src);
-}
 
 
-void RpgPlatformString::CStringToWide(wchar_t* dst, const char* src, size_t maxBufferCount) noexcept
-{
-	mbstowcs(dst, src, maxBufferCount);
-}
+	// ---------------------------------------------------------------------------------------------------------------- //
+	// 	Queue
+	// ---------------------------------------------------------------------------------------------------------------- //
+	static void Queue_Initialize() noexcept
+	{
+		for (uint64_t i = 0; i < RPG_LOG_QUEUE_CAPACITY; ++i)
+		{
+			FSlot& slot = QueueSlots[i];
+			slot.Sequence.store(i, std::memory_order_relaxed);
+			slot.HeapPayload = nullptr;
+		}
 
+		QueueEnqueuePosition.store(0, std::memory_order_relaxed);
+		QueueDequeuePosition.store(0, std::memory_order_relaxed);
+		QueueDroppedCount.store(0, std::memory_order_relaxed);
+	}
 
-void RpgPlatformString::CStringToLower(char* cstr, int len) noexcept
-{
-	RPG_Assert(cstr);
-	RPG_Assert(len > 0);
 
-	for (int i = 0; i < len; ++i)
+	// Push record into queue. Never blocks unless <bBlockWhenFull> is true
+	// @returns False if record is dropped because queue is full
+	static bool Queue_Push(ERecordType type, EVerbosity verbosity, RpgPlatformConsole::EOutputColor color, const char* categoryName, const char* format, const void* payload, uint32_t payloadSize, bool bBlockWhenFull) noexcept
 	{
-		cstr[i] = static_cast<char>(tolower(cstr[i]));
-	}
-}
+		FSlot* slot = nullptr;
+		uint64_t position = QueueEnqueuePosition.load(std::memory_order_relaxed);
 
+		while (true)
+		{
+			slot = &QueueSlots[position & (RPG_LOG_QUEUE_CAPACITY - 1)];
+			const int64_t diff = static_cast<int64_t>(slot->Sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(position);
 
-int RpgPlatformString::CStringToInt(const char* cstr) noexcept
-{
-	return cstr ? atoi(cstr) : 0;
-}
+			if (diff == 0)
+			{
+				if (QueueEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Queue full
+				if (!bBlockWhenFull || !bWriterRunning.load(std::memory_order_acquire))
+				{
+					QueueDroppedCount.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+
+				SetEvent(WriterWakeEvent);
+				SwitchToThread();
+				position = QueueEnqueuePosition.load(std::memory_order_relaxed);
+			}
+			else
+			{
+				position = QueueEnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
 
+		slot->CategoryName = categoryName;
+		slot->Format = format;
+		slot->PayloadSize = payloadSize;
+		slot->Type = type;
+		slot->Verbosity = verbosity;
+		slot->Color = color;
 
-float RpgPlatformString::CStringToFloat(const char* cstr) noexcept
-{
-	return cstr ? static_cast<float>(atof(cstr)) : 0.0f;
-}
+		if (payloadSize <= sizeof(slot->Payload))
+		{
+			slot->HeapPayload = nullptr;
+			RpgPlatformMemory::MemCopy(slot->Payload, payload, payloadSize);
+		}
+		else
+		{
+			slot->HeapPayload = reinterpret_cast<uint8_t*>(RpgPlatformMemory::MemMallocTag(payloadSize, RpgPlatformMemory::TAG_LOG));
+			RpgPlatformMemory::MemCopy(slot->HeapPayload, payload, payloadSize);
+		}
 
+		slot->Sequence.store(position + 1, std::memory_order_seq_cst);
 
-uint64_t RpgPlatformString::CStringHash(const char* cstr) noexcept
-{
-	const int len = CStringLength(cstr);
-	if (len == 0)
-	{
-		return 0;
+		if (bWriterWaiting.load(std::memory_order_seq_cst))
+		{
+			SetEvent(WriterWakeEvent);
+		}
+
+		return true;
 	}
 
-	uint64_t hash = 0;
 
-	for (int i = 0; i < len; ++i)
+	static inline bool Queue_HasPending() noexcept
 	{
-		hash += cstr[i];
-		hash += (hash << 10);
-		hash ^= (hash >> 6);
+		const uint64_t position = QueueDequeuePosition.load(std::memory_order_relaxed);
+		return QueueSlots[position & (RPG_LOG_QUEUE_CAPACITY - 1)].Sequence.load(std::memory_order_seq_cst) == position + 1;
 	}
 
-	hash += (hash << 3);
-	hash ^= (hash >> 11);
-	hash += (hash << 15);
-
-	return hash;
-}
 
+	// Format and output all published records. Must hold OutputLock
+	// @returns Number of records consumed
+	static int Queue_Drain() noexcept
+	{
+		char message[RPG_LOG_CATEGORY_MAX_FORMAT];
+		char text[RPG_LOG_MAX_OUTPUT_BUFFER];
+		int count = 0;
 
-int RpgPlatformString::WStringLength(const wchar_t* wstr) noexcept
-{
-	return static_cast<int>(wcslen(wstr));
-}
+		while (true)
+		{
+			const uint64_t position = QueueDequeuePosition.load(std::memory_order_relaxed);
+			FSlot& slot = QueueSlots[position & (RPG_LOG_QUEUE_CAPACITY - 1)];
 
+			if (slot.Sequence.load(std::memory_order_acquire) != position + 1)
+			{
+				break;
+			}
 
-void RpgPlatformString::WStringToMultibyte(char* dst, const wchar_t* wstr, size_t maxBufferCount) noexcept
-{
-	wcstombs(dst, wstr, maxBufferCount);
-}
+			const uint8_t* payload = slot.HeapPayload ? slot.HeapPayload : slot.Payload;
 
+			if (slot.Type == RECORD_MESSAGE)
+			{
+				Output_Write(slot.Color, reinterpret_cast<const char*>(payload), static_cast<int>(slot.PayloadSize) - 1);
+			}
+			else
+			{
+				Format_UnpackArgs(slot.Format, payload, static_cast<int>(slot.PayloadSize), message, RPG_LOG_CATEGORY_MAX_FORMAT);
 
+				int length = snprintf(text, RPG_LOG_MAX_OUTPUT_BUFFER, "<%s>: %s\n", slot.CategoryName, message);
+				length = (length < RPG_LOG_MAX_OUTPUT_BUFFER) ? length : RPG_LOG_MAX_OUTPUT_BUFFER - 1;
 
+				Output_Write(GetVerbosityColor(slot.Verbosity), text, length);
+			}
 
-// ========================================================================================================================= //
-// PLATFORM - CONSOLE
-// ========================================================================================================================= //
-#define RPG_WINDOWS_CONSOLE_DEFAULT_ATTRIBUTES		(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE | FOREGROUND_INTENSITY)
+			if (slot.HeapPayload)
+			{
+				RpgPlatformMemory::MemFree(slot.HeapPayload);
+				slot.HeapPayload = nullptr;
+			}
 
+			slot.Sequence.store(position + RPG_LOG_QUEUE_CAPACITY, std::memory_order_release);
+			QueueDequeuePosition.store(position + 1, std::memory_order_release);
+			++count;
+		}
 
-namespace RpgPlatformConsole
-{
-	static bool bInitialized = false;
+		const uint32_t droppedCount = QueueDroppedCount.exchange(0, std::memory_order_relaxed);
 
-};
+		if (droppedCount > 0)
+		{
+			const int length = snprintf(text, RPG_LOG_MAX_OUTPUT_BUFFER, "<RpgPlatformLog>: Queue full, %u messages dropped\n", droppedCount);
+			Output_Write(RpgPlatformConsole::OUTPUT_COLOR_YELLOW, text, length);
+		}
 
+		Output_FlushFile();
 
-void RpgPlatformConsole::Initialize() noexcept
-{
-	if (bInitialized)
-	{
-		return;
+		return count;
 	}
 
-	// Check if console already exists
-	HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
 
-	if (consoleHandle == NULL || consoleHandle == INVALID_HANDLE_VALUE)
+	// Drain queue on calling thread until everything pushed before this call has been written or timeout
+	static void Queue_Flush(uint64_t timeoutMs) noexcept
 	{
-		if (AllocConsole())
+		const uint64_t targetPosition = QueueEnqueuePosition.load(std::memory_order_acquire);
+		const uint64_t startTick = GetTickCount64();
+
+		while (true)
 		{
-			consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+			// Lock is also held by writer thread while it's writing, acquiring it means the drained records have been written
+			if (TryAcquireSRWLockExclusive(&OutputLock))
+			{
+				Queue_Drain();
+				ReleaseSRWLockExclusive(&OutputLock);
+
+				if (QueueDequeuePosition.load(std::memory_order_acquire) >= targetPosition)
+				{
+					break;
+				}
+			}
+
+			// Timeout prevents deadlock when crashed thread holds the lock or never publishes its record
+			if (GetTickCount64() - startTick >= timeoutMs)
+			{
+				break;
+			}
+
+			SwitchToThread();
 		}
 	}
 
-	// Double check console handle
-	if (consoleHandle == NULL || consoleHandle == INVALID_HANDLE_VALUE)
-	{
-		OutputDebugStringA("ERROR: Initialize console failed!\n");
-		return;
-	}
 
-	HWND consoleWindow = GetConsoleWindow();
-	if (consoleWindow == NULL || consoleWindow == INVALID_HANDLE_VALUE)
+	static DWORD WINAPI Writer_Main(_In_ LPVOID lpParameter)
 	{
-		OutputDebugStringA("ERROR: Fail to get console window!\n");
-		return;
-	}
+		RpgPlatformMemory::SetThreadTag(RpgPlatformMemory::TAG_LOG);
 
-	SetWindowPos(consoleWindow, NULL, 16, 16, 1280, 480, SWP_SHOWWINDOW);
+		while (bWriterRunning.load(std::memory_order_acquire))
+		{
+			AcquireSRWLockExclusive(&OutputLock);
+			const int count = Queue_Drain();
+			ReleaseSRWLockExclusive(&OutputLock);
 
-	bInitialized = true;
-}
+			if (count == 0)
+			{
+				// Announce waiting, then check again so a concurrent push will not be missed
+				bWriterWaiting.store(true, std::memory_order_seq_cst);
 
+				if (!Queue_HasPending())
+				{
+					WaitForSingleObject(WriterWakeEvent, RPG_LOG_WRITER_WAIT_MS);
+				}
 
-void RpgPlatformConsole::OutputMessage(const char* message, int messageLength, EOutputColor color) noexcept
-{
-	if (!bInitialized || message == nullptr || messageLength == 0)
-	{
-		return;
-	}
+				bWriterWaiting.store(false, std::memory_order_relaxed);
+			}
+		}
 
-	HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
-	if (consoleHandle == NULL || consoleHandle == INVALID_HANDLE_VALUE)
-	{
-		return;
+		return 0;
 	}
 
-	WORD attributes = RPG_WINDOWS_CONSOLE_DEFAULT_ATTRIBUTES;
 
-	switch (color)
+	static LONG WINAPI Log_UnhandledExceptionFilter(EXCEPTION_POINTERS* exceptionInfo)
 	{
-		case OUTPUT_COLOR_GREEN: attributes = FOREGROUND_GREEN | FOREGROUND_INTENSITY; break;
-		case OUTPUT_COLOR_YELLOW: attributes = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY; break;
-		case OUTPUT_COLOR_RED: attributes = FOREGROUND_RED | FOREGROUND_INTENSITY; break;
-		default: break;
-	}
+		Queue_Flush(RPG_LOG_CRASH_FLUSH_TIMEOUT_MS);
 
-	SetConsoleTextAttribute(consoleHandle, attributes);
-	WriteConsoleA(consoleHandle, message, static_cast<DWORD>(messageLength), NULL, NULL);
-	SetConsoleTextAttribute(consoleHandle, RPG_WINDOWS_CONSOLE_DEFAULT_ATTRIBUTES);
-}
+		return PrevUnhandledExceptionFilter ? PrevUnhandledExceptionFilter(exceptionInfo) : EXCEPTION_CONTINUE_SEARCH;
+	}
 
 
+	static void Log_OutputText(RpgPlatformConsole::EOutputColor color, const char* text, int length, bool bBlockWhenFull) noexcept
+	{
+		if (bAsync.load(std::memory_order_acquire))
+		{
+			Queue_Push(RECORD_MESSAGE, VERBOSITY_NONE, color, nullptr, nullptr, text, static_cast<uint32_t>(length) + 1, bBlockWhenFull);
+			return;
+		}
 
+		AcquireSRWLockExclusive(&OutputLock);
+		Output_Write(color, text, length);
+		Output_FlushFile();
+		ReleaseSRWLockExclusive(&OutputLock);
+	}
 
-// ========================================================================================================================= //
-// PLATFORM - LOG
-// ========================================================================================================================= //
-namespace RpgPlatformLog
-{
-	static EVerbosity GlobalVerbosity;
-	static HANDLE OutputFileHandle;
-	static CRITICAL_SECTION OutputFileCS;
-	static bool bInitialized;
 };
 
 
@@ -287,7 +1736,23 @@ void RpgPlatformLog::Initialize(EVerbosity in_GlobalVerbosity, const char* opt_O
 	if (opt_OutputLogFilePath)
 	{
 		OutputFileHandle = CreateFileA(opt_OutputLogFilePath, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-		InitializeCriticalSection(&OutputFileCS);
+	}
+
+	Queue_Initialize();
+
+	WriterWakeEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+	bWriterRunning.store(true, std::memory_order_release);
+	WriterThread = WriterWakeEvent ? CreateThread(NULL, 0, Writer_Main, NULL, 0, NULL) : NULL;
+
+	if (WriterThread)
+	{
+		bAsync.store(true, std::memory_order_release);
+		PrevUnhandledExceptionFilter = SetUnhandledExceptionFilter(Log_UnhandledExceptionFilter);
+	}
+	else
+	{
+		bWriterRunning.store(false, std::memory_order_release);
+		OutputDebugStringA("WARNING: Failed to start log writer thread, log output is synchronous!\n");
 	}
 
 	bInitialized = true;
@@ -301,18 +1766,48 @@ void RpgPlatformLog::Shutdown() noexcept
 		return;
 	}
 
+	// New messages are written synchronously from now on
+	bAsync.store(false, std::memory_order_release);
+
+	if (WriterThread)
+	{
+		bWriterRunning.store(false, std::memory_order_release);
+		SetEvent(WriterWakeEvent);
+		WaitForSingleObject(WriterThread, INFINITE);
+		CloseHandle(WriterThread);
+		WriterThread = NULL;
+
+		SetUnhandledExceptionFilter(PrevUnhandledExceptionFilter);
+		PrevUnhandledExceptionFilter = nullptr;
+	}
+
+	if (WriterWakeEvent)
+	{
+		CloseHandle(WriterWakeEvent);
+		WriterWakeEvent = NULL;
+	}
+
+	Queue_Flush(RPG_LOG_FLUSH_TIMEOUT_MS);
+
 	if (OutputFileHandle)
 	{
 		CloseHandle(OutputFileHandle);
 		OutputFileHandle = NULL;
-
-		DeleteCriticalSection(&OutputFileCS);
 	}
 
 	bInitialized = false;
 }
 
 
+void RpgPlatformLog::Flush() noexcept
+{
+	if (bInitialized)
+	{
+		Queue_Flush(RPG_LOG_FLUSH_TIMEOUT_MS);
+	}
+}
+
+
 void RpgPlatformLog::SetGlobalVerbosity(EVerbosity in_Verbosity) noexcept
 {
 	GlobalVerbosity = in_Verbosity;
@@ -333,18 +1828,8 @@ void RpgPlatformLog::OutputMessage(RpgPlatformConsole::EOutputColor consoleOutpu
 		return;
 	}
 
-	OutputDebugString(message);
-
-	EnterCriticalSection(&OutputFileCS);
-
-	RpgPlatformConsole::OutputMessage(message, len, consoleOutputColor);
-
-	if (OutputFileHandle && OutputFileHandle != INVALID_HANDLE_VALUE)
-	{
-		WriteFile(OutputFileHandle, message, len, NULL, NULL);
-	}
-
-	LeaveCriticalSection(&OutputFileCS);
+	// Raw messages are used for errors and asserts, never dropped
+	Log_OutputText(consoleOutputColor, message, len, true);
 }
 
 
@@ -368,46 +1853,39 @@ void RpgPlatformLog::OutputMessageLogCategoryFormat(const FCategory& category, E
 		return;
 	}
 
-	char message[RPG_LOG_CATEGORY_MAX_FORMAT]{};
-
-	va_list args;
-	va_start(args, format);
-	vsnprintf(message, RPG_LOG_CATEGORY_MAX_FORMAT, format, args);
-	va_end(args);
-
-	RpgPlatformConsole::EOutputColor consoleOutputColor = RpgPlatformConsole::OUTPUT_COLOR_DEFAULT;
+	// Warning and error wait for free slot, debug and log are dropped when queue is full
+	const bool bBlockWhenFull = (verbosity >= VERBOSITY_WARN);
 
-	switch (verbosity)
+	if (bAsync.load(std::memory_order_acquire))
 	{
-		case VERBOSITY_DEBUG:
-		{
-			consoleOutputColor = RpgPlatformConsole::OUTPUT_COLOR_GREEN;
-			break;
-		}
+		uint8_t packed[RPG_LOG_MAX_OUTPUT_BUFFER];
+		int packedSize = 0;
 
-		case VERBOSITY_LOG:
-		{
-			consoleOutputColor = RpgPlatformConsole::OUTPUT_COLOR_DEFAULT;
-			break;
-		}
+		va_list args;
+		va_start(args, format);
+		const bool bPacked = Format_PackArgs(format, args, packed, RPG_LOG_MAX_OUTPUT_BUFFER, packedSize);
+		va_end(args);
 
-		case VERBOSITY_WARN:
+		if (bPacked)
 		{
-			consoleOutputColor = RpgPlatformConsole::OUTPUT_COLOR_YELLOW;
-			break;
+			Queue_Push(RECORD_CATEGORY, verbosity, RpgPlatformConsole::OUTPUT_COLOR_DEFAULT, category.Name, format, packed, static_cast<uint32_t>(packedSize), bBlockWhenFull);
+			return;
 		}
+	}
 
-		case VERBOSITY_ERROR:
-		{
-			consoleOutputColor = RpgPlatformConsole::OUTPUT_COLOR_RED;
-			break;
-		}
+	// Not initialized or arguments can not be packed, format on calling thread
+	char message[RPG_LOG_CATEGORY_MAX_FORMAT]{};
 
-		default:
-			break;
-	}
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, RPG_LOG_CATEGORY_MAX_FORMAT, format, args);
+	va_end(args);
+
+	char text[RPG_LOG_MAX_OUTPUT_BUFFER];
+	int length = snprintf(text, RPG_LOG_MAX_OUTPUT_BUFFER, "<%s>: %s\n", category.Name, message);
+	length = (length < RPG_LOG_MAX_OUTPUT_BUFFER) ? length : RPG_LOG_MAX_OUTPUT_BUFFER - 1;
 
-	OutputMessageFormat(consoleOutputColor, "<%s>: %s\n", category.Name, message);
+	Log_OutputText(GetVerbosityColor(verbosity), text, length, bBlockWhenFull);
 }
 
 
@@ -477,6 +1955,7 @@ void RpgPlatformProcess::Shutdown() noexcept
 
 void RpgPlatformProcess::Exit(uint32_t code) noexcept
 {
+	RpgPlatformLog::Flush();
 	ExitProcess(code);
 }
 
@@ -506,6 +1985,12 @@ uint32_t RpgPlatformProcess::GetMainThreadId() noexcept
 }
 
 
+void RpgPlatformProcess::Sleep(uint32_t milliseconds) noexcept
+{
+	::Sleep(milliseconds);
+}
+
+
 bool RpgPlatformProcess::IsMainThread() noexcept
 {
 	return GetCurrentThreadId() == MainThreadId;
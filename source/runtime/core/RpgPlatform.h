@@ -34,13 +34,106 @@ typedef volatile LONG	RpgAtomicInt;
 // ========================================================================================================================= //
 // PLATFORM - MEMORY
 // ========================================================================================================================= //
+// Track allocations made through RpgPlatformMemory per tag (live bytes, counts, peak, per-frame churn). Disabled in shipping build by default
+#ifndef RPG_MEMORY_TRACKING
+	#ifndef RPG_BUILD_SHIPPING
+		#define RPG_MEMORY_TRACKING	1
+	#else
+		#define RPG_MEMORY_TRACKING	0
+	#endif // !RPG_BUILD_SHIPPING
+#endif // !RPG_MEMORY_TRACKING
+
+
 namespace RpgPlatformMemory
 {
+	enum ETag : uint8_t
+	{
+		TAG_UNTAGGED = 0,
+		TAG_STRING,
+		TAG_LOG,
+		TAG_ASSET,
+		TAG_MESH,
+		TAG_TEXTURE,
+		TAG_WORLD,
+		TAG_ANIMATION,
+		TAG_PHYSICS,
+		TAG_RENDER,
+		TAG_GPU,
+		TAG_GUI,
+		TAG_FRAME_ARENA,
+		TAG_MAX_COUNT
+	};
+
+
+	struct FTagStats
+	{
+		// Currently allocated bytes
+		int64_t LiveBytes{ 0 };
+
+		// Highest live bytes sampled at frame boundary (see UpdateFrameStats)
+		int64_t PeakBytes{ 0 };
+
+		// Currently allocated count
+		int64_t LiveCount{ 0 };
+
+		// Total allocation/free count since start
+		uint64_t AllocCount{ 0 };
+		uint64_t FreeCount{ 0 };
+
+		// Allocated/freed bytes and allocation count during previous frame
+		uint64_t FrameAllocBytes{ 0 };
+		uint64_t FrameFreeBytes{ 0 };
+		uint64_t FrameAllocCount{ 0 };
+	};
+
+
+	struct FSnapshot
+	{
+		FTagStats Tags[TAG_MAX_COUNT];
+		FTagStats Total;
+	};
+
+
 	[[nodiscard]] extern void* MemMalloc(size_t sizeBytes) noexcept;
 	[[nodiscard]] extern void* MemMallocAligned(size_t sizeBytes, size_t alignmentBytes) noexcept;
 	[[nodiscard]] extern void* MemRealloc(void* prevAlloc, size_t newSizeBytes) noexcept;
 	[[nodiscard]] extern void* MemRecalloc(void* prevAlloc, int count, size_t sizeBytes) noexcept;
 	extern void MemFree(void* alloc) noexcept;
+
+
+	// Allocate memory attributed to <tag> instead of the current thread tag
+	[[nodiscard]] extern void* MemMallocTag(size_t sizeBytes, ETag tag) noexcept;
+	[[nodiscard]] extern void* MemMallocAlignedTag(size_t sizeBytes, size_t alignmentBytes, ETag tag) noexcept;
+	[[nodiscard]] extern void* MemReallocTag(void* prevAlloc, size_t newSizeBytes, ETag tag) noexcept;
+
+
+	// Set tag used by allocations of calling thread
+	// @param tag - Memory tag
+	// @returns Previous tag
+	extern ETag SetThreadTag(ETag tag) noexcept;
+
+
+	// Get tag used by allocations of calling thread
+	[[nodiscard]] extern ETag GetThreadTag() noexcept;
+
+
+	// Get tag name
+	[[nodiscard]] extern const char* GetTagName(ETag tag) noexcept;
+
+
+	// Sample peak and per-frame churn. Called once per frame by main thread
+	extern void UpdateFrameStats() noexcept;
+
+
+	// Get stats of all tags. Counters are gathered from each thread without locking, values are approximate while other threads allocate
+	// @param out_Snapshot - Output snapshot
+	// @returns None
+	extern void GetSnapshot(FSnapshot& out_Snapshot) noexcept;
+
+
+	// Print mimalloc process stats to log output
+	extern void OutputAllocatorStats() noexcept;
+
 	extern void MemCopy(void* dst, const void* src, size_t sizeBytes) noexcept;
 	extern void MemMove(void* dst, const void* src, size_t sizeBytes) noexcept;
 	extern void MemSet(void* data, int value, size_t sizeBytes) noexcept;
@@ -49,6 +142,31 @@ namespace RpgPlatformMemory
 }; // RpgPlatformMemory
 
 
+// Scoped memory tag for allocations of calling thread
+class RpgPlatformMemoryScopedTag
+{
+	RPG_NOCOPYMOVE(RpgPlatformMemoryScopedTag)
+
+public:
+	RpgPlatformMemoryScopedTag(RpgPlatformMemory::ETag tag) noexcept
+	{
+		PrevTag = RpgPlatformMemory::SetThreadTag(tag);
+	}
+
+	~RpgPlatformMemoryScopedTag() noexcept
+	{
+		RpgPlatformMemory::SetThreadTag(PrevTag);
+	}
+
+private:
+	RpgPlatformMemory::ETag PrevTag;
+
+};
+
+
+#define RPG_MEMORY_SCOPE_TAG(tag)	RpgPlatformMemoryScopedTag _rpgMemoryScopedTag(RpgPlatformMemory::tag)
+
+
 
 
 // ========================================================================================================================= //
@@ -63,7 +181,11 @@ namespace RpgPlatformString
 	extern void CStringToLower(char* cstr, int len) noexcept;
 	extern int CStringToInt(const char* cstr) noexcept;
 	extern float CStringToFloat(const char* cstr) noexcept;
-	extern uint64_t CStringHash(const char* cstr) noexcept;
+
+	// 64-bit hash (XXH3). If <bIgnoreCase> is true, characters are lowercased before hashing so equal strings under CStringCompare(bIgnoreCase=true) have equal hash
+	extern uint64_t CStringHash(const char* cstr, bool bIgnoreCase = false) noexcept;
+	extern uint64_t CStringHash(const char* cstr, int len, bool bIgnoreCase) noexcept;
+
 
 	extern int WStringLength(const wchar_t* wstr) noexcept;
 	extern void WStringToMultibyte(char* dst, const wchar_t* wstr, size_t maxBufferCount) noexcept;
@@ -98,6 +220,16 @@ namespace RpgPlatformConsole
 	// @returns None
 	extern void OutputMessage(const char* message, int messageLength, EOutputColor color) noexcept;
 
+
+	// Callback invoked on console interrupt (Ctrl+C, Ctrl+Break, console window close). Called from system thread, not from main thread
+	typedef void (*FInterruptCallback)();
+
+
+	// Set console interrupt callback, replaces default handler (process exit)
+	// @param callback - Interrupt callback, nullptr restores default handler
+	// @returns None
+	extern void SetInterruptCallback(FInterruptCallback callback) noexcept;
+
 }; // RpgPlatformConsole
 
 
@@ -110,6 +242,16 @@ namespace RpgPlatformConsole
 #define RPG_LOG_CATEGORY_NAME_LENGTH	32	// Includes null terminator
 #define RPG_LOG_CATEGORY_MAX_FORMAT		(RPG_LOG_MAX_OUTPUT_BUFFER - RPG_LOG_CATEGORY_NAME_LENGTH)
 
+// Log messages are pushed into bounded queue (lock-free, multi-producer) and written by background writer thread.
+// Queue memory is fixed (capacity * slot size). Arguments that does not fit into slot are heap allocated (up to RPG_LOG_MAX_OUTPUT_BUFFER).
+// When queue is full, debug and log messages are dropped (reported by writer), warning, error and raw messages wait for free slot.
+#define RPG_LOG_QUEUE_CAPACITY				2048	// Must be power of two
+#define RPG_LOG_QUEUE_SLOT_SIZE				512
+#define RPG_LOG_OUTPUT_FILE_BUFFER_SIZE		(64 * 1024)
+#define RPG_LOG_WRITER_WAIT_MS				100
+#define RPG_LOG_FLUSH_TIMEOUT_MS			5000
+#define RPG_LOG_CRASH_FLUSH_TIMEOUT_MS		1000
+
 
 namespace RpgPlatformLog
 {
@@ -132,10 +274,23 @@ namespace RpgPlatformLog
 
 	extern void Initialize(EVerbosity in_GlobalVerbosity, const char* opt_OutputLogFilePath = nullptr) noexcept;
 	extern void Shutdown() noexcept;
+
+
+	// Write all queued messages before returning. Called on exit and unhandled exception
+	extern void Flush() noexcept;
+
+
 	extern void SetGlobalVerbosity(EVerbosity in_Verbosity) noexcept;
 	extern EVerbosity GetGlobalVerbosity() noexcept;
 	extern void OutputMessage(RpgPlatformConsole::EOutputColor consoleOutputColor, const char* message) noexcept;
 	extern void OutputMessageFormat(RpgPlatformConsole::EOutputColor consoleOutputColor, const char* format, ...) noexcept;
+
+	// Queue category message. Formatting is deferred to writer thread, only the format pointer is stored.
+	// Format must be a string literal (or have static storage duration), use RPG_Log macros which only accept string literal
+	// @param category - Log category
+	// @param verbosity - Message verbosity
+	// @param format - Format string with static storage duration
+	// @returns None
 	extern void OutputMessageLogCategoryFormat(const FCategory& category, EVerbosity verbosity, const char* format, ...) noexcept;
 
 }; // RpgPlatformLog
@@ -154,15 +309,16 @@ RpgPlatformLog::FCategory catName{#catName, RpgPlatformLog::defaultVerbosity};
 static_assert(sizeof(#catName) <= RPG_LOG_CATEGORY_NAME_LENGTH, "Exceeds maximum log category name length!");
 
 
+// Format is concatenated with empty literal, so passing non-literal format (which may not outlive deferred formatting) fails to compile
 #ifndef RPG_BUILD_SHIPPING
-	#define RPG_LogDebug(category, format, ...)	RpgPlatformLog::OutputMessageLogCategoryFormat(category, RpgPlatformLog::VERBOSITY_DEBUG, format, __VA_ARGS__)
+	#define RPG_LogDebug(category, format, ...)	RpgPlatformLog::OutputMessageLogCategoryFormat(category, RpgPlatformLog::VERBOSITY_DEBUG, "" format, __VA_ARGS__)
 #else
 	#define RPG_LogDebug(category, format, ...)
 #endif // !RPG_BUILD_SHIPPING
 
-#define RPG_Log(category, format, ...)		RpgPlatformLog::OutputMessageLogCategoryFormat(category, RpgPlatformLog::VERBOSITY_LOG, format, __VA_ARGS__)
-#define RPG_LogWarn(category, format, ...)	RpgPlatformLog::OutputMessageLogCategoryFormat(category, RpgPlatformLog::VERBOSITY_WARN, format, __VA_ARGS__)
-#define RPG_LogError(category, format, ...)	RpgPlatformLog::OutputMessageLogCategoryFormat(category, RpgPlatformLog::VERBOSITY_ERROR, format, __VA_ARGS__)
+#define RPG_Log(category, format, ...)		RpgPlatformLog::OutputMessageLogCategoryFormat(category, RpgPlatformLog::VERBOSITY_LOG, "" format, __VA_ARGS__)
+#define RPG_LogWarn(category, format, ...)	RpgPlatformLog::OutputMessageLogCategoryFormat(category, RpgPlatformLog::VERBOSITY_WARN, "" format, __VA_ARGS__)
+#define RPG_LogError(category, format, ...)	RpgPlatformLog::OutputMessageLogCategoryFormat(category, RpgPlatformLog::VERBOSITY_ERROR, "" format, __VA_ARGS__)
 
 
 RPG_LOG_DECLARE_CATEGORY_EXTERN(RpgLogTemp)
@@ -185,6 +341,12 @@ namespace RpgPlatformProcess
 	extern uint32_t GetMainThreadId() noexcept;
 
 
+	// Suspend calling thread
+	// @param milliseconds - Minimum sleep duration
+	// @returns None
+	extern void Sleep(uint32_t milliseconds) noexcept;
+
+
 	// Check if function running on main thread
 	// @returns True if running on main thread
 	extern bool IsMainThread() noexcept;
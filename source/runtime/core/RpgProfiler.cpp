@@ -0,0 +1,306 @@
+#include "RpgProfiler.h"
+
+#if RPG_PROFILER_ENABLED
+#include "RpgFilePath.h"
+#include <atomic>
+
+
+// Number of oldest ring buffer slots skipped when thread buffer wrapped during capture.
+// Reserves room for events other threads keep writing while the buffer is exported, so exported slots are not overwritten mid-read
+#define RPG_PROFILER_WRAP_READ_SLACK		64
+
+
+
+namespace RpgProfiler
+{
+	struct FEvent
+	{
+		const char* Name;
+		uint64_t BeginTimestamp;
+		uint64_t EndTimestamp;
+	};
+
+
+	struct FThreadBuffer
+	{
+		FEvent Events[RPG_PROFILER_THREAD_MAX_EVENT];
+
+		// Total events written. Only owner thread writes
+		std::atomic<uint64_t> WriteCount{ 0 };
+
+		// Write count when current capture started
+		uint64_t CaptureStartCount;
+
+		const char* Name;
+		int Index;
+	};
+
+
+	RpgAtomicInt CaptureState;
+
+	static FThreadBuffer* ThreadBuffers[RPG_PROFILER_MAX_THREAD];
+	static std::atomic<int> ThreadBufferCount;
+	static thread_local FThreadBuffer* ThisThreadBuffer = nullptr;
+	static thread_local const char* ThisThreadName = nullptr;
+
+	static uint64_t TimestampFrequency;
+
+	// Main thread only
+	static int RequestedCaptureFrameCount;
+	static int CaptureFrameCount;
+	static int CapturedFrameCount;
+	static uint64_t CaptureStartTimestamp;
+	static uint64_t CaptureCounter;
+
+
+
+	static FThreadBuffer* GetThreadBuffer() noexcept
+	{
+		if (ThisThreadBuffer)
+		{
+			return ThisThreadBuffer;
+		}
+
+		const int index = ThreadBufferCount.fetch_add(1, std::memory_order_acq_rel);
+		if (index >= RPG_PROFILER_MAX_THREAD)
+		{
+			return nullptr;
+		}
+
+		void* bufferMemory = RpgPlatformMemory::MemMalloc(sizeof(FThreadBuffer));
+		RPG_Check(bufferMemory);
+
+		FThreadBuffer* buffer = new (bufferMemory) FThreadBuffer();
+		buffer->CaptureStartCount = 0;
+		buffer->Name = ThisThreadName;
+		buffer->Index = index;
+
+		ThisThreadBuffer = buffer;
+
+		std::atomic_thread_fence(std::memory_order_release);
+		ThreadBuffers[index] = buffer;
+
+		return buffer;
+	}
+
+
+	static inline int GetThreadBufferCount() noexcept
+	{
+		const int count = ThreadBufferCount.load(std::memory_order_acquire);
+		return (count < RPG_PROFILER_MAX_THREAD) ? count : RPG_PROFILER_MAX_THREAD;
+	}
+
+
+	static void Json_AppendFormat(RpgArray<char>& out_Json, const char* format, ...) noexcept
+	{
+		char temp[256];
+
+		va_list args;
+		va_start(args, format);
+		const int length = vsnprintf(temp, sizeof(temp), format, args);
+		va_end(args);
+
+		if (length > 0)
+		{
+			out_Json.InsertAtRange(temp, (length < static_cast<int>(sizeof(temp))) ? length : static_cast<int>(sizeof(temp)) - 1, RPG_INDEX_LAST);
+		}
+	}
+
+
+	static void ExportCapture(uint64_t captureEndTimestamp) noexcept
+	{
+		const double tickToMicroseconds = 1000000.0 / static_cast<double>(TimestampFrequency);
+		const int threadCount = GetThreadBufferCount();
+
+		RpgArray<char> json;
+		json.Reserve(1024 * 1024);
+
+		Json_AppendFormat(json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+		int eventCount = 0;
+
+		for (int t = 0; t < threadCount; ++t)
+		{
+			const FThreadBuffer* buffer = ThreadBuffers[t];
+			if (buffer == nullptr)
+			{
+				continue;
+			}
+
+			Json_AppendFormat(json, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+				(eventCount > 0) ? ",\n" : "", buffer->Index, buffer->Name ? buffer->Name : "Thread"
+			);
+			++eventCount;
+
+			Json_AppendFormat(json, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"sort_index\":%i}}", buffer->Index, buffer->Index);
+
+			const uint64_t writeCount = buffer->WriteCount.load(std::memory_order_acquire);
+			uint64_t readIndex = buffer->CaptureStartCount;
+
+			// Ring buffer wrapped during capture. Skip oldest events, they may be overwritten by late scopes while reading
+			if (writeCount - readIndex > RPG_PROFILER_THREAD_MAX_EVENT)
+			{
+				readIndex = writeCount - RPG_PROFILER_THREAD_MAX_EVENT + RPG_PROFILER_WRAP_READ_SLACK;
+				RPG_LogWarn(RpgLogSystem, "Profiler: Thread (%s) overflows event buffer, oldest events are dropped", buffer->Name ? buffer->Name : "Thread");
+			}
+
+			for (; readIndex < writeCount; ++readIndex)
+			{
+				const FEvent& e = buffer->Events[readIndex % RPG_PROFILER_THREAD_MAX_EVENT];
+
+				if (e.BeginTimestamp < CaptureStartTimestamp || e.EndTimestamp > captureEndTimestamp)
+				{
+					continue;
+				}
+
+				Json_AppendFormat(json, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+					e.Name, buffer->Index, (e.BeginTimestamp - CaptureStartTimestamp) * tickToMicroseconds, (e.EndTimestamp - e.BeginTimestamp) * tickToMicroseconds
+				);
+				++eventCount;
+			}
+		}
+
+		Json_AppendFormat(json, "\n]}\n");
+
+
+		const RpgString dirPath = RpgFileSystem::GetProjectDirPath() + "__profile/";
+
+		if (!RpgPlatformFile::FolderExists(*dirPath))
+		{
+			RpgPlatformFile::FolderCreate(*dirPath);
+		}
+
+		const RpgString filePath = RpgString::Format("%strace_%llu.json", *dirPath, CaptureCounter++);
+
+		if (RpgFileSystem::WriteToFile(filePath, json.GetData(), json.GetMemorySizeBytes_Allocated()))
+		{
+			RPG_Log(RpgLogSystem, "Profiler: Exported %i frames (%i events) to %s", CapturedFrameCount, eventCount, *filePath);
+		}
+		else
+		{
+			RPG_LogError(RpgLogSystem, "Profiler: Failed to write %s", *filePath);
+		}
+	}
+
+};
+
+
+uint64_t RpgProfiler::GetTimestamp() noexcept
+{
+	LARGE_INTEGER li;
+	QueryPerformanceCounter(&li);
+
+	return static_cast<uint64_t>(li.QuadPart);
+}
+
+
+void RpgProfiler::SetThreadName(const char* name) noexcept
+{
+	ThisThreadName = name;
+
+	if (ThisThreadBuffer)
+	{
+		ThisThreadBuffer->Name = name;
+	}
+}
+
+
+void RpgProfiler::AddEvent(const char* name, uint64_t beginTimestamp, uint64_t endTimestamp) noexcept
+{
+	FThreadBuffer* buffer = GetThreadBuffer();
+	if (buffer == nullptr)
+	{
+		return;
+	}
+
+	const uint64_t writeCount = buffer->WriteCount.load(std::memory_order_relaxed);
+
+	FEvent& e = buffer->Events[writeCount % RPG_PROFILER_THREAD_MAX_EVENT];
+	e.Name = name ? name : "Unnamed";
+	e.BeginTimestamp = beginTimestamp;
+	e.EndTimestamp = endTimestamp;
+
+	buffer->WriteCount.store(writeCount + 1, std::memory_order_release);
+}
+
+
+void RpgProfiler::RequestCapture(int frameCount) noexcept
+{
+	RPG_IsMainThread();
+
+	if (frameCount < 1)
+	{
+		frameCount = 1;
+	}
+	else if (frameCount > RPG_PROFILER_MAX_CAPTURE_FRAME)
+	{
+		frameCount = RPG_PROFILER_MAX_CAPTURE_FRAME;
+	}
+
+	RequestedCaptureFrameCount = frameCount;
+}
+
+
+void RpgProfiler::EndFrame() noexcept
+{
+	RPG_IsMainThread();
+
+	if (IsCapturing())
+	{
+		++CapturedFrameCount;
+
+		if (CapturedFrameCount >= CaptureFrameCount)
+		{
+			const uint64_t captureEndTimestamp = GetTimestamp();
+			InterlockedExchange(&CaptureState, 0);
+
+			ExportCapture(captureEndTimestamp);
+		}
+	}
+	else if (RequestedCaptureFrameCount > 0)
+	{
+		if (TimestampFrequency == 0)
+		{
+			LARGE_INTEGER li;
+			QueryPerformanceFrequency(&li);
+			TimestampFrequency = static_cast<uint64_t>(li.QuadPart);
+		}
+
+		const int threadCount = GetThreadBufferCount();
+
+		for (int t = 0; t < threadCount; ++t)
+		{
+			FThreadBuffer* buffer = ThreadBuffers[t];
+
+			if (buffer)
+			{
+				buffer->CaptureStartCount = buffer->WriteCount.load(std::memory_order_acquire);
+			}
+		}
+
+		CaptureFrameCount = RequestedCaptureFrameCount;
+		CapturedFrameCount = 0;
+		RequestedCaptureFrameCount = 0;
+		CaptureStartTimestamp = GetTimestamp();
+
+		InterlockedExchange(&CaptureState, 1);
+
+		RPG_Log(RpgLogSystem, "Profiler: Capture %i frames", CaptureFrameCount);
+	}
+}
+
+
+void RpgProfiler::Shutdown() noexcept
+{
+	InterlockedExchange(&CaptureState, 0);
+
+	const int threadCount = GetThreadBufferCount();
+
+	for (int t = 0; t < threadCount; ++t)
+	{
+		RpgPlatformMemory::MemFree(ThreadBuffers[t]);
+		ThreadBuffers[t] = nullptr;
+	}
+}
+
+#endif // RPG_PROFILER_ENABLED
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "RpgPlatform.h"
+
+
+#ifndef RPG_BUILD_SHIPPING
+#define RPG_PROFILER_ENABLED	1
+#else
+#define RPG_PROFILER_ENABLED	0
+#endif // !RPG_BUILD_SHIPPING
+
+
+
+#if RPG_PROFILER_ENABLED
+
+// Maximum events recorded per thread. Ring buffer, oldest events are overwritten
+#define RPG_PROFILER_THREAD_MAX_EVENT		(1 << 15)
+
+// Maximum threads that can record events
+#define RPG_PROFILER_MAX_THREAD				64
+
+// Maximum frames in single capture
+#define RPG_PROFILER_MAX_CAPTURE_FRAME		300
+
+
+
+namespace RpgProfiler
+{
+	// Non-zero while capturing. Read by scopes without locking
+	extern RpgAtomicInt CaptureState;
+
+
+	inline bool IsCapturing() noexcept
+	{
+		return CaptureState != 0;
+	}
+
+
+	[[nodiscard]] extern uint64_t GetTimestamp() noexcept;
+
+
+	// Set name of calling thread shown in trace
+	// @param name - Thread name. Must stay valid until shutdown (static string)
+	// @returns None
+	extern void SetThreadName(const char* name) noexcept;
+
+
+	// Record event into ring buffer of calling thread. Lock-free, only calling thread writes to its buffer
+	// @param name - Event name. Must stay valid until capture is exported (static string)
+	// @param beginTimestamp - Timestamp from GetTimestamp
+	// @param endTimestamp - Timestamp from GetTimestamp
+	// @returns None
+	extern void AddEvent(const char* name, uint64_t beginTimestamp, uint64_t endTimestamp) noexcept;
+
+
+	// Request capture for <frameCount> frames starting from next frame. When finished, trace is exported to <ProjectDir>/__profile/ as chrome trace event JSON (chrome://tracing, ui.perfetto.dev)
+	// @param frameCount - Number of frames to capture
+	// @returns None
+	extern void RequestCapture(int frameCount) noexcept;
+
+
+	// Mark end of frame. Starts, advances and finishes capture. Must be called by main thread
+	extern void EndFrame() noexcept;
+
+
+	extern void Shutdown() noexcept;
+
+};
+
+
+
+class RpgProfilerScope
+{
+	RPG_NOCOPYMOVE(RpgProfilerScope)
+
+public:
+	RpgProfilerScope(const char* in_Name) noexcept
+		: Name(in_Name)
+		, BeginTimestamp(0)
+		, bRecord(RpgProfiler::IsCapturing())
+	{
+		if (bRecord)
+		{
+			BeginTimestamp = RpgProfiler::GetTimestamp();
+		}
+	}
+
+	~RpgProfilerScope() noexcept
+	{
+		if (bRecord)
+		{
+			RpgProfiler::AddEvent(Name, BeginTimestamp, RpgProfiler::GetTimestamp());
+		}
+	}
+
+private:
+	const char* Name;
+	uint64_t BeginTimestamp;
+	bool bRecord;
+
+};
+
+
+#define RPG_PROFILE_CONCAT_INNER(a, b)		a##b
+#define RPG_PROFILE_CONCAT(a, b)			RPG_PROFILE_CONCAT_INNER(a, b)
+
+// Profile current scope. <name> must be static string
+#define RPG_PROFILE_SCOPE(name)				RpgProfilerScope RPG_PROFILE_CONCAT(_rpgProfileScope, __LINE__)(name)
+
+#define RPG_PROFILE_THREAD_NAME(name)		RpgProfiler::SetThreadName(name)
+
+#else
+
+#define RPG_PROFILE_SCOPE(name)
+#define RPG_PROFILE_THREAD_NAME(name)
+
+#endif // RPG_PROFILER_ENABLED
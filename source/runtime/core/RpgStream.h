@@ -23,8 +23,8 @@ public:
 	}
 
 
-	template<typename T, int N>
-	inline void WriteArray(const RpgArray<T, N>& dataArray) noexcept
+	template<typename T, int N, typename TAllocator>
+	inline void WriteArray(const RpgArray<T, N, TAllocator>& dataArray) noexcept
 	{
 		int count = dataArray.GetCount();
 		WriteData(&count, sizeof(int));
@@ -72,8 +72,20 @@ public:
 	RpgStreamReader() noexcept = default;
 	virtual ~RpgStreamReader() noexcept = default;
 	virtual void Reset() noexcept = 0;
+
+	// Read <dataSizeBytes> into <outData>. Reading past the end of stream zero-fills <outData> and sets error flag
 	virtual void ReadData(void* outData, uint32_t dataSizeBytes) noexcept = 0;
 
+	// @returns Number of bytes left to read
+	[[nodiscard]] virtual size_t GetRemainingByteSize() const noexcept = 0;
+
+
+	// @returns True if any read went past the end of stream
+	[[nodiscard]] inline bool HasError() const noexcept
+	{
+		return bError;
+	}
+
 
 	template<typename T>
 	inline void Read(T& data) noexcept
@@ -83,12 +95,18 @@ public:
 	}
 
 
-	template<typename T, int N>
-	inline void ReadArray(RpgArray<T, N>& dataArray) noexcept
+	template<typename T, int N, typename TAllocator>
+	inline void ReadArray(RpgArray<T, N, TAllocator>& dataArray) noexcept
 	{
 		int count = 0;
 		ReadData(&count, sizeof(int));
 
+		if (count > 0 && static_cast<size_t>(count) * sizeof(T) > GetRemainingByteSize())
+		{
+			SetError();
+			return;
+		}
+
 		if (count > 0)
 		{
 			const int index = dataArray.GetCount();
@@ -108,6 +126,12 @@ public:
 		int count = 0;
 		ReadData(&count, sizeof(int));
 
+		if (count > 0 && (count > N - dataArray.GetCount() || static_cast<size_t>(count) * sizeof(T) > GetRemainingByteSize()))
+		{
+			SetError();
+			return;
+		}
+
 		if (count > 0)
 		{
 			const int index = dataArray.GetCount();
@@ -126,10 +150,14 @@ public:
 		int length = 0;
 		ReadData(&length, sizeof(int));
 
-		if (length > 0)
+		if (length >= RPG_STRING_FORMAT_BUFFER_COUNT || static_cast<size_t>(length) > GetRemainingByteSize())
 		{
-			RPG_Check(length < RPG_STRING_FORMAT_BUFFER_COUNT);
+			SetError();
+			return;
+		}
 
+		if (length > 0)
+		{
 			char temp[RPG_STRING_FORMAT_BUFFER_COUNT];
 			RpgPlatformMemory::MemZero(temp, RPG_STRING_FORMAT_BUFFER_COUNT);
 			ReadData(temp, length);
@@ -139,6 +167,17 @@ public:
 		}
 	}
 
+
+protected:
+	inline void SetError() noexcept
+	{
+		bError = true;
+	}
+
+
+protected:
+	bool bError{ false };
+
 };
 
 
@@ -198,6 +237,7 @@ public:
 		: Bytes(std::move(other.Bytes))
 		, Offset(other.Offset)
 	{
+		bError = other.bError;
 	}
 
 
@@ -205,14 +245,28 @@ public:
 	{
 		Bytes.Clear();
 		Offset = 0;
+		bError = false;
 	}
 
 	virtual void ReadData(void* outData, uint32_t dataSizeBytes) noexcept override
 	{
+		if (dataSizeBytes > GetRemainingByteSize())
+		{
+			RpgPlatformMemory::MemZero(outData, dataSizeBytes);
+			Offset = Bytes.GetCount();
+			SetError();
+			return;
+		}
+
 		RpgPlatformMemory::MemCopy(outData, Bytes.GetData() + Offset, dataSizeBytes);
 		Offset += dataSizeBytes;
 	}
 
+	virtual size_t GetRemainingByteSize() const noexcept override
+	{
+		return Bytes.GetCount() - Offset;
+	}
+
 
 	inline const uint8_t* GetByteData() const noexcept
 	{
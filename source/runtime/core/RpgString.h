@@ -361,7 +361,7 @@ private:
 
 
 private:
-	RpgArray<char, 16> CharArray;
+	RpgArray<char, 16, RpgAllocatorTagged<RpgPlatformMemory::TAG_STRING>> CharArray;
 
 
 public:
@@ -503,5 +503,6 @@ public:
 
 inline uint64_t Rpg_GetHash(const RpgName& value) noexcept
 {
-	return RpgPlatformString::CStringHash(*value);
+	// Name compares ignore case
+	return RpgPlatformString::CStringHash(*value, true);
 }
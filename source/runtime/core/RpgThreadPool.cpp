@@ -1,106 +1,696 @@
 #include "RpgThreadPool.h"
+#include "RpgProfiler.h"
 #include "dsa/RpgArray.h"
+#include <atomic>
 
 
 
+#if RPG_THREAD_POOL_BACKEND_STD
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <immintrin.h>
+#endif // RPG_THREAD_POOL_BACKEND_STD
+
+
+// Maximum number of tasks in each worker local queue. When local queue is full, task will be pushed into shared queue
+#define RPG_THREAD_POOL_LOCAL_QUEUE_CAPACITY	1024
+
+#define RPG_THREAD_POOL_MAX_WORKER				32
+
+// Number of pause iterations before waiting thread start yielding
+#define RPG_THREAD_POOL_WAIT_SPIN_COUNT			64
+
+// Number of yields before waiting thread parks
+#define RPG_THREAD_POOL_WAIT_YIELD_COUNT		8
+
+// Parked waiting thread wakes up after this timeout to check for new tasks to help
+#define RPG_THREAD_POOL_WAIT_PARK_TIMEOUT_MS	1
+
+
+
+// ========================================================================================================================= //
+// THREAD POOL - BACKEND
+// ========================================================================================================================= //
 namespace RpgThreadPool
 {
-	class FTaskQueue
+	namespace Backend
 	{
-	private:
-		RpgArray<RpgThreadTask*, 8> Pool;
-		CRITICAL_SECTION CS;
+	#if RPG_THREAD_POOL_BACKEND_STD
+		class FMutex
+		{
+		public:
+			inline void Lock() noexcept { Mutex.lock(); }
+			inline void Unlock() noexcept { Mutex.unlock(); }
+
+		private:
+			std::mutex Mutex;
+		};
+
+
+		class FSemaphore
+		{
+		public:
+			FSemaphore() noexcept : Semaphore(0) {}
+			inline void Acquire() noexcept { Semaphore.acquire(); }
+			inline void Release(int count) noexcept { Semaphore.release(count); }
 
+		private:
+			std::counting_semaphore<UINT16_MAX> Semaphore;
+		};
+
+
+		struct FThread
+		{
+			std::thread Thread;
+		};
+
+
+		template<typename TFunction, typename TParam>
+		inline void ThreadStart(FThread& thread, TFunction function, TParam* param) noexcept
+		{
+			thread.Thread = std::thread(function, param);
+		}
+
+		inline void ThreadJoin(FThread& thread) noexcept
+		{
+			if (thread.Thread.joinable())
+			{
+				thread.Thread.join();
+			}
+		}
+
+		inline int GetProcessorCount() noexcept
+		{
+			return static_cast<int>(std::thread::hardware_concurrency());
+		}
+
+		inline uint64_t GetTimestamp() noexcept
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		inline double GetTimestampFrequency() noexcept
+		{
+			return 1000000000.0;
+		}
+
+		inline void Pause() noexcept
+		{
+		#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+			_mm_pause();
+		#endif
+		}
+
+		inline void YieldThread() noexcept
+		{
+			std::this_thread::yield();
+		}
+
+		// std::atomic wait has no timeout. Emulate wait on address with condition variables keyed on address hash
+		#define RPG_THREAD_POOL_PARK_BUCKET_COUNT	64
+
+		struct FParkBucket
+		{
+			std::mutex Mutex;
+			std::condition_variable Condition;
+		};
+
+		inline FParkBucket& GetParkBucket(const std::atomic<LONG>* address) noexcept
+		{
+			static FParkBucket Buckets[RPG_THREAD_POOL_PARK_BUCKET_COUNT];
+			return Buckets[(reinterpret_cast<uintptr_t>(address) / sizeof(LONG)) % RPG_THREAD_POOL_PARK_BUCKET_COUNT];
+		}
+
+		inline void ParkOnAddress(FAtomicInt& value, LONG compareValue, uint32_t timeoutMs) noexcept
+		{
+			std::atomic<LONG>* address = value.GetAddress();
+			FParkBucket& bucket = GetParkBucket(address);
+			std::unique_lock<std::mutex> lock(bucket.Mutex);
+
+			// Value is re-checked under bucket lock. Waker takes the same lock before notify, so the wake can not be lost
+			bucket.Condition.wait_for(lock, std::chrono::milliseconds(timeoutMs), [address, compareValue]() { return address->load() != compareValue; });
+		}
+
+		inline void WakeAddress(FAtomicInt& value) noexcept
+		{
+			FParkBucket& bucket = GetParkBucket(value.GetAddress());
+			{
+				std::lock_guard<std::mutex> lock(bucket.Mutex);
+			}
+
+			// Bucket can be shared by different addresses, wake all and let each waiter re-check its own value
+			bucket.Condition.notify_all();
+		}
+
+	#else
+		class FMutex
+		{
+		public:
+			FMutex() noexcept { InitializeCriticalSection(&CS); }
+			~FMutex() noexcept { DeleteCriticalSection(&CS); }
+			inline void Lock() noexcept { EnterCriticalSection(&CS); }
+			inline void Unlock() noexcept { LeaveCriticalSection(&CS); }
+
+		private:
+			CRITICAL_SECTION CS;
+		};
+
+
+		class FSemaphore
+		{
+		public:
+			FSemaphore() noexcept { Handle = CreateSemaphoreA(NULL, 0, UINT16_MAX, NULL); }
+			~FSemaphore() noexcept { CloseHandle(Handle); }
+			inline void Acquire() noexcept { WaitForSingleObject(Handle, INFINITE); }
+			inline void Release(int count) noexcept { ReleaseSemaphore(Handle, count, NULL); }
+
+		private:
+			HANDLE Handle;
+		};
+
+
+		struct FThread
+		{
+			HANDLE Handle{ NULL };
+		};
+
+
+		template<typename TParam>
+		inline void ThreadStart(FThread& thread, void(*function)(TParam*), TParam* param) noexcept
+		{
+			struct FStartup
+			{
+				static DWORD WINAPI Main(_In_ LPVOID lpParameter)
+				{
+					// Function pointer is stored in first member of <TParam>
+					TParam* param = reinterpret_cast<TParam*>(lpParameter);
+					param->EntryFunction(param);
+
+					return 0;
+				}
+			};
+
+			param->EntryFunction = function;
+			thread.Handle = CreateThread(NULL, 0, FStartup::Main, param, 0, NULL);
+		}
+
+		inline void ThreadJoin(FThread& thread) noexcept
+		{
+			if (thread.Handle)
+			{
+				WaitForSingleObject(thread.Handle, INFINITE);
+				CloseHandle(thread.Handle);
+				thread.Handle = NULL;
+			}
+		}
+
+		inline int GetProcessorCount() noexcept
+		{
+			SYSTEM_INFO systemInfo{};
+			GetSystemInfo(&systemInfo);
+
+			return static_cast<int>(systemInfo.dwNumberOfProcessors);
+		}
+
+		inline uint64_t GetTimestamp() noexcept
+		{
+			LARGE_INTEGER li;
+			QueryPerformanceCounter(&li);
+
+			return static_cast<uint64_t>(li.QuadPart);
+		}
+
+		inline double GetTimestampFrequency() noexcept
+		{
+			LARGE_INTEGER li;
+			QueryPerformanceFrequency(&li);
+
+			return static_cast<double>(li.QuadPart);
+		}
+
+		inline void Pause() noexcept
+		{
+			YieldProcessor();
+		}
+
+		inline void YieldThread() noexcept
+		{
+			SwitchToThread();
+		}
+
+		inline void ParkOnAddress(FAtomicInt& value, LONG compareValue, uint32_t timeoutMs) noexcept
+		{
+			WaitOnAddress(value.GetAddress(), &compareValue, sizeof(LONG), timeoutMs);
+		}
+
+		inline void WakeAddress(FAtomicInt& value) noexcept
+		{
+			WakeByAddressAll((PVOID)value.GetAddress());
+		}
+
+	#endif // RPG_THREAD_POOL_BACKEND_STD
+
+	}; // Backend
+
+}; // RpgThreadPool
+
+
+
+
+// ========================================================================================================================= //
+// THREAD POOL - QUEUE
+// ========================================================================================================================= //
+namespace RpgThreadPool
+{
+	// Bounded work-stealing deque (Chase-Lev).
+	// Only the owner thread can Push/Pop at the bottom (LIFO), any other thread can Steal from the top (FIFO).
+	class FLocalQueue
+	{
+		RPG_NOCOPYMOVE(FLocalQueue)
 
 	public:
-		FTaskQueue() noexcept
+		static constexpr int64_t CAPACITY = RPG_THREAD_POOL_LOCAL_QUEUE_CAPACITY;
+		static constexpr int64_t MASK = CAPACITY - 1;
+		static_assert(RpgAlgorithm::IsPowerOfTwo(CAPACITY), "RpgThreadPool: Local queue capacity must be power of two!");
+
+
+	public:
+		FLocalQueue() noexcept
+			: Top(0)
+			, Bottom(0)
+			, Tasks()
+		{
+		}
+
+
+		// [Owner thread] Push task at bottom
+		// @returns False if queue is full
+		inline bool Push(RpgThreadTask* task) noexcept
+		{
+			const int64_t bottom = Bottom.load(std::memory_order_relaxed);
+			const int64_t top = Top.load(std::memory_order_acquire);
+
+			if (bottom - top >= CAPACITY)
+			{
+				return false;
+			}
+
+			Tasks[bottom & MASK].store(task, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+			return true;
+		}
+
+
+		// [Owner thread] Pop task from bottom (most recently pushed)
+		// @returns Task or nullptr if queue is empty
+		inline RpgThreadTask* Pop() noexcept
+		{
+			const int64_t bottom = Bottom.load(std::memory_order_relaxed) - 1;
+			Bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = Top.load(std::memory_order_relaxed);
+
+			if (top > bottom)
+			{
+				// Empty
+				Bottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			RpgThreadTask* task = Tasks[bottom & MASK].load(std::memory_order_relaxed);
+
+			if (top == bottom)
+			{
+				// Last task, race against thieves
+				if (!Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					task = nullptr;
+				}
+
+				Bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+
+			return task;
+		}
+
+
+		// [Any thread] Steal task from top (least recently pushed)
+		// @returns Task or nullptr if queue is empty or lost the race
+		inline RpgThreadTask* Steal() noexcept
 		{
-			InitializeCriticalSection(&CS);
+			int64_t top = Top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t bottom = Bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+			{
+				return nullptr;
+			}
+
+			RpgThreadTask* task = Tasks[top & MASK].load(std::memory_order_relaxed);
+
+			if (!Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+
+			return task;
 		}
 
-		~FTaskQueue() noexcept
+
+		inline int GetCount() const noexcept
 		{
-			DeleteCriticalSection(&CS);
+			const int64_t count = Bottom.load(std::memory_order_relaxed) - Top.load(std::memory_order_relaxed);
+			return count > 0 ? static_cast<int>(count) : 0;
 		}
 
-		inline void PushTasks(RpgThreadTask** tasks, int count) noexcept
+
+	private:
+		alignas(64) std::atomic<int64_t> Top;
+		alignas(64) std::atomic<int64_t> Bottom;
+		alignas(64) std::atomic<RpgThreadTask*> Tasks[CAPACITY];
+
+	};
+
+
+
+	// Shared FIFO ring queue for tasks submitted from threads that do not own local queue (render thread, etc)
+	class FSharedQueue
+	{
+		RPG_NOCOPYMOVE(FSharedQueue)
+
+	public:
+		FSharedQueue() noexcept
+			: Head(0)
+			, Count(0)
+			, AtomicCount(0)
 		{
-			EnterCriticalSection(&CS);
-			Pool.InsertAtRange(tasks, count, RPG_INDEX_LAST);
-			LeaveCriticalSection(&CS);
 		}
 
+
+		inline void PushTasks(RpgThreadTask** tasks, int taskCount) noexcept
+		{
+			Mutex.Lock();
+
+			if (Count + taskCount > Pool.GetCount())
+			{
+				Grow(Count + taskCount);
+			}
+
+			const int capacity = Pool.GetCount();
+
+			for (int i = 0; i < taskCount; ++i)
+			{
+				Pool[(Head + Count + i) % capacity] = tasks[i];
+			}
+
+			Count += taskCount;
+			AtomicCount.store(Count, std::memory_order_release);
+
+			Mutex.Unlock();
+		}
+
+
 		inline RpgThreadTask* PopTask() noexcept
 		{
-			EnterCriticalSection(&CS);
+			// Avoid taking the lock when queue is empty
+			if (AtomicCount.load(std::memory_order_acquire) == 0)
+			{
+				return nullptr;
+			}
+
 			RpgThreadTask* task = nullptr;
+			Mutex.Lock();
 
-			if (Pool.GetCount() > 0)
+			if (Count > 0)
 			{
-				task = Pool[0];
-				Pool.RemoveAt(0);
+				task = Pool[Head];
+				Head = (Head + 1) % Pool.GetCount();
+				--Count;
+				AtomicCount.store(Count, std::memory_order_release);
 			}
 
-			LeaveCriticalSection(&CS);
+			Mutex.Unlock();
 
 			return task;
 		}
 
+
+		inline int GetCount() const noexcept
+		{
+			return AtomicCount.load(std::memory_order_relaxed);
+		}
+
+
+	private:
+		inline void Grow(int minCapacity) noexcept
+		{
+			const int prevCapacity = Pool.GetCount();
+			int newCapacity = prevCapacity > 0 ? prevCapacity * 2 : 64;
+
+			while (newCapacity < minCapacity)
+			{
+				newCapacity *= 2;
+			}
+
+			// Unwrap ring into linear order
+			RpgArray<RpgThreadTask*> newPool(newCapacity);
+
+			for (int i = 0; i < Count; ++i)
+			{
+				newPool[i] = Pool[(Head + i) % prevCapacity];
+			}
+
+			Pool = std::move(newPool);
+			Head = 0;
+		}
+
+
+	private:
+		Backend::FMutex Mutex;
+		RpgArray<RpgThreadTask*> Pool;
+		int Head;
+		int Count;
+		std::atomic<int> AtomicCount;
+
 	};
 
+}; // RpgThreadPool
+
 
-	static HANDLE SignalSemaphore;
-	static FTaskQueue TaskQueue;
 
 
+// ========================================================================================================================= //
+// THREAD POOL - WORKER
+// ========================================================================================================================= //
+namespace RpgThreadPool
+{
 	struct FThreadWorker
 	{
-		char Name[32];
-		HANDLE Handle{ nullptr };
-		RpgAtomicInt IsRunning{};
+		// Must be first member (see Backend::ThreadStart)
+		void(*EntryFunction)(FThreadWorker*){ nullptr };
+
+		char Name[32]{};
+		int Index{ RPG_INDEX_INVALID };
+		Backend::FThread Thread;
+		std::atomic<bool> bRunning{ false };
+
+		// Random state for selecting steal victim
+		uint32_t RandomState{ 0 };
+
+		// Counters. Only written by the owner worker
+		std::atomic<uint64_t> ExecutedTaskCount{ 0 };
+		std::atomic<uint64_t> StealCount{ 0 };
+		std::atomic<uint64_t> StealFailCount{ 0 };
+		std::atomic<uint64_t> IdleTicks{ 0 };
 	};
-	static RpgArrayInline<FThreadWorker, 32> ThreadWorkers;
 
+
+	static FThreadWorker* ThreadWorkers;
+	static int ThreadWorkerCount;
+
+	// Local queues, one per worker thread plus one for main thread at index [ThreadWorkerCount]
+	static FLocalQueue* LocalQueues;
+	static int LocalQueueCount;
+
+	static FSharedQueue* SharedQueue;
+	static Backend::FSemaphore* SignalSemaphore;
+	static std::atomic<int> SleepingWorkerCount;
+	static double TimestampFrequency;
 	static bool bInitialized;
 
+	// Index of local queue owned by current thread, or RPG_INDEX_INVALID if current thread does not own any queue
+	static thread_local int ThisThreadLocalQueueIndex = RPG_INDEX_INVALID;
+
+	// Worker owned by current thread or nullptr if current thread is not worker thread
+	static thread_local FThreadWorker* ThisThreadWorker = nullptr;
+
+	// Random state for selecting steal victim when current thread is not worker thread
+	static thread_local uint32_t ThisThreadRandomState = 0x2545F491u;
+
+	// Counters accumulated by RpgThreadTask::Wait
+	static std::atomic<uint64_t> WaitWastedTicks;
+	static std::atomic<uint64_t> WaitHelpTicks;
+	static std::atomic<uint64_t> WaitHelpTaskCount;
+	static std::atomic<uint64_t> WaitParkCount;
+
+
 
-	static DWORD ThreadWorker_Main(_In_ LPVOID lpParameter)
+	static inline uint32_t RandomNext(uint32_t& state) noexcept
 	{
-		RpgThreadPool::FThreadWorker* worker = reinterpret_cast<RpgThreadPool::FThreadWorker*>(lpParameter);
+		// xorshift32
+		uint32_t x = state;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		state = x;
 
-		while (worker->IsRunning)
+		return x;
+	}
+
+
+	// Find task for the calling thread
+	// @param localQueueIndex - Local queue owned by the calling thread or RPG_INDEX_INVALID
+	// @param randomState - Random state for selecting steal victim
+	// @param worker - Worker to record steal counters or nullptr if calling thread is not worker thread
+	// @returns Task or nullptr if there's nothing to execute
+	static RpgThreadTask* FindTask(int localQueueIndex, uint32_t& randomState, FThreadWorker* worker) noexcept
+	{
+		RpgThreadTask* task = nullptr;
+
+		// Local queue first (LIFO, hot in cache)
+		if (localQueueIndex != RPG_INDEX_INVALID)
 		{
-			WaitForSingleObject(SignalSemaphore, INFINITE);
+			task = LocalQueues[localQueueIndex].Pop();
 
-			// Check if should exit
-			if (!worker->IsRunning)
+			if (task)
 			{
-				break;
+				return task;
 			}
+		}
 
-			RpgThreadTask* task = TaskQueue.PopTask();
+		// Shared queue
+		task = SharedQueue->PopTask();
+
+		if (task)
+		{
+			return task;
+		}
+
+		// Steal from other queues starting at random victim
+		const bool bOwnQueue = (localQueueIndex != RPG_INDEX_INVALID);
+		const int victimCount = bOwnQueue ? LocalQueueCount - 1 : LocalQueueCount;
+
+		if (victimCount > 0)
+		{
+			const int start = static_cast<int>(RandomNext(randomState) % static_cast<uint32_t>(victimCount));
 
-			while (task)
+			for (int i = 0; i < victimCount; ++i)
 			{
-				//RPG_PLATFORM_LogDebug(RpgLogSystem, "%s execute task %s", threadName, task->GetTaskName());
-				task->Execute();
-				task->SetDone();
+				int victim = (start + i) % victimCount;
 
-				// Check if should exit
-				if (!worker->IsRunning)
+				// Skip own queue
+				if (bOwnQueue && victim >= localQueueIndex)
 				{
-					break;
+					++victim;
 				}
 
-				task = TaskQueue.PopTask();
+				task = LocalQueues[victim].Steal();
+
+				if (task)
+				{
+					if (worker)
+					{
+						worker->StealCount.fetch_add(1, std::memory_order_relaxed);
+					}
+
+					return task;
+				}
+			}
+
+			if (worker)
+			{
+				worker->StealFailCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		return nullptr;
+	}
+
+
+	static inline void ExecuteTask(FThreadWorker* worker, RpgThreadTask* task) noexcept
+	{
+		//RPG_LogDebug(RpgLogSystem, "%s execute task %s", worker->Name, task->GetTaskName());
+		{
+			// Task may be stolen by a waiting thread inside its own memory tag scope. Allocations of the task must not be charged to that tag
+			RPG_MEMORY_SCOPE_TAG(TAG_UNTAGGED);
+			RPG_PROFILE_SCOPE(task->GetTaskName());
+			task->Execute();
+		}
+
+		task->SetDone();
+
+		if (worker)
+		{
+			worker->ExecutedTaskCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+
+	static void ThreadWorker_Main(FThreadWorker* worker)
+	{
+		ThisThreadLocalQueueIndex = worker->Index;
+		ThisThreadWorker = worker;
+		RPG_PROFILE_THREAD_NAME(worker->Name);
+
+		while (worker->bRunning.load(std::memory_order_acquire))
+		{
+			RpgThreadTask* task = FindTask(worker->Index, worker->RandomState, worker);
+
+			if (task)
+			{
+				ExecuteTask(worker, task);
+				continue;
+			}
+
+			// Announce going to sleep, then check again so a concurrent submit will not be missed
+			SleepingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+
+			task = FindTask(worker->Index, worker->RandomState, worker);
+
+			if (task)
+			{
+				SleepingWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+				ExecuteTask(worker, task);
+				continue;
 			}
 
-			//RPG_PLATFORM_LogDebug(RpgLogSystem, "%s back to wait", threadName);
+			const uint64_t idleStart = Backend::GetTimestamp();
+			SignalSemaphore->Acquire();
+			worker->IdleTicks.fetch_add(Backend::GetTimestamp() - idleStart, std::memory_order_relaxed);
+
+			SleepingWorkerCount.fetch_sub(1, std::memory_order_relaxed);
 		}
 
 		RPG_Log(RpgLogSystem, "%s exit", worker->Name);
+	}
 
-		return 0;
+
+	static inline void WakeWorkers(int taskCount) noexcept
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int sleepingCount = SleepingWorkerCount.load(std::memory_order_relaxed);
+		const int wakeCount = (taskCount < sleepingCount) ? taskCount : sleepingCount;
+
+		if (wakeCount > 0)
+		{
+			SignalSemaphore->Release(wakeCount);
+		}
 	}
 
 };
@@ -112,35 +702,50 @@ void RpgThreadPool::Initialize(int numOtherDedicatedThreads) noexcept
 	{
 		return;
 	}
-	
-	SYSTEM_INFO systemInfo{};
-	GetSystemInfo(&systemInfo);
 
-	const int cpuCount = systemInfo.dwNumberOfProcessors;
+	const int cpuCount = Backend::GetProcessorCount();
 	RPG_RuntimeErrorCheck(cpuCount >= 4, "CPU must have at least 4 cores!");
 
 	// Exclude dedicated threads and main thread
-	const int numThreadWorkers = cpuCount - numOtherDedicatedThreads - 1;
+	int numThreadWorkers = cpuCount - numOtherDedicatedThreads - 1;
 	RPG_Validate(numThreadWorkers > 1);
 
+	if (numThreadWorkers > RPG_THREAD_POOL_MAX_WORKER)
+	{
+		numThreadWorkers = RPG_THREAD_POOL_MAX_WORKER;
+	}
+
 	RPG_Log(RpgLogSystem, "Initialize threadpool with %i worker threads", numThreadWorkers);
 
-	SignalSemaphore = CreateSemaphoreA(NULL, 0, UINT16_MAX, NULL);
-	ThreadWorkers.Resize(numThreadWorkers);
+	TimestampFrequency = Backend::GetTimestampFrequency();
+	SleepingWorkerCount.store(0, std::memory_order_relaxed);
+
+	SignalSemaphore = new Backend::FSemaphore();
+	SharedQueue = new FSharedQueue();
 
-	for (int i = 0; i < numThreadWorkers; ++i)
+	LocalQueueCount = numThreadWorkers + 1;
+	LocalQueues = new FLocalQueue[LocalQueueCount];
+
+	// Thread that initialize threadpool (main thread) owns the last local queue
+	ThisThreadLocalQueueIndex = numThreadWorkers;
+
+	ThreadWorkerCount = numThreadWorkers;
+	ThreadWorkers = new FThreadWorker[ThreadWorkerCount];
+
+	for (int i = 0; i < ThreadWorkerCount; ++i)
 	{
 		FThreadWorker& worker = ThreadWorkers[i];
 		snprintf(worker.Name, 32, "Thread-Worker-%i", i);
-		worker.IsRunning = 1;
-		worker.Handle = CreateThread(NULL, 0, ThreadWorker_Main, &worker, CREATE_SUSPENDED, NULL);
+		worker.Index = i;
+		worker.RandomState = 0x9E3779B9u * static_cast<uint32_t>(i + 1);
+		worker.bRunning.store(true, std::memory_order_relaxed);
 	}
 
-	for (int i = 0; i < numThreadWorkers; ++i)
+	for (int i = 0; i < ThreadWorkerCount; ++i)
 	{
-		ResumeThread(ThreadWorkers[i].Handle);
+		Backend::ThreadStart(ThreadWorkers[i].Thread, ThreadWorker_Main, &ThreadWorkers[i]);
 	}
-	
+
 	bInitialized = true;
 }
 
@@ -154,24 +759,31 @@ void RpgThreadPool::Shutdown() noexcept
 
 	RPG_Log(RpgLogSystem, "Shutdown threadpool");
 
-	for (int t = 0; t < ThreadWorkers.GetCount(); ++t)
+	for (int t = 0; t < ThreadWorkerCount; ++t)
 	{
-		FThreadWorker& worker = ThreadWorkers[t];
-		InterlockedExchange(&worker.IsRunning, 0);
+		ThreadWorkers[t].bRunning.store(false, std::memory_order_release);
 	}
 
-	ReleaseSemaphore(SignalSemaphore, ThreadWorkers.GetCount(), NULL);
+	SignalSemaphore->Release(ThreadWorkerCount);
 
-	for (int t = 0; t < ThreadWorkers.GetCount(); ++t)
+	for (int t = 0; t < ThreadWorkerCount; ++t)
 	{
-		FThreadWorker& worker = ThreadWorkers[t];
-		WaitForSingleObject(worker.Handle, INFINITE);
-		CloseHandle(worker.Handle);
+		Backend::ThreadJoin(ThreadWorkers[t].Thread);
 	}
 
-	ThreadWorkers.Clear();
+	delete[] ThreadWorkers;
+	ThreadWorkers = nullptr;
+	ThreadWorkerCount = 0;
 
-	CloseHandle(SignalSemaphore);
+	delete[] LocalQueues;
+	LocalQueues = nullptr;
+	LocalQueueCount = 0;
+	ThisThreadLocalQueueIndex = RPG_INDEX_INVALID;
+
+	delete SharedQueue;
+	SharedQueue = nullptr;
+
+	delete SignalSemaphore;
 	SignalSemaphore = nullptr;
 
 	bInitialized = false;
@@ -189,7 +801,361 @@ void RpgThreadPool::SubmitTasks(RpgThreadTask** tasks, int taskCount) noexcept
 		task->SetRunning();
 	}
 
-	TaskQueue.PushTasks(tasks, taskCount);
+	const int localQueueIndex = ThisThreadLocalQueueIndex;
+
+	if (localQueueIndex == RPG_INDEX_INVALID)
+	{
+		SharedQueue->PushTasks(tasks, taskCount);
+	}
+	else
+	{
+		FLocalQueue& localQueue = LocalQueues[localQueueIndex];
+
+		for (int i = 0; i < taskCount; ++i)
+		{
+			if (!localQueue.Push(tasks[i]))
+			{
+				// Local queue is full, push the rest into shared queue
+				SharedQueue->PushTasks(tasks + i, taskCount - i);
+				break;
+			}
+		}
+	}
+
+	WakeWorkers(taskCount);
+}
+
+
+int RpgThreadPool::GetWorkerCount() noexcept
+{
+	return ThreadWorkerCount;
+}
+
+
+void RpgThreadPool::GetWorkerStats(int workerIndex, FWorkerStats& out_Stats) noexcept
+{
+	RPG_Check(workerIndex >= 0 && workerIndex < ThreadWorkerCount);
+
+	const FThreadWorker& worker = ThreadWorkers[workerIndex];
+	out_Stats.ExecutedTaskCount = worker.ExecutedTaskCount.load(std::memory_order_relaxed);
+	out_Stats.StealCount = worker.StealCount.load(std::memory_order_relaxed);
+	out_Stats.StealFailCount = worker.StealFailCount.load(std::memory_order_relaxed);
+	out_Stats.IdleTimeMs = static_cast<float>(worker.IdleTicks.load(std::memory_order_relaxed) * 1000.0 / TimestampFrequency);
+	out_Stats.QueueDepth = LocalQueues[workerIndex].GetCount();
+}
+
+
+void RpgThreadPool::GetStats(FStats& out_Stats) noexcept
+{
+	out_Stats = FStats();
+	out_Stats.WorkerCount = ThreadWorkerCount;
+
+	if (!bInitialized)
+	{
+		return;
+	}
+
+	for (int i = 0; i < ThreadWorkerCount; ++i)
+	{
+		FWorkerStats workerStats;
+		GetWorkerStats(i, workerStats);
+
+		out_Stats.ExecutedTaskCount += workerStats.ExecutedTaskCount;
+		out_Stats.StealCount += workerStats.StealCount;
+		out_Stats.StealFailCount += workerStats.StealFailCount;
+		out_Stats.IdleTimeMs += workerStats.IdleTimeMs;
+		out_Stats.QueueDepth += workerStats.QueueDepth;
+	}
+
+	// Main thread local queue
+	out_Stats.QueueDepth += LocalQueues[ThreadWorkerCount].GetCount();
+	out_Stats.SharedQueueDepth = SharedQueue->GetCount();
+}
+
+
+void RpgThreadPool::ResetStats() noexcept
+{
+	for (int i = 0; i < ThreadWorkerCount; ++i)
+	{
+		FThreadWorker& worker = ThreadWorkers[i];
+		worker.ExecutedTaskCount.store(0, std::memory_order_relaxed);
+		worker.StealCount.store(0, std::memory_order_relaxed);
+		worker.StealFailCount.store(0, std::memory_order_relaxed);
+		worker.IdleTicks.store(0, std::memory_order_relaxed);
+	}
+}
+
+
+bool RpgThreadPool::TryExecuteTask() noexcept
+{
+	if (!bInitialized)
+	{
+		return false;
+	}
+
+	FThreadWorker* worker = ThisThreadWorker;
+	RpgThreadTask* task = FindTask(ThisThreadLocalQueueIndex, worker ? worker->RandomState : ThisThreadRandomState, worker);
+
+	if (task)
+	{
+		ExecuteTask(worker, task);
+		return true;
+	}
+
+	return false;
+}
+
+
+void RpgThreadPool::GetWaitStats(FWaitStats& out_Stats, bool bReset) noexcept
+{
+	uint64_t wastedTicks = 0;
+	uint64_t helpTicks = 0;
+
+	if (bReset)
+	{
+		wastedTicks = WaitWastedTicks.exchange(0, std::memory_order_relaxed);
+		helpTicks = WaitHelpTicks.exchange(0, std::memory_order_relaxed);
+		out_Stats.HelpTaskCount = WaitHelpTaskCount.exchange(0, std::memory_order_relaxed);
+		out_Stats.ParkCount = WaitParkCount.exchange(0, std::memory_order_relaxed);
+	}
+	else
+	{
+		wastedTicks = WaitWastedTicks.load(std::memory_order_relaxed);
+		helpTicks = WaitHelpTicks.load(std::memory_order_relaxed);
+		out_Stats.HelpTaskCount = WaitHelpTaskCount.load(std::memory_order_relaxed);
+		out_Stats.ParkCount = WaitParkCount.load(std::memory_order_relaxed);
+	}
+
+	const double frequency = bInitialized ? TimestampFrequency : Backend::GetTimestampFrequency();
+	out_Stats.WastedTimeMs = static_cast<float>(wastedTicks * 1000.0 / frequency);
+	out_Stats.HelpTimeMs = static_cast<float>(helpTicks * 1000.0 / frequency);
+}
+
+
+
+
+// ========================================================================================================================= //
+// THREAD POOL - PARALLEL FOR
+// ========================================================================================================================= //
+namespace RpgThreadPool
+{
+	struct FParallelForContext
+	{
+		FParallelForFunction Function;
+		void* UserData;
+		int Count;
+		int ChunkSize;
+		alignas(64) std::atomic<int> NextIndex;
+	};
+
+
+	// Claim and process chunks until range exhausted
+	static inline void ParallelForContext_Run(FParallelForContext* context) noexcept
+	{
+		const int count = context->Count;
+		const int chunkSize = context->ChunkSize;
+
+		int begin = context->NextIndex.fetch_add(chunkSize, std::memory_order_relaxed);
+
+		while (begin < count)
+		{
+			const int end = (begin + chunkSize < count) ? begin + chunkSize : count;
+			context->Function(context->UserData, begin, end);
+
+			begin = context->NextIndex.fetch_add(chunkSize, std::memory_order_relaxed);
+		}
+	}
+
+
+	class FParallelForTask : public RpgThreadTask
+	{
+	public:
+		FParallelForContext* Context{ nullptr };
+
+	public:
+		virtual void Execute() noexcept override
+		{
+			ParallelForContext_Run(Context);
+		}
+
+		virtual const char* GetTaskName() const noexcept override
+		{
+			return "RpgThreadPool_ParallelFor";
+		}
+	};
+
+};
+
+
+void RpgThreadPool::ParallelForDispatch(int count, int minChunkSize, FParallelForFunction function, void* userData) noexcept
+{
+	RPG_Assert(function);
+
+	if (count <= 0)
+	{
+		return;
+	}
+
+	if (minChunkSize < 1)
+	{
+		minChunkSize = 1;
+	}
+
+	// Execute serial if threadpool not initialized or range is too small to split
+	if (!bInitialized || count <= minChunkSize)
+	{
+		function(userData, 0, count);
+		return;
+	}
+
+	// Target few chunks per thread (workers + calling thread) for dynamic load balancing
+	const int threadCount = ThreadWorkerCount + 1;
+	int chunkSize = (count + threadCount * 4 - 1) / (threadCount * 4);
+
+	if (chunkSize < minChunkSize)
+	{
+		chunkSize = minChunkSize;
+	}
+
+	const int chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	// Calling thread processes at least one chunk
+	int helperCount = chunkCount - 1;
+
+	if (helperCount > ThreadWorkerCount)
+	{
+		helperCount = ThreadWorkerCount;
+	}
+
+	FParallelForContext context;
+	context.Function = function;
+	context.UserData = userData;
+	context.Count = count;
+	context.ChunkSize = chunkSize;
+	context.NextIndex.store(0, std::memory_order_relaxed);
+
+	FParallelForTask helperTasks[RPG_THREAD_POOL_MAX_WORKER];
+	RpgThreadTask* submitTasks[RPG_THREAD_POOL_MAX_WORKER];
+
+	for (int i = 0; i < helperCount; ++i)
+	{
+		helperTasks[i].Context = &context;
+		submitTasks[i] = &helperTasks[i];
+	}
+
+	if (helperCount > 0)
+	{
+		SubmitTasks(submitTasks, helperCount);
+	}
+
+	ParallelForContext_Run(&context);
+
+	// Helpers that have not started yet are executed by this thread while waiting (they find no chunk left and exit)
+	for (int i = 0; i < helperCount; ++i)
+	{
+		helperTasks[i].Wait();
+	}
+}
+
+
+
+
+// ========================================================================================================================= //
+// THREAD TASK
+// ========================================================================================================================= //
+void RpgThreadTask::SetDone() noexcept
+{
+	State.Store(2);
+
+	// Store above is sequentially consistent. Either waiter sees the done state before parking, or we see the waiter here
+	if (WaiterCount.Load() > 0)
+	{
+		RpgThreadPool::Backend::WakeAddress(State);
+	}
+}
+
+
+void RpgThreadTask::Wait() noexcept
+{
+	if (State.Load() != 1)
+	{
+		RPG_Assert(State.Load() == 2);
+		return;
+	}
+
+	WaitUntilDone();
+}
+
+
+void RpgThreadTask::WaitUntilDone() noexcept
+{
+	if (State.Load() == 2)
+	{
+		return;
+	}
+
+	using namespace RpgThreadPool;
+
+	const uint64_t waitStart = Backend::GetTimestamp();
+	uint64_t helpTicks = 0;
+	uint64_t helpTaskCount = 0;
+	uint64_t parkCount = 0;
+	int backoff = 0;
+
+	while (State.Load() != 2)
+	{
+		// Help executing other tasks, the task we are waiting may be one of them
+		const uint64_t helpStart = Backend::GetTimestamp();
+
+		if (TryExecuteTask())
+		{
+			helpTicks += Backend::GetTimestamp() - helpStart;
+			++helpTaskCount;
+			backoff = 0;
 
-	ReleaseSemaphore(SignalSemaphore, taskCount, NULL);
+			continue;
+		}
+
+		if (backoff < RPG_THREAD_POOL_WAIT_SPIN_COUNT)
+		{
+			// Exponential pause
+			for (int i = 0; i <= backoff && State.Load() != 2; ++i)
+			{
+				Backend::Pause();
+			}
+
+			backoff = (backoff == 0) ? 1 : backoff * 2;
+		}
+		else if (backoff < RPG_THREAD_POOL_WAIT_SPIN_COUNT + RPG_THREAD_POOL_WAIT_YIELD_COUNT)
+		{
+			Backend::YieldThread();
+			++backoff;
+		}
+		else
+		{
+			// Park until done. Timeout to check for new tasks to help (idle task is not woken when submitted)
+			const LONG state = State.Load();
+			WaiterCount.Increment();
+			Backend::ParkOnAddress(State, state, RPG_THREAD_POOL_WAIT_PARK_TIMEOUT_MS);
+			WaiterCount.Decrement();
+
+			++parkCount;
+		}
+	}
+
+	RPG_Assert(State.Load() == 2);
+
+	const uint64_t waitTicks = Backend::GetTimestamp() - waitStart;
+	WaitWastedTicks.fetch_add(waitTicks > helpTicks ? waitTicks - helpTicks : 0, std::memory_order_relaxed);
+
+	if (helpTaskCount > 0)
+	{
+		WaitHelpTicks.fetch_add(helpTicks, std::memory_order_relaxed);
+		WaitHelpTaskCount.fetch_add(helpTaskCount, std::memory_order_relaxed);
+	}
+
+	if (parkCount > 0)
+	{
+		WaitParkCount.fetch_add(parkCount, std::memory_order_relaxed);
+	}
 }
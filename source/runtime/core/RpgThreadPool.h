@@ -1,6 +1,77 @@
 #pragma once
 
 #include "RpgPlatform.h"
+#include "dsa/RpgArray.h"
+#include "dsa/RpgFreeList.h"
+
+
+// Default minimum number of elements processed per chunk in ParallelFor
+#define RPG_THREAD_POOL_PARALLEL_FOR_MIN_CHUNK	16
+
+// Arrays smaller than this are radix sorted on calling thread only
+#define RPG_THREAD_POOL_PARALLEL_SORT_MIN_COUNT	65536
+
+
+// Set to 1 to use std::thread backend instead of native Win32 threads (always used on non-Windows platform)
+#ifndef RPG_THREAD_POOL_BACKEND_STD
+	#ifdef _WIN32
+		#define RPG_THREAD_POOL_BACKEND_STD	0
+	#else
+		#define RPG_THREAD_POOL_BACKEND_STD	1
+	#endif // _WIN32
+#endif // !RPG_THREAD_POOL_BACKEND_STD
+
+
+#if RPG_THREAD_POOL_BACKEND_STD
+#include <atomic>
+#endif // RPG_THREAD_POOL_BACKEND_STD
+
+
+
+namespace RpgThreadPool
+{
+	namespace Backend
+	{
+		// Atomic integer of thread task state. Every operation is sequentially consistent
+		// (SetDone and Wait rely on it: either waiter sees done state before parking, or SetDone sees the waiter)
+		class FAtomicInt
+		{
+			RPG_NOCOPYMOVE(FAtomicInt)
+
+		public:
+			FAtomicInt() noexcept
+				: Value(0)
+			{
+			}
+
+		#if RPG_THREAD_POOL_BACKEND_STD
+			[[nodiscard]] inline LONG Load() const noexcept { return Value.load(); }
+			inline void Store(LONG value) noexcept { Value.store(value); }
+			inline LONG Increment() noexcept { return Value.fetch_add(1) + 1; }
+			inline LONG Decrement() noexcept { return Value.fetch_sub(1) - 1; }
+
+			// Used by ParkOnAddress/WakeAddress
+			[[nodiscard]] inline std::atomic<LONG>* GetAddress() noexcept { return &Value; }
+
+		private:
+			std::atomic<LONG> Value;
+		#else
+			[[nodiscard]] inline LONG Load() const noexcept { return Value; }
+			inline void Store(LONG value) noexcept { InterlockedExchange(&Value, value); }
+			inline LONG Increment() noexcept { return InterlockedIncrement(&Value); }
+			inline LONG Decrement() noexcept { return InterlockedDecrement(&Value); }
+
+			// Used by ParkOnAddress/WakeAddress
+			[[nodiscard]] inline volatile LONG* GetAddress() noexcept { return &Value; }
+
+		private:
+			volatile LONG Value;
+		#endif // RPG_THREAD_POOL_BACKEND_STD
+		};
+
+	}; // Backend
+
+}; // RpgThreadPool
 
 
 
@@ -11,6 +82,7 @@ class RpgThreadTask
 public:
 	RpgThreadTask() noexcept
 		: State()
+		, WaiterCount()
 	{
 	}
 
@@ -21,8 +93,8 @@ public:
 
 	virtual void Reset() noexcept
 	{
-		RPG_AssertV(State != 1, "Cannot reset while it's still running!");
-		InterlockedExchange(&State, 0);
+		RPG_AssertV(State.Load() != 1, "Cannot reset while it's still running!");
+		State.Store(0);
 	}
 
 	virtual void Execute() noexcept = 0;
@@ -32,47 +104,49 @@ public:
 	// Called by threadpool when submit task. Do not call this manually!
 	inline void SetRunning() noexcept
 	{
-		InterlockedExchange(&State, 1);
+		State.Store(1);
 	}
 
-	// Called by threadpool worker thread when task finish executed. Do not call this manually
-	inline void SetDone() noexcept
-	{
-		InterlockedExchange(&State, 2);
-	}
+	// Called by threadpool worker thread when task finish executed. Wakes any thread parked in Wait. Do not call this manually
+	void SetDone() noexcept;
 
 
 	// [Block] Wait until task finished.
+	// While waiting, the calling thread executes other queued tasks from threadpool. When there's nothing to execute, it backs off (pause, yield) then parks until task finished.
 	// @returns None
-	inline void Wait() noexcept
-	{
-		while (State == 1);
-		RPG_Assert(State == 2);
-	}
+	void Wait() noexcept;
+
+	// [Block] Wait until task finished. Same as Wait, but task may still be idle (not submitted yet),
+	// eg. task submitted by another task once its dependencies finished
+	// @returns None
+	void WaitUntilDone() noexcept;
 
 
 	// Check if task is in idle state
 	inline bool IsIdle() const noexcept
 	{
-		return State == 0;
+		return State.Load() == 0;
 	}
 
 	// Check if task is in running state (submitted or probably being executed by worker thread)
 	inline bool IsRunning() const noexcept
 	{
-		return State == 1;
+		return State.Load() == 1;
 	}
 
 	// Check if task is done (worker thread has finished execute this task)
 	inline bool IsDone() const noexcept
 	{
-		return State == 2;
+		return State.Load() == 2;
 	}
 
 
 private:
 	// [0]: Idle, [1]: Running, [2]: Done
-	RpgAtomicInt State;
+	RpgThreadPool::Backend::FAtomicInt State;
+
+	// Number of threads parked in Wait
+	RpgThreadPool::Backend::FAtomicInt WaiterCount;
 
 };
 
@@ -91,6 +165,58 @@ for (int __i = 0; __i < taskCount; ++__i)				\
 
 namespace RpgThreadPool
 {
+	struct FWorkerStats
+	{
+		// Number of tasks executed by this worker
+		uint64_t ExecutedTaskCount{ 0 };
+
+		// Number of tasks taken from other worker queues
+		uint64_t StealCount{ 0 };
+
+		// Number of steal rounds that found every other queue empty
+		uint64_t StealFailCount{ 0 };
+
+		// Total time spent sleeping while waiting for tasks
+		float IdleTimeMs{ 0.0f };
+
+		// Number of tasks currently in worker local queue
+		int QueueDepth{ 0 };
+	};
+
+
+	struct FStats
+	{
+		uint64_t ExecutedTaskCount{ 0 };
+		uint64_t StealCount{ 0 };
+		uint64_t StealFailCount{ 0 };
+		float IdleTimeMs{ 0.0f };
+
+		// Number of tasks currently in all worker local queues
+		int QueueDepth{ 0 };
+
+		// Number of tasks currently in shared queue (submitted from non-worker threads)
+		int SharedQueueDepth{ 0 };
+
+		int WorkerCount{ 0 };
+	};
+
+
+	struct FWaitStats
+	{
+		// Time spent in RpgThreadTask::Wait not executing any task (spinning, yielding, parked)
+		float WastedTimeMs{ 0.0f };
+
+		// Time spent in RpgThreadTask::Wait executing other tasks
+		float HelpTimeMs{ 0.0f };
+
+		// Number of tasks executed by waiting threads
+		uint64_t HelpTaskCount{ 0 };
+
+		// Number of times waiting thread parked
+		uint64_t ParkCount{ 0 };
+	};
+
+
 	// Initialize thread pool with number worker threads at max (NumCore - numOtherDedicatedThreads - 1) depends on if there's dedicated render/audio thread
 	// @param numOtherDedicatedThreads - Number of other dedicated threads
 	// @returns None
@@ -103,6 +229,8 @@ namespace RpgThreadPool
 
 
 	// Submit task. 
+	// Tasks submitted from worker thread or main thread are pushed into the local queue of the calling thread (executed LIFO, stolen FIFO by other workers).
+	// Tasks submitted from any other thread are pushed into shared queue.
 	// @param task - Task to submit
 	// @returns None
 	void SubmitTasks(RpgThreadTask** tasks, int taskCount) noexcept;
@@ -115,8 +243,285 @@ namespace RpgThreadPool
 	//void WaitAllTasks(RpgThreadTask** tasks, int taskCount) noexcept;
 
 
+	// Get number of worker threads
+	// @returns Worker thread count
+	[[nodiscard]] int GetWorkerCount() noexcept;
+
+
+	// Get scheduler counters for specific worker thread
+	// @param workerIndex - Worker index [0, GetWorkerCount())
+	// @param out_Stats - Output stats
+	// @returns None
+	void GetWorkerStats(int workerIndex, FWorkerStats& out_Stats) noexcept;
+
+
+	// Get scheduler counters accumulated from all worker threads
+	// @param out_Stats - Output stats
+	// @returns None
+	void GetStats(FStats& out_Stats) noexcept;
+
+
+	// Reset accumulated counters (executed, steal, idle time) of all worker threads
+	// @returns None
+	void ResetStats() noexcept;
+
+
+	// Get counters accumulated by RpgThreadTask::Wait from all threads
+	// @param out_Stats - Output stats
+	// @param bReset - Reset counters after read (call once per frame to get per-frame values)
+	// @returns None
+	void GetWaitStats(FWaitStats& out_Stats, bool bReset = false) noexcept;
+
+
+	// Execute one queued task on the calling thread if any
+	// @returns True if a task was executed
+	bool TryExecuteTask() noexcept;
+
+
+	// Chunk function used by ParallelFor. Process elements in range [begin, end)
+	typedef void(*FParallelForFunction)(void* userData, int begin, int end);
+
+
+	// [Block] Process range [0, count) in chunks distributed over worker threads. Calling thread also processes chunks.
+	// Chunks are claimed dynamically (atomic counter) so uneven workloads are balanced. No heap allocation.
+	// Prefer ParallelFor/ParallelForRange/ParallelForEach templates below.
+	// @param count - Number of elements
+	// @param minChunkSize - Minimum number of elements per chunk
+	// @param function - Chunk function
+	// @param userData - User data passed into <function>
+	// @returns None
+	void ParallelForDispatch(int count, int minChunkSize, FParallelForFunction function, void* userData) noexcept;
+
+
+	// [Block] Call function(int begin, int end) for chunks of range [0, count)
+	template<typename TFunction>
+	inline void ParallelForRange(int count, TFunction&& function, int minChunkSize = RPG_THREAD_POOL_PARALLEL_FOR_MIN_CHUNK) noexcept
+	{
+		typedef typename std::remove_reference<TFunction>::type FFunctionType;
+
+		struct FInvoker
+		{
+			static void Invoke(void* userData, int begin, int end) noexcept
+			{
+				(*static_cast<FFunctionType*>(userData))(begin, end);
+			}
+		};
+
+		ParallelForDispatch(count, minChunkSize, &FInvoker::Invoke, const_cast<void*>(static_cast<const void*>(&function)));
+	}
+
+
+	// [Block] Call function(int index) for each index in range [0, count)
+	template<typename TFunction>
+	inline void ParallelFor(int count, TFunction&& function, int minChunkSize = RPG_THREAD_POOL_PARALLEL_FOR_MIN_CHUNK) noexcept
+	{
+		ParallelForRange(count, 
+			[&function](int begin, int end)
+			{
+				for (int i = begin; i < end; ++i)
+				{
+					function(i);
+				}
+			}
+			, minChunkSize
+		);
+	}
+
+
+	// [Block] Call function(T& element) for each element in array
+	template<typename T, int N, typename TAllocator, typename TFunction>
+	inline void ParallelForEach(RpgArray<T, N, TAllocator>& array, TFunction&& function, int minChunkSize = RPG_THREAD_POOL_PARALLEL_FOR_MIN_CHUNK) noexcept
+	{
+		T* data = array.GetData();
+
+		ParallelForRange(array.GetCount(),
+			[data, &function](int begin, int end)
+			{
+				for (int i = begin; i < end; ++i)
+				{
+					function(data[i]);
+				}
+			}
+			, minChunkSize
+		);
+	}
+
+
+	// [Block] Call function(T& element) for each valid element in free list. Chunks are made over used index range (including empty slots)
+	template<typename T, int N, typename TFunction>
+	inline void ParallelForEach(RpgFreeList<T, N>& freeList, TFunction&& function, int minChunkSize = RPG_THREAD_POOL_PARALLEL_FOR_MIN_CHUNK) noexcept
+	{
+		ParallelForRange(freeList.GetIndexEnd(),
+			[&freeList, &function](int begin, int end)
+			{
+				for (int i = freeList.FindNextValidIndex(begin); i < end; i = freeList.FindNextValidIndex(i + 1))
+				{
+					function(freeList.GetAt(i));
+				}
+			}
+			, minChunkSize
+		);
+	}
+
+
+	namespace Internal
+	{
+		// Each pass: per-chunk digit histograms (parallel), prefix sum over (digit, chunk) (serial), scatter (parallel).
+		// Chunks are fixed contiguous ranges scattered in order, so sort is stable.
+		template<typename TKey, typename TValue, bool bHasValue>
+		inline void ParallelRadixSort(TKey* keys, TValue* values, int count) noexcept
+		{
+			RpgAlgorithm::Internal::RadixSort_CheckKeyType<TKey>();
+
+			int chunkCount = GetWorkerCount() + 1;
+
+			if (chunkCount > 64)
+			{
+				chunkCount = 64;
+			}
+
+			if (count < RPG_THREAD_POOL_PARALLEL_SORT_MIN_COUNT || chunkCount < 2)
+			{
+				if constexpr (bHasValue)
+				{
+					RpgAlgorithm::RadixSort_KeyValue(keys, values, count);
+				}
+				else
+				{
+					RpgAlgorithm::RadixSort(keys, count);
+				}
+
+				return;
+			}
+
+			TKey* scratchKeys = reinterpret_cast<TKey*>(RpgPlatformMemory::MemMalloc(sizeof(TKey) * count));
+			TValue* scratchValues = bHasValue ? reinterpret_cast<TValue*>(RpgPlatformMemory::MemMalloc(sizeof(TValue) * count)) : nullptr;
+			uint32_t* histograms = reinterpret_cast<uint32_t*>(RpgPlatformMemory::MemMalloc(sizeof(uint32_t) * 256 * chunkCount));
+			RPG_Check(scratchKeys && histograms);
+
+			TKey* srcKeys = keys;
+			TKey* dstKeys = scratchKeys;
+			TValue* srcValues = values;
+			TValue* dstValues = scratchValues;
+
+			for (int p = 0; p < static_cast<int>(sizeof(TKey)); ++p)
+			{
+				const int shift = p * 8;
+
+				ParallelFor(chunkCount,
+					[=](int chunk)
+					{
+						uint32_t* histogram = histograms + chunk * 256;
+						RpgPlatformMemory::MemZero(histogram, sizeof(uint32_t) * 256);
+
+						const int end = static_cast<int>((static_cast<int64_t>(count) * (chunk + 1)) / chunkCount);
+
+						for (int i = static_cast<int>((static_cast<int64_t>(count) * chunk) / chunkCount); i < end; ++i)
+						{
+							++histogram[(srcKeys[i] >> shift) & 0xFF];
+						}
+					}
+					, 1
+				);
+
+				// Skip pass if all keys share the same digit
+				const uint32_t firstDigit = (srcKeys[0] >> shift) & 0xFF;
+				uint32_t firstDigitCount = 0;
+
+				for (int c = 0; c < chunkCount; ++c)
+				{
+					firstDigitCount += histograms[c * 256 + firstDigit];
+				}
+
+				if (firstDigitCount == static_cast<uint32_t>(count))
+				{
+					continue;
+				}
+
+				uint32_t offset = 0;
+
+				for (int d = 0; d < 256; ++d)
+				{
+					for (int c = 0; c < chunkCount; ++c)
+					{
+						const uint32_t digitCount = histograms[c * 256 + d];
+						histograms[c * 256 + d] = offset;
+						offset += digitCount;
+					}
+				}
+
+				ParallelFor(chunkCount,
+					[=](int chunk)
+					{
+						uint32_t* histogram = histograms + chunk * 256;
+						const int end = static_cast<int>((static_cast<int64_t>(count) * (chunk + 1)) / chunkCount);
+
+						for (int i = static_cast<int>((static_cast<int64_t>(count) * chunk) / chunkCount); i < end; ++i)
+						{
+							const uint32_t dst = histogram[(srcKeys[i] >> shift) & 0xFF]++;
+							dstKeys[dst] = srcKeys[i];
+
+							if constexpr (bHasValue)
+							{
+								dstValues[dst] = srcValues[i];
+							}
+						}
+					}
+					, 1
+				);
+
+				RpgAlgorithm::Swap(srcKeys, dstKeys);
+				RpgAlgorithm::Swap(srcValues, dstValues);
+			}
+
+			if (srcKeys != keys)
+			{
+				RpgPlatformMemory::MemCopy(keys, srcKeys, sizeof(TKey) * count);
+
+				if constexpr (bHasValue)
+				{
+					RpgPlatformMemory::MemCopy(values, srcValues, sizeof(TValue) * count);
+				}
+			}
+
+			RpgPlatformMemory::MemFree(histograms);
+			RpgPlatformMemory::MemFree(scratchKeys);
+
+			if (scratchValues)
+			{
+				RpgPlatformMemory::MemFree(scratchValues);
+			}
+		}
+
+	};
+
+
+	// [Block] Stable radix sort of unsigned integer keys (uint32_t or uint64_t) using worker threads. Small arrays are sorted on calling thread
+	template<typename TKey>
+	inline void ParallelRadixSort(TKey* keys, int count) noexcept
+	{
+		if (keys && count > 1)
+		{
+			Internal::ParallelRadixSort<TKey, uint8_t, false>(keys, nullptr, count);
+		}
+	}
+
+
+	// [Block] Stable radix sort of key/value pairs using worker threads. Small arrays are sorted on calling thread
+	template<typename TKey, typename TValue>
+	inline void ParallelRadixSort_KeyValue(TKey* keys, TValue* values, int count) noexcept
+	{
+		static_assert(std::is_trivially_copyable<TValue>::value, "RpgThreadPool: Radix sort value type must be trivially copyable!");
+
+		if (keys && values && count > 1)
+		{
+			Internal::ParallelRadixSort<TKey, TValue, true>(keys, values, count);
+		}
+	}
+
+
 	// Submit <tasks> into threadpool or execute in serial based on <bCondition>
-	template<typename bool bCondition = false>
+	template<bool bCondition = false>
 	inline void SubmitOrExecuteTasks(RpgThreadTask** tasks, int taskCount) noexcept
 	{
 		if (tasks == nullptr || taskCount == 0)
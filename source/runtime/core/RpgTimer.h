@@ -11,13 +11,30 @@ public:
 	static constexpr int TIME_UNIT = 1000000;
 
 
-public:
-	RpgTimer() noexcept
+	// @returns Current value of high resolution performance counter
+	[[nodiscard]] static inline uint64_t GetPerformanceCounter() noexcept
+	{
+		LARGE_INTEGER li;
+		QueryPerformanceCounter(&li);
+
+		return static_cast<uint64_t>(li.QuadPart);
+	}
+
+
+	// @returns Performance counter ticks per second
+	[[nodiscard]] static inline uint64_t GetPerformanceFrequency() noexcept
 	{
 		LARGE_INTEGER li;
 		QueryPerformanceFrequency(&li);
 
-		PerformanceFrequency = static_cast<float>(li.QuadPart);
+		return static_cast<uint64_t>(li.QuadPart);
+	}
+
+
+public:
+	RpgTimer() noexcept
+	{
+		PerformanceFrequency = static_cast<float>(GetPerformanceFrequency());
 		StartTickCounter = 0;
 		PrevTickCounter = 0;
 		DeltaTime = 0.0f;
@@ -38,10 +55,7 @@ public:
 	{
 		if (StartTickCounter == 0)
 		{
-			LARGE_INTEGER li;
-			QueryPerformanceCounter(&li);
-
-			StartTickCounter = li.QuadPart;
+			StartTickCounter = GetPerformanceCounter();
 			PrevTickCounter = StartTickCounter;
 		}
 	}
@@ -51,10 +65,7 @@ public:
 	// @returns Delta time in micro seconds
 	inline float Tick() noexcept
 	{
-		LARGE_INTEGER li;
-		QueryPerformanceCounter(&li);
-
-		const uint64_t currentTickCounter = li.QuadPart;
+		const uint64_t currentTickCounter = GetPerformanceCounter();
 		DeltaTime = static_cast<float>((currentTickCounter - PrevTickCounter) * TIME_UNIT) / PerformanceFrequency;
 		PrevTickCounter = currentTickCounter;
 
@@ -119,6 +119,11 @@ namespace RpgType
 	return static_cast<uint64_t>(value);
 }
 
+[[nodiscard]] inline uint64_t Rpg_GetHash(uint64_t value) noexcept
+{
+	return value;
+}
+
 template<typename T>
 [[nodiscard]] inline uint64_t Rpg_GetHash(T* value) noexcept
 {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../RpgPlatform.h"
+#include <bit>
 
 
 
@@ -9,9 +10,9 @@ namespace RpgAlgorithm
 	template<typename T>
 	inline void Swap(T& out_A, T& out_B) noexcept
 	{
-		T temp = out_A;
-		out_A = out_B;
-		out_B = temp;
+		T temp = std::move(out_A);
+		out_A = std::move(out_B);
+		out_B = std::move(temp);
 	}
 
 
@@ -210,4 +211,588 @@ namespace RpgAlgorithm
 		return RPG_INDEX_INVALID;
 	}
 
+
+
+	// Default compare for sort and binary search
+	struct FLess
+	{
+		template<typename TA, typename TB>
+		inline bool operator()(const TA& a, const TB& b) const noexcept
+		{
+			return a < b;
+		}
+	};
+
+
+	namespace Internal
+	{
+		// Ranges below this size are finished with insertion sort
+		constexpr int SORT_INSERTION_THRESHOLD = 16;
+
+
+		template<typename T, typename TLess>
+		inline void InsertionSort(T* data, int count, TLess& less) noexcept
+		{
+			for (int i = 1; i < count; ++i)
+			{
+				if (less(data[i], data[i - 1]))
+				{
+					T value = std::move(data[i]);
+					int j = i;
+
+					do
+					{
+						data[j] = std::move(data[j - 1]);
+						--j;
+					}
+					while (j > 0 && less(value, data[j - 1]));
+
+					data[j] = std::move(value);
+				}
+			}
+		}
+
+
+		template<typename T, typename TLess>
+		inline void HeapSiftDown(T* data, int root, int count, TLess& less) noexcept
+		{
+			T value = std::move(data[root]);
+			int child = 2 * root + 1;
+
+			while (child < count)
+			{
+				if (child + 1 < count && less(data[child], data[child + 1]))
+				{
+					++child;
+				}
+
+				if (!less(value, data[child]))
+				{
+					break;
+				}
+
+				data[root] = std::move(data[child]);
+				root = child;
+				child = 2 * root + 1;
+			}
+
+			data[root] = std::move(value);
+		}
+
+
+		template<typename T, typename TLess>
+		inline void HeapSort(T* data, int count, TLess& less) noexcept
+		{
+			for (int i = count / 2 - 1; i >= 0; --i)
+			{
+				HeapSiftDown(data, i, count, less);
+			}
+
+			for (int i = count - 1; i > 0; --i)
+			{
+				Swap(data[0], data[i]);
+				HeapSiftDown(data, 0, i, less);
+			}
+		}
+
+
+		// Median of three pivot, Hoare partition. Requires count >= 3
+		// @returns Final pivot index. Elements before it are not greater, elements after it are not less
+		template<typename T, typename TLess>
+		inline int PartitionMedianOfThree(T* data, int count, TLess& less) noexcept
+		{
+			const int mid = count / 2;
+			const int last = count - 1;
+
+			if (less(data[mid], data[0]))
+			{
+				Swap(data[mid], data[0]);
+			}
+
+			if (less(data[last], data[mid]))
+			{
+				Swap(data[last], data[mid]);
+
+				if (less(data[mid], data[0]))
+				{
+					Swap(data[mid], data[0]);
+				}
+			}
+
+			// Pivot at [1], data[0] and data[last] act as sentinels
+			Swap(data[1], data[mid]);
+
+			int i = 1;
+			int j = last;
+
+			for (;;)
+			{
+				do { ++i; } while (less(data[i], data[1]));
+				do { --j; } while (less(data[1], data[j]));
+
+				if (i >= j)
+				{
+					break;
+				}
+
+				Swap(data[i], data[j]);
+			}
+
+			Swap(data[1], data[j]);
+
+			return j;
+		}
+
+
+		template<typename T, typename TLess>
+		inline void IntroSort(T* data, int count, int depthLimit, TLess& less) noexcept
+		{
+			while (count > SORT_INSERTION_THRESHOLD)
+			{
+				if (depthLimit == 0)
+				{
+					HeapSort(data, count, less);
+					return;
+				}
+
+				--depthLimit;
+
+				const int pivot = PartitionMedianOfThree(data, count, less);
+				const int rightCount = count - pivot - 1;
+
+				// Recurse into smaller side, loop on larger side (stack depth O(log n))
+				if (pivot < rightCount)
+				{
+					IntroSort(data, pivot, depthLimit, less);
+					data += pivot + 1;
+					count = rightCount;
+				}
+				else
+				{
+					IntroSort(data + pivot + 1, rightCount, depthLimit, less);
+					count = pivot;
+				}
+			}
+
+			InsertionSort(data, count, less);
+		}
+
+
+		template<typename T, typename TLess>
+		inline void MergeSort(T* data, int count, T* buffer, TLess& less) noexcept
+		{
+			if (count <= SORT_INSERTION_THRESHOLD * 2)
+			{
+				InsertionSort(data, count, less);
+				return;
+			}
+
+			const int half = count / 2;
+			MergeSort(data, half, buffer, less);
+			MergeSort(data + half, count - half, buffer, less);
+
+			// Already ordered
+			if (!less(data[half], data[half - 1]))
+			{
+				return;
+			}
+
+			for (int i = 0; i < half; ++i)
+			{
+				buffer[i] = std::move(data[i]);
+			}
+
+			int a = 0;
+			int b = half;
+			int d = 0;
+
+			while (a < half && b < count)
+			{
+				// Take from right side only if strictly less to keep equal elements in order
+				if (less(data[b], buffer[a]))
+				{
+					data[d++] = std::move(data[b++]);
+				}
+				else
+				{
+					data[d++] = std::move(buffer[a++]);
+				}
+			}
+
+			while (a < half)
+			{
+				data[d++] = std::move(buffer[a++]);
+			}
+		}
+
+
+		template<typename TKey>
+		constexpr inline void RadixSort_CheckKeyType() noexcept
+		{
+			static_assert(std::is_same<TKey, uint32_t>::value || std::is_same<TKey, uint64_t>::value, "RpgAlgorithm: Radix sort key type must be uint32_t or uint64_t!");
+		}
+
+
+		// LSD radix sort, 8 bits per pass. Pass is skipped when all keys share the same digit
+		// Result is in <keys>/<values>, scratch arrays must hold <count> elements
+		template<typename TKey, typename TValue, bool bHasValue>
+		inline void RadixSort(TKey* keys, TValue* values, TKey* scratchKeys, TValue* scratchValues, int count) noexcept
+		{
+			constexpr int PASS_COUNT = sizeof(TKey);
+
+			uint32_t histograms[PASS_COUNT][256] = {};
+
+			for (int i = 0; i < count; ++i)
+			{
+				const TKey key = keys[i];
+
+				for (int p = 0; p < PASS_COUNT; ++p)
+				{
+					++histograms[p][(key >> (p * 8)) & 0xFF];
+				}
+			}
+
+			TKey* srcKeys = keys;
+			TKey* dstKeys = scratchKeys;
+			TValue* srcValues = values;
+			TValue* dstValues = scratchValues;
+
+			for (int p = 0; p < PASS_COUNT; ++p)
+			{
+				uint32_t* histogram = histograms[p];
+				const int shift = p * 8;
+
+				if (histogram[(srcKeys[0] >> shift) & 0xFF] == static_cast<uint32_t>(count))
+				{
+					continue;
+				}
+
+				uint32_t offset = 0;
+
+				for (int d = 0; d < 256; ++d)
+				{
+					const uint32_t digitCount = histogram[d];
+					histogram[d] = offset;
+					offset += digitCount;
+				}
+
+				for (int i = 0; i < count; ++i)
+				{
+					const uint32_t dst = histogram[(srcKeys[i] >> shift) & 0xFF]++;
+					dstKeys[dst] = srcKeys[i];
+
+					if constexpr (bHasValue)
+					{
+						dstValues[dst] = srcValues[i];
+					}
+				}
+
+				Swap(srcKeys, dstKeys);
+
+				if constexpr (bHasValue)
+				{
+					Swap(srcValues, dstValues);
+				}
+			}
+
+			if (srcKeys != keys)
+			{
+				RpgPlatformMemory::MemCopy(keys, srcKeys, sizeof(TKey) * count);
+
+				if constexpr (bHasValue)
+				{
+					RpgPlatformMemory::MemCopy(values, srcValues, sizeof(TValue) * count);
+				}
+			}
+		}
+
+	};
+
+
+
+	// Unstable sort (introsort: quicksort with median of three, heapsort fallback on bad pivots, insertion sort for small ranges). O(n log n) worst case
+	// @param data - Data array
+	// @param count - Number of elements
+	// @param less - Compare function less(a, b)
+	// @returns None
+	template<typename T, typename TLess = FLess>
+	inline void Sort(T* data, int count, TLess less = TLess()) noexcept
+	{
+		if (data == nullptr || count < 2)
+		{
+			return;
+		}
+
+		Internal::IntroSort(data, count, 2 * std::bit_width(static_cast<uint32_t>(count)), less);
+	}
+
+
+	// Stable sort (merge sort). Allocates temporary buffer of (count / 2) elements
+	// @param data - Data array
+	// @param count - Number of elements
+	// @param less - Compare function less(a, b)
+	// @returns None
+	template<typename T, typename TLess = FLess>
+	inline void StableSort(T* data, int count, TLess less = TLess()) noexcept
+	{
+		if (data == nullptr || count < 2)
+		{
+			return;
+		}
+
+		if (count <= Internal::SORT_INSERTION_THRESHOLD * 2)
+		{
+			Internal::InsertionSort(data, count, less);
+			return;
+		}
+
+		const int bufferCount = count / 2;
+		T* buffer = reinterpret_cast<T*>(RpgPlatformMemory::MemMalloc(sizeof(T) * bufferCount));
+		RPG_Check(buffer);
+
+		if constexpr (!std::is_trivially_copyable<T>::value)
+		{
+			for (int i = 0; i < bufferCount; ++i)
+			{
+				new (buffer + i)T(data[i]);
+			}
+		}
+
+		Internal::MergeSort(data, count, buffer, less);
+
+		if constexpr (!std::is_trivially_copyable<T>::value)
+		{
+			for (int i = 0; i < bufferCount; ++i)
+			{
+				(buffer + i)->~T();
+			}
+		}
+
+		RpgPlatformMemory::MemFree(buffer);
+	}
+
+
+	// Stable LSD radix sort for unsigned integer keys
+	// @param keys - Key array (uint32_t or uint64_t)
+	// @param count - Number of elements
+	// @param scratchKeys - (Optional) Temporary array of <count> keys. Allocated internally if nullptr
+	// @returns None
+	template<typename TKey>
+	inline void RadixSort(TKey* keys, int count, TKey* scratchKeys = nullptr) noexcept
+	{
+		Internal::RadixSort_CheckKeyType<TKey>();
+
+		if (keys == nullptr || count < 2)
+		{
+			return;
+		}
+
+		TKey* scratch = scratchKeys ? scratchKeys : reinterpret_cast<TKey*>(RpgPlatformMemory::MemMalloc(sizeof(TKey) * count));
+		RPG_Check(scratch);
+
+		Internal::RadixSort<TKey, uint8_t, false>(keys, nullptr, scratch, nullptr, count);
+
+		if (scratchKeys == nullptr)
+		{
+			RpgPlatformMemory::MemFree(scratch);
+		}
+	}
+
+
+	// Stable LSD radix sort for key/value pairs. Values are moved along with their keys
+	// @param keys - Key array (uint32_t or uint64_t)
+	// @param values - Value array (trivially copyable)
+	// @param count - Number of elements
+	// @param scratchKeys - (Optional) Temporary array of <count> keys. Allocated internally if nullptr
+	// @param scratchValues - (Optional) Temporary array of <count> values. Allocated internally if nullptr
+	// @returns None
+	template<typename TKey, typename TValue>
+	inline void RadixSort_KeyValue(TKey* keys, TValue* values, int count, TKey* scratchKeys = nullptr, TValue* scratchValues = nullptr) noexcept
+	{
+		Internal::RadixSort_CheckKeyType<TKey>();
+		static_assert(std::is_trivially_copyable<TValue>::value, "RpgAlgorithm: Radix sort value type must be trivially copyable!");
+
+		if (keys == nullptr || values == nullptr || count < 2)
+		{
+			return;
+		}
+
+		TKey* tempKeys = scratchKeys ? scratchKeys : reinterpret_cast<TKey*>(RpgPlatformMemory::MemMalloc(sizeof(TKey) * count));
+		TValue* tempValues = scratchValues ? scratchValues : reinterpret_cast<TValue*>(RpgPlatformMemory::MemMalloc(sizeof(TValue) * count));
+		RPG_Check(tempKeys && tempValues);
+
+		Internal::RadixSort<TKey, TValue, true>(keys, values, tempKeys, tempValues, count);
+
+		if (scratchKeys == nullptr)
+		{
+			RpgPlatformMemory::MemFree(tempKeys);
+		}
+
+		if (scratchValues == nullptr)
+		{
+			RpgPlatformMemory::MemFree(tempValues);
+		}
+	}
+
+
+	// Map signed integer to radix key with the same ordering
+	constexpr inline uint32_t RadixKey_FromInt(int32_t value) noexcept
+	{
+		return static_cast<uint32_t>(value) ^ 0x80000000u;
+	}
+
+
+	// Map float to radix key with the same ordering (negative values flip all bits, positive values flip sign bit)
+	inline uint32_t RadixKey_FromFloat(float value) noexcept
+	{
+		const uint32_t bits = std::bit_cast<uint32_t>(value);
+		return bits ^ ((bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u);
+	}
+
+
+	// Reorder elements so that element at <nth> is the one that would be there if array is sorted.
+	// Elements before it are not greater, elements after it are not less. Average O(n)
+	// @param data - Data array
+	// @param count - Number of elements
+	// @param nth - Index [0, count)
+	// @param less - Compare function less(a, b)
+	// @returns None
+	template<typename T, typename TLess = FLess>
+	inline void NthElement(T* data, int count, int nth, TLess less = TLess()) noexcept
+	{
+		if (data == nullptr || count < 2)
+		{
+			return;
+		}
+
+		RPG_CheckV(nth >= 0 && nth < count, "RpgAlgorithm: NthElement index (%i) out of bound!", nth);
+
+		int depthLimit = 2 * std::bit_width(static_cast<uint32_t>(count));
+
+		while (count > Internal::SORT_INSERTION_THRESHOLD)
+		{
+			if (depthLimit-- == 0)
+			{
+				Internal::HeapSort(data, count, less);
+				return;
+			}
+
+			const int pivot = Internal::PartitionMedianOfThree(data, count, less);
+
+			if (pivot == nth)
+			{
+				return;
+			}
+
+			if (nth < pivot)
+			{
+				count = pivot;
+			}
+			else
+			{
+				data += pivot + 1;
+				nth -= pivot + 1;
+				count -= pivot + 1;
+			}
+		}
+
+		Internal::InsertionSort(data, count, less);
+	}
+
+
+	// Move elements that satisfy predicate to the front. Relative order is not kept
+	// @returns Number of elements that satisfy predicate (index of first element that does not)
+	template<typename T, typename TPredicate>
+	inline int Partition(T* data, int count, TPredicate predicate) noexcept
+	{
+		int first = 0;
+		int last = count - 1;
+
+		for (;;)
+		{
+			while (first <= last && predicate(data[first]))
+			{
+				++first;
+			}
+
+			while (first <= last && !predicate(data[last]))
+			{
+				--last;
+			}
+
+			if (first >= last)
+			{
+				return first;
+			}
+
+			Swap(data[first], data[last]);
+			++first;
+			--last;
+		}
+	}
+
+
+	// Binary search on sorted array
+	// @returns Index of first element that is not less than <value>, or <count> if none
+	template<typename T, typename TValue, typename TLess = FLess>
+	inline int BinarySearch_LowerBound(const T* dataArray, int dataCount, const TValue& value, TLess less = TLess()) noexcept
+	{
+		int first = 0;
+		int count = dataCount;
+
+		while (count > 0)
+		{
+			const int step = count / 2;
+
+			if (less(dataArray[first + step], value))
+			{
+				first += step + 1;
+				count -= step + 1;
+			}
+			else
+			{
+				count = step;
+			}
+		}
+
+		return first;
+	}
+
+
+	// Binary search on sorted array
+	// @returns Index of first element that is greater than <value>, or <count> if none
+	template<typename T, typename TValue, typename TLess = FLess>
+	inline int BinarySearch_UpperBound(const T* dataArray, int dataCount, const TValue& value, TLess less = TLess()) noexcept
+	{
+		int first = 0;
+		int count = dataCount;
+
+		while (count > 0)
+		{
+			const int step = count / 2;
+
+			if (!less(value, dataArray[first + step]))
+			{
+				first += step + 1;
+				count -= step + 1;
+			}
+			else
+			{
+				count = step;
+			}
+		}
+
+		return first;
+	}
+
+
+	// Binary search on sorted array
+	// @returns Index of first element equal to <value>, RPG_INDEX_INVALID if not found
+	template<typename T, typename TValue, typename TLess = FLess>
+	inline int BinarySearch_FindIndexByValue(const T* dataArray, int dataCount, const TValue& value, TLess less = TLess()) noexcept
+	{
+		const int index = BinarySearch_LowerBound(dataArray, dataCount, value, less);
+		return (index < dataCount && !less(value, dataArray[index])) ? index : RPG_INDEX_INVALID;
+	}
+
 }; // RpgAlgorithm
@@ -1,15 +1,21 @@
 #pragma once
 
 #include "RpgAlgorithm.h"
+#include "../RpgAllocator.h"
 
 
 #define RPG_ARRAY_ValidateIndex(i)		RPG_ValidateV(i >= 0 && i < Count, "RpgArray: Index (%i) out of bound!", i)
 
 
 
-template<typename T, int CAPACITY_ALIGNMENT = 1>
-class RpgArray
+// Dynamic array.
+// TAllocator must provide Reallocate(prevAlloc, prevSizeBytes, newSizeBytes) and Free(alloc). See RpgAllocator.h
+template<typename T, int CAPACITY_ALIGNMENT = 1, typename TAllocator = RpgAllocatorDefault>
+class RpgArray : private TAllocator
 {
+	template<typename, int, typename>
+	friend class RpgArray;
+
 	static_assert(RpgAlgorithm::IsPowerOfTwo(CAPACITY_ALIGNMENT), "RpgArray: CAPACITY_ALIGNMENT must be power of two!");
 
 public:
@@ -25,6 +31,19 @@ public:
 	}
 
 
+	explicit RpgArray(const TAllocator& in_Allocator, int in_Count = 0) noexcept
+		: TAllocator(in_Allocator)
+		, Data(nullptr)
+		, Capacity(0)
+		, Count(0)
+	{
+		if (in_Count > 0)
+		{
+			Resize(in_Count);
+		}
+	}
+
+
 	template<typename...TConstructorArgs>
 	RpgArray(int in_Count, TConstructorArgs&&... args) noexcept
 		: Data(nullptr)
@@ -66,7 +85,8 @@ public:
 
 
 	RpgArray(const RpgArray& other) noexcept
-		: Data(nullptr)
+		: TAllocator(other.GetAllocator())
+		, Data(nullptr)
 		, Capacity(0)
 		, Count(0)
 	{
@@ -78,8 +98,8 @@ public:
 	}
 
 
-	template<int N>
-	RpgArray(const RpgArray<T, N>& other) noexcept
+	template<int N, typename TOtherAllocator>
+	RpgArray(const RpgArray<T, N, TOtherAllocator>& other) noexcept
 		: Data(nullptr)
 		, Capacity(0)
 		, Count(0)
@@ -93,7 +113,8 @@ public:
 
 
 	RpgArray(RpgArray&& other) noexcept
-		: Data(other.Data)
+		: TAllocator(other.GetAllocator())
+		, Data(other.Data)
 		, Capacity(other.Capacity)
 		, Count(other.Count)
 	{
@@ -132,6 +153,7 @@ public:
 		if (this != &rhs)
 		{
 			Clear(true);
+			GetAllocator() = rhs.GetAllocator();
 			Data = rhs.Data;
 			Capacity = rhs.Capacity;
 			Count = rhs.Count;
@@ -144,8 +166,8 @@ public:
 	}
 
 
-	template<int N>
-	inline RpgArray& operator=(const RpgArray<T, N>& rhs) noexcept
+	template<int N, typename TOtherAllocator>
+	inline RpgArray& operator=(const RpgArray<T, N, TOtherAllocator>& rhs) noexcept
 	{
 		Clear();
 
@@ -291,6 +313,25 @@ public:
 		return Count > 0 ? RpgAlgorithm::LinearSearch_FindIndexByPredicate(Data, Count, predicate) : RPG_INDEX_INVALID;
 	}
 
+	// Array must be sorted by <less>
+	template<typename TValue, typename TLess = RpgAlgorithm::FLess>
+	inline int FindIndexByValueSorted(const TValue& value, TLess less = TLess()) const noexcept
+	{
+		return Count > 0 ? RpgAlgorithm::BinarySearch_FindIndexByValue(Data, Count, value, less) : RPG_INDEX_INVALID;
+	}
+
+	template<typename TLess = RpgAlgorithm::FLess>
+	inline void Sort(TLess less = TLess()) noexcept
+	{
+		RpgAlgorithm::Sort(Data, Count, less);
+	}
+
+	template<typename TLess = RpgAlgorithm::FLess>
+	inline void StableSort(TLess less = TLess()) noexcept
+	{
+		RpgAlgorithm::StableSort(Data, Count, less);
+	}
+
 
 	inline void Reserve(int in_Capacity) noexcept
 	{
@@ -302,7 +343,7 @@ public:
 		const int alignedCapacity = RpgType::Align(in_Capacity, CAPACITY_ALIGNMENT);
 		RPG_Check(alignedCapacity >= in_Capacity);
 
-		T* NewData = reinterpret_cast<T*>(RpgPlatformMemory::MemRealloc(Data, sizeof(T) * alignedCapacity));
+		T* NewData = reinterpret_cast<T*>(TAllocator::Reallocate(Data, sizeof(T) * Capacity, sizeof(T) * alignedCapacity));
 		RPG_Check(NewData);
 
 		Data = NewData;
@@ -457,8 +498,8 @@ public:
 	}
 
 
-	template<int N>
-	inline void InsertAtRange(const RpgArray<T, N>& other, int index) noexcept
+	template<int N, typename TOtherAllocator>
+	inline void InsertAtRange(const RpgArray<T, N, TOtherAllocator>& other, int index) noexcept
 	{
 		InsertAtRange(other.Data, other.Count, index);
 	}
@@ -589,13 +630,31 @@ public:
 
 		if (Data && bFreeMemory)
 		{
-			RpgPlatformMemory::MemFree(Data);
+			TAllocator::Free(Data);
 			Data = nullptr;
 			Capacity = 0;
 		}
 	}
 
 
+	// Replace allocator. Array must not have allocated memory (empty and Clear(true) called)
+	inline void SetAllocator(const TAllocator& in_Allocator) noexcept
+	{
+		RPG_CheckV(Data == nullptr, "RpgArray: Cannot change allocator while memory is allocated!");
+		GetAllocator() = in_Allocator;
+	}
+
+	inline TAllocator& GetAllocator() noexcept
+	{
+		return static_cast<TAllocator&>(*this);
+	}
+
+	inline const TAllocator& GetAllocator() const noexcept
+	{
+		return static_cast<const TAllocator&>(*this);
+	}
+
+
 	inline T* begin() noexcept
 	{
 		return Data;
@@ -1,20 +1,35 @@
 #pragma once
 
-#include "RpgAlgorithm.h"
+#include "RpgArray.h"
+#include <bit>
 
 
-template<typename T>
+// Default number of elements per block
+#define RPG_FREELIST_DEFAULT_BLOCK_SIZE		256
+
+
+
+// Sparse array with stable indices and stable element addresses.
+// Elements live in fixed-size blocks that are never reallocated, so pointer/reference to element stays valid until the element is removed (or Defragment/Clear).
+// Blocks are allocated geometrically (each grow allocates one page holding as many blocks as currently exist).
+// Removed slots are chained into intrusive free list (first 4 bytes of removed element) and reused LIFO.
+// Occupancy is stored as bitmap of 64-bit words, iteration skips empty slots a word at a time.
+template<typename T, int BLOCK_SIZE = RPG_FREELIST_DEFAULT_BLOCK_SIZE>
 class RpgFreeList
 {
 	static_assert(sizeof(T) >= sizeof(int), "RpgFreeList size of type <T> must be greater than sizeof(int) 4 bytes! ");
+	static_assert(RpgAlgorithm::IsPowerOfTwo(BLOCK_SIZE) && BLOCK_SIZE >= 64, "RpgFreeList: BLOCK_SIZE must be power of two and at least 64!");
+
+	static constexpr int BLOCK_SHIFT = std::countr_zero(static_cast<uint32_t>(BLOCK_SIZE));
+	static constexpr int BLOCK_MASK = BLOCK_SIZE - 1;
+
 
 public:
 	RpgFreeList() noexcept
 		: Capacity(0)
 		, Count(0)
+		, IndexEnd(0)
 		, NextFreeIndex(RPG_INDEX_INVALID)
-		, ValidIndexArray(nullptr)
-		, DataArray(nullptr)
 	{
 	}
 
@@ -29,16 +44,16 @@ public:
 	RpgFreeList(RpgFreeList&& other) noexcept
 		: Capacity(other.Capacity)
 		, Count(other.Count)
+		, IndexEnd(other.IndexEnd)
 		, NextFreeIndex(other.NextFreeIndex)
-		, ValidIndexArray(other.ValidIndexArray)
-		, DataArray(other.DataArray)
+		, ValidBits(std::move(other.ValidBits))
+		, Blocks(std::move(other.Blocks))
+		, Pages(std::move(other.Pages))
 	{
 		other.Capacity = 0;
 		other.Count = 0;
+		other.IndexEnd = 0;
 		other.NextFreeIndex = RPG_INDEX_INVALID;
-		other.FreeIndexArray = nullptr;
-		other.ValidIndexArray = nullptr;
-		other.DataArray = nullptr;
 	}
 
 
@@ -76,15 +91,16 @@ public:
 
 			Capacity = rhs.Capacity;
 			Count = rhs.Count;
+			IndexEnd = rhs.IndexEnd;
 			NextFreeIndex = rhs.NextFreeIndex;
-			ValidIndexArray = rhs.ValidIndexArray;
-			DataArray = rhs.DataArray;
+			ValidBits = std::move(rhs.ValidBits);
+			Blocks = std::move(rhs.Blocks);
+			Pages = std::move(rhs.Pages);
 
 			rhs.Capacity = 0;
 			rhs.Count = 0;
+			rhs.IndexEnd = 0;
 			rhs.NextFreeIndex = RPG_INDEX_INVALID;
-			rhs.ValidIndexArray = nullptr;
-			rhs.DataArray = nullptr;
 		}
 
 		return *this;
@@ -103,46 +119,79 @@ public:
 	inline T& operator[](int index) noexcept
 	{
 		RPG_ValidateV(IsValid(index), "RpgFreeList: Element at index %i is not valid!", index);
-		return DataArray[index];
+		return *GetSlot(index);
 	}
 
 
 	inline const T& operator[](int index) const noexcept
 	{
 		RPG_ValidateV(IsValid(index), "RpgFreeList: Element at index %i is not valid!", index);
-		return DataArray[index];
+		return *GetSlot(index);
 	}
 
 
 private:
-	inline void InternalCopyFromOther(int otherCapacity, int otherCount, int otherNextFreeIndex, const bool* otherValidIndexArray, const T* otherDataArray) noexcept
+	inline T* GetSlot(int index) const noexcept
 	{
-		Reserve(otherCapacity);
-		Count = otherCount;
-		NextFreeIndex = otherNextFreeIndex;
+		return Blocks[index >> BLOCK_SHIFT] + (index & BLOCK_MASK);
+	}
 
-		// Copy valid index array
-		RpgPlatformMemory::MemCopy(ValidIndexArray, otherValidIndexArray, sizeof(bool) * Capacity);
 
-		// Copy to get the value of first 4 bytes (the NextFreeIndex) from each empty element
-		RpgPlatformMemory::MemCopy(DataArray, otherDataArray, sizeof(T) * Capacity);
+	inline void SetValidBit(int index) noexcept
+	{
+		ValidBits[index >> 6] |= (1ull << (index & 63));
+	}
 
-		// (Non-POD) actual deep copy for valid element only
-		if constexpr (!std::is_trivially_copyable<T>::value)
+
+	inline void ClearValidBit(int index) noexcept
+	{
+		ValidBits[index >> 6] &= ~(1ull << (index & 63));
+	}
+
+
+	// Allocate one page holding <blockCount> blocks
+	inline void AllocatePage(int blockCount) noexcept
+	{
+		T* page = reinterpret_cast<T*>(RpgPlatformMemory::MemMalloc(sizeof(T) * BLOCK_SIZE * blockCount));
+		RPG_Check(page);
+
+		Pages.AddValue(page);
+
+		for (int b = 0; b < blockCount; ++b)
 		{
-			for (int i = 0; i < Capacity; ++i)
-			{
-				if (ValidIndexArray[i])
-				{
-					DataArray[i] = otherDataArray[i];
-				}
-			}
+			Blocks.AddValue(page + b * BLOCK_SIZE);
 		}
+
+		Capacity += BLOCK_SIZE * blockCount;
+		ValidBits.Resize(Capacity >> 6);
 	}
 
+
 	inline void CopyFromOther(const RpgFreeList& other) noexcept
 	{
-		InternalCopyFromOther(other.Capacity, other.Count, other.NextFreeIndex, other.ValidIndexArray, other.DataArray);
+		if (other.Capacity == 0)
+		{
+			return;
+		}
+
+		Reserve(other.Capacity);
+		Count = other.Count;
+		IndexEnd = other.IndexEnd;
+		NextFreeIndex = other.NextFreeIndex;
+		RpgPlatformMemory::MemCopy(ValidBits.GetData(), other.ValidBits.GetData(), sizeof(uint64_t) * ValidBits.GetCount());
+
+		for (int i = 0; i < IndexEnd; ++i)
+		{
+			if (IsValid(i))
+			{
+				new (GetSlot(i))T(*other.GetSlot(i));
+			}
+			else
+			{
+				// Empty slot only holds next free index
+				*reinterpret_cast<int*>(GetSlot(i)) = *reinterpret_cast<const int*>(other.GetSlot(i));
+			}
+		}
 	}
 
 
@@ -156,30 +205,26 @@ private:
 		}
 
 		Reserve(initCount);
-		Count = initCount;
-		RpgPlatformMemory::MemSet(ValidIndexArray, 1, sizeof(bool) * Count);
 
-		if constexpr (std::is_trivially_copyable<T>::value)
+		for (int i = 0; i < initCount; ++i)
 		{
-			RpgPlatformMemory::MemCopy(DataArray, initializerList.begin(), sizeof(T) * Count);
-		}
-		else
-		{
-			for (int i = 0; i < Count; ++i)
-			{
-				DataArray[i] = *(initializerList.begin() + i);
-			}
+			SetValidBit(i);
+			new (GetSlot(i))T(*(initializerList.begin() + i));
 		}
+
+		Count = initCount;
+		IndexEnd = initCount;
 	}
 
 
 public:
 	inline bool IsValid(int index) const noexcept
 	{
-		return Capacity > 0 ? ValidIndexArray[index] : false;
+		return (index >= 0 && index < Capacity) ? (ValidBits[index >> 6] & (1ull << (index & 63))) != 0 : false;
 	}
 
 
+	// Ensure capacity. Existing blocks are never moved
 	inline void Reserve(int in_Capacity) noexcept
 	{
 		if (Capacity >= in_Capacity)
@@ -187,13 +232,10 @@ public:
 			return;
 		}
 
-		const int addedCapacity = in_Capacity - Capacity;
-
-		ValidIndexArray = reinterpret_cast<bool*>(RpgPlatformMemory::MemRealloc(ValidIndexArray, sizeof(bool) * in_Capacity));
-		RpgPlatformMemory::MemZero(ValidIndexArray + Capacity, sizeof(bool) * addedCapacity);
+		const int requiredBlockCount = ((in_Capacity + BLOCK_MASK) >> BLOCK_SHIFT) - Blocks.GetCount();
+		const int growBlockCount = (Blocks.GetCount() > requiredBlockCount) ? Blocks.GetCount() : requiredBlockCount;
 
-		DataArray = reinterpret_cast<T*>(RpgPlatformMemory::MemRealloc(DataArray, sizeof(T) * in_Capacity));
-		Capacity = in_Capacity;
+		AllocatePage(growBlockCount);
 	}
 
 
@@ -204,8 +246,9 @@ public:
 
 		if (NextFreeIndex == RPG_INDEX_INVALID)
 		{
-			index = Count;
-			Reserve(Count + 1);
+			index = IndexEnd;
+			Reserve(IndexEnd + 1);
+			++IndexEnd;
 		}
 		else
 		{
@@ -213,13 +256,13 @@ public:
 			index = NextFreeIndex;
 
 			// Set current NextFreeIndex. The value is the first 4 bytes interpreted as int
-			const int* intPtr = reinterpret_cast<const int*>(DataArray + index);
+			const int* intPtr = reinterpret_cast<const int*>(GetSlot(index));
 			NextFreeIndex = *intPtr;
 		}
 
 		RPG_Check(index != RPG_INDEX_INVALID);
-		ValidIndexArray[index] = true;
-		new (DataArray + index)T(std::forward<TConstructorArgs>(args)...);
+		SetValidBit(index);
+		new (GetSlot(index))T(std::forward<TConstructorArgs>(args)...);
 
 		++Count;
 
@@ -227,28 +270,63 @@ public:
 	}
 
 
+	// Reserve <count> slots at [GetIndexEnd(), GetIndexEnd() + count) without constructing elements. Empty slots are not reused.
+	// Reserved slot is not valid (skipped by iteration) until EmplaceAt is called on it, reserved slot that is never emplaced stays empty and is not reused by Add
+	// @param count - Number of slots
+	// @returns Index of the first reserved slot
+	inline int ReserveRange(int count) noexcept
+	{
+		RPG_Check(count >= 0);
+
+		const int firstIndex = IndexEnd;
+		Reserve(IndexEnd + count);
+		IndexEnd += count;
+
+		return firstIndex;
+	}
+
+
+	// Construct element at slot reserved by ReserveRange
+	// @param index - Reserved slot index
+	// @returns Constructed element
+	template<typename... TConstructorArgs>
+	inline T& EmplaceAt(int index, TConstructorArgs&&... args) noexcept
+	{
+		RPG_CheckV(index >= 0 && index < IndexEnd && !IsValid(index), "RpgFreeList: Slot at index %i is not reserved!", index);
+
+		SetValidBit(index);
+		T* slot = new (GetSlot(index))T(std::forward<TConstructorArgs>(args)...);
+
+		++Count;
+
+		return *slot;
+	}
+
+
 	inline void RemoveAt(int index)
 	{
 		RPG_ValidateV(IsValid(index), "RpgFreeList: Element at index %i is not valid!", index);
 
+		T* slot = GetSlot(index);
+
 		// Call destructor if not POD
 		if constexpr (!std::is_trivially_copyable<T>::value)
 		{
-			(DataArray + index)->~T();
+			slot->~T();
 		}
 
 	#ifdef RPG_BUILD_DEBUG
 		// Fill data with garbage values
-		RpgPlatformMemory::MemSet(DataArray + index, 0x0000DEAD, sizeof(T));
+		RpgPlatformMemory::MemSet(slot, 0x0000DEAD, sizeof(T));
 	#endif // !RPG_BUILD_DEBUG
 
 		// Interpret the first 4 bytes of removed element as (int) and set its value from NextFreeIndex
-		int* intPtr = reinterpret_cast<int*>(DataArray + index);
+		int* intPtr = reinterpret_cast<int*>(slot);
 		*intPtr = NextFreeIndex;
 
 		// Set the removed index as current NextFreeIndex
 		NextFreeIndex = index;
-		ValidIndexArray[index] = false;
+		ClearValidBit(index);
 
 		--Count;
 	}
@@ -256,52 +334,134 @@ public:
 
 	inline void Clear(bool bFreeMemory = false) noexcept
 	{
+		// Call destructor if not POD for valid item only
+		if constexpr (!std::is_trivially_copyable<T>::value)
+		{
+			for (int i = FindNextValidIndex(0); i < IndexEnd; i = FindNextValidIndex(i + 1))
+			{
+				GetSlot(i)->~T();
+			}
+		}
+
 		Count = 0;
+		IndexEnd = 0;
 		NextFreeIndex = RPG_INDEX_INVALID;
 
-		if (DataArray)
+		if (bFreeMemory)
 		{
-			// Call destructor if not POD for valid item only
-			if constexpr (!std::is_trivially_copyable<T>::value)
+			for (int i = 0; i < Pages.GetCount(); ++i)
+			{
+				RpgPlatformMemory::MemFree(Pages[i]);
+			}
+
+			Pages.Clear(true);
+			Blocks.Clear(true);
+			ValidBits.Clear(true);
+			Capacity = 0;
+		}
+		else if (ValidBits.GetCount() > 0)
+		{
+			RpgPlatformMemory::MemZero(ValidBits.GetData(), sizeof(uint64_t) * ValidBits.GetCount());
+		}
+	}
+
+
+	// Move valid elements down into empty slots so that valid indices become [0, Count). Element addresses of moved elements change.
+	// @param optOut_IndexRemap - (Optional) Resized to GetIndexEnd() before compaction. Element at old index i is now at (*optOut_IndexRemap)[i], RPG_INDEX_INVALID for empty slot
+	// @returns Number of moved elements
+	inline int Defragment(RpgArray<int>* optOut_IndexRemap = nullptr) noexcept
+	{
+		if (optOut_IndexRemap)
+		{
+			optOut_IndexRemap->Clear();
+			optOut_IndexRemap->Resize(IndexEnd);
+
+			for (int i = 0; i < IndexEnd; ++i)
 			{
-				for (int i = 0; i < Capacity; ++i)
-				{
-					if (ValidIndexArray[i])
-					{
-						(DataArray + i)->~T();
-					}
-				}
+				(*optOut_IndexRemap)[i] = IsValid(i) ? i : RPG_INDEX_INVALID;
 			}
+		}
 
-			if (bFreeMemory)
+		int movedCount = 0;
+		int dst = FindNextEmptyIndex(0);
+		int src = IndexEnd - 1;
+
+		while (dst < src)
+		{
+			if (!IsValid(src))
 			{
-				Capacity = 0;
+				--src;
+				continue;
+			}
 
-				RpgPlatformMemory::MemFree(ValidIndexArray);
-				ValidIndexArray = nullptr;
+			T* srcSlot = GetSlot(src);
+			new (GetSlot(dst))T(std::move(*srcSlot));
 
-				RpgPlatformMemory::MemFree(DataArray);
-				DataArray = nullptr;
+			if constexpr (!std::is_trivially_copyable<T>::value)
+			{
+				srcSlot->~T();
 			}
-			else
+
+			SetValidBit(dst);
+			ClearValidBit(src);
+
+			if (optOut_IndexRemap)
 			{
-				RpgPlatformMemory::MemZero(ValidIndexArray, sizeof(bool) * Capacity);
+				(*optOut_IndexRemap)[src] = dst;
 			}
+
+			++movedCount;
+			--src;
+			dst = FindNextEmptyIndex(dst + 1);
 		}
+
+		// All empty slots are now above Count, free chain is not needed anymore
+		IndexEnd = Count;
+		NextFreeIndex = RPG_INDEX_INVALID;
+
+		return movedCount;
+	}
+
+
+	// @returns First valid index >= <startIndex>, or GetIndexEnd() if none
+	inline int FindNextValidIndex(int startIndex) const noexcept
+	{
+		if (startIndex >= IndexEnd)
+		{
+			return IndexEnd;
+		}
+
+		int wordIndex = startIndex >> 6;
+		uint64_t word = ValidBits[wordIndex] & (~0ull << (startIndex & 63));
+		const int wordEnd = (IndexEnd + 63) >> 6;
+
+		while (word == 0)
+		{
+			if (++wordIndex >= wordEnd)
+			{
+				return IndexEnd;
+			}
+
+			word = ValidBits[wordIndex];
+		}
+
+		const int index = (wordIndex << 6) + std::countr_zero(word);
+
+		return (index < IndexEnd) ? index : IndexEnd;
 	}
 
 
 	inline T& GetAt(int index) noexcept
 	{
 		RPG_AssertV(IsValid(index), "RpgFreeList: Element at index %i is not valid!", index);
-		return DataArray[index];
+		return *GetSlot(index);
 	}
 
 
 	inline const T& GetAt(int index) const noexcept
 	{
 		RPG_AssertV(IsValid(index), "RpgFreeList: Element at index %i is not valid!", index);
-		return DataArray[index];
+		return *GetSlot(index);
 	}
 
 
@@ -317,22 +477,62 @@ public:
 	}
 
 
+	// @returns One past the highest index used since last Clear/Defragment. All valid indices are below this value
+	inline int GetIndexEnd() const noexcept
+	{
+		return IndexEnd;
+	}
+
+
 	inline bool IsEmpty() const noexcept
 	{
 		return Count == 0;
 	}
 
 
+private:
+	inline int FindNextEmptyIndex(int startIndex) const noexcept
+	{
+		int wordIndex = startIndex >> 6;
+		const int wordEnd = (IndexEnd + 63) >> 6;
+
+		if (wordIndex >= wordEnd)
+		{
+			return IndexEnd;
+		}
+
+		uint64_t word = ~ValidBits[wordIndex] & (~0ull << (startIndex & 63));
+
+		while (word == 0)
+		{
+			if (++wordIndex >= wordEnd)
+			{
+				return IndexEnd;
+			}
+
+			word = ~ValidBits[wordIndex];
+		}
+
+		const int index = (wordIndex << 6) + std::countr_zero(word);
+
+		return (index < IndexEnd) ? index : IndexEnd;
+	}
+
+
 private:
 	int Capacity;
 	int Count;
+	int IndexEnd;
 	int NextFreeIndex;
 
-	// For fast checking if index is valid
-	bool* ValidIndexArray;
+	// Occupancy bitmap, one bit per slot
+	RpgArray<uint64_t> ValidBits;
 
-	// Actual data array
-	T* DataArray;
+	// Block pointers, index >> BLOCK_SHIFT
+	RpgArray<T*> Blocks;
+
+	// Allocated pages (each holds one or more consecutive blocks)
+	RpgArray<T*> Pages;
 
 
 
@@ -349,12 +549,11 @@ public:
 
 		Iterator(RpgFreeList* in_FreeList) noexcept
 			: FreeList(in_FreeList)
-			, Index(-1)
+			, Index(in_FreeList->FindNextValidIndex(0))
 		{
-			UpdateValidIndex();
 		}
 
-	
+
 	public:
 		[[nodiscard]] inline int GetIndex() const noexcept
 		{
@@ -368,7 +567,7 @@ public:
 
 		inline Iterator& operator++() noexcept
 		{
-			UpdateValidIndex();
+			Index = FreeList->FindNextValidIndex(Index + 1);
 			return *this;
 		}
 
@@ -394,23 +593,7 @@ public:
 
 		inline operator bool() const noexcept
 		{
-			return FreeList && Index >= 0 && Index < FreeList->GetCapacity();
-		}
-
-
-	private:
-		inline void UpdateValidIndex() noexcept
-		{
-			const int capacity = FreeList->GetCapacity();
-
-			do
-			{
-				if (FreeList->IsValid(++Index))
-				{
-					break;
-				}
-			}
-			while (Index < capacity);
+			return FreeList && Index >= 0 && Index < FreeList->GetIndexEnd();
 		}
 
 
@@ -433,9 +616,8 @@ public:
 
 		ConstIterator(const RpgFreeList* in_FreeList) noexcept
 			: FreeList(in_FreeList)
-			, Index(-1)
+			, Index(in_FreeList->FindNextValidIndex(0))
 		{
-			UpdateValidIndex();
 		}
 
 
@@ -452,7 +634,7 @@ public:
 
 		inline ConstIterator& operator++() noexcept
 		{
-			UpdateValidIndex();
+			Index = FreeList->FindNextValidIndex(Index + 1);
 			return *this;
 		}
 
@@ -478,23 +660,7 @@ public:
 
 		inline operator bool() const noexcept
 		{
-			return FreeList && Index >= 0 && Index < FreeList->GetCapacity();
-		}
-
-
-	private:
-		inline void UpdateValidIndex() noexcept
-		{
-			const int capacity = FreeList->GetCapacity();
-
-			do
-			{
-				if (FreeList->IsValid(++Index))
-				{
-					break;
-				}
-			}
-			while (Index < capacity);
+			return FreeList && Index >= 0 && Index < FreeList->GetIndexEnd();
 		}
 
 
@@ -1,18 +1,32 @@
 #pragma once
 
 #include "RpgArray.h"
+#include <emmintrin.h>
+#include <bit>
 
 
 
 // ============================================================================================================================================================================================== //
 // RpgMap
 // Hash map, key-value pair.
+// Keys and values are stored in dense arrays in insertion order, index is stable until entry removed. Remove without keeping order moves last entry into removed index.
+// Dense index lookup uses open-addressing table with swiss-table style control bytes (7-bit hash fragment per slot), probed 16 slots at once with SSE2.
+// Table uses linear probing with backward shift deletion, removed slots are always empty (no tombstones).
 // ============================================================================================================================================================================================== //
-#define RPG_MAP_CHECK_COLLISION	1
+
+// Default maximum ratio of entries to table slots before the table grows. Must be less than 1.0
+#define RPG_MAP_DEFAULT_MAX_LOAD_FACTOR		0.875f
 
 template<typename TUniqueKey, typename TValue>
 class RpgMap
 {
+private:
+	// Slots probed at once
+	static constexpr int GROUP_WIDTH = 16;
+
+	// Control byte of empty slot. Full slot stores 7-bit hash fragment (top bit is zero)
+	static constexpr uint8_t CONTROL_EMPTY = 0x80;
+
 
 public:
 	RpgMap() noexcept
@@ -20,6 +34,9 @@ public:
 		Hashes.Reserve(8);
 		Keys.Reserve(8);
 		Values.Reserve(8);
+
+		MaxLoadFactor = RPG_MAP_DEFAULT_MAX_LOAD_FACTOR;
+		TableGrowCount = 0;
 	}
 
 
@@ -27,6 +44,10 @@ public:
 		: Hashes(other.Hashes)
 		, Keys(other.Keys)
 		, Values(other.Values)
+		, TableControls(other.TableControls)
+		, TableSlots(other.TableSlots)
+		, MaxLoadFactor(other.MaxLoadFactor)
+		, TableGrowCount(other.TableGrowCount)
 	{
 	}
 
@@ -35,7 +56,12 @@ public:
 		: Hashes(std::move(other.Hashes))
 		, Keys(std::move(other.Keys))
 		, Values(std::move(other.Values))
+		, TableControls(std::move(other.TableControls))
+		, TableSlots(std::move(other.TableSlots))
+		, MaxLoadFactor(other.MaxLoadFactor)
+		, TableGrowCount(other.TableGrowCount)
 	{
+		other.TableGrowCount = 0;
 	}
 
 
@@ -50,6 +76,10 @@ public:
 			Hashes = rhs.Hashes;
 			Keys = rhs.Keys;
 			Values = rhs.Values;
+			TableControls = rhs.TableControls;
+			TableSlots = rhs.TableSlots;
+			MaxLoadFactor = rhs.MaxLoadFactor;
+			TableGrowCount = rhs.TableGrowCount;
 		}
 
 		return *this;
@@ -63,6 +93,11 @@ public:
 			Hashes = std::move(rhs.Hashes);
 			Keys = std::move(rhs.Keys);
 			Values = std::move(rhs.Values);
+			TableControls = std::move(rhs.TableControls);
+			TableSlots = std::move(rhs.TableSlots);
+			MaxLoadFactor = rhs.MaxLoadFactor;
+			TableGrowCount = rhs.TableGrowCount;
+			rhs.TableGrowCount = 0;
 		}
 
 		return *this;
@@ -79,7 +114,7 @@ public:
 
 	inline const TValue& operator[](const TUniqueKey& key) const noexcept
 	{
-		const int index = FindIndex(Rpg_GetHash(key));
+		const int index = FindIndex(Rpg_GetHash(key), key);
 		RPG_ValidateV(index != RPG_INDEX_INVALID, "RpgMap key not found!");
 
 		return Values[index];
@@ -92,13 +127,38 @@ public:
 		Hashes.Reserve(newCapacity);
 		Keys.Reserve(newCapacity);
 		Values.Reserve(newCapacity);
+
+		if (newCapacity > TableGrowCount)
+		{
+			Table_Rebuild(newCapacity);
+		}
+	}
+
+
+	// Set maximum ratio of entries to table slots. Lower value uses more memory but shorter probe sequence
+	// @param loadFactor - Load factor, clamped to [0.25, 0.9375]
+	// @returns None
+	inline void SetMaxLoadFactor(float loadFactor) noexcept
+	{
+		MaxLoadFactor = (loadFactor < 0.25f) ? 0.25f : (loadFactor > 0.9375f ? 0.9375f : loadFactor);
+
+		if (!TableSlots.IsEmpty())
+		{
+			Table_Rebuild(Hashes.GetCount());
+		}
+	}
+
+
+	inline float GetMaxLoadFactor() const noexcept
+	{
+		return MaxLoadFactor;
 	}
 
 
 	inline TValue& Add(const TUniqueKey& key, int* outIndex = nullptr) noexcept
 	{
 		const uint64_t hash = Rpg_GetHash(key);
-		int index = FindIndex(hash);
+		int index = FindIndex(hash, key);
 
 		if (index == RPG_INDEX_INVALID)
 		{
@@ -106,13 +166,7 @@ public:
 			Hashes.AddValue(hash);
 			Keys.AddValue(key);
 			Values.Add();
-		}
-		else
-		{
-		#if RPG_MAP_CHECK_COLLISION
-			const int keyIndex = Keys.FindFirstIndexOf(key);
-			RPG_ValidateV(keyIndex != RPG_INDEX_INVALID, "RpgMap collision!");
-		#endif // RPG_MAP_CHECK_COLLISION
+			Table_Insert(hash, index);
 		}
 
 		if (outIndex)
@@ -128,7 +182,7 @@ public:
 	inline void Add(const TUniqueKey& key, TConstructorArgs&&... args) noexcept
 	{
 		const uint64_t hash = Rpg_GetHash(key);
-		int index = FindIndex(hash);
+		int index = FindIndex(hash, key);
 
 		if (index == RPG_INDEX_INVALID)
 		{
@@ -136,14 +190,10 @@ public:
 			Hashes.AddValue(hash);
 			Keys.AddValue(key);
 			Values.AddConstruct(std::forward<TConstructorArgs>(args)...);
+			Table_Insert(hash, index);
 		}
 		else
 		{
-		#if RPG_MAP_CHECK_COLLISION
-			const int keyIndex = Keys.FindIndexByValue(key);
-			RPG_ValidateV(keyIndex != RPG_INDEX_INVALID, "RpgMap collision!");
-		#endif // RPG_MAP_CHECK_COLLISION
-
 			Values[index] = TValue(std::forward<TConstructorArgs>(args)...);
 		}
 	}
@@ -151,34 +201,31 @@ public:
 
 	inline void Remove(const TUniqueKey& key, bool bKeepOrder = false) noexcept
 	{
-		const int index = FindIndex(Rpg_GetHash(key));
+		const int slot = Table_FindSlot(Rpg_GetHash(key), key);
 
-		if (index != RPG_INDEX_INVALID)
+		if (slot != RPG_INDEX_INVALID)
 		{
-			Hashes.RemoveAt(index, bKeepOrder);
-			Keys.RemoveAt(index, bKeepOrder);
-			Values.RemoveAt(index, bKeepOrder);
+			RemoveEntry(slot, TableSlots[slot], bKeepOrder);
 		}
 	}
 
 
 	inline void RemoveAt(int index, bool bKeepOrder = false) noexcept
 	{
-		Hashes.RemoveAt(index, bKeepOrder);
-		Keys.RemoveAt(index, bKeepOrder);
-		Values.RemoveAt(index, bKeepOrder);
+		RPG_ValidateV(index >= 0 && index < Hashes.GetCount(), "RpgMap: Index (%i) out of bound!", index);
+		RemoveEntry(Table_FindSlotByIndex(Hashes[index], index), index, bKeepOrder);
 	}
 
 
 	inline int FindKeyIndex(const TUniqueKey& key) const noexcept
 	{
-		return FindIndex(Rpg_GetHash(key));
+		return FindIndex(Rpg_GetHash(key), key);
 	}
 
 
 	inline bool Exists(const TUniqueKey& key, int* optOut_Index = nullptr) const noexcept
 	{
-		const int index = FindIndex(Rpg_GetHash(key));
+		const int index = FindIndex(Rpg_GetHash(key), key);
 
 		if (optOut_Index)
 		{
@@ -209,7 +256,7 @@ public:
 
 	inline TValue* GetValueByKey(const TUniqueKey& key) noexcept
 	{
-		const int index = FindIndex(Rpg_GetHash(key));
+		const int index = FindIndex(Rpg_GetHash(key), key);
 
 		if (index == RPG_INDEX_INVALID)
 		{
@@ -222,7 +269,7 @@ public:
 
 	inline const TValue* GetValueByKey(const TUniqueKey& key) const noexcept
 	{
-		const int index = FindIndex(Rpg_GetHash(key));
+		const int index = FindIndex(Rpg_GetHash(key), key);
 
 		if (index == RPG_INDEX_INVALID)
 		{
@@ -262,6 +309,17 @@ public:
 		Hashes.Clear(bFree);
 		Keys.Clear(bFree);
 		Values.Clear(bFree);
+
+		if (bFree)
+		{
+			TableControls.Clear(true);
+			TableSlots.Clear(true);
+			TableGrowCount = 0;
+		}
+		else if (!TableControls.IsEmpty())
+		{
+			RpgPlatformMemory::MemSet(TableControls.GetData(), CONTROL_EMPTY, TableControls.GetCount());
+		}
 	}
 
 
@@ -278,23 +336,280 @@ public:
 
 
 private:
-	inline int FindIndex(uint64_t hashValue) const noexcept
+	// Mix hash bits. Integer and pointer keys use identity hash, without mixing they fill only low bits
+	static inline uint64_t MixHash(uint64_t hash) noexcept
 	{
-		for (int i = 0; i < Hashes.GetCount(); ++i)
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+
+		return hash;
+	}
+
+	// Hash fragment stored in control byte
+	static inline uint8_t GetControlHash(uint64_t mixedHash) noexcept
+	{
+		return static_cast<uint8_t>(mixedHash >> 57);
+	}
+
+	// Bit mask of slots in group [ctrl, ctrl + GROUP_WIDTH) that match control byte
+	static inline uint32_t Group_Match(const uint8_t* ctrl, uint8_t controlHash) noexcept
+	{
+		const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(controlHash)))));
+	}
+
+	// Bit mask of empty slots in group [ctrl, ctrl + GROUP_WIDTH). Only empty control byte has top bit set
+	static inline uint32_t Group_MatchEmpty(const uint8_t* ctrl) noexcept
+	{
+		const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+		return static_cast<uint32_t>(_mm_movemask_epi8(group));
+	}
+
+
+	inline int FindIndex(uint64_t hashValue, const TUniqueKey& key) const noexcept
+	{
+		const int slot = Table_FindSlot(hashValue, key);
+		return (slot != RPG_INDEX_INVALID) ? TableSlots[slot] : RPG_INDEX_INVALID;
+	}
+
+
+	inline int Table_GetHomeSlot(uint64_t mixedHash) const noexcept
+	{
+		return static_cast<int>(mixedHash & static_cast<uint64_t>(TableSlots.GetCount() - 1));
+	}
+
+
+	// Control bytes have GROUP_WIDTH extra bytes at the end that mirror the first group, so group load near the end of the table wraps around
+	inline void Table_SetControl(int slot, uint8_t control) noexcept
+	{
+		TableControls[slot] = control;
+
+		if (slot < GROUP_WIDTH)
+		{
+			TableControls[TableSlots.GetCount() + slot] = control;
+		}
+	}
+
+
+	inline int Table_FindSlot(uint64_t hashValue, const TUniqueKey& key) const noexcept
+	{
+		if (TableSlots.IsEmpty())
+		{
+			return RPG_INDEX_INVALID;
+		}
+
+		const uint64_t mixedHash = MixHash(hashValue);
+		const uint8_t controlHash = GetControlHash(mixedHash);
+		const int mask = TableSlots.GetCount() - 1;
+		const uint8_t* controls = TableControls.GetData();
+		int pos = Table_GetHomeSlot(mixedHash);
+
+		// Entry is always inside the run of full slots starting at its home slot, stop at the first group that contains empty slot
+		for (int probed = 0; probed <= mask; probed += GROUP_WIDTH)
+		{
+			uint32_t match = Group_Match(controls + pos, controlHash);
+
+			while (match)
+			{
+				const int slot = (pos + std::countr_zero(match)) & mask;
+				const int index = TableSlots[slot];
+
+				if (Hashes[index] == hashValue && Keys[index] == key)
+				{
+					return slot;
+				}
+
+				match &= match - 1;
+			}
+
+			if (Group_MatchEmpty(controls + pos))
+			{
+				break;
+			}
+
+			pos = (pos + GROUP_WIDTH) & mask;
+		}
+
+		return RPG_INDEX_INVALID;
+	}
+
+
+	inline int Table_FindSlotByIndex(uint64_t hashValue, int index) const noexcept
+	{
+		const uint64_t mixedHash = MixHash(hashValue);
+		const uint8_t controlHash = GetControlHash(mixedHash);
+		const int mask = TableSlots.GetCount() - 1;
+		const uint8_t* controls = TableControls.GetData();
+		int pos = Table_GetHomeSlot(mixedHash);
+
+		for (int probed = 0; probed <= mask; probed += GROUP_WIDTH)
 		{
-			if (Hashes[i] == hashValue)
+			uint32_t match = Group_Match(controls + pos, controlHash);
+
+			while (match)
 			{
-				return i;
+				const int slot = (pos + std::countr_zero(match)) & mask;
+
+				if (TableSlots[slot] == index)
+				{
+					return slot;
+				}
+
+				match &= match - 1;
 			}
+
+			RPG_Check(Group_MatchEmpty(controls + pos) == 0);
+			pos = (pos + GROUP_WIDTH) & mask;
 		}
 
+		RPG_CheckV(0, "RpgMap: Table slot for index (%i) not found!", index);
+
 		return RPG_INDEX_INVALID;
 	}
 
 
+	// Insert dense index of entry that does not exist in table yet
+	inline void Table_Insert(uint64_t hashValue, int index) noexcept
+	{
+		if (Hashes.GetCount() > TableGrowCount)
+		{
+			Table_Rebuild(Hashes.GetCount());
+			return;
+		}
+
+		Table_InsertNoGrow(hashValue, index);
+	}
+
+
+	inline void Table_InsertNoGrow(uint64_t hashValue, int index) noexcept
+	{
+		const uint64_t mixedHash = MixHash(hashValue);
+		const int mask = TableSlots.GetCount() - 1;
+		int pos = Table_GetHomeSlot(mixedHash);
+
+		// Load factor is less than 1.0, there is always an empty slot
+		for (;;)
+		{
+			const uint32_t empty = Group_MatchEmpty(TableControls.GetData() + pos);
+
+			if (empty)
+			{
+				const int slot = (pos + std::countr_zero(empty)) & mask;
+				Table_SetControl(slot, GetControlHash(mixedHash));
+				TableSlots[slot] = index;
+
+				return;
+			}
+
+			pos = (pos + GROUP_WIDTH) & mask;
+		}
+	}
+
+
+	// Remove slot then shift following entries of the same probe run back into the hole
+	inline void Table_EraseSlot(int slot) noexcept
+	{
+		const int mask = TableSlots.GetCount() - 1;
+		int hole = slot;
+		int next = slot;
+
+		for (;;)
+		{
+			next = (next + 1) & mask;
+
+			if (TableControls[next] == CONTROL_EMPTY)
+			{
+				break;
+			}
+
+			const int home = Table_GetHomeSlot(MixHash(Hashes[TableSlots[next]]));
+
+			// Entry can move into the hole if its home slot is not between hole (exclusive) and next (inclusive)
+			if (((next - home) & mask) >= ((next - hole) & mask))
+			{
+				Table_SetControl(hole, TableControls[next]);
+				TableSlots[hole] = TableSlots[next];
+				hole = next;
+			}
+		}
+
+		Table_SetControl(hole, CONTROL_EMPTY);
+	}
+
+
+	// Resize table to fit <count> entries then reinsert all entries
+	inline void Table_Rebuild(int count) noexcept
+	{
+		int capacity = GROUP_WIDTH;
+
+		while (static_cast<float>(count) > static_cast<float>(capacity) * MaxLoadFactor)
+		{
+			capacity <<= 1;
+		}
+
+		TableSlots.Resize(capacity);
+		TableControls.Resize(capacity + GROUP_WIDTH);
+		RpgPlatformMemory::MemSet(TableControls.GetData(), CONTROL_EMPTY, TableControls.GetCount());
+
+		TableGrowCount = static_cast<int>(static_cast<float>(capacity) * MaxLoadFactor);
+
+		for (int i = 0; i < Hashes.GetCount(); ++i)
+		{
+			Table_InsertNoGrow(Hashes[i], i);
+		}
+	}
+
+
+	inline void RemoveEntry(int slot, int index, bool bKeepOrder) noexcept
+	{
+		RPG_Check(slot != RPG_INDEX_INVALID && TableSlots[slot] == index);
+
+		// Hashes must be intact while erasing, backward shift reads hashes of following entries
+		Table_EraseSlot(slot);
+
+		const int lastIndex = Hashes.GetCount() - 1;
+
+		if (index != lastIndex)
+		{
+			if (bKeepOrder)
+			{
+				// Entries after index shift left
+				for (int s = 0; s < TableSlots.GetCount(); ++s)
+				{
+					if (TableControls[s] != CONTROL_EMPTY && TableSlots[s] > index)
+					{
+						--TableSlots[s];
+					}
+				}
+			}
+			else
+			{
+				// Last entry moves into index
+				TableSlots[Table_FindSlotByIndex(Hashes[lastIndex], lastIndex)] = index;
+			}
+		}
+
+		Hashes.RemoveAt(index, bKeepOrder);
+		Keys.RemoveAt(index, bKeepOrder);
+		Values.RemoveAt(index, bKeepOrder);
+	}
+
+
 private:
 	RpgArray<uint64_t> Hashes;
 	RpgArray<TUniqueKey> Keys;
 	RpgArray<TValue> Values;
 
+	// Control byte per slot (+ GROUP_WIDTH mirrored bytes). Table capacity is power of two
+	RpgArray<uint8_t> TableControls;
+
+	// Dense index per slot
+	RpgArray<int> TableSlots;
+
+	float MaxLoadFactor;
+
+	// Maximum entry count before the table grows
+	int TableGrowCount;
+
 };
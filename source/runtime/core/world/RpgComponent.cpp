@@ -0,0 +1,134 @@
+#include "RpgComponent.h"
+
+
+
+RpgComponentArchetype::RpgComponentArchetype(RpgComponentSignature in_Signature, const RpgComponentTypeInfo* in_TypeInfos) noexcept
+{
+	Signature = in_Signature;
+	ChunkCapacity = 0;
+	Count = 0;
+	TypeInfos = in_TypeInfos;
+
+	RpgPlatformMemory::MemSet(ComponentOffsets, 0xFF, sizeof(ComponentOffsets));
+
+	// Bytes per row: game object index + each component
+	uint32_t rowSize = sizeof(int);
+
+	for (int t = 0; t < RPG_COMPONENT_TYPE_MAX_COUNT; ++t)
+	{
+		if (HasComponent(t))
+		{
+			// Chunk memory is aligned to 16 bytes (default heap alignment on x64)
+			RPG_CheckV(TypeInfos[t].Alignment <= 16, "RpgComponentArchetype: Component (%s) alignment exceeds 16 bytes!", TypeInfos[t].Name);
+			rowSize += TypeInfos[t].Size;
+		}
+	}
+
+	// Shrink capacity until arrays with alignment padding fit into chunk
+	int capacity = RPG_COMPONENT_CHUNK_SIZE / rowSize;
+	RPG_CheckV(capacity > 0, "RpgComponentArchetype: Components size exceeds chunk size!");
+
+	for (;;)
+	{
+		uint32_t offset = sizeof(int) * capacity;
+
+		for (int t = 0; t < RPG_COMPONENT_TYPE_MAX_COUNT; ++t)
+		{
+			if (HasComponent(t))
+			{
+				offset = RpgType::Align(offset, 16u);
+				ComponentOffsets[t] = offset;
+				offset += TypeInfos[t].Size * capacity;
+			}
+		}
+
+		if (offset <= RPG_COMPONENT_CHUNK_SIZE || capacity == 1)
+		{
+			break;
+		}
+
+		--capacity;
+	}
+
+	ChunkCapacity = capacity;
+}
+
+
+RpgComponentArchetype::~RpgComponentArchetype() noexcept
+{
+	for (int row = 0; row < Count; ++row)
+	{
+		for (int t = 0; t < RPG_COMPONENT_TYPE_MAX_COUNT; ++t)
+		{
+			if (HasComponent(t))
+			{
+				TypeInfos[t].Destruct(GetComponentData(t, row));
+			}
+		}
+	}
+
+	for (int i = 0; i < Chunks.GetCount(); ++i)
+	{
+		RpgPlatformMemory::MemFree(Chunks[i]);
+	}
+}
+
+
+int RpgComponentArchetype::AddRow(int gameObjectIndex) noexcept
+{
+	if (Count == Chunks.GetCount() * ChunkCapacity)
+	{
+		uint8_t* chunk = reinterpret_cast<uint8_t*>(RpgPlatformMemory::MemMallocTag(RPG_COMPONENT_CHUNK_SIZE, RpgPlatformMemory::TAG_WORLD));
+		RPG_Check(chunk);
+		Chunks.AddValue(chunk);
+	}
+
+	const int row = Count++;
+	reinterpret_cast<int*>(Chunks[row / ChunkCapacity])[row % ChunkCapacity] = gameObjectIndex;
+
+	return row;
+}
+
+
+int RpgComponentArchetype::RemoveRow(int row) noexcept
+{
+	RPG_Check(row >= 0 && row < Count);
+
+	const int lastRow = Count - 1;
+	int movedGameObjectIndex = RPG_INDEX_INVALID;
+
+	for (int t = 0; t < RPG_COMPONENT_TYPE_MAX_COUNT; ++t)
+	{
+		if (!HasComponent(t))
+		{
+			continue;
+		}
+
+		void* data = GetComponentData(t, row);
+		TypeInfos[t].Destruct(data);
+
+		if (row != lastRow)
+		{
+			void* lastData = GetComponentData(t, lastRow);
+			TypeInfos[t].MoveConstruct(data, lastData);
+			TypeInfos[t].Destruct(lastData);
+		}
+	}
+
+	if (row != lastRow)
+	{
+		movedGameObjectIndex = GetGameObjectIndex(lastRow);
+		reinterpret_cast<int*>(Chunks[row / ChunkCapacity])[row % ChunkCapacity] = movedGameObjectIndex;
+	}
+
+	--Count;
+
+	// Release chunk once it becomes empty
+	if (Count == (Chunks.GetCount() - 1) * ChunkCapacity)
+	{
+		RpgPlatformMemory::MemFree(Chunks[Chunks.GetCount() - 1]);
+		Chunks.RemoveAtLast();
+	}
+
+	return movedGameObjectIndex;
+}
@@ -1,19 +1,27 @@
 #pragma once
 
-#include "../dsa/RpgFreeList.h"
+#include "../RpgThreadPool.h"
+#include "../RpgStream.h"
 #include "RpgGameObject.h"
 
 
 class RpgWorld;
+class RpgWorldCommandBuffer;
+struct RpgWorldSubsystemAccess;
 
 
 #define RPG_COMPONENT_ID_INVALID		UINT16_MAX
 #define RPG_COMPONENT_TYPE_MAX_COUNT	16
 
+// Size of archetype chunk memory in bytes
+#define RPG_COMPONENT_CHUNK_SIZE		(16 * 1024)
+
 
 
 #define RPG_COMPONENT_TYPE(name)																	\
 friend RpgWorld;																					\
+friend RpgWorldCommandBuffer;																		\
+friend RpgWorldSubsystemAccess;																		\
 private:																							\
 inline static uint16_t TYPE_ID = UINT16_MAX;														\
 public:																								\
@@ -22,70 +30,476 @@ RpgGameObjectID GameObject;
 
 
 
+// Bit per component TYPE_ID
+typedef uint16_t RpgComponentSignature;
+
+
 
-class RpgComponentStorageInterface
+// Type erased component functions used by archetype to construct/move/destruct components
+struct RpgComponentTypeInfo
 {
-	RPG_NOCOPY(RpgComponentStorageInterface)
+	const char* Name{ nullptr };
+	uint32_t Size{ 0 };
+	uint32_t Alignment{ 0 };
+	void(*DefaultConstruct)(void* dst) noexcept = nullptr;
+	void(*MoveConstruct)(void* dst, void* src) noexcept = nullptr;
+	void(*Destruct)(void* data) noexcept = nullptr;
+
+	// Calls component Destroy() before the component is removed from game object
+	void(*Destroy)(void* data) noexcept = nullptr;
+
+	void(*SetGameObject)(void* data, RpgGameObjectID gameObject) noexcept = nullptr;
+
+	// World snapshot. Trivially copyable component is copied as raw memory block (bSnapshotBulkCopy),
+	// otherwise component must implement Serialize(RpgStreamWriter&) const and Deserialize(RpgStreamReader&) to be saved
+	void(*Serialize)(const void* data, RpgStreamWriter& writer) noexcept = nullptr;
+	void(*Deserialize)(void* data, RpgStreamReader& reader) noexcept = nullptr;
+	bool bSnapshotBulkCopy{ false };
+
+	// Optional, component implements bool IsSnapshotSupported() const when its data can not always be saved (eg. asset reference that can not be resolved on load).
+	// Null if component is always supported
+	bool(*IsSnapshotSupported)(const void* data) noexcept = nullptr;
+
+	// Hash of name, memory layout and SNAPSHOT_VERSION of component. Snapshot data with different hash is not loaded.
+	// 0 if component is not saved into snapshot
+	uint64_t SchemaHash{ 0 };
+
+
+	template<typename TComponent>
+	[[nodiscard]] static inline RpgComponentTypeInfo Create() noexcept
+	{
+		static_assert(std::is_move_constructible<TComponent>::value, "RpgComponentTypeInfo: Component type must be move constructible!");
+
+		RpgComponentTypeInfo info;
+		info.Name = TComponent::TYPE_NAME;
+		info.Size = sizeof(TComponent);
+		info.Alignment = alignof(TComponent);
+		info.DefaultConstruct = [](void* dst) noexcept { new (dst)TComponent(); };
+		info.MoveConstruct = [](void* dst, void* src) noexcept { new (dst)TComponent(std::move(*static_cast<TComponent*>(src))); };
+		info.Destruct = [](void* data) noexcept { static_cast<TComponent*>(data)->~TComponent(); };
+		info.Destroy = [](void* data) noexcept { static_cast<TComponent*>(data)->Destroy(); };
+		info.SetGameObject = [](void* data, RpgGameObjectID gameObject) noexcept { static_cast<TComponent*>(data)->GameObject = gameObject; };
+
+		if constexpr (requires(const TComponent& component, TComponent& out_Component, RpgStreamWriter& writer, RpgStreamReader& reader) { component.Serialize(writer); out_Component.Deserialize(reader); })
+		{
+			static_assert(requires { TComponent::SNAPSHOT_VERSION; }, "RpgComponentTypeInfo: Component with Serialize must declare SNAPSHOT_VERSION!");
+
+			info.Serialize = [](const void* data, RpgStreamWriter& writer) noexcept { static_cast<const TComponent*>(data)->Serialize(writer); };
+			info.Deserialize = [](void* data, RpgStreamReader& reader) noexcept { static_cast<TComponent*>(data)->Deserialize(reader); };
+
+			if constexpr (requires(const TComponent& component) { component.IsSnapshotSupported(); })
+			{
+				info.IsSnapshotSupported = [](const void* data) noexcept { return static_cast<const TComponent*>(data)->IsSnapshotSupported(); };
+			}
+		}
+		else if constexpr (std::is_trivially_copyable<TComponent>::value)
+		{
+			info.bSnapshotBulkCopy = true;
+		}
+
+		if (info.bSnapshotBulkCopy || info.Serialize)
+		{
+			// Layout change of bulk copied component is caught by size and alignment, serialized data format is only caught by version.
+			// Component with Serialize must declare static constexpr uint32_t SNAPSHOT_VERSION and bump it whenever serialized data changes.
+			// Bulk copied component may declare it too
+			uint64_t snapshotVersion = 0;
+
+			if constexpr (requires { TComponent::SNAPSHOT_VERSION; })
+			{
+				snapshotVersion = TComponent::SNAPSHOT_VERSION;
+			}
+
+			info.SchemaHash = RpgPlatformString::CStringHash(info.Name);
+			info.SchemaHash = (info.SchemaHash ^ info.Size) * 0x9E3779B97F4A7C15ull;
+			info.SchemaHash = (info.SchemaHash ^ info.Alignment ^ (static_cast<uint64_t>(info.bSnapshotBulkCopy) << 8)) * 0x9E3779B97F4A7C15ull;
+			info.SchemaHash = (info.SchemaHash ^ snapshotVersion) * 0x9E3779B97F4A7C15ull;
+			info.SchemaHash = info.SchemaHash ? info.SchemaHash : 1;
+		}
+
+		return info;
+	}
+
+};
+
+
+
+// Storage of all game objects that have exactly the same component signature.
+// Objects are packed into rows [0, Count). Each chunk (RPG_COMPONENT_CHUNK_SIZE bytes) stores game object index array followed by one contiguous array per component type.
+// Removing row moves the last row into it, so component address of other objects in this archetype may change.
+class RpgComponentArchetype
+{
+	RPG_NOCOPY(RpgComponentArchetype)
 
 public:
-	RpgComponentStorageInterface() noexcept = default;
-	virtual ~RpgComponentStorageInterface() noexcept = default;
+	RpgComponentArchetype(RpgComponentSignature in_Signature, const RpgComponentTypeInfo* in_TypeInfos) noexcept;
+	~RpgComponentArchetype() noexcept;
+
+
+	// Add row at the end. Components of the new row are not constructed
+	// @param gameObjectIndex - Game object index stored for the row
+	// @returns Row index
+	[[nodiscard]] int AddRow(int gameObjectIndex) noexcept;
+
+	// Destruct components at row, then move the last row into it
+	// @param row - Row index
+	// @returns Game object index of the row moved into <row>, RPG_INDEX_INVALID if <row> was the last row
+	int RemoveRow(int row) noexcept;
+
+
+	[[nodiscard]] inline bool HasComponent(int typeId) const noexcept
+	{
+		return Signature & (1u << typeId);
+	}
+
+	[[nodiscard]] inline void* GetComponentData(int typeId, int row) const noexcept
+	{
+		RPG_Check(HasComponent(typeId) && row >= 0 && row < Count);
+		return Chunks[row / ChunkCapacity] + ComponentOffsets[typeId] + static_cast<size_t>(row % ChunkCapacity) * TypeInfos[typeId].Size;
+	}
+
+	// @returns Component array of chunk, GetChunkRowCount(chunkIndex) elements
+	template<typename TComponent>
+	[[nodiscard]] inline TComponent* GetChunkComponents(int typeId, int chunkIndex) const noexcept
+	{
+		RPG_Check(HasComponent(typeId));
+		return reinterpret_cast<TComponent*>(Chunks[chunkIndex] + ComponentOffsets[typeId]);
+	}
+
+	[[nodiscard]] inline const int* GetChunkGameObjectIndices(int chunkIndex) const noexcept
+	{
+		return reinterpret_cast<const int*>(Chunks[chunkIndex]);
+	}
 
-	virtual void Remove(int index) noexcept = 0;
+	[[nodiscard]] inline int GetGameObjectIndex(int row) const noexcept
+	{
+		RPG_Check(row >= 0 && row < Count);
+		return GetChunkGameObjectIndices(row / ChunkCapacity)[row % ChunkCapacity];
+	}
+
+	[[nodiscard]] inline int GetChunkRowCount(int chunkIndex) const noexcept
+	{
+		const int remaining = Count - chunkIndex * ChunkCapacity;
+		return (remaining < ChunkCapacity) ? remaining : ChunkCapacity;
+	}
+
+	[[nodiscard]] inline int GetChunkCount() const noexcept
+	{
+		return Chunks.GetCount();
+	}
+
+	[[nodiscard]] inline int GetChunkCapacity() const noexcept
+	{
+		return ChunkCapacity;
+	}
+
+	[[nodiscard]] inline int GetCount() const noexcept
+	{
+		return Count;
+	}
+
+	[[nodiscard]] inline RpgComponentSignature GetSignature() const noexcept
+	{
+		return Signature;
+	}
+
+
+private:
+	RpgComponentSignature Signature;
+	int ChunkCapacity;
+	int Count;
+
+	// Byte offset of component array inside chunk
+	uint32_t ComponentOffsets[RPG_COMPONENT_TYPE_MAX_COUNT];
+
+	// Owned by world
+	const RpgComponentTypeInfo* TypeInfos;
+
+	RpgArray<uint8_t*> Chunks;
 
 };
 
 
+
+// Iterate every component of one type over all archetypes. TComponent may be const qualified.
+// Adding/removing components while iterating is not allowed.
 template<typename TComponent>
-class RpgComponentStorage : public RpgComponentStorageInterface
+class RpgComponentIterator
+{
+public:
+	RpgComponentIterator() noexcept
+		: Archetypes(nullptr)
+		, ArchetypeCount(0)
+		, TypeId(0)
+		, ArchetypeIndex(0)
+		, Row(0)
+	{
+	}
+
+	RpgComponentIterator(RpgComponentArchetype* const* in_Archetypes, int in_ArchetypeCount, int in_TypeId) noexcept
+		: Archetypes(in_Archetypes)
+		, ArchetypeCount(in_ArchetypeCount)
+		, TypeId(in_TypeId)
+		, ArchetypeIndex(-1)
+		, Row(0)
+	{
+		NextArchetype();
+	}
+
+
+public:
+	[[nodiscard]] inline TComponent& GetValue() const noexcept
+	{
+		return *static_cast<TComponent*>(Archetypes[ArchetypeIndex]->GetComponentData(TypeId, Row));
+	}
+
+	inline RpgComponentIterator& operator++() noexcept
+	{
+		if (++Row >= Archetypes[ArchetypeIndex]->GetCount())
+		{
+			NextArchetype();
+		}
+
+		return *this;
+	}
+
+	inline TComponent& operator*() const noexcept
+	{
+		return GetValue();
+	}
+
+	inline TComponent* operator->() const noexcept
+	{
+		return &GetValue();
+	}
+
+	inline bool operator==(const RpgComponentIterator& rhs) const noexcept
+	{
+		return Archetypes == rhs.Archetypes && ArchetypeIndex == rhs.ArchetypeIndex && Row == rhs.Row;
+	}
+
+	inline bool operator!=(const RpgComponentIterator& rhs) const noexcept
+	{
+		return !(*this == rhs);
+	}
+
+	inline operator bool() const noexcept
+	{
+		return Archetypes && ArchetypeIndex < ArchetypeCount;
+	}
+
+
+private:
+	inline void NextArchetype() noexcept
+	{
+		Row = 0;
+
+		while (++ArchetypeIndex < ArchetypeCount)
+		{
+			const RpgComponentArchetype* archetype = Archetypes[ArchetypeIndex];
+
+			if (archetype->HasComponent(TypeId) && archetype->GetCount() > 0)
+			{
+				break;
+			}
+		}
+	}
+
+
+private:
+	RpgComponentArchetype* const* Archetypes;
+	int ArchetypeCount;
+	int TypeId;
+	int ArchetypeIndex;
+	int Row;
+
+};
+
+
+
+// Chunks of all archetypes that contain every component in TComponents. Created by RpgWorld::Component_Query.
+// Matching chunks are collected on creation, adding/removing components invalidates the query.
+template<typename... TComponents>
+class RpgComponentQuery
 {
+	static_assert(sizeof...(TComponents) > 0, "RpgComponentQuery: Requires at least one component type!");
+
+public:
+	struct FChunk
+	{
+		RpgComponentArchetype* Archetype;
+		int ChunkIndex;
+		int Count;
+	};
+
 
 public:
-	RpgComponentStorage() noexcept = default;
-	
-	~RpgComponentStorage() noexcept
+	RpgComponentQuery(RpgComponentArchetype* const* archetypes, int archetypeCount, const uint16_t (&in_TypeIds)[sizeof...(TComponents)]) noexcept
+		: TotalCount(0)
 	{
-		RPG_LogDebug(RpgLogTemp, "Destroy component storage (%s)", TComponent::TYPE_NAME);
+		RpgComponentSignature signature = 0;
+
+		for (int t = 0; t < static_cast<int>(sizeof...(TComponents)); ++t)
+		{
+			TypeIds[t] = in_TypeIds[t];
+			signature |= static_cast<RpgComponentSignature>(1u << TypeIds[t]);
+		}
+
+		for (int a = 0; a < archetypeCount; ++a)
+		{
+			RpgComponentArchetype* archetype = archetypes[a];
+
+			if ((archetype->GetSignature() & signature) != signature)
+			{
+				continue;
+			}
+
+			for (int c = 0; c < archetype->GetChunkCount(); ++c)
+			{
+				const int count = archetype->GetChunkRowCount(c);
+
+				if (count > 0)
+				{
+					Chunks.AddValue({ archetype, c, count });
+					ChunkFirstElements.AddValue(TotalCount);
+					TotalCount += count;
+				}
+			}
+		}
 	}
 
 
-	inline bool IsValid(int id) const noexcept 
+	[[nodiscard]] inline int GetChunkCount() const noexcept
 	{
-		return Components.IsValid(id);
+		return Chunks.GetCount();
 	}
 
-	[[nodiscard]] inline int Add() noexcept 
+	[[nodiscard]] inline const FChunk& GetChunk(int chunkIndex) const noexcept
 	{
-		return Components.Add();
+		return Chunks[chunkIndex];
 	}
 
-	virtual void Remove(int id) noexcept override
+	// @returns Number of game objects matching query
+	[[nodiscard]] inline int GetCount() const noexcept
 	{
-		Components.RemoveAt(id);
+		return TotalCount;
 	}
 
-	inline TComponent& Get(int id) noexcept
+	// @returns Component array of chunk, GetChunk(chunkIndex).Count elements
+	template<typename TComponent>
+	[[nodiscard]] inline TComponent* GetChunkComponents(int chunkIndex) const noexcept
 	{
-		return Components.GetAt(id);
+		static_assert(GetTypeSlot<TComponent>() >= 0, "RpgComponentQuery: Component type is not part of query!");
+
+		const FChunk& chunk = Chunks[chunkIndex];
+		return chunk.Archetype->template GetChunkComponents<TComponent>(TypeIds[GetTypeSlot<TComponent>()], chunk.ChunkIndex);
 	}
 
-	inline const TComponent& Get(int id) const noexcept
+
+	// Call function(TComponents&...) for each game object matching query
+	template<typename TFunction>
+	inline void ForEach(TFunction&& function) const noexcept
 	{
-		return Components.GetAt(id);
+		for (int c = 0; c < Chunks.GetCount(); ++c)
+		{
+			ForEachInChunk(c, 0, Chunks[c].Count, function);
+		}
 	}
 
-	inline RpgFreeList<TComponent>& GetComponents() noexcept
+
+	// Call function(int count, TComponents*...) for each chunk matching query
+	template<typename TFunction>
+	inline void ForEachChunk(TFunction&& function) const noexcept
 	{
-		return Components;
+		for (int c = 0; c < Chunks.GetCount(); ++c)
+		{
+			function(Chunks[c].Count, GetChunkComponents<TComponents>(c)...);
+		}
 	}
 
-	inline const RpgFreeList<TComponent>& GetComponents() const noexcept
+
+	// [Block] Call function(TComponents&...) for each game object matching query, distributed over worker threads.
+	// Elements of all chunks are split into ranges of at least <minChunkSize>, range never crosses chunk boundary.
+	template<typename TFunction>
+	inline void ParallelForEach(TFunction&& function, int minChunkSize = RPG_THREAD_POOL_PARALLEL_FOR_MIN_CHUNK) const noexcept
 	{
-		return Components;
+		RpgThreadPool::ParallelForRange(TotalCount,
+			[this, &function](int begin, int end)
+			{
+				// Chunk containing <begin>
+				int c = RpgAlgorithm::BinarySearch_UpperBound(ChunkFirstElements.GetData(), ChunkFirstElements.GetCount(), begin) - 1;
+
+				while (begin < end)
+				{
+					const int chunkBegin = ChunkFirstElements[c];
+					const int chunkEnd = chunkBegin + Chunks[c].Count;
+					const int rangeEnd = (end < chunkEnd) ? end : chunkEnd;
+
+					ForEachInChunk(c, begin - chunkBegin, rangeEnd - chunkBegin, function);
+
+					begin = rangeEnd;
+					++c;
+				}
+			}
+			, minChunkSize
+		);
+	}
+
+
+	// [Block] Call function(int count, TComponents*...) for each chunk matching query, one chunk per worker task
+	template<typename TFunction>
+	inline void ParallelForEachChunk(TFunction&& function) const noexcept
+	{
+		RpgThreadPool::ParallelFor(Chunks.GetCount(),
+			[this, &function](int c)
+			{
+				function(Chunks[c].Count, GetChunkComponents<TComponents>(c)...);
+			}
+			, 1
+		);
+	}
+
+
+private:
+	template<typename TComponent>
+	static constexpr int GetTypeSlot() noexcept
+	{
+		constexpr bool MATCHES[] = { std::is_same<TComponent, TComponents>::value... };
+
+		for (int i = 0; i < static_cast<int>(sizeof...(TComponents)); ++i)
+		{
+			if (MATCHES[i])
+			{
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+
+	template<typename TFunction>
+	inline void ForEachInChunk(int chunkIndex, int begin, int end, TFunction& function) const noexcept
+	{
+		ForEachInChunk_Implementation(function, begin, end, GetChunkComponents<TComponents>(chunkIndex)...);
+	}
+
+	template<typename TFunction, typename... TArrays>
+	static inline void ForEachInChunk_Implementation(TFunction& function, int begin, int end, TArrays*... arrays) noexcept
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			function(arrays[i]...);
+		}
 	}
 
 
 private:
-	RpgFreeList<TComponent> Components;
+	uint16_t TypeIds[sizeof...(TComponents)];
+	RpgArray<FChunk> Chunks;
+
+	// First element index (over all chunks) of each chunk, used to map parallel ranges into chunks
+	RpgArray<int> ChunkFirstElements;
+
+	int TotalCount;
 
 };
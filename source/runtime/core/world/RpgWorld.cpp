@@ -1,9 +1,15 @@
 #include "RpgWorld.h"
+#include "../RpgProfiler.h"
 
 
 RPG_LOG_DEFINE_CATEGORY(RpgLogWorld, VERBOSITY_DEBUG)
 
 
+// Command buffer slot of the calling thread, shared by all worlds
+static RpgAtomicInt CommandBufferThreadCount = 0;
+static thread_local int ThisThreadCommandBufferSlot = RPG_INDEX_INVALID;
+
+
 
 RpgWorld::RpgWorld(const RpgName& name) noexcept
 {
@@ -11,7 +17,32 @@ RpgWorld::RpgWorld(const RpgName& name) noexcept
 
     Name = name;
     bHasStartedPlay = false;
+    bInTickStep = false;
     FrameIndex = 0;
+
+    SubsystemTickDeltaTime = 0.0f;
+    bSubsystemGraphDirty = true;
+    bSubsystemGraphDispatched = false;
+
+    ComponentTypeCount = 0;
+    bTransformHierarchyDirty = false;
+
+    ChangeListGameObjects.Resize(RPG_WORLD_MAX_GAMEOBJECT);
+    ChangeListCount = 0;
+    ChangeListStamp = 0;
+
+    TransformStepGameObjects.Resize(RPG_WORLD_MAX_GAMEOBJECT);
+    TransformStepCount = 0;
+
+    RpgPlatformMemory::MemZero(CommandBuffers, sizeof(CommandBuffers));
+    GameObjectReservedIndexEnd = 0;
+    GameObjectCount = 0;
+
+    for (int i = 0; i < RPG_WORLD_MAX_SUBSYSTEM; ++i)
+    {
+        SubsystemTickTasks[i].World = this;
+        SubsystemTickTasks[i].NodeIndex = i;
+    }
 }
 
 
@@ -19,15 +50,20 @@ RpgWorld::~RpgWorld() noexcept
 {
     RPG_LogDebug(RpgLogWorld, "Destroy world (%s)", *Name);
 
-    for (int i = 0; i < ComponentStorages.GetCount(); ++i)
+    SubsystemGraph_Wait();
+
+    for (int i = 0; i < RPG_WORLD_MAX_COMMAND_BUFFER; ++i)
     {
-        if (ComponentStorages[i])
-        {
-            delete ComponentStorages[i];
-            ComponentStorages[i] = nullptr;
-        }
+        delete CommandBuffers[i];
+    }
+
+    for (int i = 0; i < ComponentArchetypes.GetCount(); ++i)
+    {
+        delete ComponentArchetypes[i];
     }
 
+    ComponentArchetypes.Clear(true);
+
     for (int i = 0; i < Subsystems.GetCount(); ++i)
     {
         RPG_LogDebug(RpgLogWorld, "Destroy subsystem (%s)", *Subsystems[i]->Name);
@@ -44,29 +80,34 @@ void RpgWorld::BeginFrame(int frameIndex) noexcept
     for (int i = 0; i < frame.PendingDestroyObjects.GetCount(); ++i)
     {
         const int index = frame.PendingDestroyObjects[i];
+        GameObject_ChangeArchetype(index, 0);
+
+        // Invalidate existing handles, then slot can be reused. Slot is retired once generation is exhausted
         FGameObjectInfo& info = GameObjectInfos[index];
+        info.Flags = 0;
 
-        for (int c = 0; c < RPG_COMPONENT_TYPE_MAX_COUNT; ++c)
+        if (++info.Gen < UINT16_MAX)
         {
-            if (info.ComponentIndices[c] != RPG_COMPONENT_ID_INVALID)
-            {
-                ComponentStorages[c]->Remove(info.ComponentIndices[c]);
-                info.ComponentIndices[c] = RPG_COMPONENT_ID_INVALID;
-            }
+            GameObjectFreeIndices.AddValue(index);
         }
-
-        info.Flags = 0;
     }
+
+    frame.PendingDestroyObjects.Clear();
 }
 
 
 void RpgWorld::EndFrame(int frameIndex) noexcept
 {
-    for (auto it = GameObjectInfos.CreateIterator(); it; ++it)
+    RPG_IsMainThread();
+
+    // Only changed game objects can have transform updated flag
+    for (int i = 0; i < ChangeListCount; ++i)
     {
-        FGameObjectInfo& gameObjectInfo = it.GetValue();
-        gameObjectInfo.Flags &= ~FLAG_TransformUpdated;
+        GameObjectInfos[ChangeListGameObjects[i]].Flags &= ~FLAG_TransformUpdated;
     }
+
+    ChangeListCount = 0;
+    ++ChangeListStamp;
 }
 
 
@@ -128,10 +169,16 @@ void RpgWorld::DispatchStopPlay() noexcept
 
 void RpgWorld::DispatchTickUpdate(float deltaTime) noexcept
 {
-    for (int i = 0; i < Subsystems.GetCount(); ++i)
-    {
-        Subsystems[i]->TickUpdate(deltaTime);
-    }
+    // Scripts may access anything, tick them before subsystems
+    DispatchScriptTickUpdate(deltaTime);
+    DispatchSubsystemTickUpdate(deltaTime);
+}
+
+
+void RpgWorld::DispatchScriptTickUpdate(float deltaTime) noexcept
+{
+    RPG_IsMainThread();
+    RPG_Check(!bSubsystemGraphDispatched);
 
     for (int i = 0; i < GameObjectScripts.GetCount(); ++i)
     {
@@ -140,85 +187,1568 @@ void RpgWorld::DispatchTickUpdate(float deltaTime) noexcept
 
         script->TickUpdate(deltaTime);
     }
+
+    PlaybackCommandBuffers();
+    UpdateTransformHierarchy();
+}
+
+
+void RpgWorld::DispatchSubsystemTickUpdate(float deltaTime) noexcept
+{
+    RPG_IsMainThread();
+    RPG_Check(!bSubsystemGraphDispatched);
+
+    if (bSubsystemGraphDirty)
+    {
+        SubsystemGraph_Build();
+    }
+
+    const int nodeCount = Subsystems.GetCount();
+    if (nodeCount == 0)
+    {
+        return;
+    }
+
+    SubsystemTickDeltaTime = deltaTime;
+
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        FSubsystemNode& node = SubsystemNodes[i];
+        InterlockedExchange(&node.PendingDependencyCount, node.DependencyCount);
+        SubsystemTickTasks[i].Reset();
+    }
+
+    bSubsystemGraphDispatched = true;
+
+    // Submit root nodes, the rest are submitted by worker thread when their dependencies finished
+    RpgArrayInline<RpgThreadTask*, RPG_WORLD_MAX_SUBSYSTEM> submitTasks;
+
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        const FSubsystemNode& node = SubsystemNodes[i];
+
+        if (node.DependencyCount == 0 && !node.Access.bMainThread)
+        {
+            submitTasks.AddValue(&SubsystemTickTasks[i]);
+        }
+    }
+
+    if (submitTasks.GetCount() > 0)
+    {
+        RpgThreadPool::SubmitTasks(submitTasks.GetData(), submitTasks.GetCount());
+    }
+
+    // Execute main thread nodes in order
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        FSubsystemNode& node = SubsystemNodes[i];
+        if (!node.Access.bMainThread)
+        {
+            continue;
+        }
+
+        // Dependency releases this node before its task is done. Wait helps executing tasks, then parks (counted in thread pool wait stats)
+        for (int d = 0; d < nodeCount; ++d)
+        {
+            if (SubsystemNodes[d].Dependents.FindIndexByValue(i) != RPG_INDEX_INVALID)
+            {
+                SubsystemTickTasks[d].WaitUntilDone();
+            }
+        }
+
+        RPG_Check(node.PendingDependencyCount == 0);
+
+        FSubsystemTickTask& task = SubsystemTickTasks[i];
+        task.SetRunning();
+        task.Execute();
+        task.SetDone();
+    }
 }
 
 
 void RpgWorld::DispatchPostTickUpdate() noexcept
 {
+    // Sync point
+    SubsystemGraph_Wait();
+
     for (int i = 0; i < Subsystems.GetCount(); ++i)
     {
         Subsystems[i]->PostTickUpdate();
     }
+
+    PlaybackCommandBuffers();
+    UpdateTransformHierarchy();
 }
 
 
-void RpgWorld::DispatchRender(int frameIndex, RpgRenderer* renderer) noexcept
+void RpgWorld::BeginTickStep() noexcept
 {
-    for (int i = 0; i < Subsystems.GetCount(); ++i)
+    RPG_IsMainThread();
+    RPG_Check(!bInTickStep && !bSubsystemGraphDispatched);
+
+    // Objects moved during previous tick step start interpolation from their current transform.
+    // Slot destroyed since then has its flags cleared and is skipped
+    for (int i = 0; i < TransformStepCount; ++i)
     {
-        Subsystems[i]->Render(frameIndex, renderer);
+        const int index = TransformStepGameObjects[i];
+        FGameObjectInfo& info = GameObjectInfos[index];
+
+        if (info.Flags & FLAG_TransformStepUpdated)
+        {
+            FGameObjectTransform& transform = GameObjectTransforms[index];
+            transform.PrevWorldMatrix = transform.WorldMatrix;
+            info.Flags &= ~FLAG_TransformStepUpdated;
+        }
     }
+
+    TransformStepCount = 0;
+    bInTickStep = true;
 }
 
 
-RpgGameObjectID RpgWorld::GameObject_Create(const RpgName& name, const RpgTransform& worldTransform) noexcept
+void RpgWorld::EndTickStep() noexcept
 {
     RPG_IsMainThread();
+    RPG_Check(bInTickStep && !bSubsystemGraphDispatched);
 
-    RPG_Assert(!name.IsEmpty());
-    RPG_Check(GameObjectNames.GetCount() < RPG_WORLD_MAX_GAMEOBJECT);
+    bInTickStep = false;
+}
 
-    RPG_LogDebug(RpgLogWorld, "Create game object (%s)", *name);
 
-    const int nameId = GameObjectNames.Add();
-    const int infoId = GameObjectInfos.Add();
-    const int transformId = GameObjectTransforms.Add();
-    RPG_Check(nameId == infoId && infoId == transformId);
+void RpgWorld::UpdateTransformInterpolation(float alpha) noexcept
+{
+    RPG_IsMainThread();
+    RPG_Check(!bInTickStep);
 
-    GameObjectNames[nameId] = name;
-    
-    FGameObjectInfo& info = GameObjectInfos[infoId];
-    RpgPlatformMemory::MemSet(info.ComponentIndices, RPG_COMPONENT_ID_INVALID, sizeof(uint16_t) * RPG_COMPONENT_TYPE_MAX_COUNT);
+    alpha = RpgMath::Clamp(alpha, 0.0f, 1.0f);
 
-    ++info.Gen;
-    info.Flags = FLAG_Allocated | FLAG_TransformUpdated;
-    RPG_Check(info.Gen < UINT16_MAX);
+    // Interpolation of game objects not moved during latest tick step is finished, render at latest world transform
+    for (int i = 0; i < TransformInterpolatedGameObjects.GetCount(); ++i)
+    {
+        const int index = TransformInterpolatedGameObjects[i];
+        FGameObjectInfo& info = GameObjectInfos[index];
 
-    RpgPlatformMemory::MemSet(info.ScriptIndices, RPG_INDEX_INVALID, sizeof(int16_t) * RPG_GAMEOBJECT_MAX_SCRIPT);
+        if (info.Flags & FLAG_TransformInterpolated)
+        {
+            info.Flags &= ~FLAG_TransformInterpolated;
+
+            if (!(info.Flags & FLAG_TransformStepUpdated))
+            {
+                info.Flags |= FLAG_TransformUpdated;
+                GameObject_MarkChanged(index);
+            }
+        }
+    }
+
+    TransformInterpolatedGameObjects.Clear();
+
+    for (int i = 0; i < TransformStepCount; ++i)
+    {
+        const int index = TransformStepGameObjects[i];
+        FGameObjectInfo& info = GameObjectInfos[index];
+
+        if (!(info.Flags & FLAG_TransformStepUpdated) || (info.Flags & FLAG_TransformInterpolated))
+        {
+            continue;
+        }
 
-    FGameObjectTransform& transform = GameObjectTransforms[transformId];
-    transform.LocalMatrix = RpgMatrixTransform();
-    transform.WorldMatrix = worldTransform.ToMatrixTransform();
-    transform.InverseWorldMatrix = transform.WorldMatrix.GetInverse();
+        FGameObjectTransform& transform = GameObjectTransforms[index];
 
-    return RpgGameObjectID(this, nameId, info.Gen);
+        RpgTransform prev(transform.PrevWorldMatrix);
+        RpgTransform current(transform.WorldMatrix);
+
+        RpgTransform interpolated;
+        interpolated.Position = RpgVector3::Lerp(prev.Position, current.Position, alpha);
+        interpolated.Rotation = RpgQuaternion::Slerp(prev.Rotation, current.Rotation, alpha);
+        interpolated.Scale = RpgVector3::Lerp(prev.Scale, current.Scale, alpha);
+
+        transform.InterpolatedWorldMatrix = interpolated.ToMatrixTransform();
+        info.Flags |= (FLAG_TransformInterpolated | FLAG_TransformUpdated);
+        GameObject_MarkChanged(index);
+        TransformInterpolatedGameObjects.AddValue(index);
+    }
 }
 
 
-void RpgWorld::GameObject_Destroy(RpgGameObjectID& gameObject) noexcept
+void RpgWorld::UpdateTransformHierarchy() noexcept
 {
     RPG_IsMainThread();
+    RPG_Check(!bSubsystemGraphDispatched);
 
-    if (GameObject_IsValid(gameObject))
+    if (bTransformHierarchyDirty)
     {
-        FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
-        info.Flags |= FLAG_PendingDestroy;
+        TransformHierarchy_Rebuild();
+    }
 
-        // remove scripts
-        for (int i = 0; i < RPG_GAMEOBJECT_MAX_SCRIPT; ++i)
+    const int levelCount = TransformHierarchyLevelOffsets.GetCount() - 1;
+
+    if (levelCount <= 1)
+    {
+        return;
+    }
+
+    RPG_PROFILE_SCOPE("RpgWorld_UpdateTransformHierarchy");
+
+    // Parents are in previous level and already final, nodes in the same level can be processed concurrently
+    auto propagate = [this](int nodeIndex)
+    {
+        const FTransformHierarchyNode& node = TransformHierarchyNodes[nodeIndex];
+
+        if (GameObjectInfos[node.ParentIndex].Flags & FLAG_TransformHierarchyDirty)
         {
-            const int scriptIndex = info.ScriptIndices[i];
-            if (scriptIndex != RPG_INDEX_INVALID)
+            FGameObjectTransform& transform = GameObjectTransforms[node.GameObjectIndex];
+            transform.WorldMatrix = transform.LocalMatrix * GameObjectTransforms[node.ParentIndex].WorldMatrix;
+            GameObject_MarkTransformChanged(node.GameObjectIndex);
+        }
+    };
+
+    // Level 0 contains roots only
+    for (int level = 1; level < levelCount; ++level)
+    {
+        const int begin = TransformHierarchyLevelOffsets[level];
+        const int count = TransformHierarchyLevelOffsets[level + 1] - begin;
+
+        if (count >= RPG_WORLD_TRANSFORM_HIERARCHY_PARALLEL_MIN_COUNT)
+        {
+            RpgThreadPool::ParallelFor(count, 
+                [&propagate, begin](int i)
+                {
+                    propagate(begin + i);
+                }
+                , 256
+            );
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
             {
-                GameObject_RemoveScriptAtIndex(scriptIndex);
-                info.ScriptIndices[i] = RPG_INDEX_INVALID;
+                propagate(begin + i);
             }
         }
+    }
 
-        FrameDatas[FrameIndex].PendingDestroyObjects.AddValue(gameObject.Index);
+    for (int i = 0; i < TransformHierarchyNodes.GetCount(); ++i)
+    {
+        GameObjectInfos[TransformHierarchyNodes[i].GameObjectIndex].Flags &= ~FLAG_TransformHierarchyDirty;
+    }
+}
 
-        RPG_LogDebug(RpgLogWorld, "Mark game object (%s) as pending destroy", *GameObjectNames[gameObject.Index]);
+
+void RpgWorld::TransformHierarchy_Rebuild() noexcept
+{
+    RPG_MEMORY_SCOPE_TAG(TAG_WORLD);
+
+    TransformHierarchyNodes.Clear();
+    TransformHierarchyLevelOffsets.Clear();
+    bTransformHierarchyDirty = false;
+
+    // Depth of each game object, -1 if not part of hierarchy
+    RpgArray<int> depths;
+    depths.ResizeConstructs(GameObjectTransforms.GetIndexEnd(), -1);
+    int maxDepth = -1;
+    int nodeCount = 0;
+
+    for (auto it = GameObjectTransforms.CreateConstIterator(); it; ++it)
+    {
+        const FGameObjectTransform& transform = it.GetValue();
+
+        if (depths[it.GetIndex()] != -1 || (!transform.Parent.IsValid() && transform.ChildCount == 0))
+        {
+            continue;
+        }
+
+        // Walk up until root or ancestor with known depth
+        int index = it.GetIndex();
+        int stepCount = 0;
+
+        while (depths[index] == -1 && GameObjectTransforms[index].Parent.IsValid())
+        {
+            index = GameObjectTransforms[index].Parent.Index;
+            ++stepCount;
+        }
+
+        int depth = ((depths[index] != -1) ? depths[index] : 0) + stepCount;
+        maxDepth = RpgMath::Max(maxDepth, depth);
+
+        // Assign depth along the same path
+        index = it.GetIndex();
+
+        while (depths[index] == -1)
+        {
+            depths[index] = depth--;
+            ++nodeCount;
+
+            if (!GameObjectTransforms[index].Parent.IsValid())
+            {
+                break;
+            }
+
+            index = GameObjectTransforms[index].Parent.Index;
+        }
     }
 
-    gameObject = RpgGameObjectID();
+    if (nodeCount == 0)
+    {
+        return;
+    }
+
+    // Counting sort by depth
+    TransformHierarchyLevelOffsets.ResizeConstructs(maxDepth + 2, 0);
+
+    for (int i = 0; i < depths.GetCount(); ++i)
+    {
+        if (depths[i] != -1)
+        {
+            ++TransformHierarchyLevelOffsets[depths[i] + 1];
+        }
+    }
+
+    for (int level = 1; level < TransformHierarchyLevelOffsets.GetCount(); ++level)
+    {
+        TransformHierarchyLevelOffsets[level] += TransformHierarchyLevelOffsets[level - 1];
+    }
+
+    RpgArray<int> writeOffsets = TransformHierarchyLevelOffsets;
+    TransformHierarchyNodes.Resize(nodeCount);
+
+    for (int i = 0; i < depths.GetCount(); ++i)
+    {
+        if (depths[i] != -1)
+        {
+            const RpgGameObjectID parent = GameObjectTransforms[i].Parent;
+
+            FTransformHierarchyNode& node = TransformHierarchyNodes[writeOffsets[depths[i]]++];
+            node.GameObjectIndex = i;
+            node.ParentIndex = parent.IsValid() ? parent.Index : RPG_INDEX_INVALID;
+        }
+    }
+
+    RPG_LogDebug(RpgLogWorld, "Rebuild transform hierarchy (nodes: %i, levels: %i)", nodeCount, maxDepth + 1);
+}
+
+
+void RpgWorld::TransformHierarchy_Remove(int index) noexcept
+{
+    FGameObjectTransform& transform = GameObjectTransforms[index];
+
+    if (!transform.Parent.IsValid() && transform.ChildCount == 0)
+    {
+        return;
+    }
+
+    if (transform.Parent.IsValid())
+    {
+        --GameObjectTransforms[transform.Parent.Index].ChildCount;
+        transform.Parent = RpgGameObjectID();
+        transform.LocalMatrix = transform.WorldMatrix;
+    }
+
+    for (auto it = GameObjectTransforms.CreateIterator(); it && transform.ChildCount > 0; ++it)
+    {
+        FGameObjectTransform& child = it.GetValue();
+
+        if (child.Parent.IsValid() && child.Parent.Index == index)
+        {
+            child.Parent = RpgGameObjectID();
+            child.LocalMatrix = child.WorldMatrix;
+            --transform.ChildCount;
+        }
+    }
+
+    RPG_Check(transform.ChildCount == 0);
+    bTransformHierarchyDirty = true;
+}
+
+
+void RpgWorld::DispatchRender(int frameIndex, RpgRenderer* renderer) noexcept
+{
+    // Sync point
+    SubsystemGraph_Wait();
+
+    for (int i = 0; i < Subsystems.GetCount(); ++i)
+    {
+        Subsystems[i]->Render(frameIndex, renderer);
+    }
+}
+
+
+void RpgWorld::SubsystemGraph_Build() noexcept
+{
+    const int nodeCount = Subsystems.GetCount();
+    RPG_LogDebug(RpgLogWorld, "Build subsystem tick graph (%s)", *Name);
+
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        FSubsystemNode& node = SubsystemNodes[i];
+        node.Access = RpgWorldSubsystemAccess();
+        node.Dependents.Clear();
+        node.DependencyCount = 0;
+
+        Subsystems[i]->DeclareAccess(node.Access);
+    }
+
+    // Subsystems are sorted by update priority. Node depends on every previous node that has conflicting access
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        FSubsystemNode& node = SubsystemNodes[i];
+
+        for (int p = 0; p < i; ++p)
+        {
+            FSubsystemNode& prevNode = SubsystemNodes[p];
+
+            if (node.Access.IsConflict(prevNode.Access))
+            {
+                prevNode.Dependents.AddValue(i);
+                ++node.DependencyCount;
+            }
+        }
+
+        RPG_LogDebug(RpgLogWorld, "\t[%i] %s (read: 0x%X, write: 0x%X, main_thread: %i, dependencies: %i)", 
+            i, *Subsystems[i]->Name, node.Access.ReadMask, node.Access.WriteMask, node.Access.bMainThread, node.DependencyCount
+        );
+    }
+
+    bSubsystemGraphDirty = false;
+}
+
+
+void RpgWorld::SubsystemGraph_ExecuteNode(int nodeIndex) noexcept
+{
+    {
+        // Subsystem name lives as long as the world
+        RPG_PROFILE_SCOPE(*Subsystems[nodeIndex]->GetName());
+        Subsystems[nodeIndex]->TickUpdate(SubsystemTickDeltaTime);
+    }
+
+    const FSubsystemNode& node = SubsystemNodes[nodeIndex];
+
+    for (int i = 0; i < node.Dependents.GetCount(); ++i)
+    {
+        const int dependentIndex = node.Dependents[i];
+        FSubsystemNode& dependent = SubsystemNodes[dependentIndex];
+
+        // Main thread nodes are picked up by main thread in DispatchTickUpdate
+        if (InterlockedDecrement(&dependent.PendingDependencyCount) == 0 && !dependent.Access.bMainThread)
+        {
+            RpgThreadTask* task = &SubsystemTickTasks[dependentIndex];
+            RpgThreadPool::SubmitTasks(&task, 1);
+        }
+    }
+}
+
+
+void RpgWorld::SubsystemGraph_Wait() noexcept
+{
+    if (!bSubsystemGraphDispatched)
+    {
+        return;
+    }
+
+    // Node may not be submitted yet (still waiting its dependencies), wait until done instead of running. Help executing tasks meanwhile
+    for (int i = 0; i < Subsystems.GetCount(); ++i)
+    {
+        SubsystemTickTasks[i].WaitUntilDone();
+    }
+
+    bSubsystemGraphDispatched = false;
+}
+
+
+RpgGameObjectID RpgWorld::GameObject_Create(const RpgName& name, const RpgTransform& worldTransform) noexcept
+{
+    RPG_IsMainThread();
+    RPG_Assert(!name.IsEmpty());
+
+    int index = RPG_INDEX_INVALID;
+
+    if (GameObjectFreeIndices.IsEmpty())
+    {
+        index = GameObject_Reserve().Index;
+        GameObject_AllocateReserved();
+    }
+    else
+    {
+        index = GameObjectFreeIndices[GameObjectFreeIndices.GetCount() - 1];
+        GameObjectFreeIndices.RemoveAtLast();
+    }
+
+    GameObject_Initialize(index, name, worldTransform);
+
+    return RpgGameObjectID(this, index, GameObjectInfos[index].Gen);
+}
+
+
+void RpgWorld::GameObject_GetAll(RpgArray<RpgGameObjectID>& out_GameObjects) const noexcept
+{
+    out_GameObjects.Reserve(out_GameObjects.GetCount() + GameObjectInfos.GetCount());
+
+    for (auto it = GameObjectInfos.CreateConstIterator(); it; ++it)
+    {
+        const FGameObjectInfo& info = it.GetValue();
+
+        if ((info.Flags & FLAG_Allocated) && !(info.Flags & FLAG_PendingDestroy))
+        {
+            out_GameObjects.AddValue(RpgGameObjectID(const_cast<RpgWorld*>(this), it.GetIndex(), info.Gen));
+        }
+    }
+}
+
+
+RpgGameObjectID RpgWorld::GameObject_Reserve() noexcept
+{
+    const int index = InterlockedIncrement(&GameObjectReservedIndexEnd) - 1;
+    RPG_CheckV(index < RPG_WORLD_MAX_GAMEOBJECT, "RpgWorld: Exceeds maximum game object count!");
+
+    // New slot starts at generation 0, GameObject_Initialize sets it to 1
+    return RpgGameObjectID(this, index, 1);
+}
+
+
+void RpgWorld::GameObject_AllocateReserved() noexcept
+{
+    RPG_IsMainThread();
+
+    const int count = GameObjectReservedIndexEnd - GameObjectInfos.GetIndexEnd();
+
+    if (count <= 0)
+    {
+        return;
+    }
+
+    RPG_MEMORY_SCOPE_TAG(TAG_WORLD);
+
+    // Slots stay invalid (skipped by iteration) until GameObject_Initialize
+    const int nameId = GameObjectNames.ReserveRange(count);
+    const int infoId = GameObjectInfos.ReserveRange(count);
+    const int transformId = GameObjectTransforms.ReserveRange(count);
+    RPG_Check(nameId == infoId && infoId == transformId);
+}
+
+
+void RpgWorld::GameObject_EmplaceReserved(int index) noexcept
+{
+    // Slot reused from destroyed game object is still constructed
+    if (GameObjectInfos.IsValid(index))
+    {
+        return;
+    }
+
+    GameObjectNames.EmplaceAt(index);
+    GameObjectInfos.EmplaceAt(index);
+    GameObjectTransforms.EmplaceAt(index);
+}
+
+
+void RpgWorld::GameObject_Initialize(int index, const RpgName& name, const RpgMatrixTransform& localMatrix, const RpgMatrixTransform& worldMatrix) noexcept
+{
+    RPG_LogDebug(RpgLogWorld, "Create game object (%s)", *name);
+
+    GameObject_EmplaceReserved(index);
+    GameObjectNames[index] = name;
+    
+    FGameObjectInfo& info = GameObjectInfos[index];
+    RPG_Check(info.Flags == 0);
+
+    info.ArchetypeIndex = RPG_COMPONENT_ID_INVALID;
+    info.ArchetypeRow = RPG_INDEX_INVALID;
+
+    // Reused slot keeps generation incremented on destroy
+    info.Gen = (info.Gen == 0) ? 1 : info.Gen;
+    info.Flags = FLAG_Allocated | FLAG_TransformUpdated;
+
+    RpgPlatformMemory::MemSet(info.ScriptIndices, RPG_INDEX_INVALID, sizeof(int16_t) * RPG_GAMEOBJECT_MAX_SCRIPT);
+
+    FGameObjectTransform& transform = GameObjectTransforms[index];
+    transform.LocalMatrix = localMatrix;
+    transform.WorldMatrix = worldMatrix;
+    transform.PrevWorldMatrix = transform.WorldMatrix;
+    transform.bInverseWorldMatrixDirty = true;
+    transform.Parent = RpgGameObjectID();
+    transform.ChildCount = 0;
+
+    ++GameObjectCount;
+    GameObject_MarkChanged(index);
+}
+
+
+void RpgWorld::GameObject_Destroy(RpgGameObjectID& gameObject) noexcept
+{
+    RPG_IsMainThread();
+
+    if (GameObject_IsValid(gameObject))
+    {
+        FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
+        info.Flags |= FLAG_PendingDestroy;
+        --GameObjectCount;
+
+        // remove scripts
+        for (int i = 0; i < RPG_GAMEOBJECT_MAX_SCRIPT; ++i)
+        {
+            const int scriptIndex = info.ScriptIndices[i];
+            if (scriptIndex != RPG_INDEX_INVALID)
+            {
+                GameObject_RemoveScriptAtIndex(scriptIndex);
+                info.ScriptIndices[i] = RPG_INDEX_INVALID;
+            }
+        }
+
+        // Children stay in world at their current transform
+        TransformHierarchy_Remove(gameObject.Index);
+
+        FrameDatas[FrameIndex].PendingDestroyObjects.AddValue(gameObject.Index);
+
+        RPG_LogDebug(RpgLogWorld, "Mark game object (%s) as pending destroy", *GameObjectNames[gameObject.Index]);
+    }
+
+    gameObject = RpgGameObjectID();
+}
+
+
+void RpgWorld::GameObject_SetParent(RpgGameObjectID gameObject, RpgGameObjectID parent, bool bKeepWorldTransform) noexcept
+{
+    RPG_IsMainThread();
+    RPG_Check(GameObject_IsValid(gameObject));
+    RPG_Check(!parent.IsValid() || GameObject_IsValid(parent));
+
+    FGameObjectTransform& transform = GameObjectTransforms[gameObject.Index];
+
+    if (transform.Parent == parent)
+    {
+        return;
+    }
+
+    for (RpgGameObjectID check = parent; check.IsValid(); check = GameObjectTransforms[check.Index].Parent)
+    {
+        if (check == gameObject)
+        {
+            RPG_LogWarn(RpgLogWorld, "Ignore set parent of game object (%s) to (%s). Cyclic hierarchy!", *GameObjectNames[gameObject.Index], *GameObjectNames[parent.Index]);
+            return;
+        }
+    }
+
+    if (transform.Parent.IsValid())
+    {
+        --GameObjectTransforms[transform.Parent.Index].ChildCount;
+    }
+
+    transform.Parent = parent;
+
+    if (parent.IsValid())
+    {
+        ++GameObjectTransforms[parent.Index].ChildCount;
+    }
+
+    if (bKeepWorldTransform)
+    {
+        transform.LocalMatrix = parent.IsValid() ? transform.WorldMatrix * GameObject_GetInverseWorldTransformMatrix(parent) : transform.WorldMatrix;
+    }
+    else
+    {
+        transform.WorldMatrix = parent.IsValid() ? transform.LocalMatrix * GameObjectTransforms[parent.Index].WorldMatrix : transform.LocalMatrix;
+    }
+
+    GameObject_MarkTransformChanged(gameObject.Index);
+    bTransformHierarchyDirty = true;
+}
+
+
+int RpgWorld::Component_FindOrCreateArchetype(RpgComponentSignature signature) noexcept
+{
+    RPG_Check(signature != 0);
+
+    if (const int* index = ComponentArchetypeLookup.GetValueByKey(signature))
+    {
+        return *index;
+    }
+
+    RPG_CheckV(ComponentArchetypes.GetCount() < RPG_COMPONENT_ID_INVALID, "RpgWorld: Exceeds maximum archetype count!");
+
+    const int index = ComponentArchetypes.GetCount();
+    ComponentArchetypes.AddValue(new RpgComponentArchetype(signature, ComponentTypeInfos));
+    ComponentArchetypeLookup.Add(signature, index);
+
+    RPG_LogDebug(RpgLogWorld, "Create component archetype [%i] (signature: 0x%X, chunk capacity: %i)", index, signature, ComponentArchetypes[index]->GetChunkCapacity());
+
+    return index;
+}
+
+
+void RpgWorld::GameObject_ChangeArchetype(int gameObjectIndex, RpgComponentSignature newSignature) noexcept
+{
+    RPG_IsMainThread();
+    RPG_Check(!bSubsystemGraphDispatched);
+
+    FGameObjectInfo& info = GameObjectInfos[gameObjectIndex];
+
+    RpgComponentArchetype* oldArchetype = (info.ArchetypeIndex != RPG_COMPONENT_ID_INVALID) ? ComponentArchetypes[info.ArchetypeIndex] : nullptr;
+    const int oldRow = info.ArchetypeRow;
+
+    if ((oldArchetype ? oldArchetype->GetSignature() : 0) == newSignature)
+    {
+        return;
+    }
+
+    if (newSignature != 0)
+    {
+        const int newArchetypeIndex = Component_FindOrCreateArchetype(newSignature);
+        RpgComponentArchetype* newArchetype = ComponentArchetypes[newArchetypeIndex];
+        const int newRow = newArchetype->AddRow(gameObjectIndex);
+
+        if (oldArchetype)
+        {
+            const RpgComponentSignature keepSignature = oldArchetype->GetSignature() & newSignature;
+
+            for (int t = 0; t < ComponentTypeCount; ++t)
+            {
+                if (keepSignature & (1u << t))
+                {
+                    ComponentTypeInfos[t].MoveConstruct(newArchetype->GetComponentData(t, newRow), oldArchetype->GetComponentData(t, oldRow));
+                }
+            }
+        }
+
+        info.ArchetypeIndex = static_cast<uint16_t>(newArchetypeIndex);
+        info.ArchetypeRow = newRow;
+    }
+    else
+    {
+        info.ArchetypeIndex = RPG_COMPONENT_ID_INVALID;
+        info.ArchetypeRow = RPG_INDEX_INVALID;
+    }
+
+    if (oldArchetype)
+    {
+        // Destructs moved-from and removed components. Last row is moved into old row, fix its game object location
+        const int movedGameObjectIndex = oldArchetype->RemoveRow(oldRow);
+
+        if (movedGameObjectIndex != RPG_INDEX_INVALID)
+        {
+            GameObjectInfos[movedGameObjectIndex].ArchetypeRow = oldRow;
+        }
+    }
+}
+
+
+void RpgWorld::GameObject_AddComponentMove(RpgGameObjectID gameObject, int typeId, void* src) noexcept
+{
+    RPG_Check(GameObject_IsValid(gameObject));
+    RPG_Check(typeId >= 0 && typeId < ComponentTypeCount);
+
+    const RpgComponentTypeInfo& typeInfo = ComponentTypeInfos[typeId];
+    const FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
+    const RpgComponentSignature signature = (info.ArchetypeIndex != RPG_COMPONENT_ID_INVALID) ? ComponentArchetypes[info.ArchetypeIndex]->GetSignature() : 0;
+    const RpgComponentSignature typeBit = static_cast<RpgComponentSignature>(1u << typeId);
+
+    if (signature & typeBit)
+    {
+        void* existing = ComponentArchetypes[info.ArchetypeIndex]->GetComponentData(typeId, info.ArchetypeRow);
+        typeInfo.Destroy(existing);
+        typeInfo.Destruct(existing);
+    }
+    else
+    {
+        GameObject_ChangeArchetype(gameObject.Index, signature | typeBit);
+    }
+
+    typeInfo.MoveConstruct(ComponentArchetypes[info.ArchetypeIndex]->GetComponentData(typeId, info.ArchetypeRow), src);
+    typeInfo.Destruct(src);
+
+    GameObject_MarkChanged(gameObject.Index);
+}
+
+
+void RpgWorld::GameObject_RemoveComponentByTypeId(RpgGameObjectID gameObject, int typeId) noexcept
+{
+    RPG_Check(GameObject_IsValid(gameObject));
+
+    const FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
+
+    if (info.ArchetypeIndex == RPG_COMPONENT_ID_INVALID)
+    {
+        return;
+    }
+
+    const RpgComponentArchetype* archetype = ComponentArchetypes[info.ArchetypeIndex];
+
+    if (!archetype->HasComponent(typeId))
+    {
+        return;
+    }
+
+    ComponentTypeInfos[typeId].Destroy(archetype->GetComponentData(typeId, info.ArchetypeRow));
+
+    GameObject_ChangeArchetype(gameObject.Index, archetype->GetSignature() & ~static_cast<RpgComponentSignature>(1u << typeId));
+    GameObject_MarkChanged(gameObject.Index);
+}
+
+
+RpgWorldCommandBuffer& RpgWorld::GetCommandBuffer() noexcept
+{
+    if (ThisThreadCommandBufferSlot == RPG_INDEX_INVALID)
+    {
+        ThisThreadCommandBufferSlot = InterlockedIncrement(&CommandBufferThreadCount) - 1;
+        RPG_CheckV(ThisThreadCommandBufferSlot < RPG_WORLD_MAX_COMMAND_BUFFER, "RpgWorld: Exceeds maximum command buffer thread count!");
+    }
+
+    // Slot is only written by its own thread, main thread reads it at sync point
+    RpgWorldCommandBuffer*& buffer = CommandBuffers[ThisThreadCommandBufferSlot];
+
+    if (buffer == nullptr)
+    {
+        RPG_MEMORY_SCOPE_TAG(TAG_WORLD);
+        buffer = new RpgWorldCommandBuffer(this);
+    }
+
+    return *buffer;
+}
+
+
+void RpgWorld::PlaybackCommandBuffers() noexcept
+{
+    RPG_IsMainThread();
+    RPG_Check(!bSubsystemGraphDispatched);
+
+    bool bHasCommands = false;
+
+    for (int i = 0; i < RPG_WORLD_MAX_COMMAND_BUFFER && !bHasCommands; ++i)
+    {
+        bHasCommands = CommandBuffers[i] && !CommandBuffers[i]->IsEmpty();
+    }
+
+    if (!bHasCommands)
+    {
+        return;
+    }
+
+    RPG_PROFILE_SCOPE("RpgWorld_PlaybackCommandBuffers");
+    RPG_MEMORY_SCOPE_TAG(TAG_WORLD);
+
+    // Slots for every reserved game object at once
+    GameObject_AllocateReserved();
+
+    // Create reserved game objects first, commands from other buffers may refer to them
+    for (int b = 0; b < RPG_WORLD_MAX_COMMAND_BUFFER; ++b)
+    {
+        RpgWorldCommandBuffer* buffer = CommandBuffers[b];
+
+        if (buffer == nullptr)
+        {
+            continue;
+        }
+
+        for (int c = 0; c < buffer->Commands.GetCount(); ++c)
+        {
+            const RpgWorldCommandBuffer::FCommand& command = buffer->Commands[c];
+
+            if (command.Type == RpgWorldCommandBuffer::COMMAND_CREATE)
+            {
+                const RpgWorldCommandBuffer::FCreateData& data = buffer->CreateDatas[command.DataIndex];
+                GameObject_Initialize(command.GameObject.Index, data.Name, data.WorldTransform);
+            }
+        }
+    }
+
+    for (int b = 0; b < RPG_WORLD_MAX_COMMAND_BUFFER; ++b)
+    {
+        RpgWorldCommandBuffer* buffer = CommandBuffers[b];
+
+        if (buffer == nullptr)
+        {
+            continue;
+        }
+
+        for (int c = 0; c < buffer->Commands.GetCount(); ++c)
+        {
+            const RpgWorldCommandBuffer::FCommand& command = buffer->Commands[c];
+
+            if (command.Type == RpgWorldCommandBuffer::COMMAND_CREATE)
+            {
+                continue;
+            }
+
+            // Game object may be destroyed by previous command
+            if (!GameObject_IsValid(command.GameObject))
+            {
+                RPG_LogWarn(RpgLogWorld, "Ignore command (%i) from command buffer. Invalid game object!", command.Type);
+                continue;
+            }
+
+            switch (command.Type)
+            {
+                case RpgWorldCommandBuffer::COMMAND_DESTROY:
+                {
+                    RpgGameObjectID gameObject = command.GameObject;
+                    GameObject_Destroy(gameObject);
+                    break;
+                }
+
+                case RpgWorldCommandBuffer::COMMAND_ADD_COMPONENT:
+                {
+                    GameObject_AddComponentMove(command.GameObject, command.ComponentTypeId, buffer->ComponentDatas[command.DataIndex]);
+                    buffer->ComponentDatas[command.DataIndex] = nullptr;
+                    break;
+                }
+
+                case RpgWorldCommandBuffer::COMMAND_REMOVE_COMPONENT:
+                {
+                    GameObject_RemoveComponentByTypeId(command.GameObject, command.ComponentTypeId);
+                    break;
+                }
+
+                case RpgWorldCommandBuffer::COMMAND_SET_WORLD_TRANSFORM:
+                {
+                    GameObject_SetWorldTransform(command.GameObject, buffer->Transforms[command.DataIndex]);
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        buffer->Reset();
+    }
+}
+
+
+// "RPGW"
+#define RPG_WORLD_SNAPSHOT_MAGIC      0x57475052
+#define RPG_WORLD_SNAPSHOT_VERSION    1
+
+
+struct FWorldSnapshotHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    int GameObjectCount;
+    int ComponentTypeCount;
+    int ArchetypeCount;
+};
+
+
+struct FWorldSnapshotComponentType
+{
+    uint64_t NameHash;
+
+    // 0 if component data is not saved
+    uint64_t SchemaHash;
+};
+
+
+struct FWorldSnapshotArchetype
+{
+    // Bit per component type index in snapshot
+    RpgComponentSignature Signature;
+
+    int RowCount;
+};
+
+
+
+void RpgWorld::Snapshot_Save(RpgStreamWriter& writer) const noexcept
+{
+    RpgArray<RpgGameObjectID> gameObjects;
+    GameObject_GetAll(gameObjects);
+
+    Snapshot_Save(writer, gameObjects.GetData(), gameObjects.GetCount());
+}
+
+
+void RpgWorld::Snapshot_Save(RpgStreamWriter& writer, const RpgGameObjectID* gameObjects, int gameObjectCount, const RpgGameObjectID* externalParents, int externalParentCount) const noexcept
+{
+    RPG_IsMainThread();
+    RPG_Check(!bSubsystemGraphDispatched);
+    RPG_PROFILE_SCOPE("RpgWorld_SnapshotSave");
+
+    // Key: game object index, Value: snapshot index
+    RpgMap<int, int> snapshotIndices;
+    snapshotIndices.Reserve(gameObjectCount);
+
+    for (int i = 0; i < gameObjectCount; ++i)
+    {
+        RPG_Check(GameObject_IsValid(gameObjects[i]));
+        snapshotIndices.Add(gameObjects[i].Index, i);
+    }
+
+    RpgComponentSignature savedSignature = 0;
+    FWorldSnapshotComponentType types[RPG_COMPONENT_TYPE_MAX_COUNT];
+
+    for (int t = 0; t < ComponentTypeCount; ++t)
+    {
+        const RpgComponentTypeInfo& typeInfo = ComponentTypeInfos[t];
+        types[t].NameHash = RpgPlatformString::CStringHash(typeInfo.Name);
+        types[t].SchemaHash = typeInfo.SchemaHash;
+
+        if (typeInfo.SchemaHash)
+        {
+            savedSignature |= static_cast<RpgComponentSignature>(1u << t);
+        }
+        else
+        {
+            RPG_LogWarn(RpgLogWorld, "Component (%s) does not support snapshot. Component is not saved!", typeInfo.Name);
+        }
+    }
+
+    // Group saved rows by archetype, rows are sorted to copy consecutive rows as one block
+    struct FRow
+    {
+        int ArchetypeIndex;
+        int Row;
+        int SnapshotIndex;
+    };
+
+    RpgArray<FRow> rows;
+    rows.Reserve(gameObjectCount);
+
+    for (int i = 0; i < gameObjectCount; ++i)
+    {
+        const FGameObjectInfo& info = GameObjectInfos[gameObjects[i].Index];
+
+        if (info.ArchetypeIndex != RPG_COMPONENT_ID_INVALID && (ComponentArchetypes[info.ArchetypeIndex]->GetSignature() & savedSignature))
+        {
+            rows.AddValue({ info.ArchetypeIndex, info.ArchetypeRow, i });
+        }
+    }
+
+    RpgAlgorithm::Sort(rows.GetData(), rows.GetCount(),
+        [](const FRow& a, const FRow& b)
+        {
+            return (a.ArchetypeIndex != b.ArchetypeIndex) ? (a.ArchetypeIndex < b.ArchetypeIndex) : (a.Row < b.Row);
+        }
+    );
+
+    int archetypeCount = 0;
+
+    for (int r = 0; r < rows.GetCount(); ++r)
+    {
+        archetypeCount += (r == 0 || rows[r].ArchetypeIndex != rows[r - 1].ArchetypeIndex) ? 1 : 0;
+    }
+
+    FWorldSnapshotHeader header;
+    header.Magic = RPG_WORLD_SNAPSHOT_MAGIC;
+    header.Version = RPG_WORLD_SNAPSHOT_VERSION;
+    header.GameObjectCount = gameObjectCount;
+    header.ComponentTypeCount = ComponentTypeCount;
+    header.ArchetypeCount = archetypeCount;
+    writer.Write(header);
+    writer.WriteData(types, sizeof(FWorldSnapshotComponentType) * ComponentTypeCount);
+
+    // Game object blocks
+    {
+        RpgArray<RpgName> names;
+        RpgArray<RpgMatrixTransform> matrices;
+        RpgArray<int> parents;
+        names.Resize(gameObjectCount);
+        matrices.Resize(gameObjectCount * 2);
+        parents.Resize(gameObjectCount);
+
+        for (int i = 0; i < gameObjectCount; ++i)
+        {
+            const int index = gameObjects[i].Index;
+            const FGameObjectTransform& transform = GameObjectTransforms[index];
+
+            names[i] = GameObjectNames[index];
+            matrices[i] = transform.LocalMatrix;
+            matrices[gameObjectCount + i] = transform.WorldMatrix;
+            parents[i] = RPG_INDEX_INVALID;
+
+            if (!transform.Parent.IsValid())
+            {
+                continue;
+            }
+
+            if (const int* parentSnapshotIndex = snapshotIndices.GetValueByKey(transform.Parent.Index))
+            {
+                parents[i] = *parentSnapshotIndex;
+            }
+            else
+            {
+                // Parent outside snapshot is saved as index into external parents, encoded as (-2 - index)
+                const int externalIndex = RpgAlgorithm::LinearSearch_FindIndexByValueFromLast(externalParents, externalParentCount, transform.Parent);
+
+                if (externalIndex != RPG_INDEX_INVALID)
+                {
+                    parents[i] = -2 - externalIndex;
+                }
+                else
+                {
+                    RPG_LogWarn(RpgLogWorld, "Parent (%s) of game object (%s) is not in snapshot nor in external parents. Game object is saved as root!", *GameObjectNames[transform.Parent.Index], *names[i]);
+                }
+            }
+        }
+
+        writer.WriteData(names.GetData(), sizeof(RpgName) * gameObjectCount);
+        writer.WriteData(matrices.GetData(), sizeof(RpgMatrixTransform) * gameObjectCount * 2);
+        writer.WriteData(parents.GetData(), sizeof(int) * gameObjectCount);
+    }
+
+    // Archetype blocks
+    RpgArray<int> rowGameObjects;
+    RpgBinaryStreamWriter componentWriter;
+
+    for (int begin = 0; begin < rows.GetCount(); )
+    {
+        int end = begin + 1;
+
+        while (end < rows.GetCount() && rows[end].ArchetypeIndex == rows[begin].ArchetypeIndex)
+        {
+            ++end;
+        }
+
+        const RpgComponentArchetype* archetype = ComponentArchetypes[rows[begin].ArchetypeIndex];
+        const RpgComponentSignature signature = archetype->GetSignature() & savedSignature;
+        const int chunkCapacity = archetype->GetChunkCapacity();
+
+        FWorldSnapshotArchetype snapshotArchetype;
+        snapshotArchetype.Signature = signature;
+        snapshotArchetype.RowCount = end - begin;
+        writer.Write(snapshotArchetype);
+
+        rowGameObjects.Clear();
+
+        for (int r = begin; r < end; ++r)
+        {
+            rowGameObjects.AddValue(rows[r].SnapshotIndex);
+        }
+
+        writer.WriteData(rowGameObjects.GetData(), sizeof(int) * rowGameObjects.GetCount());
+
+        for (int t = 0; t < ComponentTypeCount; ++t)
+        {
+            if (!(signature & (1u << t)))
+            {
+                continue;
+            }
+
+            const RpgComponentTypeInfo& typeInfo = ComponentTypeInfos[t];
+
+            if (typeInfo.bSnapshotBulkCopy)
+            {
+                const uint32_t byteSize = typeInfo.Size * (end - begin);
+                writer.Write(byteSize);
+
+                // Consecutive rows inside one chunk are contiguous
+                for (int r = begin; r < end; )
+                {
+                    int runEnd = r + 1;
+
+                    while (runEnd < end && rows[runEnd].Row == rows[runEnd - 1].Row + 1 && (rows[runEnd].Row % chunkCapacity) != 0)
+                    {
+                        ++runEnd;
+                    }
+
+                    writer.WriteData(archetype->GetComponentData(t, rows[r].Row), typeInfo.Size * (runEnd - r));
+                    r = runEnd;
+                }
+            }
+            else
+            {
+                componentWriter.Reset();
+
+                for (int r = begin; r < end; ++r)
+                {
+                    typeInfo.Serialize(archetype->GetComponentData(t, rows[r].Row), componentWriter);
+                }
+
+                const uint32_t byteSize = static_cast<uint32_t>(componentWriter.GetByteSize());
+                writer.Write(byteSize);
+                writer.WriteData(componentWriter.GetByteData(), byteSize);
+            }
+        }
+
+        begin = end;
+    }
+
+    RPG_LogDebug(RpgLogWorld, "Saved world (%s) snapshot (game objects: %i, archetypes: %i)", *Name, gameObjectCount, archetypeCount);
+}
+
+
+bool RpgWorld::Snapshot_IsSupported(RpgGameObjectID gameObject) const noexcept
+{
+    RPG_Check(GameObject_IsValid(gameObject));
+
+    const FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
+
+    for (int i = 0; i < RPG_GAMEOBJECT_MAX_SCRIPT; ++i)
+    {
+        if (info.ScriptIndices[i] != RPG_INDEX_INVALID)
+        {
+            return false;
+        }
+    }
+
+    if (info.ArchetypeIndex == RPG_COMPONENT_ID_INVALID)
+    {
+        return true;
+    }
+
+    const RpgComponentArchetype* archetype = ComponentArchetypes[info.ArchetypeIndex];
+
+    for (int t = 0; t < ComponentTypeCount; ++t)
+    {
+        if (!archetype->HasComponent(t))
+        {
+            continue;
+        }
+
+        const RpgComponentTypeInfo& typeInfo = ComponentTypeInfos[t];
+
+        if (typeInfo.SchemaHash == 0)
+        {
+            return false;
+        }
+
+        if (typeInfo.IsSnapshotSupported && !typeInfo.IsSnapshotSupported(archetype->GetComponentData(t, info.ArchetypeRow)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool RpgWorld::Snapshot_Load(RpgStreamReader& reader, RpgArray<RpgGameObjectID>* out_GameObjects, const RpgGameObjectID* externalParents, int externalParentCount) noexcept
+{
+    RPG_IsMainThread();
+    RPG_Check(!bSubsystemGraphDispatched);
+    RPG_PROFILE_SCOPE("RpgWorld_SnapshotLoad");
+    RPG_MEMORY_SCOPE_TAG(TAG_WORLD);
+
+    FWorldSnapshotHeader header;
+    reader.Read(header);
+
+    if (header.Magic != RPG_WORLD_SNAPSHOT_MAGIC || header.Version != RPG_WORLD_SNAPSHOT_VERSION)
+    {
+        RPG_LogWarn(RpgLogWorld, "Fail to load world (%s) snapshot. Invalid snapshot header or version (%u)!", *Name, header.Version);
+        return false;
+    }
+
+    const int gameObjectCount = header.GameObjectCount;
+    const int reuseCount = RpgMath::Max(0, RpgMath::Min(gameObjectCount, GameObjectFreeIndices.GetCount()));
+
+    if (header.ComponentTypeCount < 0 || header.ComponentTypeCount > RPG_COMPONENT_TYPE_MAX_COUNT || gameObjectCount < 0 ||
+        GameObjectReservedIndexEnd + (gameObjectCount - reuseCount) > RPG_WORLD_MAX_GAMEOBJECT)
+    {
+        RPG_LogWarn(RpgLogWorld, "Fail to load world (%s) snapshot. Exceeds maximum game object count!", *Name);
+        return false;
+    }
+
+    // Type table and game object blocks must be complete before any game object is created
+    const size_t gameObjectBlockSize = (sizeof(RpgName) + sizeof(RpgMatrixTransform) * 2 + sizeof(int)) * static_cast<size_t>(gameObjectCount);
+
+    if (reader.HasError() || sizeof(FWorldSnapshotComponentType) * header.ComponentTypeCount + gameObjectBlockSize > reader.GetRemainingByteSize())
+    {
+        RPG_LogWarn(RpgLogWorld, "Fail to load world (%s) snapshot. Snapshot data is truncated!", *Name);
+        return false;
+    }
+
+    // Map snapshot component type into registered component type
+    FWorldSnapshotComponentType types[RPG_COMPONENT_TYPE_MAX_COUNT];
+    reader.ReadData(types, sizeof(FWorldSnapshotComponentType) * header.ComponentTypeCount);
+
+    int typeRemap[RPG_COMPONENT_TYPE_MAX_COUNT];
+
+    for (int s = 0; s < header.ComponentTypeCount; ++s)
+    {
+        typeRemap[s] = RPG_INDEX_INVALID;
+
+        if (types[s].SchemaHash == 0)
+        {
+            continue;
+        }
+
+        for (int t = 0; t < ComponentTypeCount; ++t)
+        {
+            if (RpgPlatformString::CStringHash(ComponentTypeInfos[t].Name) != types[s].NameHash)
+            {
+                continue;
+            }
+
+            if (ComponentTypeInfos[t].SchemaHash == types[s].SchemaHash)
+            {
+                typeRemap[s] = t;
+            }
+            else
+            {
+                RPG_LogWarn(RpgLogWorld, "Component (%s) schema has changed since snapshot was saved. Ignore component data!", ComponentTypeInfos[t].Name);
+            }
+
+            break;
+        }
+    }
+
+    // Data past header is validated while reading. Once data is corrupted, remaining rows are default constructed
+    // and every game object created by this load is destroyed at the end
+    bool bCorrupted = false;
+
+    // Reuse destroyed slots first, then allocate new slots at once
+    RpgArray<int> gameObjectIndices;
+    gameObjectIndices.Resize(gameObjectCount);
+
+    for (int i = 0; i < reuseCount; ++i)
+    {
+        gameObjectIndices[i] = GameObjectFreeIndices[GameObjectFreeIndices.GetCount() - 1 - i];
+    }
+
+    GameObjectFreeIndices.Resize(GameObjectFreeIndices.GetCount() - reuseCount);
+
+    if (gameObjectCount > reuseCount)
+    {
+        const int firstIndex = InterlockedExchangeAdd(&GameObjectReservedIndexEnd, gameObjectCount - reuseCount);
+        GameObject_AllocateReserved();
+
+        for (int i = reuseCount; i < gameObjectCount; ++i)
+        {
+            gameObjectIndices[i] = firstIndex + (i - reuseCount);
+        }
+    }
+
+    {
+        RpgArray<RpgName> names;
+        RpgArray<RpgMatrixTransform> matrices;
+        RpgArray<int> parents;
+        names.Resize(gameObjectCount);
+        matrices.Resize(gameObjectCount * 2);
+        parents.Resize(gameObjectCount);
+
+        reader.ReadData(names.GetData(), sizeof(RpgName) * gameObjectCount);
+        reader.ReadData(matrices.GetData(), sizeof(RpgMatrixTransform) * gameObjectCount * 2);
+        reader.ReadData(parents.GetData(), sizeof(int) * gameObjectCount);
+
+        for (int i = 0; i < gameObjectCount; ++i)
+        {
+            names[i].GetData()[RPG_NAME_MAX_COUNT - 1] = '\0';
+            GameObject_Initialize(gameObjectIndices[i], names[i], matrices[i], matrices[gameObjectCount + i]);
+        }
+
+        // Fix up parent handles once every game object has its generation
+        for (int i = 0; i < gameObjectCount; ++i)
+        {
+            const int parentIndex = parents[i];
+            RpgGameObjectID parent;
+
+            if (parentIndex >= 0 && parentIndex < gameObjectCount)
+            {
+                parent = RpgGameObjectID(this, gameObjectIndices[parentIndex], GameObjectInfos[gameObjectIndices[parentIndex]].Gen);
+            }
+            else
+            {
+                // Only parents inside snapshot are kept for cycle check below
+                parents[i] = RPG_INDEX_INVALID;
+
+                if (parentIndex <= -2 && (-2 - parentIndex) < externalParentCount && GameObject_IsValid(externalParents[-2 - parentIndex]))
+                {
+                    parent = externalParents[-2 - parentIndex];
+                }
+            }
+
+            if (parent.IsValid())
+            {
+                GameObjectTransforms[gameObjectIndices[i]].Parent = parent;
+                ++GameObjectTransforms[parent.Index].ChildCount;
+                bTransformHierarchyDirty = true;
+            }
+        }
+
+        // Corrupted parent indices can form a cycle. Parent chain of each loaded game object must end at root (0: not visited, 1: in current chain, 2: ends at root)
+        RpgArray<uint8_t> visitStates;
+        visitStates.ResizeConstructs(gameObjectCount, 0);
+
+        for (int i = 0; i < gameObjectCount && !bCorrupted; ++i)
+        {
+            int index = i;
+
+            while (index != RPG_INDEX_INVALID && visitStates[index] == 0)
+            {
+                visitStates[index] = 1;
+                index = parents[index];
+            }
+
+            bCorrupted = (index != RPG_INDEX_INVALID && visitStates[index] == 1);
+
+            for (index = i; index != RPG_INDEX_INVALID && visitStates[index] == 1; index = parents[index])
+            {
+                visitStates[index] = 2;
+            }
+        }
+    }
+
+    RpgArray<int> rowGameObjects;
+    RpgArray<uint8_t> gameObjectHasRow;
+    gameObjectHasRow.ResizeConstructs(gameObjectCount, 0);
+    RpgArray<uint8_t> skipBytes;
+
+    for (int a = 0; a < header.ArchetypeCount && !bCorrupted; ++a)
+    {
+        FWorldSnapshotArchetype snapshotArchetype;
+        reader.Read(snapshotArchetype);
+
+        const int rowCount = snapshotArchetype.RowCount;
+
+        if (reader.HasError() || rowCount < 0 || rowCount > gameObjectCount || sizeof(int) * static_cast<size_t>(rowCount) > reader.GetRemainingByteSize())
+        {
+            bCorrupted = true;
+            break;
+        }
+
+        rowGameObjects.Resize(rowCount);
+        reader.ReadData(rowGameObjects.GetData(), sizeof(int) * rowCount);
+
+        RpgComponentSignature signature = 0;
+
+        for (int s = 0; s < header.ComponentTypeCount; ++s)
+        {
+            if ((snapshotArchetype.Signature & (1u << s)) && typeRemap[s] != RPG_INDEX_INVALID)
+            {
+                signature |= static_cast<RpgComponentSignature>(1u << typeRemap[s]);
+            }
+        }
+
+        // Each loaded game object can be in one archetype only
+        for (int r = 0; r < rowCount; ++r)
+        {
+            const int snapshotIndex = rowGameObjects[r];
+
+            if (snapshotIndex < 0 || snapshotIndex >= gameObjectCount || gameObjectHasRow[snapshotIndex])
+            {
+                bCorrupted = true;
+                break;
+            }
+
+            gameObjectHasRow[snapshotIndex] = 1;
+        }
+
+        if (bCorrupted)
+        {
+            break;
+        }
+
+        int archetypeIndex = RPG_INDEX_INVALID;
+        RpgComponentArchetype* archetype = nullptr;
+        int firstRow = 0;
+
+        if (signature != 0)
+        {
+            archetypeIndex = Component_FindOrCreateArchetype(signature);
+            archetype = ComponentArchetypes[archetypeIndex];
+            firstRow = archetype->GetCount();
+
+            for (int r = 0; r < rowCount; ++r)
+            {
+                const int gameObjectIndex = gameObjectIndices[rowGameObjects[r]];
+                const int row = archetype->AddRow(gameObjectIndex);
+
+                FGameObjectInfo& info = GameObjectInfos[gameObjectIndex];
+                info.ArchetypeIndex = static_cast<uint16_t>(archetypeIndex);
+                info.ArchetypeRow = row;
+            }
+        }
+
+        for (int s = 0; s < header.ComponentTypeCount; ++s)
+        {
+            if (!(snapshotArchetype.Signature & (1u << s)))
+            {
+                continue;
+            }
+
+            uint32_t byteSize = 0;
+
+            if (!bCorrupted)
+            {
+                reader.Read(byteSize);
+                bCorrupted = reader.HasError() || byteSize > reader.GetRemainingByteSize();
+            }
+
+            const int t = typeRemap[s];
+
+            if (t == RPG_INDEX_INVALID)
+            {
+                if (!bCorrupted)
+                {
+                    skipBytes.Resize(static_cast<int>(byteSize));
+                    reader.ReadData(skipBytes.GetData(), byteSize);
+                }
+
+                continue;
+            }
+
+            const RpgComponentTypeInfo& typeInfo = ComponentTypeInfos[t];
+
+            if (typeInfo.bSnapshotBulkCopy && !bCorrupted && byteSize == typeInfo.Size * rowCount)
+            {
+                // Rows inside one chunk are contiguous, copy from stream straight into chunk memory
+                const int chunkCapacity = archetype->GetChunkCapacity();
+
+                for (int row = firstRow; row < firstRow + rowCount; )
+                {
+                    const int chunkRemaining = chunkCapacity - (row % chunkCapacity);
+                    const int count = RpgMath::Min(chunkRemaining, firstRow + rowCount - row);
+                    reader.ReadData(archetype->GetComponentData(t, row), typeInfo.Size * count);
+                    row += count;
+                }
+            }
+            else if (typeInfo.bSnapshotBulkCopy || bCorrupted)
+            {
+                bCorrupted = true;
+
+                for (int row = firstRow; row < firstRow + rowCount; ++row)
+                {
+                    typeInfo.DefaultConstruct(archetype->GetComponentData(t, row));
+                }
+            }
+            else
+            {
+                // Serialized block is read as a whole, so deserialize can not read past its own block
+                RpgArray<uint8_t> blockBytes;
+                blockBytes.Resize(static_cast<int>(byteSize));
+                reader.ReadData(blockBytes.GetData(), byteSize);
+                RpgBinaryStreamReader componentReader(blockBytes);
+
+                for (int row = firstRow; row < firstRow + rowCount; ++row)
+                {
+                    void* data = archetype->GetComponentData(t, row);
+                    typeInfo.DefaultConstruct(data);
+                    typeInfo.Deserialize(data, componentReader);
+                }
+
+                bCorrupted = componentReader.HasError() || componentReader.GetRemainingByteSize() != 0;
+            }
+
+            // Fix up game object handle, component data still holds handle from saved world
+            for (int row = firstRow; row < firstRow + rowCount; ++row)
+            {
+                const int gameObjectIndex = archetype->GetGameObjectIndex(row);
+                typeInfo.SetGameObject(archetype->GetComponentData(t, row), RpgGameObjectID(this, gameObjectIndex, GameObjectInfos[gameObjectIndex].Gen));
+            }
+        }
+    }
+
+    if (bCorrupted || reader.HasError())
+    {
+        RPG_LogWarn(RpgLogWorld, "Fail to load world (%s) snapshot. Snapshot data is corrupted, loaded game objects are destroyed!", *Name);
+
+        for (int i = 0; i < gameObjectCount; ++i)
+        {
+            RpgGameObjectID gameObject(this, gameObjectIndices[i], GameObjectInfos[gameObjectIndices[i]].Gen);
+            GameObject_Destroy(gameObject);
+        }
+
+        return false;
+    }
+
+    if (out_GameObjects)
+    {
+        out_GameObjects->Reserve(out_GameObjects->GetCount() + gameObjectCount);
+
+        for (int i = 0; i < gameObjectCount; ++i)
+        {
+            const int index = gameObjectIndices[i];
+            out_GameObjects->AddValue(RpgGameObjectID(this, index, GameObjectInfos[index].Gen));
+        }
+    }
+
+    RPG_LogDebug(RpgLogWorld, "Loaded world (%s) snapshot (game objects: %i, archetypes: %i)", *Name, gameObjectCount, header.ArchetypeCount);
+
+    return true;
 }
@@ -2,11 +2,20 @@
 
 #include "../RpgMath.h"
 #include "../RpgString.h"
+#include "../RpgThreadPool.h"
+#include "../dsa/RpgMap.h"
 #include "RpgComponent.h"
+#include "RpgWorldCommandBuffer.h"
 
 
 #define RPG_WORLD_MAX_GAMEOBJECT	65536
 
+// Maximum number of subsystems, size of subsystem dependency graph
+#define RPG_WORLD_MAX_SUBSYSTEM		16
+
+// Minimum number of game objects in one transform hierarchy level to propagate it on worker threads
+#define RPG_WORLD_TRANSFORM_HIERARCHY_PARALLEL_MIN_COUNT	1024
+
 
 RPG_LOG_DECLARE_CATEGORY_EXTERN(RpgLogWorld)
 
@@ -16,6 +25,75 @@ class RpgRenderer;
 
 
 
+// Data accessed by world subsystem during TickUpdate.
+// World uses it to build dependency graph between subsystems, subsystems that do not conflict are ticked concurrently on threadpool.
+struct RpgWorldSubsystemAccess
+{
+	// Bit index used for game object transforms
+	static constexpr int TRANSFORM_BIT = RPG_COMPONENT_TYPE_MAX_COUNT;
+
+
+	uint32_t ReadMask{ 0 };
+	uint32_t WriteMask{ 0 };
+
+	// If true, TickUpdate is always executed on main thread
+	bool bMainThread{ false };
+
+
+	template<typename TComponent>
+	inline void ReadComponent() noexcept
+	{
+		ReadMask |= GetComponentBit<TComponent>();
+	}
+
+	template<typename TComponent>
+	inline void WriteComponent() noexcept
+	{
+		WriteMask |= GetComponentBit<TComponent>();
+	}
+
+	inline void ReadTransform() noexcept
+	{
+		ReadMask |= (1u << TRANSFORM_BIT);
+	}
+
+	inline void WriteTransform() noexcept
+	{
+		WriteMask |= (1u << TRANSFORM_BIT);
+	}
+
+	// Access everything on main thread. Subsystem will be serialized with every other subsystem
+	inline void SetExclusive() noexcept
+	{
+		ReadMask = UINT32_MAX;
+		WriteMask = UINT32_MAX;
+		bMainThread = true;
+	}
+
+	[[nodiscard]] inline bool IsConflict(const RpgWorldSubsystemAccess& other) const noexcept
+	{
+		return (WriteMask & (other.ReadMask | other.WriteMask)) || (other.WriteMask & ReadMask);
+	}
+
+
+private:
+	template<typename TComponent>
+	[[nodiscard]] static inline uint32_t GetComponentBit() noexcept
+	{
+		// Component not registered into world, nothing can access it
+		if (TComponent::TYPE_ID >= RPG_COMPONENT_TYPE_MAX_COUNT)
+		{
+			return 0;
+		}
+
+		return (1u << TComponent::TYPE_ID);
+	}
+
+};
+
+
+
+
 class RpgWorldSubsystem
 {
 	RPG_NOCOPY(RpgWorldSubsystem)
@@ -30,6 +108,16 @@ public:
 	virtual ~RpgWorldSubsystem() noexcept = default;
 
 protected:
+	// Declare data accessed by TickUpdate. Default is exclusive access on main thread.
+	// TickUpdate must not read/write anything outside declared access, since it may run concurrently with other subsystems on worker thread.
+	// Tasks submitted by TickUpdate that still running after TickUpdate returns must be waited by the subsystem itself.
+	// @param out_Access - Output access
+	// @returns None
+	virtual void DeclareAccess(RpgWorldSubsystemAccess& out_Access) const noexcept
+	{
+		out_Access.SetExclusive();
+	}
+
 	virtual void StartPlay() noexcept {}
 	virtual void StopPlay() noexcept {}
 	virtual void PreTickUpdate() noexcept {}
@@ -78,10 +166,32 @@ public:
 	void DispatchStartPlay() noexcept;
 	void DispatchStopPlay() noexcept;
 	void DispatchTickUpdate(float deltaTimeSeconds) noexcept;
+	void DispatchScriptTickUpdate(float deltaTimeSeconds) noexcept;
+	void DispatchSubsystemTickUpdate(float deltaTimeSeconds) noexcept;
 	void DispatchPostTickUpdate() noexcept;
 	void DispatchRender(int frameIndex, RpgRenderer* renderer) noexcept;
 
 
+	// Begin fixed tick step. Transforms set until EndTickStep are interpolated from their state before this step.
+	// Transforms set outside tick step (scripts, editor, teleport) snap without interpolation.
+	// @returns None
+	void BeginTickStep() noexcept;
+
+	// End fixed tick step. Must be called after DispatchPostTickUpdate
+	// @returns None
+	void EndTickStep() noexcept;
+
+	// Calculate interpolated world transforms of game objects moved during the latest tick step. Call once per frame before render
+	// @param alpha - Fraction of fixed tick step elapsed since latest tick step [0.0, 1.0]
+	// @returns None
+	void UpdateTransformInterpolation(float alpha) noexcept;
+
+	// Propagate world transforms from parents to attached children. Only subtrees of game objects whose transform changed are recalculated.
+	// Called after scripts tick and after subsystems tick, call it manually to read children world transforms right after moving their parent
+	// @returns None
+	void UpdateTransformHierarchy() noexcept;
+
+
 	[[nodiscard]] inline const RpgName& GetName() const noexcept
 	{
 		return Name;
@@ -96,6 +206,7 @@ public:
 private:
 	RpgName Name;
 	bool bHasStartedPlay;
+	bool bInTickStep;
 
 
 	struct FFrameData
@@ -107,6 +218,61 @@ private:
 	int FrameIndex;
 
 
+// --------------------------------------------------------------------------------------------------------------------------------------------- //
+// 	Subsystem tick graph
+// --------------------------------------------------------------------------------------------------------------------------------------------- //
+private:
+	class FSubsystemTickTask : public RpgThreadTask
+	{
+	public:
+		RpgWorld* World{ nullptr };
+		int NodeIndex{ RPG_INDEX_INVALID };
+
+	public:
+		virtual void Execute() noexcept override
+		{
+			World->SubsystemGraph_ExecuteNode(NodeIndex);
+		}
+
+		virtual const char* GetTaskName() const noexcept override
+		{
+			return "RpgWorld_SubsystemTickUpdate";
+		}
+	};
+
+
+	struct FSubsystemNode
+	{
+		RpgWorldSubsystemAccess Access;
+
+		// Nodes that must wait this node
+		RpgArrayInline<int, RPG_WORLD_MAX_SUBSYSTEM> Dependents;
+
+		// Number of nodes this node must wait
+		int DependencyCount{ 0 };
+
+		// Decremented when dependency finished, ready to execute when reach 0
+		RpgAtomicInt PendingDependencyCount{ 0 };
+	};
+
+
+	// Rebuild dependency graph from subsystem access declarations
+	void SubsystemGraph_Build() noexcept;
+
+	// Execute subsystem TickUpdate then release dependent nodes. Called from worker thread or main thread
+	void SubsystemGraph_ExecuteNode(int nodeIndex) noexcept;
+
+	// [Block] Wait all subsystem TickUpdate finished
+	void SubsystemGraph_Wait() noexcept;
+
+
+	FSubsystemNode SubsystemNodes[RPG_WORLD_MAX_SUBSYSTEM];
+	FSubsystemTickTask SubsystemTickTasks[RPG_WORLD_MAX_SUBSYSTEM];
+	float SubsystemTickDeltaTime;
+	bool bSubsystemGraphDirty;
+	bool bSubsystemGraphDispatched;
+
+
 
 // --------------------------------------------------------------------------------------------------------------------------------------------- //
 // 	Subsystem interface
@@ -126,11 +292,23 @@ public:
 			}
 		}
 
+		RPG_Check(!bSubsystemGraphDispatched);
+		RPG_CheckV(Subsystems.GetCount() < RPG_WORLD_MAX_SUBSYSTEM, "RpgWorld: Exceeds maximum number of subsystems (%i)!", RPG_WORLD_MAX_SUBSYSTEM);
+
 		RpgWorldSubsystem* subsystem = new TWorldSubsystem();
 		subsystem->World = this;
 		subsystem->UpdatePriority = updatePriority;
 
+		// Keep subsystems sorted by update priority (lower first), same priority keeps registration order
 		Subsystems.AddValue(subsystem);
+
+		for (int i = Subsystems.GetCount() - 1; i > 0 && Subsystems[i - 1]->UpdatePriority > updatePriority; --i)
+		{
+			Subsystems[i] = Subsystems[i - 1];
+			Subsystems[i - 1] = subsystem;
+		}
+
+		bSubsystemGraphDirty = true;
 	}
 
 
@@ -163,38 +341,115 @@ public:
 	template<typename TComponent>
 	inline void Component_Register() noexcept
 	{
-		TComponent::TYPE_ID = ComponentStorages.GetCount();
+		TComponent::TYPE_ID = static_cast<uint16_t>(ComponentTypeCount);
 		RPG_CheckV(TComponent::TYPE_ID >= 0 && TComponent::TYPE_ID < RPG_COMPONENT_TYPE_MAX_COUNT, "RpgWorld: Exceeds maximum component type count!");
-		ComponentStorages.AddValue(new RpgComponentStorage<TComponent>());
+		ComponentTypeInfos[ComponentTypeCount++] = RpgComponentTypeInfo::Create<TComponent>();
+		bSubsystemGraphDirty = true;
 	}
 
 	template<typename TComponent>
-	[[nodiscard]] inline RpgComponentStorage<TComponent>* Component_GetStorage() noexcept
+	[[nodiscard]] inline RpgComponentIterator<TComponent> Component_CreateIterator() noexcept
 	{
-		return static_cast<RpgComponentStorage<TComponent>*>(ComponentStorages[TComponent::TYPE_ID]);
+		return RpgComponentIterator<TComponent>(ComponentArchetypes.GetData(), ComponentArchetypes.GetCount(), TComponent::TYPE_ID);
 	}
 
 	template<typename TComponent>
-	[[nodiscard]] inline const RpgComponentStorage<TComponent>* Component_GetStorage() const noexcept
+	[[nodiscard]] inline RpgComponentIterator<const TComponent> Component_CreateConstIterator() const noexcept
 	{
-		return static_cast<const RpgComponentStorage<TComponent>*>(ComponentStorages[TComponent::TYPE_ID]);
+		return RpgComponentIterator<const TComponent>(ComponentArchetypes.GetData(), ComponentArchetypes.GetCount(), TComponent::TYPE_ID);
 	}
 
-	template<typename TComponent>
-	[[nodiscard]] inline RpgFreeList<TComponent>::Iterator Component_CreateIterator() noexcept
+	// Collect chunks of game objects that have all of TComponents. Adding/removing components invalidates returned query
+	template<typename... TComponents>
+	[[nodiscard]] inline RpgComponentQuery<TComponents...> Component_Query() noexcept
 	{
-		return Component_GetStorage<TComponent>()->GetComponents().CreateIterator();
+		const uint16_t typeIds[] = { TComponents::TYPE_ID... };
+		return RpgComponentQuery<TComponents...>(ComponentArchetypes.GetData(), ComponentArchetypes.GetCount(), typeIds);
 	}
 
-	template<typename TComponent>
-	[[nodiscard]] inline RpgFreeList<TComponent>::ConstIterator Component_CreateConstIterator() const noexcept
+
+private:
+	// Find or create archetype with <signature>
+	// @returns Archetype index
+	int Component_FindOrCreateArchetype(RpgComponentSignature signature) noexcept;
+
+	// Move game object into archetype with <newSignature>. Components in both signatures are moved, components not in <newSignature> are destructed.
+	// Components only in <newSignature> are left unconstructed.
+	void GameObject_ChangeArchetype(int gameObjectIndex, RpgComponentSignature newSignature) noexcept;
+
+	// Move constructed component <src> into game object, existing component of the same type is replaced. <src> is destructed
+	void GameObject_AddComponentMove(RpgGameObjectID gameObject, int typeId, void* src) noexcept;
+
+	// Call component Destroy() then remove it from game object. Does nothing if game object does not have the component
+	void GameObject_RemoveComponentByTypeId(RpgGameObjectID gameObject, int typeId) noexcept;
+
+
+private:
+	RpgComponentTypeInfo ComponentTypeInfos[RPG_COMPONENT_TYPE_MAX_COUNT];
+	int ComponentTypeCount;
+
+	RpgArray<RpgComponentArchetype*> ComponentArchetypes;
+
+	// Key: signature, Value: index into ComponentArchetypes
+	RpgMap<int, int> ComponentArchetypeLookup;
+
+
+
+// --------------------------------------------------------------------------------------------------------------------------------------------- //
+// 	Command buffer interface
+// --------------------------------------------------------------------------------------------------------------------------------------------- //
+public:
+	// Get command buffer of the calling thread. Used to record structural changes during parallel work (subsystem tick, worker tasks)
+	// @returns Command buffer owned by the calling thread
+	[[nodiscard]] RpgWorldCommandBuffer& GetCommandBuffer() noexcept;
+
+	// Play back all command buffers in one batch. Reserved game objects are created first, then other commands in recorded order.
+	// Called after scripts tick and after subsystems tick
+	// @returns None
+	void PlaybackCommandBuffers() noexcept;
+
+
+private:
+	// Reserve index for new game object. Thread safe. Reserved index is always a new slot, destroyed slots are only reused by main thread
+	// @returns Game object ID, valid after GameObject_Initialize
+	[[nodiscard]] RpgGameObjectID GameObject_Reserve() noexcept;
+
+	// Allocate free list slots for all reserved game objects. Slots are not valid until GameObject_Initialize
+	void GameObject_AllocateReserved() noexcept;
+
+	// Construct game object data at slot allocated by GameObject_AllocateReserved. Does nothing for reused slot
+	void GameObject_EmplaceReserved(int index) noexcept;
+
+	// Initialize game object at reserved or reused slot as root (no parent) without components and scripts
+	// @param index - Slot index
+	// @param name - Game object name
+	// @param localMatrix - Local transform, same as <worldMatrix> unless parent is assigned afterward (snapshot load)
+	// @param worldMatrix - World transform
+	// @returns None
+	void GameObject_Initialize(int index, const RpgName& name, const RpgMatrixTransform& localMatrix, const RpgMatrixTransform& worldMatrix) noexcept;
+
+	inline void GameObject_Initialize(int index, const RpgName& name, const RpgTransform& worldTransform) noexcept
 	{
-		return Component_GetStorage<TComponent>()->GetComponents().CreateConstIterator();
+		const RpgMatrixTransform worldMatrix = worldTransform.ToMatrixTransform();
+		GameObject_Initialize(index, name, worldMatrix, worldMatrix);
 	}
 
 
 private:
-	RpgArrayInline<RpgComponentStorageInterface*, RPG_COMPONENT_TYPE_MAX_COUNT> ComponentStorages;
+	// Indexed by command buffer slot of thread, created by the owning thread on first use
+	RpgWorldCommandBuffer* CommandBuffers[RPG_WORLD_MAX_COMMAND_BUFFER];
+
+	// Next game object index to reserve
+	RpgAtomicInt GameObjectReservedIndexEnd;
+
+	// Slots of destroyed game objects, reused by GameObject_Create and Snapshot_Load
+	RpgArray<int> GameObjectFreeIndices;
+
+	// Number of initialized game objects not pending destroy. Slots of destroyed game objects stay in free list, so free list count is high-water mark
+	int GameObjectCount;
+
+
+	friend RpgWorldCommandBuffer;
 
 
 
@@ -205,6 +460,9 @@ public:
 	[[nodiscard]] RpgGameObjectID GameObject_Create(const RpgName& name, const RpgTransform& worldTransform = RpgTransform()) noexcept;
 	void GameObject_Destroy(RpgGameObjectID& gameObject) noexcept;
 
+	// Append all valid game objects (not pending destroy) into <out_GameObjects>
+	void GameObject_GetAll(RpgArray<RpgGameObjectID>& out_GameObjects) const noexcept;
+
 
 	[[nodiscard]] inline bool GameObject_IsValid(RpgGameObjectID gameObject) const noexcept
 	{
@@ -218,6 +476,21 @@ public:
 	}
 
 
+	// Attach game object to <parent>. Child world transform follows parent once UpdateTransformHierarchy is called
+	// @param gameObject - Child game object
+	// @param parent - Parent game object, invalid ID detaches game object from its current parent
+	// @param bKeepWorldTransform - Keep current world transform (local transform is recalculated), otherwise current local transform is applied relative to <parent>
+	// @returns None
+	void GameObject_SetParent(RpgGameObjectID gameObject, RpgGameObjectID parent, bool bKeepWorldTransform = true) noexcept;
+
+
+	[[nodiscard]] inline RpgGameObjectID GameObject_GetParent(RpgGameObjectID gameObject) const noexcept
+	{
+		RPG_Check(GameObject_IsValid(gameObject));
+		return GameObjectTransforms[gameObject.Index].Parent;
+	}
+
+
 	inline void GameObject_SetWorldTransform(RpgGameObjectID gameObject, const RpgTransform& worldTransform) noexcept
 	{
 		RPG_Check(GameObject_IsValid(gameObject));
@@ -225,7 +498,30 @@ public:
 		FGameObjectTransform& transform = GameObjectTransforms[gameObject.Index];
 		transform.WorldMatrix = worldTransform.ToMatrixTransform();
 
-		GameObjectInfos[gameObject.Index].Flags |= FLAG_TransformUpdated;
+		// Parent inverse is computed here, cached inverse in GameObject_GetInverseWorldTransformMatrix is not safe to write from tick tasks
+		transform.LocalMatrix = transform.Parent.IsValid() ? transform.WorldMatrix * GameObjectTransforms[transform.Parent.Index].WorldMatrix.GetInverse() : transform.WorldMatrix;
+
+		GameObject_MarkTransformChanged(gameObject.Index);
+	}
+
+
+	// Set transform relative to parent. Same as world transform if game object has no parent
+	inline void GameObject_SetLocalTransform(RpgGameObjectID gameObject, const RpgTransform& localTransform) noexcept
+	{
+		RPG_Check(GameObject_IsValid(gameObject));
+
+		FGameObjectTransform& transform = GameObjectTransforms[gameObject.Index];
+		transform.LocalMatrix = localTransform.ToMatrixTransform();
+		transform.WorldMatrix = transform.Parent.IsValid() ? transform.LocalMatrix * GameObjectTransforms[transform.Parent.Index].WorldMatrix : transform.LocalMatrix;
+
+		GameObject_MarkTransformChanged(gameObject.Index);
+	}
+
+
+	[[nodiscard]] inline RpgTransform GameObject_GetLocalTransform(RpgGameObjectID gameObject) const noexcept
+	{
+		RPG_Check(GameObject_IsValid(gameObject));
+		return RpgTransform(GameObjectTransforms[gameObject.Index].LocalMatrix);
 	}
 
 
@@ -254,70 +550,78 @@ public:
 	}
 
 
-	template<typename TComponent>
-	inline TComponent* GameObject_AddComponent(RpgGameObjectID gameObject) noexcept
+	// Get inverse of world transform matrix. Calculated on first access after world transform changed and cached.
+	// Main thread only (cache write is not synchronized), tick tasks must compute inverse from GameObject_GetWorldTransformMatrix
+	[[nodiscard]] inline const RpgMatrixTransform& GameObject_GetInverseWorldTransformMatrix(RpgGameObjectID gameObject) const noexcept
 	{
 		RPG_Check(GameObject_IsValid(gameObject));
 
-		FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
-		int index = info.ComponentIndices[TComponent::TYPE_ID];
+		const FGameObjectTransform& transform = GameObjectTransforms[gameObject.Index];
 
-		if (index != RPG_COMPONENT_ID_INVALID)
+		if (transform.bInverseWorldMatrixDirty)
 		{
-			TComponent& check = Component_GetStorage<TComponent>()->Get(index);
-			RPG_Check(check.GameObject == gameObject);
-
-			return &check;
+			RPG_IsMainThread();
+			transform.InverseWorldMatrix = transform.WorldMatrix.GetInverse();
+			transform.bInverseWorldMatrixDirty = false;
 		}
 
-		auto storage = Component_GetStorage<TComponent>();
-		index = storage->Add();
-		info.ComponentIndices[TComponent::TYPE_ID] = index;
-
-		TComponent& data = storage->Get(index);
-		data.GameObject = gameObject;
-
-		return &data;
+		return transform.InverseWorldMatrix;
 	}
 
 
-	template<typename TComponent>
-	inline void GameObject_RemoveComponent(RpgGameObjectID gameObject) noexcept
+	// Get world transform used for rendering. Interpolated between the two latest tick steps if game object moved during the latest tick step
+	[[nodiscard]] inline const RpgMatrixTransform& GameObject_GetInterpolatedWorldTransformMatrix(RpgGameObjectID gameObject) const noexcept
 	{
 		RPG_Check(GameObject_IsValid(gameObject));
 
-		FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
-		const int index = info.ComponentIndices[TComponent::TYPE_ID];
+		const FGameObjectTransform& transform = GameObjectTransforms[gameObject.Index];
+		return (GameObjectInfos[gameObject.Index].Flags & FLAG_TransformInterpolated) ? transform.InterpolatedWorldMatrix : transform.WorldMatrix;
+	}
 
-		auto storage = Component_GetStorage<TComponent>();
-		{
-			TComponent& data = storage->Get(index);
-			RPG_Check(data.GameObject == gameObject);
-			data.Destroy();
-		}
-		storage->Remove(index);
 
-		info.ComponentIndices[TComponent::TYPE_ID] = RPG_COMPONENT_ID_INVALID;
+	[[nodiscard]] inline RpgTransform GameObject_GetInterpolatedWorldTransform(RpgGameObjectID gameObject) const noexcept
+	{
+		return RpgTransform(GameObject_GetInterpolatedWorldTransformMatrix(gameObject));
 	}
 
 
+	// Add component. Game object moves into another archetype, pointers to its other components are invalidated
 	template<typename TComponent>
-	[[nodiscard]] inline TComponent* GameObject_GetComponent(RpgGameObjectID gameObject) noexcept
+	inline TComponent* GameObject_AddComponent(RpgGameObjectID gameObject) noexcept
 	{
-		RPG_Check(GameObject_IsValid(gameObject));
+		if (TComponent* check = GameObject_GetComponent<TComponent>(gameObject))
+		{
+			return check;
+		}
+
+		RPG_MEMORY_SCOPE_TAG(TAG_WORLD);
 
 		const FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
-		const int index = info.ComponentIndices[TComponent::TYPE_ID];
+		const RpgComponentSignature signature = (info.ArchetypeIndex != RPG_COMPONENT_ID_INVALID) ? ComponentArchetypes[info.ArchetypeIndex]->GetSignature() : 0;
+		GameObject_ChangeArchetype(gameObject.Index, signature | static_cast<RpgComponentSignature>(1u << TComponent::TYPE_ID));
 
-		if (index == RPG_COMPONENT_ID_INVALID)
-		{
-			return nullptr;
-		}
+		void* data = ComponentArchetypes[info.ArchetypeIndex]->GetComponentData(TComponent::TYPE_ID, info.ArchetypeRow);
+		TComponent* component = new (data)TComponent();
+		component->GameObject = gameObject;
+
+		GameObject_MarkChanged(gameObject.Index);
+
+		return component;
+	}
 
-		TComponent& data = Component_GetStorage<TComponent>()->Get(index);
-		RPG_Check(data.GameObject == gameObject);
 
-		return &data;
+	// Remove component. Game object moves into another archetype, pointers to its other components are invalidated
+	template<typename TComponent>
+	inline void GameObject_RemoveComponent(RpgGameObjectID gameObject) noexcept
+	{
+		GameObject_RemoveComponentByTypeId(gameObject, TComponent::TYPE_ID);
+	}
+
+
+	template<typename TComponent>
+	[[nodiscard]] inline TComponent* GameObject_GetComponent(RpgGameObjectID gameObject) noexcept
+	{
+		return const_cast<TComponent*>(static_cast<const RpgWorld*>(this)->GameObject_GetComponent<TComponent>(gameObject));
 	}
 
 
@@ -327,17 +631,23 @@ public:
 		RPG_Check(GameObject_IsValid(gameObject));
 
 		const FGameObjectInfo& info = GameObjectInfos[gameObject.Index];
-		const int index = info.ComponentIndices[TComponent::TYPE_ID];
 
-		if (index == RPG_COMPONENT_ID_INVALID)
+		if (info.ArchetypeIndex == RPG_COMPONENT_ID_INVALID)
+		{
+			return nullptr;
+		}
+
+		const RpgComponentArchetype* archetype = ComponentArchetypes[info.ArchetypeIndex];
+
+		if (!archetype->HasComponent(TComponent::TYPE_ID))
 		{
 			return nullptr;
 		}
 
-		const TComponent& data = Component_GetStorage<TComponent>()->Get(index);
-		RPG_Check(data.GameObject == gameObject);
+		const TComponent* data = static_cast<const TComponent*>(archetype->GetComponentData(TComponent::TYPE_ID, info.ArchetypeRow));
+		RPG_Check(data->GameObject == gameObject);
 
-		return &data;
+		return data;
 	}
 
 
@@ -423,9 +733,10 @@ public:
 	}
 
 
+	// @returns Number of live game objects (not pending destroy)
 	[[nodiscard]] inline int GameObject_GetCount() const noexcept
 	{
-		return GameObjectInfos.GetCount();
+		return GameObjectCount;
 	}
 
 
@@ -436,7 +747,83 @@ public:
 	}
 
 
+	// Incremented every time transform or components of game object changed. Compare with previously seen version to detect changes
+	[[nodiscard]] inline int GameObject_GetChangeVersion(RpgGameObjectID gameObject) const noexcept
+	{
+		RPG_Check(GameObject_IsValid(gameObject));
+		return GameObjectInfos[gameObject.Index].ChangeVersion;
+	}
+
+
+	// Number of game objects whose transform or components changed this frame. Each game object is listed once, list is cleared in EndFrame
+	[[nodiscard]] inline int ChangeList_GetCount() const noexcept
+	{
+		return ChangeListCount;
+	}
+
+
+	// @param index - Index in change list [0, ChangeList_GetCount())
+	// @returns Changed game object. Check GameObject_IsValid, game object may be destroyed after it changed
+	[[nodiscard]] inline RpgGameObjectID ChangeList_GetGameObject(int index) const noexcept
+	{
+		RPG_Check(index >= 0 && index < ChangeListCount);
+
+		const int gameObjectIndex = ChangeListGameObjects[index];
+		return RpgGameObjectID(const_cast<RpgWorld*>(this), gameObjectIndex, GameObjectInfos[gameObjectIndex].Gen);
+	}
+
+
 private:
+	// Increment change version and append game object into change list once per frame. Thread safe
+	inline void GameObject_MarkChanged(int index) noexcept
+	{
+		FGameObjectInfo& info = GameObjectInfos[index];
+		InterlockedIncrement(&info.ChangeVersion);
+
+		if (InterlockedExchange(&info.ChangeListStamp, ChangeListStamp) != ChangeListStamp)
+		{
+			const int slot = InterlockedIncrement(&ChangeListCount) - 1;
+			ChangeListGameObjects[slot] = index;
+		}
+	}
+
+
+	// Flag transform changed after world matrix is written
+	inline void GameObject_MarkTransformChanged(int index) noexcept
+	{
+		FGameObjectTransform& transform = GameObjectTransforms[index];
+		transform.bInverseWorldMatrixDirty = true;
+
+		FGameObjectInfo& info = GameObjectInfos[index];
+
+		if (bInTickStep)
+		{
+			// Game object is only moved by one thread at a time, flag check is enough to add it once per tick step
+			if (!(info.Flags & FLAG_TransformStepUpdated))
+			{
+				const int slot = InterlockedIncrement(&TransformStepCount) - 1;
+				TransformStepGameObjects[slot] = index;
+			}
+
+			info.Flags |= (FLAG_TransformUpdated | FLAG_TransformStepUpdated | FLAG_TransformHierarchyDirty);
+		}
+		else
+		{
+			transform.PrevWorldMatrix = transform.WorldMatrix;
+			info.Flags |= (FLAG_TransformUpdated | FLAG_TransformHierarchyDirty);
+		}
+
+		GameObject_MarkChanged(index);
+	}
+
+
+	// Rebuild depth sorted TransformHierarchyNodes after parent changed
+	void TransformHierarchy_Rebuild() noexcept;
+
+	// Detach game object from its parent and detach all its children. Children keep their world transform
+	void TransformHierarchy_Remove(int index) noexcept;
+
+
 	inline void GameObject_RemoveScriptAtIndex(int index) noexcept
 	{
 		RpgGameObjectScript* script = GameObjectScripts[index];
@@ -464,12 +851,24 @@ private:
 		FLAG_Loaded				= (1 << 2),
 		FLAG_PendingDestroy		= (1 << 3),
 		FLAG_TransformUpdated	= (1 << 4),
+
+		// World transform set during the latest tick step, interpolated from PrevWorldMatrix
+		FLAG_TransformStepUpdated	= (1 << 5),
+
+		// InterpolatedWorldMatrix is valid for this frame
+		FLAG_TransformInterpolated	= (1 << 6),
+
+		// World transform changed since last UpdateTransformHierarchy, children must be recalculated
+		FLAG_TransformHierarchyDirty	= (1 << 7),
 	};
 
 	struct FGameObjectInfo
 	{
-		// Component index for each type
-		uint16_t ComponentIndices[RPG_COMPONENT_TYPE_MAX_COUNT]{};
+		// Row in archetype
+		int ArchetypeRow{ RPG_INDEX_INVALID };
+
+		// Index into ComponentArchetypes, RPG_COMPONENT_ID_INVALID if game object has no component
+		uint16_t ArchetypeIndex{ RPG_COMPONENT_ID_INVALID };
 
 		// Generation number
 		uint16_t Gen{ 0 };
@@ -479,14 +878,35 @@ private:
 
 		// Script indices
 		int16_t ScriptIndices[RPG_GAMEOBJECT_MAX_SCRIPT]{};
+
+		// See GameObject_GetChangeVersion
+		RpgAtomicInt ChangeVersion{ 0 };
+
+		// Value of world ChangeListStamp when game object was added into change list
+		RpgAtomicInt ChangeListStamp{ -1 };
 	};
 
 	struct FGameObjectTransform
 	{
+		// Relative to parent, same as WorldMatrix if game object has no parent
 		RpgMatrixTransform LocalMatrix;
 		RpgMatrixTransform WorldMatrix;
-		RpgMatrixTransform InverseWorldMatrix;
+
+		// Valid if not bInverseWorldMatrixDirty
+		mutable RpgMatrixTransform InverseWorldMatrix;
+
+		// World matrix before the latest tick step
+		RpgMatrixTransform PrevWorldMatrix;
+
+		// World matrix used for rendering, valid if FLAG_TransformInterpolated
+		RpgMatrixTransform InterpolatedWorldMatrix;
+
 		RpgGameObjectID Parent;
+
+		// Number of attached children
+		int ChildCount{ 0 };
+
+		mutable bool bInverseWorldMatrixDirty{ true };
 	};
 
 	RpgFreeList<RpgName> GameObjectNames;
@@ -495,4 +915,69 @@ private:
 
 	RpgArray<RpgGameObjectScript*> GameObjectScripts;
 
+
+	struct FTransformHierarchyNode
+	{
+		int GameObjectIndex;
+		int ParentIndex;
+	};
+
+	// Game objects that have parent or children, sorted by depth. Parent always comes before its children
+	RpgArray<FTransformHierarchyNode> TransformHierarchyNodes;
+
+	// Start of each depth level in TransformHierarchyNodes, last element is node count
+	RpgArray<int> TransformHierarchyLevelOffsets;
+
+	bool bTransformHierarchyDirty;
+
+
+	// Indices of game objects changed this frame. Sized to RPG_WORLD_MAX_GAMEOBJECT, game object is added at most once per frame
+	RpgArray<int> ChangeListGameObjects;
+	RpgAtomicInt ChangeListCount;
+
+	// Incremented when change list is cleared
+	LONG ChangeListStamp;
+
+	// Indices of game objects moved during current (or latest) tick step (FLAG_TransformStepUpdated). Sized to RPG_WORLD_MAX_GAMEOBJECT, cleared by BeginTickStep
+	RpgArray<int> TransformStepGameObjects;
+	RpgAtomicInt TransformStepCount;
+
+	// Indices of game objects rendered at interpolated transform (FLAG_TransformInterpolated). Rebuilt by UpdateTransformInterpolation
+	RpgArray<int> TransformInterpolatedGameObjects;
+
+
+
+// --------------------------------------------------------------------------------------------------------------------------------------------- //
+// 	Snapshot interface
+// --------------------------------------------------------------------------------------------------------------------------------------------- //
+public:
+	// Write all game objects into binary snapshot. Pending destroy game objects are not saved
+	// @param writer - Output stream
+	// @returns None
+	void Snapshot_Save(RpgStreamWriter& writer) const noexcept;
+
+	// Write game objects (names, transforms, parents) and their components into binary snapshot. Each data is written as contiguous block.
+	// Scripts and components without snapshot support are not saved
+	// @param writer - Output stream
+	// @param gameObjects - Valid game objects to save
+	// @param gameObjectCount - Number of game objects
+	// @param externalParents - Game objects outside snapshot that can be parent of saved game objects. Parent not in snapshot nor in <externalParents> is not saved (warning is logged)
+	// @param externalParentCount - Number of external parents
+	// @returns None
+	void Snapshot_Save(RpgStreamWriter& writer, const RpgGameObjectID* gameObjects, int gameObjectCount, const RpgGameObjectID* externalParents = nullptr, int externalParentCount = 0) const noexcept;
+
+	// Check if game object can be saved into snapshot without losing data
+	// @param gameObject - Valid game object
+	// @returns False if game object has script, component without snapshot support or component that reports unsupported data (eg. unregistered asset reference, see RpgWorldSnapshotAsset)
+	[[nodiscard]] bool Snapshot_IsSupported(RpgGameObjectID gameObject) const noexcept;
+
+	// Create game objects from snapshot written by Snapshot_Save. Existing game objects are kept.
+	// Component data is copied into archetype chunks in bulk, component with different schema hash or not registered is ignored
+	// @param reader - Input stream
+	// @param out_GameObjects - Optional, created game objects are appended in saved order
+	// @param externalParents - Game objects that were passed as external parents to Snapshot_Save, in the same order
+	// @param externalParentCount - Number of external parents
+	// @returns False if snapshot header is invalid, snapshot exceeds maximum game object count or snapshot data is truncated/corrupted (game objects created by this load are destroyed)
+	bool Snapshot_Load(RpgStreamReader& reader, RpgArray<RpgGameObjectID>* out_GameObjects = nullptr, const RpgGameObjectID* externalParents = nullptr, int externalParentCount = 0) noexcept;
+
 };
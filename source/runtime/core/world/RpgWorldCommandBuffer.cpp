@@ -0,0 +1,98 @@
+#include "RpgWorldCommandBuffer.h"
+#include "RpgWorld.h"
+
+
+
+RpgWorldCommandBuffer::RpgWorldCommandBuffer(RpgWorld* in_World) noexcept
+{
+	World = in_World;
+	PageIndex = 0;
+	PageOffset = 0;
+}
+
+
+RpgWorldCommandBuffer::~RpgWorldCommandBuffer() noexcept
+{
+	Reset();
+
+	for (int i = 0; i < Pages.GetCount(); ++i)
+	{
+		RpgPlatformMemory::MemFree(Pages[i]);
+	}
+}
+
+
+RpgGameObjectID RpgWorldCommandBuffer::CreateGameObject(const RpgName& name, const RpgTransform& worldTransform) noexcept
+{
+	RPG_Assert(!name.IsEmpty());
+
+	const RpgGameObjectID gameObject = World->GameObject_Reserve();
+
+	AddCommand(COMMAND_CREATE, gameObject, RPG_COMPONENT_ID_INVALID, CreateDatas.GetCount());
+
+	FCreateData& data = CreateDatas.Add();
+	data.Name = name;
+	data.WorldTransform = worldTransform;
+
+	return gameObject;
+}
+
+
+void RpgWorldCommandBuffer::DestroyGameObject(RpgGameObjectID gameObject) noexcept
+{
+	AddCommand(COMMAND_DESTROY, gameObject, RPG_COMPONENT_ID_INVALID, RPG_INDEX_INVALID);
+}
+
+
+void RpgWorldCommandBuffer::SetWorldTransform(RpgGameObjectID gameObject, const RpgTransform& worldTransform) noexcept
+{
+	AddCommand(COMMAND_SET_WORLD_TRANSFORM, gameObject, RPG_COMPONENT_ID_INVALID, Transforms.GetCount());
+	Transforms.AddValue(worldTransform);
+}
+
+
+void* RpgWorldCommandBuffer::AllocateComponentData(size_t size) noexcept
+{
+	size = RpgType::Align(static_cast<uint32_t>(size), 16u);
+	RPG_Check(size <= RPG_WORLD_COMMAND_BUFFER_PAGE_SIZE);
+
+	if (PageIndex < Pages.GetCount() && PageOffset + size > RPG_WORLD_COMMAND_BUFFER_PAGE_SIZE)
+	{
+		++PageIndex;
+		PageOffset = 0;
+	}
+
+	if (PageIndex == Pages.GetCount())
+	{
+		uint8_t* page = reinterpret_cast<uint8_t*>(RpgPlatformMemory::MemMallocTag(RPG_WORLD_COMMAND_BUFFER_PAGE_SIZE, RpgPlatformMemory::TAG_WORLD));
+		RPG_Check(page);
+		Pages.AddValue(page);
+	}
+
+	void* data = Pages[PageIndex] + PageOffset;
+	PageOffset += size;
+
+	return data;
+}
+
+
+void RpgWorldCommandBuffer::Reset() noexcept
+{
+	for (int i = 0; i < Commands.GetCount(); ++i)
+	{
+		const FCommand& command = Commands[i];
+
+		if (command.Type == COMMAND_ADD_COMPONENT && ComponentDatas[command.DataIndex])
+		{
+			World->ComponentTypeInfos[command.ComponentTypeId].Destruct(ComponentDatas[command.DataIndex]);
+		}
+	}
+
+	Commands.Clear();
+	CreateDatas.Clear();
+	Transforms.Clear();
+	ComponentDatas.Clear();
+
+	PageIndex = 0;
+	PageOffset = 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../RpgMath.h"
+#include "../RpgString.h"
+#include "RpgComponent.h"
+
+
+// Maximum number of threads that can record into world command buffers
+#define RPG_WORLD_MAX_COMMAND_BUFFER		64
+
+// Size of memory page used to store recorded component data
+#define RPG_WORLD_COMMAND_BUFFER_PAGE_SIZE	(16 * 1024)
+
+
+
+// Records structural changes (create/destroy game object, add/remove component, transform write) from any thread.
+// Each thread records into its own buffer (RpgWorld::GetCommandBuffer), world plays back all buffers on main thread at sync point.
+// Created game object ID is reserved immediately and can be used by following commands, it becomes valid after playback.
+class RpgWorldCommandBuffer
+{
+	RPG_NOCOPY(RpgWorldCommandBuffer)
+
+public:
+	RpgWorldCommandBuffer(RpgWorld* in_World) noexcept;
+	~RpgWorldCommandBuffer() noexcept;
+
+
+	// Reserve game object ID and record create command
+	// @returns Reserved game object ID, valid after playback
+	[[nodiscard]] RpgGameObjectID CreateGameObject(const RpgName& name, const RpgTransform& worldTransform = RpgTransform()) noexcept;
+
+	void DestroyGameObject(RpgGameObjectID gameObject) noexcept;
+
+	void SetWorldTransform(RpgGameObjectID gameObject, const RpgTransform& worldTransform) noexcept;
+
+
+	// Record add component command. Returned component is moved into game object on playback, existing component is replaced
+	// @returns Component to initialize, valid until playback
+	template<typename TComponent>
+	[[nodiscard]] inline TComponent& AddComponent(RpgGameObjectID gameObject) noexcept
+	{
+		static_assert(alignof(TComponent) <= 16, "RpgWorldCommandBuffer: Component alignment exceeds 16 bytes!");
+		static_assert(sizeof(TComponent) <= RPG_WORLD_COMMAND_BUFFER_PAGE_SIZE, "RpgWorldCommandBuffer: Component size exceeds page size!");
+
+		void* data = AllocateComponentData(sizeof(TComponent));
+		TComponent* component = new (data)TComponent();
+		component->GameObject = gameObject;
+
+		AddCommand(COMMAND_ADD_COMPONENT, gameObject, TComponent::TYPE_ID, ComponentDatas.GetCount());
+		ComponentDatas.AddValue(data);
+
+		return *component;
+	}
+
+
+	template<typename TComponent>
+	inline void RemoveComponent(RpgGameObjectID gameObject) noexcept
+	{
+		AddCommand(COMMAND_REMOVE_COMPONENT, gameObject, TComponent::TYPE_ID, RPG_INDEX_INVALID);
+	}
+
+
+	[[nodiscard]] inline bool IsEmpty() const noexcept
+	{
+		return Commands.IsEmpty();
+	}
+
+
+private:
+	enum ECommandType : uint8_t
+	{
+		COMMAND_CREATE = 0,
+		COMMAND_DESTROY,
+		COMMAND_ADD_COMPONENT,
+		COMMAND_REMOVE_COMPONENT,
+		COMMAND_SET_WORLD_TRANSFORM,
+	};
+
+	struct FCommand
+	{
+		RpgGameObjectID GameObject;
+
+		// Index into CreateDatas/Transforms/ComponentDatas depends on type
+		int DataIndex;
+
+		uint16_t ComponentTypeId;
+		ECommandType Type;
+	};
+
+	struct FCreateData
+	{
+		RpgName Name;
+		RpgTransform WorldTransform;
+	};
+
+
+	inline void AddCommand(ECommandType type, RpgGameObjectID gameObject, uint16_t componentTypeId, int dataIndex) noexcept
+	{
+		FCommand& command = Commands.Add();
+		command.GameObject = gameObject;
+		command.DataIndex = dataIndex;
+		command.ComponentTypeId = componentTypeId;
+		command.Type = type;
+	}
+
+
+	// Allocate 16 bytes aligned memory from pages. Pages are kept after playback
+	void* AllocateComponentData(size_t size) noexcept;
+
+	// Destruct recorded components that were not moved by playback, then reset for recording
+	void Reset() noexcept;
+
+
+private:
+	RpgWorld* World;
+
+	RpgArray<FCommand> Commands;
+	RpgArray<FCreateData> CreateDatas;
+	RpgArray<RpgTransform> Transforms;
+
+	// Recorded components, constructed until playback moves them into game object
+	RpgArray<void*> ComponentDatas;
+
+	RpgArray<uint8_t*> Pages;
+	int PageIndex;
+	size_t PageOffset;
+
+
+	friend RpgWorld;
+
+};
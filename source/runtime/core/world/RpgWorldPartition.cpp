@@ -0,0 +1,832 @@
+#include "RpgWorldPartition.h"
+#include "../RpgProfiler.h"
+#include "../RpgTimer.h"
+
+
+// "RPGC"
+#define RPG_WORLD_PARTITION_CELL_FILE_MAGIC		0x43475052
+#define RPG_WORLD_PARTITION_CELL_FILE_VERSION	1
+
+// Upper bound of batch count in cell file, cell never holds more game objects than world
+#define RPG_WORLD_PARTITION_MAX_BATCH_COUNT		((RPG_WORLD_MAX_GAMEOBJECT + RPG_WORLD_PARTITION_BATCH_GAMEOBJECT - 1) / RPG_WORLD_PARTITION_BATCH_GAMEOBJECT)
+
+
+struct FWorldPartitionCellFileHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	int X;
+	int Z;
+	int BatchCount;
+};
+
+
+
+void RpgWorldPartition::FCellLoadTask::Execute() noexcept
+{
+	RPG_MEMORY_SCOPE_TAG(TAG_WORLD);
+
+	RpgArray<uint8_t> fileData;
+
+	if (!RpgFileSystem::ReadFromFile(FilePath, fileData) || fileData.GetCount() < static_cast<int>(sizeof(FWorldPartitionCellFileHeader)))
+	{
+		return;
+	}
+
+	RpgBinaryStreamReader reader(fileData);
+
+	FWorldPartitionCellFileHeader header;
+	reader.Read(header);
+
+	if (header.Magic != RPG_WORLD_PARTITION_CELL_FILE_MAGIC || header.Version != RPG_WORLD_PARTITION_CELL_FILE_VERSION)
+	{
+		return;
+	}
+
+	// Each batch takes at least its byte size field
+	if (header.BatchCount < 0 || header.BatchCount > RPG_WORLD_PARTITION_MAX_BATCH_COUNT ||
+		static_cast<size_t>(header.BatchCount) * sizeof(uint32_t) > reader.GetRemainingByteSize())
+	{
+		RPG_LogWarn(RpgLogWorld, "World partition: Invalid batch count (%i) in cell file (%s)", header.BatchCount, *FilePath);
+		return;
+	}
+
+	Batches.Resize(header.BatchCount);
+
+	for (int b = 0; b < header.BatchCount; ++b)
+	{
+		uint32_t byteSize = 0;
+		reader.Read(byteSize);
+
+		if (reader.HasError() || byteSize > reader.GetRemainingByteSize())
+		{
+			RPG_LogWarn(RpgLogWorld, "World partition: Cell file (%s) is truncated at batch (%i)", *FilePath, b);
+			Batches.Clear();
+			return;
+		}
+
+		Batches[b].Resize(static_cast<int>(byteSize));
+		reader.ReadData(Batches[b].GetData(), byteSize);
+	}
+
+	bSuccess = !reader.HasError();
+}
+
+
+
+RpgWorldPartition::RpgWorldPartition(RpgWorld* in_World, float in_CellSize) noexcept
+{
+	RPG_Check(in_World);
+	RPG_Check(in_CellSize > 0.0f);
+
+	World = in_World;
+	CellSize = in_CellSize;
+	UnloadDistanceMargin = in_CellSize * 0.5f;
+	ActivationBudgetMs = 2.0f;
+}
+
+
+RpgWorldPartition::~RpgWorldPartition() noexcept
+{
+	for (int i = 0; i < RPG_WORLD_PARTITION_MAX_LOAD_TASK; ++i)
+	{
+		if (LoadTasks[i].IsRunning())
+		{
+			LoadTasks[i].Wait();
+		}
+	}
+}
+
+
+int RpgWorldPartition::FindOrAddCell(int x, int z) noexcept
+{
+	RPG_Check(x >= INT16_MIN && x <= INT16_MAX && z >= INT16_MIN && z <= INT16_MAX);
+
+	const int key = GetCellKey(x, z);
+
+	if (const int* index = CellLookup.GetValueByKey(key))
+	{
+		return *index;
+	}
+
+	const int index = Cells.GetCount();
+	FCell& cell = Cells.Add();
+	cell.X = x;
+	cell.Z = z;
+	CellLookup.Add(key, index);
+
+	return index;
+}
+
+
+RpgString RpgWorldPartition::GetCellFilePath(const RpgString& directoryPath, int x, int z) noexcept
+{
+	return RpgString::Format("%scell_%i_%i%s", *directoryPath, x, z, RPG_WORLD_PARTITION_CELL_FILE_EXT);
+}
+
+
+void RpgWorldPartition::SaveCellBatches(FCell& cell, const RpgGameObjectID* gameObjects, int count) noexcept
+{
+	RPG_MEMORY_SCOPE_TAG(TAG_WORLD);
+
+	const int batchCount = (count + RPG_WORLD_PARTITION_BATCH_GAMEOBJECT - 1) / RPG_WORLD_PARTITION_BATCH_GAMEOBJECT;
+	cell.Batches.Clear();
+	cell.Batches.Resize(batchCount);
+
+	RpgBinaryStreamWriter writer;
+
+	for (int b = 0; b < batchCount; ++b)
+	{
+		// Game objects of previous batches are created before this batch, they can be parent of game objects in this batch
+		const int first = b * RPG_WORLD_PARTITION_BATCH_GAMEOBJECT;
+		const int batchSize = RpgMath::Min(RPG_WORLD_PARTITION_BATCH_GAMEOBJECT, count - first);
+
+		writer.Reset();
+		World->Snapshot_Save(writer, gameObjects + first, batchSize, gameObjects, first);
+
+		RpgArray<uint8_t>& batch = cell.Batches[b];
+		batch.Resize(static_cast<int>(writer.GetByteSize()));
+		RpgPlatformMemory::MemCopy(batch.GetData(), writer.GetByteData(), writer.GetByteSize());
+	}
+
+	cell.BatchIndex = 0;
+}
+
+
+void RpgWorldPartition::BuildCellsFromWorld() noexcept
+{
+	RPG_IsMainThread();
+	RPG_PROFILE_SCOPE("RpgWorldPartition_BuildCells");
+
+	RpgArray<RpgGameObjectID> gameObjects;
+	World->GameObject_GetAll(gameObjects);
+
+	// Roots of streaming sources stay in world
+	RpgArray<RpgGameObjectID> excludedRoots;
+
+	for (int s = 0; s < StreamingSources.GetCount(); ++s)
+	{
+		RpgGameObjectID root = StreamingSources[s].GameObject;
+
+		if (!World->GameObject_IsValid(root))
+		{
+			continue;
+		}
+
+		while (World->GameObject_GetParent(root).IsValid())
+		{
+			root = World->GameObject_GetParent(root);
+		}
+
+		excludedRoots.AddValue(root);
+	}
+
+	// Script and component without snapshot support would be lost by cell round trip, whole hierarchy stays in world
+	for (int i = 0; i < gameObjects.GetCount(); ++i)
+	{
+		if (World->Snapshot_IsSupported(gameObjects[i]))
+		{
+			continue;
+		}
+
+		RpgGameObjectID root = gameObjects[i];
+
+		while (World->GameObject_GetParent(root).IsValid())
+		{
+			root = World->GameObject_GetParent(root);
+		}
+
+		if (excludedRoots.FindIndexByValue(root) == RPG_INDEX_INVALID)
+		{
+			RPG_LogWarn(RpgLogWorld, "World partition: Game object (%s) has script or component without snapshot support. Hierarchy of (%s) is kept in world!", *World->GameObject_GetName(gameObjects[i]), *World->GameObject_GetName(root));
+			excludedRoots.AddValue(root);
+		}
+	}
+
+	struct FEntry
+	{
+		RpgGameObjectID GameObject;
+		int CellIndex;
+		int Depth;
+	};
+
+	RpgArray<FEntry> entries;
+	entries.Reserve(gameObjects.GetCount());
+
+	for (int i = 0; i < gameObjects.GetCount(); ++i)
+	{
+		RpgGameObjectID root = gameObjects[i];
+		int depth = 0;
+
+		while (World->GameObject_GetParent(root).IsValid())
+		{
+			root = World->GameObject_GetParent(root);
+			++depth;
+		}
+
+		if (excludedRoots.FindIndexByValue(root) != RPG_INDEX_INVALID)
+		{
+			continue;
+		}
+
+		// Whole hierarchy goes into cell of its root
+		const RpgVector3 position = World->GameObject_GetWorldTransform(root).Position;
+		const int x = static_cast<int>(floorf(position.X / CellSize));
+		const int z = static_cast<int>(floorf(position.Z / CellSize));
+
+		entries.AddValue({ gameObjects[i], FindOrAddCell(x, z), depth });
+	}
+
+	// Group by cell, parents before children
+	entries.StableSort(
+		[](const FEntry& a, const FEntry& b)
+		{
+			return (a.CellIndex != b.CellIndex) ? (a.CellIndex < b.CellIndex) : (a.Depth < b.Depth);
+		}
+	);
+
+	RpgArray<RpgGameObjectID> cellGameObjects;
+
+	for (int begin = 0; begin < entries.GetCount(); )
+	{
+		const int cellIndex = entries[begin].CellIndex;
+		FCell& cell = Cells[cellIndex];
+		RPG_CheckV(cell.State == CELL_STATE_UNLOADED && !cell.bHasFile, "RpgWorldPartition: Build cells into existing cell (%i, %i)!", cell.X, cell.Z);
+
+		cellGameObjects.Clear();
+
+		int end = begin;
+
+		for (; end < entries.GetCount() && entries[end].CellIndex == cellIndex; ++end)
+		{
+			cellGameObjects.AddValue(entries[end].GameObject);
+		}
+
+		SaveCellBatches(cell, cellGameObjects.GetData(), cellGameObjects.GetCount());
+		cell.State = CELL_STATE_LOADED;
+
+		begin = end;
+	}
+
+	for (int i = 0; i < entries.GetCount(); ++i)
+	{
+		World->GameObject_Destroy(entries[i].GameObject);
+	}
+
+	RPG_Log(RpgLogWorld, "World partition: Built %i cells from %i game objects (cell size: %.2f)", Cells.GetCount(), entries.GetCount(), CellSize);
+}
+
+
+int RpgWorldPartition::SaveCells(const RpgString& directoryPath) noexcept
+{
+	RPG_IsMainThread();
+
+	RpgPlatformFile::FolderCreate(*directoryPath);
+	CellDirectoryPath = directoryPath;
+
+	int savedCount = 0;
+	RpgBinaryStreamWriter writer;
+
+	for (int c = 0; c < Cells.GetCount(); ++c)
+	{
+		FCell& cell = Cells[c];
+
+		if (cell.State != CELL_STATE_LOADED)
+		{
+			if (cell.State != CELL_STATE_UNLOADED)
+			{
+				RPG_LogWarn(RpgLogWorld, "World partition: Cell (%i, %i) is not saved. Cell is loading or active!", cell.X, cell.Z);
+			}
+
+			continue;
+		}
+
+		FWorldPartitionCellFileHeader header;
+		header.Magic = RPG_WORLD_PARTITION_CELL_FILE_MAGIC;
+		header.Version = RPG_WORLD_PARTITION_CELL_FILE_VERSION;
+		header.X = cell.X;
+		header.Z = cell.Z;
+		header.BatchCount = cell.Batches.GetCount();
+
+		writer.Reset();
+		writer.Write(header);
+
+		for (int b = 0; b < cell.Batches.GetCount(); ++b)
+		{
+			const uint32_t byteSize = static_cast<uint32_t>(cell.Batches[b].GetCount());
+			writer.Write(byteSize);
+			writer.WriteData(cell.Batches[b].GetData(), byteSize);
+		}
+
+		const RpgString filePath = GetCellFilePath(directoryPath, cell.X, cell.Z);
+
+		if (!RpgFileSystem::WriteToFile(filePath, writer.GetByteData(), writer.GetByteSize()))
+		{
+			RPG_LogError(RpgLogWorld, "World partition: Fail to save cell (%i, %i) to file (%s)", cell.X, cell.Z, *filePath);
+			continue;
+		}
+
+		cell.bHasFile = true;
+		++savedCount;
+	}
+
+	RPG_Log(RpgLogWorld, "World partition: Saved %i cells to (%s)", savedCount, *directoryPath);
+
+	return savedCount;
+}
+
+
+int RpgWorldPartition::RegisterCellFiles(const RpgString& directoryPath) noexcept
+{
+	RPG_IsMainThread();
+
+	CellDirectoryPath = directoryPath;
+
+	RpgArray<RpgFilePath> filePaths;
+	RpgFileSystem::IterateFiles(filePaths, directoryPath, false, RPG_WORLD_PARTITION_CELL_FILE_EXT);
+
+	int registeredCount = 0;
+
+	for (int i = 0; i < filePaths.GetCount(); ++i)
+	{
+		// Only header is read, cell data is loaded when needed
+		HANDLE fileHandle = RpgPlatformFile::FileOpen(*filePaths[i], RpgPlatformFile::OPEN_MODE_READ);
+
+		if (fileHandle == NULL || fileHandle == INVALID_HANDLE_VALUE)
+		{
+			continue;
+		}
+
+		FWorldPartitionCellFileHeader header;
+		const bool bReadHeader = RpgPlatformFile::FileRead(fileHandle, &header, sizeof(FWorldPartitionCellFileHeader));
+		RpgPlatformFile::FileClose(fileHandle);
+
+		if (!bReadHeader || header.Magic != RPG_WORLD_PARTITION_CELL_FILE_MAGIC || header.Version != RPG_WORLD_PARTITION_CELL_FILE_VERSION ||
+			RpgFilePath(GetCellFilePath(directoryPath, header.X, header.Z)) != filePaths[i])
+		{
+			RPG_LogWarn(RpgLogWorld, "World partition: Ignore invalid cell file (%s)", *filePaths[i]);
+			continue;
+		}
+
+		FCell& cell = Cells[FindOrAddCell(header.X, header.Z)];
+
+		if (!cell.bHasFile)
+		{
+			cell.bHasFile = true;
+			++registeredCount;
+		}
+	}
+
+	RPG_Log(RpgLogWorld, "World partition: Registered %i cell files from (%s)", registeredCount, *directoryPath);
+
+	return registeredCount;
+}
+
+
+void RpgWorldPartition::StreamingSource_Add(RpgGameObjectID gameObject, float loadRadius, float activationRadius) noexcept
+{
+	RPG_Check(World->GameObject_IsValid(gameObject));
+
+	StreamingSource_Remove(gameObject);
+
+	FStreamingSource& source = StreamingSources.Add();
+	source.GameObject = gameObject;
+	source.LoadRadius = loadRadius;
+	source.ActivationRadius = RpgMath::Min(activationRadius, loadRadius);
+}
+
+
+void RpgWorldPartition::StreamingSource_Remove(RpgGameObjectID gameObject) noexcept
+{
+	for (int i = 0; i < StreamingSources.GetCount(); ++i)
+	{
+		if (StreamingSources[i].GameObject == gameObject)
+		{
+			StreamingSources.RemoveAt(i);
+			return;
+		}
+	}
+}
+
+
+void RpgWorldPartition::BeginDeactivateCell(FCell& cell) noexcept
+{
+	RPG_Check(cell.State == CELL_STATE_ACTIVE);
+
+	// Game objects may be destroyed, reparented or get scripts while cell is active
+	struct FEntry
+	{
+		RpgGameObjectID GameObject;
+		int Depth;
+
+		// Entry of topmost ancestor in this cell
+		int TopEntryIndex;
+
+		// Set on top entry, whole hierarchy under it is released from cell
+		bool bReleased;
+	};
+
+	RpgArray<FEntry> entries;
+	entries.Reserve(cell.GameObjects.GetCount());
+
+	// Key: game object index, Value: entry index
+	RpgMap<int, int> entryLookup;
+	entryLookup.Reserve(cell.GameObjects.GetCount());
+
+	for (int i = 0; i < cell.GameObjects.GetCount(); ++i)
+	{
+		const RpgGameObjectID gameObject = cell.GameObjects[i];
+
+		if (World->GameObject_IsValid(gameObject))
+		{
+			entryLookup.Add(gameObject.GetIndex(), entries.GetCount());
+			entries.AddValue({ gameObject, 0, entries.GetCount(), false });
+		}
+	}
+
+	for (int i = 0; i < entries.GetCount(); ++i)
+	{
+		FEntry& entry = entries[i];
+		RpgGameObjectID parent = World->GameObject_GetParent(entry.GameObject);
+
+		while (parent.IsValid())
+		{
+			const int* parentEntryIndex = entryLookup.GetValueByKey(parent.GetIndex());
+
+			if (parentEntryIndex == nullptr)
+			{
+				break;
+			}
+
+			entry.TopEntryIndex = *parentEntryIndex;
+			++entry.Depth;
+			parent = World->GameObject_GetParent(parent);
+		}
+
+		// Parent in other cell or streaming source would be lost by cell round trip, so would script and component without snapshot support
+		if (parent.IsValid() || !World->Snapshot_IsSupported(entry.GameObject))
+		{
+			entries[entry.TopEntryIndex].bReleased = true;
+		}
+	}
+
+	for (int i = 0; i < entries.GetCount(); ++i)
+	{
+		FEntry& entry = entries[i];
+		entry.bReleased = entries[entry.TopEntryIndex].bReleased;
+
+		if (entry.bReleased && entry.TopEntryIndex == i)
+		{
+			RPG_LogWarn(RpgLogWorld, "World partition: Hierarchy of (%s) is attached outside cell (%i, %i) or has script or component without snapshot support. Hierarchy is released from cell and kept in world!",
+				*World->GameObject_GetName(entry.GameObject), cell.X, cell.Z);
+		}
+	}
+
+	int keptCount = 0;
+
+	for (int i = 0; i < entries.GetCount(); ++i)
+	{
+		if (entries[i].bReleased)
+		{
+			continue;
+		}
+
+		entries[keptCount++] = entries[i];
+	}
+
+	entries.Resize(keptCount);
+
+	entries.StableSort(
+		[](const FEntry& a, const FEntry& b)
+		{
+			return a.Depth < b.Depth;
+		}
+	);
+
+	cell.GameObjects.Resize(entries.GetCount());
+
+	for (int i = 0; i < entries.GetCount(); ++i)
+	{
+		cell.GameObjects[i] = entries[i].GameObject;
+	}
+
+	// Whole cell is saved while every game object still exists, so cross batch parents are kept. Destroy is spread over frames
+	SaveCellBatches(cell, cell.GameObjects.GetData(), cell.GameObjects.GetCount());
+	cell.State = CELL_STATE_DEACTIVATING;
+}
+
+
+bool RpgWorldPartition::ProcessCellBatch(FCell& cell) noexcept
+{
+	if (cell.State == CELL_STATE_ACTIVATING)
+	{
+		if (cell.BatchIndex < cell.Batches.GetCount())
+		{
+			// Reader takes batch data, cell data is saved again on deactivate
+			RpgBinaryStreamReader reader(cell.Batches[cell.BatchIndex++]);
+
+			// Copy external parents, created game objects are appended into the same array
+			RpgArray<RpgGameObjectID> externalParents = cell.GameObjects;
+
+			if (!World->Snapshot_Load(reader, &cell.GameObjects, externalParents.GetData(), externalParents.GetCount()))
+			{
+				RPG_LogError(RpgLogWorld, "World partition: Fail to activate batch (%i) of cell (%i, %i)", cell.BatchIndex - 1, cell.X, cell.Z);
+			}
+		}
+
+		if (cell.BatchIndex == cell.Batches.GetCount())
+		{
+			cell.Batches.Clear(true);
+			cell.BatchIndex = 0;
+			cell.State = CELL_STATE_ACTIVE;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	RPG_Check(cell.State == CELL_STATE_DEACTIVATING);
+
+	// Destroy children first, last game objects have the deepest hierarchy level
+	const int count = RpgMath::Min(RPG_WORLD_PARTITION_BATCH_GAMEOBJECT, cell.GameObjects.GetCount());
+	const int first = cell.GameObjects.GetCount() - count;
+
+	for (int i = first; i < cell.GameObjects.GetCount(); ++i)
+	{
+		World->GameObject_Destroy(cell.GameObjects[i]);
+	}
+
+	cell.GameObjects.Resize(first);
+
+	if (first == 0)
+	{
+		cell.State = CELL_STATE_LOADED;
+		return true;
+	}
+
+	return false;
+}
+
+
+void RpgWorldPartition::UnloadCell(FCell& cell) noexcept
+{
+	RPG_Check(cell.State == CELL_STATE_LOADED && cell.bHasFile);
+
+	cell.Batches.Clear(true);
+	cell.BatchIndex = 0;
+	cell.State = CELL_STATE_UNLOADED;
+}
+
+
+void RpgWorldPartition::Update() noexcept
+{
+	RPG_IsMainThread();
+	RPG_PROFILE_SCOPE("RpgWorldPartition_Update");
+
+	// Finished cell loads
+	for (int i = 0; i < RPG_WORLD_PARTITION_MAX_LOAD_TASK; ++i)
+	{
+		FCellLoadTask& task = LoadTasks[i];
+
+		if (!task.IsDone())
+		{
+			continue;
+		}
+
+		FCell& cell = Cells[task.CellIndex];
+		RPG_Check(cell.State == CELL_STATE_LOADING);
+
+		if (task.bSuccess)
+		{
+			cell.Batches = std::move(task.Batches);
+			cell.BatchIndex = 0;
+			cell.State = CELL_STATE_LOADED;
+		}
+		else
+		{
+			// Cell is not loaded again until its file is registered again
+			RPG_LogError(RpgLogWorld, "World partition: Fail to load cell file (%s)", *task.FilePath);
+			cell.bHasFile = false;
+			cell.State = CELL_STATE_UNLOADED;
+		}
+
+		task.Reset();
+	}
+
+
+	// Distance from streaming sources
+	RpgArrayInline<RpgVector3, 8> sourcePositions;
+
+	for (int s = 0; s < StreamingSources.GetCount(); ++s)
+	{
+		const RpgGameObjectID gameObject = StreamingSources[s].GameObject;
+		sourcePositions.AddValue(World->GameObject_IsValid(gameObject) ? World->GameObject_GetWorldTransform(gameObject).Position : RpgVector3(FLT_MAX));
+	}
+
+	RpgArrayInline<RpgThreadTask*, RPG_WORLD_PARTITION_MAX_LOAD_TASK> submitTasks;
+	int freeTaskIndex = 0;
+
+	Stats.ResidentCellCount = 0;
+	Stats.ActiveCellCount = 0;
+	Stats.PendingLoadCount = 0;
+	Stats.PendingActivationCount = 0;
+	Stats.PendingDeactivationCount = 0;
+	Stats.ActiveGameObjectCount = 0;
+
+	for (int c = 0; c < Cells.GetCount(); ++c)
+	{
+		FCell& cell = Cells[c];
+		const float minX = cell.X * CellSize;
+		const float minZ = cell.Z * CellSize;
+
+		bool bWantActive = false;
+		bool bWantResident = !cell.bHasFile;
+		cell.DistanceSquared = FLT_MAX;
+
+		for (int s = 0; s < sourcePositions.GetCount(); ++s)
+		{
+			const RpgVector3& position = sourcePositions[s];
+			const float dx = RpgMath::Max(0.0f, RpgMath::Max(minX - position.X, position.X - (minX + CellSize)));
+			const float dz = RpgMath::Max(0.0f, RpgMath::Max(minZ - position.Z, position.Z - (minZ + CellSize)));
+			const float distanceSquared = dx * dx + dz * dz;
+			cell.DistanceSquared = RpgMath::Min(cell.DistanceSquared, distanceSquared);
+
+			const FStreamingSource& source = StreamingSources[s];
+			const bool bActive = (cell.State >= CELL_STATE_ACTIVATING && cell.State != CELL_STATE_DEACTIVATING);
+			const bool bResident = (cell.State != CELL_STATE_UNLOADED);
+			const float activationRadius = source.ActivationRadius + (bActive ? UnloadDistanceMargin : 0.0f);
+			const float loadRadius = source.LoadRadius + (bResident ? UnloadDistanceMargin : 0.0f);
+
+			bWantActive |= (distanceSquared <= activationRadius * activationRadius);
+			bWantResident |= (distanceSquared <= loadRadius * loadRadius);
+		}
+
+		bWantResident |= bWantActive;
+
+		switch (cell.State)
+		{
+			case CELL_STATE_UNLOADED:
+			{
+				if (!bWantResident || !cell.bHasFile)
+				{
+					break;
+				}
+
+				while (freeTaskIndex < RPG_WORLD_PARTITION_MAX_LOAD_TASK && !LoadTasks[freeTaskIndex].IsIdle())
+				{
+					++freeTaskIndex;
+				}
+
+				// Wait for free load task
+				if (freeTaskIndex == RPG_WORLD_PARTITION_MAX_LOAD_TASK)
+				{
+					++Stats.PendingLoadCount;
+					break;
+				}
+
+				FCellLoadTask& task = LoadTasks[freeTaskIndex++];
+				task.FilePath = GetCellFilePath(CellDirectoryPath, cell.X, cell.Z);
+				task.CellIndex = c;
+				submitTasks.AddValue(&task);
+
+				cell.State = CELL_STATE_LOADING;
+				++Stats.PendingLoadCount;
+				break;
+			}
+
+			case CELL_STATE_LOADING:
+			{
+				++Stats.PendingLoadCount;
+				break;
+			}
+
+			case CELL_STATE_LOADED:
+			{
+				if (bWantActive)
+				{
+					cell.State = CELL_STATE_ACTIVATING;
+					cell.BatchIndex = 0;
+					++Stats.PendingActivationCount;
+				}
+				else if (!bWantResident && cell.bHasFile)
+				{
+					UnloadCell(cell);
+				}
+
+				break;
+			}
+
+			case CELL_STATE_ACTIVATING:
+			{
+				// Finish activating before deactivate, batches refer to game objects of previous batches
+				++Stats.PendingActivationCount;
+				break;
+			}
+
+			case CELL_STATE_ACTIVE:
+			{
+				if (!bWantActive)
+				{
+					BeginDeactivateCell(cell);
+					++Stats.PendingDeactivationCount;
+				}
+
+				break;
+			}
+
+			case CELL_STATE_DEACTIVATING:
+			{
+				++Stats.PendingDeactivationCount;
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+	if (submitTasks.GetCount() > 0)
+	{
+		RpgThreadPool::SubmitTasks(submitTasks.GetData(), submitTasks.GetCount());
+	}
+
+
+	// Time budgeted activation. Deactivation first to release game object slots, then nearest cell first
+	{
+		RpgTimer timer;
+		timer.Start();
+
+		float elapsedMs = 0.0f;
+		Stats.ProcessedBatchCount = 0;
+
+		while (Stats.ProcessedBatchCount == 0 || elapsedMs < ActivationBudgetMs)
+		{
+			int cellIndex = RPG_INDEX_INVALID;
+
+			for (int c = 0; c < Cells.GetCount(); ++c)
+			{
+				const FCell& cell = Cells[c];
+
+				if (cell.State != CELL_STATE_ACTIVATING && cell.State != CELL_STATE_DEACTIVATING)
+				{
+					continue;
+				}
+
+				if (cellIndex == RPG_INDEX_INVALID)
+				{
+					cellIndex = c;
+					continue;
+				}
+
+				const FCell& best = Cells[cellIndex];
+
+				if ((cell.State == CELL_STATE_DEACTIVATING) != (best.State == CELL_STATE_DEACTIVATING))
+				{
+					cellIndex = (cell.State == CELL_STATE_DEACTIVATING) ? c : cellIndex;
+				}
+				else if (cell.DistanceSquared < best.DistanceSquared)
+				{
+					cellIndex = c;
+				}
+			}
+
+			if (cellIndex == RPG_INDEX_INVALID)
+			{
+				break;
+			}
+
+			FCell& cell = Cells[cellIndex];
+			const bool bActivating = (cell.State == CELL_STATE_ACTIVATING);
+
+			if (ProcessCellBatch(cell))
+			{
+				if (bActivating)
+				{
+					--Stats.PendingActivationCount;
+				}
+				else
+				{
+					--Stats.PendingDeactivationCount;
+				}
+			}
+
+			++Stats.ProcessedBatchCount;
+			elapsedMs += timer.Tick() / 1000.0f;
+		}
+
+		Stats.ActivationTimeMs = elapsedMs;
+		Stats.PeakActivationTimeMs = RpgMath::Max(Stats.PeakActivationTimeMs, elapsedMs);
+	}
+
+
+	Stats.CellCount = Cells.GetCount();
+
+	for (int c = 0; c < Cells.GetCount(); ++c)
+	{
+		const FCell& cell = Cells[c];
+		Stats.ResidentCellCount += (cell.State >= CELL_STATE_LOADED) ? 1 : 0;
+		Stats.ActiveCellCount += (cell.State == CELL_STATE_ACTIVE) ? 1 : 0;
+		Stats.ActiveGameObjectCount += (cell.State == CELL_STATE_ACTIVE) ? cell.GameObjects.GetCount() : 0;
+	}
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "../RpgFilePath.h"
+#include "RpgWorld.h"
+
+
+// Maximum number of game objects in one cell activation batch. Activation/deactivation cost is bounded per batch
+#define RPG_WORLD_PARTITION_BATCH_GAMEOBJECT	256
+
+// Maximum number of cell files read concurrently on worker threads
+#define RPG_WORLD_PARTITION_MAX_LOAD_TASK		4
+
+#define RPG_WORLD_PARTITION_CELL_FILE_EXT		".rpgcell"
+
+
+
+// Splits world game objects into grid of cells (XZ plane). Each cell holds its game objects serialized as world snapshot batches.
+// Cells are streamed around streaming sources:
+// - Within load radius, cell file is read on worker thread and kept resident
+// - Within activation radius, cell game objects are created in world, a few batches per frame within activation time budget
+// - Outside radius + unload margin, cell game objects are saved back into cell data and destroyed, then cell data is released
+// Cells without file (built in memory and never saved) are always resident. Changes to game objects of file cell are lost once cell data is released.
+// Cell data is world snapshot, so only game objects that survive snapshot round trip are streamed:
+// - Hierarchy with script or component without snapshot support is never put into cell and stays in world (see RpgWorld::Snapshot_IsSupported).
+//   Component asset references (mesh, material, animation) are saved by name and only supported while asset is registered in RpgWorldSnapshotAsset
+// - Hierarchy of active cell attached to game object outside the cell (other cell, streaming source) or given such script/component is released from cell on deactivate and stays in world
+class RpgWorldPartition
+{
+	RPG_NOCOPY(RpgWorldPartition)
+
+public:
+	struct FStats
+	{
+		int CellCount{ 0 };
+
+		// Cells with data in memory or game objects in world
+		int ResidentCellCount{ 0 };
+
+		int ActiveCellCount{ 0 };
+		int PendingLoadCount{ 0 };
+		int PendingActivationCount{ 0 };
+		int PendingDeactivationCount{ 0 };
+
+		// Number of game objects created by active cells
+		int ActiveGameObjectCount{ 0 };
+
+		// Batches activated/deactivated in the latest Update
+		int ProcessedBatchCount{ 0 };
+
+		// Time spent activating/deactivating batches in the latest Update
+		float ActivationTimeMs{ 0.0f };
+
+		// Highest ActivationTimeMs since partition was created
+		float PeakActivationTimeMs{ 0.0f };
+	};
+
+
+public:
+	RpgWorldPartition(RpgWorld* in_World, float in_CellSize) noexcept;
+	~RpgWorldPartition() noexcept;
+
+
+	// Move every root game object (and its children) of world into cell at root position. Streaming sources are kept in world,
+	// so is hierarchy that has script or component without snapshot support (warning is logged).
+	// Game objects are saved into resident cells then destroyed, cells in activation radius are activated again by Update
+	// @returns None
+	void BuildCellsFromWorld() noexcept;
+
+	// Write each resident cell into <directoryPath>/cell_<X>_<Z>.rpgcell. Active cells are not saved
+	// @param directoryPath - Directory path with trailing slash
+	// @returns Number of saved cells
+	int SaveCells(const RpgString& directoryPath) noexcept;
+
+	// Register cell files in <directoryPath>. Cells are not loaded until they are in load radius of streaming source
+	// @param directoryPath - Directory path with trailing slash
+	// @returns Number of registered cells
+	int RegisterCellFiles(const RpgString& directoryPath) noexcept;
+
+
+	// Add streaming source. Cells around its world position are loaded and activated
+	// @param gameObject - Streaming source game object (player, camera)
+	// @param loadRadius - Cells within this distance are loaded into memory
+	// @param activationRadius - Cells within this distance are activated, clamped to <loadRadius>
+	// @returns None
+	void StreamingSource_Add(RpgGameObjectID gameObject, float loadRadius, float activationRadius) noexcept;
+
+	void StreamingSource_Remove(RpgGameObjectID gameObject) noexcept;
+
+
+	// Poll finished loads, update cell states from streaming sources then activate/deactivate batches within ActivationBudgetMs.
+	// Call once per frame on main thread after RpgWorld::BeginFrame
+	// @returns None
+	void Update() noexcept;
+
+
+	[[nodiscard]] inline const FStats& GetStats() const noexcept
+	{
+		return Stats;
+	}
+
+	[[nodiscard]] inline float GetCellSize() const noexcept
+	{
+		return CellSize;
+	}
+
+
+public:
+	// Added to streaming source radius before cell is deactivated/unloaded, prevents cells near the boundary from streaming every frame
+	float UnloadDistanceMargin;
+
+	// Time budget per Update to activate/deactivate batches. At least one batch is processed per Update
+	float ActivationBudgetMs;
+
+
+private:
+	enum ECellState : uint8_t
+	{
+		// Cell data is only in file
+		CELL_STATE_UNLOADED = 0,
+
+		// Cell file is being read on worker thread
+		CELL_STATE_LOADING,
+
+		// Cell data is in memory, no game object in world
+		CELL_STATE_LOADED,
+
+		// Batches are being created in world
+		CELL_STATE_ACTIVATING,
+
+		// All game objects are in world, cell data is released
+		CELL_STATE_ACTIVE,
+
+		// Game objects are being saved into batches and destroyed
+		CELL_STATE_DEACTIVATING,
+	};
+
+	struct FCell
+	{
+		int X{ 0 };
+		int Z{ 0 };
+		ECellState State{ CELL_STATE_UNLOADED };
+
+		// Cell can be loaded again from file after its data is released
+		bool bHasFile{ false };
+
+		// Squared distance to nearest streaming source, updated every Update
+		float DistanceSquared{ 0.0f };
+
+		// Serialized game objects. Parent of game object in batch is either in the same batch or in previous batches
+		RpgArray<RpgArray<uint8_t>> Batches;
+
+		// Next batch to activate, or batch count left to deactivate
+		int BatchIndex{ 0 };
+
+		// Game objects created from batches, in batch order
+		RpgArray<RpgGameObjectID> GameObjects;
+	};
+
+
+	class FCellLoadTask : public RpgThreadTask
+	{
+	public:
+		RpgString FilePath;
+		int CellIndex{ RPG_INDEX_INVALID };
+		RpgArray<RpgArray<uint8_t>> Batches;
+		bool bSuccess{ false };
+
+	public:
+		virtual void Reset() noexcept override
+		{
+			RpgThreadTask::Reset();
+			FilePath = RpgString();
+			CellIndex = RPG_INDEX_INVALID;
+			Batches.Clear();
+			bSuccess = false;
+		}
+
+		virtual void Execute() noexcept override;
+
+		virtual const char* GetTaskName() const noexcept override
+		{
+			return "RpgWorldPartition_LoadCell";
+		}
+	};
+
+
+	struct FStreamingSource
+	{
+		RpgGameObjectID GameObject;
+		float LoadRadius;
+		float ActivationRadius;
+	};
+
+
+	[[nodiscard]] static inline int GetCellKey(int x, int z) noexcept
+	{
+		return static_cast<int>((static_cast<uint32_t>(x) & 0xFFFF) | (static_cast<uint32_t>(z) << 16));
+	}
+
+	[[nodiscard]] int FindOrAddCell(int x, int z) noexcept;
+
+	[[nodiscard]] static RpgString GetCellFilePath(const RpgString& directoryPath, int x, int z) noexcept;
+
+
+	// Save <count> game objects as batches into cell. Parents must come before their children
+	void SaveCellBatches(FCell& cell, const RpgGameObjectID* gameObjects, int count) noexcept;
+
+	// Remove invalid game objects, release hierarchies that can not be saved, sort by hierarchy depth and prepare batches to deactivate
+	void BeginDeactivateCell(FCell& cell) noexcept;
+
+	// Create or destroy one batch of cell
+	// @returns True if cell has finished activating/deactivating
+	bool ProcessCellBatch(FCell& cell) noexcept;
+
+	// Release cell data. Cell is loaded again from file when needed
+	void UnloadCell(FCell& cell) noexcept;
+
+
+private:
+	RpgWorld* World;
+	float CellSize;
+
+	// Directory of cell files, set by SaveCells/RegisterCellFiles
+	RpgString CellDirectoryPath;
+
+	RpgArray<FCell> Cells;
+
+	// Key: GetCellKey, Value: index into Cells
+	RpgMap<int, int> CellLookup;
+
+	RpgArray<FStreamingSource> StreamingSources;
+
+	FCellLoadTask LoadTasks[RPG_WORLD_PARTITION_MAX_LOAD_TASK];
+
+	FStats Stats;
+
+};
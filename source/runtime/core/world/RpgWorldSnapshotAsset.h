@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../RpgString.h"
+#include "../RpgStream.h"
+#include "../RpgPointer.h"
+#include "../dsa/RpgMap.h"
+
+
+RPG_LOG_DECLARE_CATEGORY_EXTERN(RpgLogWorld)
+
+
+
+// Assets referenced by components in world snapshot. Snapshot stores asset name, loading resolves it into asset registered with the same name.
+// Asset must be registered before game object referencing it is saved and stay registered until snapshot is loaded.
+// Component holding unregistered asset must report it from IsSnapshotSupported() so RpgWorld::Snapshot_IsSupported keeps its hierarchy out of snapshot.
+// Registry holds strong references, call Clear() before asset resources are released. Main thread only.
+// TAsset must implement const RpgName& GetName() const
+template<typename TAsset>
+class RpgWorldSnapshotAsset
+{
+public:
+	// Register asset under its name
+	// @param asset - Asset to register
+	// @returns False if other asset is already registered with the same name, asset is not registered
+	static inline bool Register(const RpgSharedPtr<TAsset>& asset) noexcept
+	{
+		RPG_IsMainThread();
+		RPG_Check(asset);
+
+		if (RpgSharedPtr<TAsset>* registered = Assets.GetValueByKey(asset->GetName()))
+		{
+			if (*registered != asset)
+			{
+				RPG_LogWarn(RpgLogWorld, "Snapshot asset (%s) is already registered with different instance! Asset is not registered", *asset->GetName());
+				return false;
+			}
+
+			return true;
+		}
+
+		Assets.Add(asset->GetName(), asset);
+
+		return true;
+	}
+
+
+	static inline void Unregister(const RpgSharedPtr<TAsset>& asset) noexcept
+	{
+		RPG_IsMainThread();
+
+		if (asset && IsRegistered(asset))
+		{
+			Assets.Remove(asset->GetName());
+		}
+	}
+
+
+	// @returns True if asset is null or registered, false if asset can not be resolved when snapshot is loaded
+	[[nodiscard]] static inline bool IsRegistered(const RpgSharedPtr<TAsset>& asset) noexcept
+	{
+		if (!asset)
+		{
+			return true;
+		}
+
+		const RpgSharedPtr<TAsset>* registered = Assets.GetValueByKey(asset->GetName());
+
+		return registered && *registered == asset;
+	}
+
+
+	[[nodiscard]] static inline RpgSharedPtr<TAsset> Find(const RpgName& name) noexcept
+	{
+		const RpgSharedPtr<TAsset>* registered = Assets.GetValueByKey(name);
+
+		return registered ? *registered : RpgSharedPtr<TAsset>();
+	}
+
+
+	static inline void Clear() noexcept
+	{
+		RPG_IsMainThread();
+		Assets.Clear(true);
+	}
+
+
+	// Write asset reference. Null asset is written as empty name
+	static inline void Write(RpgStreamWriter& writer, const RpgSharedPtr<TAsset>& asset) noexcept
+	{
+		const RpgName name = asset ? asset->GetName() : RpgName();
+		writer.Write(name);
+	}
+
+
+	// Read asset reference written by Write. Asset that is not registered is read as null
+	static inline void Read(RpgStreamReader& reader, RpgSharedPtr<TAsset>& out_Asset) noexcept
+	{
+		RpgName name;
+		reader.Read(name);
+		name.GetData()[RPG_NAME_MAX_COUNT - 1] = '\0';
+
+		out_Asset = name.IsEmpty() ? RpgSharedPtr<TAsset>() : Find(name);
+
+		if (!name.IsEmpty() && !out_Asset)
+		{
+			RPG_LogWarn(RpgLogWorld, "Snapshot asset (%s) is not registered! Asset reference is cleared", *name);
+		}
+	}
+
+
+private:
+	inline static RpgMap<RpgName, RpgSharedPtr<TAsset>> Assets;
+
+};
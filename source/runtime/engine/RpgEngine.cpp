@@ -1,6 +1,10 @@
 #include "RpgEngine.h"
+#include "core/RpgAllocator.h"
 #include "core/RpgCommandLine.h"
 #include "core/RpgConsoleSystem.h"
+#include "core/RpgFilePath.h"
+#include "core/RpgProfiler.h"
+#include "core/RpgThreadPool.h"
 #include "input/RpgInputManager.h"
 #include "physics/world/RpgPhysicsComponent.h"
 #include "physics/world/RpgPhysicsWorldSubsystem.h"
@@ -12,6 +16,8 @@
 #include "asset/RpgAssetManager.h"
 
 #include "../../test/gui/RpgTestGui.h"
+#include "../../test/core/RpgTestCore.h"
+#include "../../test/physics/RpgTestPhysics.h"
 
 
 #ifndef RPG_BUILD_SHIPPING
@@ -39,12 +45,22 @@ RpgEngine::RpgEngine() noexcept
 	FpsTimeMs = 0.0f;
 	FpsCountMs = 0.0f;
 
+	// fixed tick
+	FixedTickRate = 60;
+	MaxTickStepsPerFrame = 4;
+	TickAccumulator = 0.0f;
+
 	RpgRenderThread::Initialize();
 }
 
 
 RpgEngine::~RpgEngine() noexcept
 {
+	RpgWorldSnapshotAsset<RpgMesh>::Clear();
+	RpgWorldSnapshotAsset<RpgMaterial>::Clear();
+	RpgWorldSnapshotAsset<RpgAnimationSkeleton>::Clear();
+	RpgWorldSnapshotAsset<RpgAnimationClip>::Clear();
+
 	RpgRenderThread::Shutdown();
 }
 
@@ -53,6 +69,27 @@ void RpgEngine::Initialize() noexcept
 {
 	g_ConsoleSystem->RegisterObjectCommandListener(this, &RpgEngine::HandleConsoleCommand);
 
+	const int cmdArgTickRate = RpgCommandLine::GetCommandValueInt("tickrate");
+	if (cmdArgTickRate > 0)
+	{
+		FixedTickRate = cmdArgTickRate;
+	}
+
+#ifndef RPG_BUILD_SHIPPING
+	g_ConsoleSystem->RegisterCommand("stat_threadpool");
+	g_ConsoleSystem->RegisterCommand("stat_frameallocator");
+	g_ConsoleSystem->RegisterCommand("stat_memory");
+	g_ConsoleSystem->RegisterCommand("profile_capture");
+	g_ConsoleSystem->RegisterCommand("bench_map");
+	g_ConsoleSystem->RegisterCommand("bench_sort");
+	g_ConsoleSystem->RegisterCommand("bench_broadphase");
+	g_ConsoleSystem->RegisterCommand("bench_trace");
+	g_ConsoleSystem->RegisterCommand("world_partition_build");
+	g_ConsoleSystem->RegisterCommand("world_partition_save");
+	g_ConsoleSystem->RegisterCommand("stat_world_partition");
+	g_ConsoleSystem->RegisterCommand("stat_physics");
+#endif // !RPG_BUILD_SHIPPING
+
 	// input manager
 	g_InputManager = new RpgInputManager();
 
@@ -115,6 +152,160 @@ void RpgEngine::HandleConsoleCommand(const RpgName& command, const RpgConsoleCom
 	{
 		RequestExit(false);
 	}
+#ifndef RPG_BUILD_SHIPPING
+	else if (command == "stat_threadpool")
+	{
+		RpgThreadPool::FStats stats;
+		RpgThreadPool::GetStats(stats);
+
+		g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "ThreadPool: workers: %i, executed: %llu, steal: %llu, steal_fail: %llu, idle: %.2f ms, queued: %i, shared_queued: %i",
+			stats.WorkerCount, stats.ExecutedTaskCount, stats.StealCount, stats.StealFailCount, stats.IdleTimeMs, stats.QueueDepth, stats.SharedQueueDepth
+		);
+
+		for (int i = 0; i < stats.WorkerCount; ++i)
+		{
+			RpgThreadPool::FWorkerStats workerStats;
+			RpgThreadPool::GetWorkerStats(i, workerStats);
+
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "  [%i] executed: %llu, steal: %llu, steal_fail: %llu, idle: %.2f ms, queued: %i",
+				i, workerStats.ExecutedTaskCount, workerStats.StealCount, workerStats.StealFailCount, workerStats.IdleTimeMs, workerStats.QueueDepth
+			);
+		}
+
+		g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "  task wait (last frame): wasted: %.3f ms, help: %.3f ms (%llu tasks), parks: %llu",
+			TaskWaitStats.WastedTimeMs, TaskWaitStats.HelpTimeMs, TaskWaitStats.HelpTaskCount, TaskWaitStats.ParkCount
+		);
+
+		// "stat_threadpool reset"
+		if (params.GetCount() > 0 && params[0] == "reset")
+		{
+			RpgThreadPool::ResetStats();
+		}
+	}
+	else if (command == "stat_memory")
+	{
+		RpgPlatformMemory::FSnapshot snapshot;
+		RpgPlatformMemory::GetSnapshot(snapshot);
+
+		g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "Memory: live: %.2f MB (%lli allocs), peak: %.2f MB, frame: +%.2f KB / -%.2f KB (%llu allocs)",
+			snapshot.Total.LiveBytes / (1024.0f * 1024.0f), snapshot.Total.LiveCount, snapshot.Total.PeakBytes / (1024.0f * 1024.0f),
+			snapshot.Total.FrameAllocBytes / 1024.0f, snapshot.Total.FrameFreeBytes / 1024.0f, snapshot.Total.FrameAllocCount
+		);
+
+		for (int t = 0; t < RpgPlatformMemory::TAG_MAX_COUNT; ++t)
+		{
+			const RpgPlatformMemory::FTagStats& stats = snapshot.Tags[t];
+
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "  [%s] live: %.2f KB (%lli allocs), peak: %.2f KB, frame: +%.2f KB / -%.2f KB (%llu allocs)",
+				RpgPlatformMemory::GetTagName(static_cast<RpgPlatformMemory::ETag>(t)), stats.LiveBytes / 1024.0f, stats.LiveCount, stats.PeakBytes / 1024.0f,
+				stats.FrameAllocBytes / 1024.0f, stats.FrameFreeBytes / 1024.0f, stats.FrameAllocCount
+			);
+		}
+
+		// "stat_memory mimalloc"
+		if (params.GetCount() > 0 && params[0] == "mimalloc")
+		{
+			RpgPlatformMemory::OutputAllocatorStats();
+		}
+	}
+	else if (command == "stat_frameallocator")
+	{
+		for (int f = 0; f < RPG_FRAME_BUFFERING; ++f)
+		{
+			RpgFrameAllocator::FStats stats;
+			RpgFrameAllocator::GetStats(f, stats);
+
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "FrameAllocator[%i]: used: %.2f KB, reserved: %.2f KB, peak: %.2f KB, blocks: %i, allocations: %i",
+				f, stats.UsedBytes / 1024.0f, stats.ReservedBytes / 1024.0f, stats.PeakUsedBytes / 1024.0f, stats.BlockCount, stats.AllocationCount
+			);
+		}
+	}
+	else if (command == "profile_capture")
+	{
+		// "profile_capture <frames>"
+		const int frameCount = params.GetCount() > 0 ? RpgPlatformString::CStringToInt(*params[0]) : 1;
+		RpgProfiler::RequestCapture(frameCount);
+
+		g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "Profiler: capture requested (%i frames), output: %s__profile/", frameCount, *RpgFileSystem::GetProjectDirPath());
+	}
+	else if (command == "bench_map")
+	{
+		RpgTest::Core::Benchmark_DSA_Map();
+	}
+	else if (command == "bench_sort")
+	{
+		RpgTest::Core::Benchmark_DSA_Algorithm();
+	}
+	else if (command == "bench_broadphase")
+	{
+		RpgTest::Physics::Benchmark_Broadphase();
+	}
+	else if (command == "bench_trace")
+	{
+		RpgTest::Physics::Benchmark_Trace();
+	}
+	else if (command == "world_partition_build")
+	{
+		// "world_partition_build <cellSize> <loadRadius> <activationRadius>"
+		const float cellSize = params.GetCount() > 0 ? RpgPlatformString::CStringToFloat(*params[0]) : 5000.0f;
+		const float loadRadius = params.GetCount() > 1 ? RpgPlatformString::CStringToFloat(*params[1]) : cellSize * 2.0f;
+		const float activationRadius = params.GetCount() > 2 ? RpgPlatformString::CStringToFloat(*params[2]) : cellSize;
+
+		if (MainWorldPartition)
+		{
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "WorldPartition: already built (cell size: %.2f)", MainWorldPartition->GetCellSize());
+		}
+		else if (cellSize > 0.0f)
+		{
+			MainWorldPartition = RpgPointer::MakeUnique<RpgWorldPartition>(MainWorld, cellSize);
+			MainWorldPartition->StreamingSource_Add(MainCameraObject, loadRadius, activationRadius);
+			MainWorldPartition->BuildCellsFromWorld();
+		}
+	}
+	else if (command == "world_partition_save")
+	{
+		// "world_partition_save" writes resident cells into <project>/__world_cells/
+		if (MainWorldPartition)
+		{
+			const int savedCount = MainWorldPartition->SaveCells(RpgFileSystem::GetProjectDirPath() + "__world_cells/");
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "WorldPartition: saved %i cells", savedCount);
+		}
+	}
+	else if (command == "stat_world_partition")
+	{
+		if (MainWorldPartition)
+		{
+			const RpgWorldPartition::FStats& stats = MainWorldPartition->GetStats();
+
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "WorldPartition: cells: %i, resident: %i, active: %i, game objects: %i, pending load: %i, pending activation: %i, pending deactivation: %i",
+				stats.CellCount, stats.ResidentCellCount, stats.ActiveCellCount, stats.ActiveGameObjectCount, stats.PendingLoadCount, stats.PendingActivationCount, stats.PendingDeactivationCount
+			);
+
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "  activation (last frame): %i batches, %.3f ms, peak: %.3f ms, budget: %.3f ms",
+				stats.ProcessedBatchCount, stats.ActivationTimeMs, stats.PeakActivationTimeMs, MainWorldPartition->ActivationBudgetMs
+			);
+		}
+		else
+		{
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "WorldPartition: not built");
+		}
+	}
+	else if (command == "stat_physics")
+	{
+		if (const RpgPhysicsWorldSubsystem* subsystem = MainWorld->Subsystem_Get<RpgPhysicsWorldSubsystem>())
+		{
+			const RpgPhysicsWorldSubsystem::FNarrowphaseStats& stats = subsystem->GetNarrowphaseStats();
+
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "Physics (narrowphase): pairs: %i, tasks: %i, manifolds: %i, cache entries: %i",
+				stats.PairCount, stats.TaskCount, stats.ManifoldCount, stats.CacheEntryCount
+			);
+
+			g_ConsoleSystem->AddLogMessageFormat(RpgColor::WHITE, "  full test: %i (batched: %i), cached separated: %i, cached contact: %i",
+				stats.FullTestCount, stats.BatchTestCount, stats.CachedSeparatedCount, stats.CachedContactCount
+			);
+		}
+	}
+#endif // !RPG_BUILD_SHIPPING
 }
 
 
@@ -237,7 +428,22 @@ void RpgEngine::FrameTick(uint64_t frameCounter, float deltaTime) noexcept
 
 	// Begin frame
 	{
+		RPG_PROFILE_SCOPE("RpgEngine_BeginFrame");
+
+		RpgThreadPool::GetWaitStats(TaskWaitStats, true);
+		RpgPlatformMemory::UpdateFrameStats();
+
+		// Wait render thread finished with this frame index before its frame arena can be reused
+		RpgRenderThread::WaitFrame(frameIndex);
+		RpgFrameAllocator::Reset(frameIndex);
+
 		MainWorld->BeginFrame(frameIndex);
+
+		if (MainWorldPartition)
+		{
+			MainWorldPartition->Update();
+		}
+
 		g_AssetManager->Update();
 	}
 
@@ -254,6 +460,9 @@ void RpgEngine::FrameTick(uint64_t frameCounter, float deltaTime) noexcept
 
 	// GUI
 	{
+		RPG_PROFILE_SCOPE("RpgEngine_UpdateGUI");
+		RPG_MEMORY_SCOPE_TAG(TAG_GUI);
+
 		GuiContext.Begin();
 
 		if (WindowState != RpgPlatformWindowSizeState::MINIMIZED)
@@ -267,19 +476,44 @@ void RpgEngine::FrameTick(uint64_t frameCounter, float deltaTime) noexcept
 
 	// Tick update
 	{
-		MainWorld->DispatchTickUpdate(deltaTime);
-	}
+		RPG_PROFILE_SCOPE("RpgEngine_TickUpdate");
 
+		// Scripts consume per-frame input (button pressed/released), tick them once per frame
+		MainWorld->DispatchScriptTickUpdate(deltaTime);
 
-	// Post tick update
-	{
-		MainWorld->DispatchPostTickUpdate();
+		// Subsystems tick at fixed rate (subsystems keep running on worker threads until post tick update)
+		const float fixedDeltaTime = 1.0f / static_cast<float>(FixedTickRate > 0 ? FixedTickRate : 60);
+		TickAccumulator += deltaTime;
+
+		int tickStepCount = 0;
+
+		while (TickAccumulator >= fixedDeltaTime && tickStepCount < MaxTickStepsPerFrame)
+		{
+			RPG_PROFILE_SCOPE("RpgEngine_TickStep");
+
+			MainWorld->BeginTickStep();
+			MainWorld->DispatchSubsystemTickUpdate(fixedDeltaTime);
+			MainWorld->DispatchPostTickUpdate();
+			MainWorld->EndTickStep();
+
+			TickAccumulator -= fixedDeltaTime;
+			++tickStepCount;
+		}
+
+		// Simulation falls behind, drop remaining steps instead of spiraling into longer frames
+		if (TickAccumulator >= fixedDeltaTime)
+		{
+			TickAccumulator = RpgMath::ModF(TickAccumulator, fixedDeltaTime);
+		}
+
+		MainWorld->UpdateTransformInterpolation(TickAccumulator / fixedDeltaTime);
 	}
 
 
 	// Render
-	RpgRenderThread::WaitFrame(frameIndex);
 	{
+		RPG_PROFILE_SCOPE("RpgEngine_Render");
+
 		RpgD3D12::BeginFrame(frameIndex);
 
 		MainRenderer->BeginRender(frameIndex, deltaTime);
@@ -311,6 +545,7 @@ void RpgEngine::FrameTick(uint64_t frameCounter, float deltaTime) noexcept
 					"CameraFrustumCulling: %d\n"
 					"Gamma: %.2f\n"
 					"VSync: %d\n"
+					"TaskWait: %.3f ms wasted, %.3f ms help (%i tasks), %i parks\n"
 					"\n"
 					"GameObject: %i\n"
 					, WindowDimension.X, WindowDimension.Y
@@ -319,6 +554,7 @@ void RpgEngine::FrameTick(uint64_t frameCounter, float deltaTime) noexcept
 					, mainCameraComp ? mainCameraComp->bFrustumCulling : false
 					, MainRenderer->Gamma
 					, MainRenderer->GetVsync()
+					, TaskWaitStats.WastedTimeMs, TaskWaitStats.HelpTimeMs, static_cast<int>(TaskWaitStats.HelpTaskCount), static_cast<int>(TaskWaitStats.ParkCount)
 					, MainWorld->GameObject_GetCount()
 				);
 
@@ -357,9 +593,12 @@ void RpgEngine::FrameTick(uint64_t frameCounter, float deltaTime) noexcept
 
 
 	// End frame
-	MainWorld->EndFrame(frameIndex);
+	{
+		RPG_PROFILE_SCOPE("RpgEngine_EndFrame");
 
-	g_InputManager->Flush();
+		MainWorld->EndFrame(frameIndex);
+		g_InputManager->Flush();
+	}
 }
 
 
@@ -3,6 +3,7 @@
 #include "core/RpgConsoleSystem.h"
 #include "core/RpgPointer.h"
 #include "core/world/RpgWorld.h"
+#include "core/world/RpgWorldPartition.h"
 #include "render/RpgRenderer.h"
 #include "render/RpgSceneViewport.h"
 #include "gui/RpgGuiContext.h"
@@ -73,6 +74,9 @@ private:
 	RpgArray<RpgUniquePtr<RpgWorld>> Worlds;
 	RpgWorld* MainWorld;
 
+	// Cell streaming of main world. Created by console command "world_partition_build"
+	RpgUniquePtr<RpgWorldPartition> MainWorldPartition;
+
 	// Main renderer
 	RpgUniquePtr<RpgRenderer> MainRenderer;
 
@@ -96,11 +100,23 @@ private:
 public:
 	int FpsLimit;
 
+	// World subsystems tick rate (Hz). Independent of frame rate, rendering interpolates between the two latest tick steps
+	int FixedTickRate;
+
+	// Maximum tick steps per frame. Remaining time is dropped when simulation falls behind (hitch, breakpoint, loading)
+	int MaxTickStepsPerFrame;
+
 private:
+	// Frame time not yet consumed by tick steps
+	float TickAccumulator;
+
 	float FpsSampleTimer;
 	int FpsSampleFrameCount;
 	float FpsTimeMs;
 	float FpsCountMs;
 	RpgString FpsString;
 
+	// Thread task wait counters of previous frame
+	RpgThreadPool::FWaitStats TaskWaitStats;
+
 };
@@ -6,9 +6,27 @@
 
 
 
+// Register lod 0 meshes and materials of model so world partition can save game objects that use them into cells
+static void TestLevel_RegisterSnapshotAssets(const RpgSharedModel& model) noexcept
+{
+	for (int m = 0; m < model->GetMeshCount(); ++m)
+	{
+		RpgWorldSnapshotAsset<RpgMesh>::Register(model->GetMeshLod(m, 0));
+
+		if (const RpgSharedMaterial& material = model->GetMaterial(m))
+		{
+			RpgWorldSnapshotAsset<RpgMaterial>::Register(material);
+		}
+	}
+}
+
+
 static void TestLevel_AddBlocker(RpgWorld* world, RpgVector3 center, RpgVector3 halfExtents, float uvScale) noexcept
 {
-	RpgSharedModel model = RpgModel::s_CreateShared("MDL_DEF_floor");
+	static int Counter = 0;
+
+	// Each blocker has its own mesh, name must be unique to be registered as snapshot asset
+	RpgSharedModel model = RpgModel::s_CreateShared(RpgName::Format("MDL_DEF_floor_%i", Counter));
 	{
 		model->AddLod();
 		model->AddMeshEmpty();
@@ -23,10 +41,9 @@ static void TestLevel_AddBlocker(RpgWorld* world, RpgVector3 center, RpgVector3
 		mesh->UpdateVertexData(vertexPositions.GetCount(), vertexPositions.GetData(), vertexNormalTangents.GetData(), vertexTexCoords.GetData(), nullptr, indices.GetCount(), indices.GetData());
 
 		model->SetMaterial(0, RpgMaterial::s_GetDefault(RpgMaterialDefault::MESH_PHONG));
+		TestLevel_RegisterSnapshotAssets(model);
 	}
 
-	static int Counter = 0;
-
 	const RpgGameObjectID blocker = world->GameObject_Create(RpgName::Format("test_blocker_%i", Counter++), RpgTransform(center));
 	{
 		// Add render component
@@ -58,6 +75,7 @@ static void TestLevel_AddBox(RpgWorld* world, const RpgTransform& transform) noe
 		mesh->UpdateVertexData(vertexPositions.GetCount(), vertexPositions.GetData(), vertexNormalTangents.GetData(), vertexTexCoords.GetData(), nullptr, indices.GetCount(), indices.GetData());
 
 		BoxModel->SetMaterial(0, RpgMaterial::s_GetDefault(RpgMaterialDefault::MESH_PHONG));
+		TestLevel_RegisterSnapshotAssets(BoxModel);
 	}
 
 	static int Counter = 0;
@@ -126,6 +144,7 @@ static void TestLevel_Import(RpgWorld* world, const RpgFilePath& sourceFilePath,
 	for (int i = 0; i < importedModels.GetCount(); ++i)
 	{
 		const RpgSharedModel& model = importedModels[i];
+		TestLevel_RegisterSnapshotAssets(model);
 
 		RpgTransform transform;
 		transform.Position = RpgVector3(0.0f, 0.0f, 0.0f);
@@ -270,6 +289,13 @@ static void TestLevel_Animations(RpgWorld* world) noexcept
 	skeletons[1] = importedSkeleton;
 	animationClips[1] = importedAnimations[0];
 
+	for (int i = 0; i < 2; ++i)
+	{
+		TestLevel_RegisterSnapshotAssets(models[i]);
+		RpgWorldSnapshotAsset<RpgAnimationSkeleton>::Register(skeletons[i]);
+		RpgWorldSnapshotAsset<RpgAnimationClip>::Register(animationClips[i]);
+	}
+
 	const int DIM_X = 16;
 	const int DIM_Z = 16;
 	const float OFFSET = 128.0f;
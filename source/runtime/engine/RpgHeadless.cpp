@@ -0,0 +1,242 @@
+#include "RpgHeadless.h"
+#include <atomic>
+#include "core/RpgAllocator.h"
+#include "core/RpgCommandLine.h"
+#include "core/RpgPointer.h"
+#include "core/RpgProfiler.h"
+#include "core/RpgThreadPool.h"
+#include "core/RpgTimer.h"
+#include "core/world/RpgWorld.h"
+#include "physics/world/RpgPhysicsComponent.h"
+#include "physics/world/RpgPhysicsWorldSubsystem.h"
+#include "animation/world/RpgAnimationComponent.h"
+#include "animation/world/RpgAnimationWorldSubsystem.h"
+
+
+RPG_LOG_DECLARE_CATEGORY_STATIC(RpgLogHeadless, VERBOSITY_LOG)
+
+
+#define RPG_HEADLESS_DEFAULT_OBJECT_COUNT		1024
+
+// Simulation delta time when tick rate is uncapped
+#define RPG_HEADLESS_UNCAPPED_DELTA_TIME		(1.0f / 60.0f)
+
+// Interval of ticks per second report
+#define RPG_HEADLESS_REPORT_INTERVAL_SECONDS	1.0
+
+
+
+// Moves game object back and forth so transform and collision are updated every tick
+class RpgScript_HeadlessMover : public RpgGameObjectScript
+{
+	RPG_GAMEOBJECT_SCRIPT("RpgScript - HeadlessMover")
+
+public:
+	RpgVector3 Origin;
+	float Phase{ 0.0f };
+	float Time{ 0.0f };
+
+
+public:
+	virtual void TickUpdate(float deltaTime) noexcept override
+	{
+		Time += deltaTime;
+
+		RpgTransform transform = World->GameObject_GetWorldTransform(GameObject);
+		transform.Position = Origin + RpgVector3(sinf(Time + Phase) * 100.0f, 0.0f, cosf(Time + Phase) * 100.0f);
+		World->GameObject_SetWorldTransform(GameObject, transform);
+	}
+
+};
+
+
+
+namespace RpgHeadless
+{
+	// Cleared by console interrupt callback (system thread)
+	static std::atomic<bool> bRunning;
+
+
+	static void ConsoleInterrupt()
+	{
+		bRunning.store(false, std::memory_order_relaxed);
+	}
+
+
+	static void SpawnObjects(RpgWorld* world, int objectCount, RpgArray<RpgUniquePtr<RpgScript_HeadlessMover>>& out_Scripts) noexcept
+	{
+		const int gridSize = static_cast<int>(sqrtf(static_cast<float>(objectCount))) + 1;
+		out_Scripts.Reserve(objectCount);
+
+		for (int i = 0; i < objectCount; ++i)
+		{
+			const RpgVector3 position(static_cast<float>(i % gridSize) * 256.0f, 100.0f, static_cast<float>(i / gridSize) * 256.0f);
+			const RpgGameObjectID gameObject = world->GameObject_Create(RpgName::Format("headless_object_%i", i), RpgTransform(position));
+
+			RpgPhysicsComponent_Filter* filterComp = world->GameObject_AddComponent<RpgPhysicsComponent_Filter>(gameObject);
+			filterComp->SetChannel(RpgPhysicsCollision::CHANNEL_CHARACTER, RpgPhysicsCollision::DEFAULT_COLLISION_RESPONSE_CHANNELS_Character);
+
+			RpgPhysicsComponent_Collision* collisionComp = world->GameObject_AddComponent<RpgPhysicsComponent_Collision>(gameObject);
+
+			if (i % 2 == 0)
+			{
+				collisionComp->SetShapeAs_Sphere(64.0f);
+			}
+			else
+			{
+				collisionComp->SetShapeAs_Box(RpgVector3(64.0f));
+			}
+
+			RpgUniquePtr<RpgScript_HeadlessMover> script = RpgPointer::MakeUnique<RpgScript_HeadlessMover>();
+			script->Origin = position;
+			script->Phase = static_cast<float>(i) * 0.1f;
+			world->GameObject_AttachScript(gameObject, script.Get());
+
+			out_Scripts.AddValue(std::move(script));
+		}
+	}
+
+};
+
+
+
+int RpgHeadless::Run() noexcept
+{
+	RpgPlatformConsole::Initialize();
+	RpgPlatformConsole::SetInterruptCallback(ConsoleInterrupt);
+
+	const int cmdArgObjectCount = RpgCommandLine::GetCommandValueInt("headless_objects");
+	const int objectCount = (cmdArgObjectCount > 0) ? cmdArgObjectCount : RPG_HEADLESS_DEFAULT_OBJECT_COUNT;
+	const int tickRate = RpgCommandLine::GetCommandValueInt("headless_tickrate");
+	const int runSeconds = RpgCommandLine::GetCommandValueInt("headless_seconds");
+	const int workerCount = RpgThreadPool::GetWorkerCount();
+
+	RPG_Log(RpgLogHeadless, "Start headless simulation (objects: %i, tickrate: %i%s, workers: %i)", objectCount, tickRate, (tickRate > 0) ? "" : " (uncapped)", workerCount);
+
+	RpgArray<RpgUniquePtr<RpgScript_HeadlessMover>> scripts;
+	RpgUniquePtr<RpgWorld> world = RpgPointer::MakeUnique<RpgWorld>("world_headless");
+	{
+		world->Subsystem_Register<RpgPhysicsWorldSubsystem>(0);
+		world->Subsystem_Register<RpgAnimationWorldSubsystem>(1);
+
+		world->Component_Register<RpgPhysicsComponent_Filter>();
+		world->Component_Register<RpgPhysicsComponent_Collision>();
+		world->Component_Register<RpgAnimationComponent_AnimSkeletonPose>();
+
+		SpawnObjects(world.Get(), objectCount, scripts);
+		world->DispatchStartPlay();
+	}
+
+
+	RPG_PROFILE_THREAD_NAME("Main");
+
+	const uint64_t frequency = RpgTimer::GetPerformanceFrequency();
+	const double tickToSeconds = 1.0 / static_cast<double>(frequency);
+	const float deltaTime = (tickRate > 0) ? 1.0f / tickRate : RPG_HEADLESS_UNCAPPED_DELTA_TIME;
+	const uint64_t tickIntervalCounter = (tickRate > 0) ? frequency / tickRate : 0;
+
+	const uint64_t startCounter = RpgTimer::GetPerformanceCounter();
+	uint64_t tickEndCounter = startCounter;
+	uint64_t nextTickCounter = startCounter;
+	uint64_t reportStartCounter = startCounter;
+
+	uint64_t tickCounter = 0;
+	uint64_t reportTickCount = 0;
+	double reportTickSeconds = 0.0;
+	double reportTickMaxSeconds = 0.0;
+
+	bRunning.store(true, std::memory_order_relaxed);
+
+	while (bRunning.load(std::memory_order_relaxed))
+	{
+		const uint64_t tickStartCounter = RpgTimer::GetPerformanceCounter();
+
+		{
+			RPG_PROFILE_SCOPE("RpgHeadless_Tick");
+
+			const int frameIndex = tickCounter % RPG_FRAME_BUFFERING;
+
+			// No render thread, frame arena can be reused right away
+			RpgPlatformMemory::UpdateFrameStats();
+			RpgFrameAllocator::Reset(frameIndex);
+
+			world->BeginFrame(frameIndex);
+			world->DispatchTickUpdate(deltaTime);
+			world->DispatchPostTickUpdate();
+			world->EndFrame(frameIndex);
+		}
+
+		tickEndCounter = RpgTimer::GetPerformanceCounter();
+
+		const double tickSeconds = (tickEndCounter - tickStartCounter) * tickToSeconds;
+		reportTickSeconds += tickSeconds;
+		reportTickMaxSeconds = (tickSeconds > reportTickMaxSeconds) ? tickSeconds : reportTickMaxSeconds;
+		++reportTickCount;
+		++tickCounter;
+
+#if RPG_PROFILER_ENABLED
+		RpgProfiler::EndFrame();
+#endif // RPG_PROFILER_ENABLED
+
+		const double reportSeconds = (tickEndCounter - reportStartCounter) * tickToSeconds;
+
+		if (reportSeconds >= RPG_HEADLESS_REPORT_INTERVAL_SECONDS)
+		{
+			const double ticksPerSecond = reportTickCount / reportSeconds;
+
+			RPG_Log(RpgLogHeadless, "ticks/sec: %.1f, tick: %.3f ms (max %.3f ms), object-ticks/sec per thread: %.0f",
+				ticksPerSecond, (reportTickSeconds / reportTickCount) * 1000.0, reportTickMaxSeconds * 1000.0, (ticksPerSecond * objectCount) / (workerCount + 1)
+			);
+
+			reportStartCounter = tickEndCounter;
+			reportTickCount = 0;
+			reportTickSeconds = 0.0;
+			reportTickMaxSeconds = 0.0;
+		}
+
+		if (runSeconds > 0 && (tickEndCounter - startCounter) * tickToSeconds >= runSeconds)
+		{
+			break;
+		}
+
+		// Fixed tick rate. Sleep most of the remaining time, spin the rest
+		if (tickIntervalCounter > 0)
+		{
+			nextTickCounter += tickIntervalCounter;
+
+			// Fell behind, do not try to catch up
+			if (nextTickCounter < tickEndCounter)
+			{
+				nextTickCounter = tickEndCounter;
+			}
+
+			uint64_t nowCounter;
+
+			do
+			{
+				nowCounter = RpgTimer::GetPerformanceCounter();
+				const double remainingMs = (nowCounter < nextTickCounter) ? (nextTickCounter - nowCounter) * tickToSeconds * 1000.0 : 0.0;
+
+				if (remainingMs > 2.0)
+				{
+					RpgPlatformProcess::Sleep(1);
+				}
+			}
+			while (nowCounter < nextTickCounter);
+		}
+	}
+
+	const double totalSeconds = (tickEndCounter - startCounter) * tickToSeconds;
+
+	RPG_Log(RpgLogHeadless, "Stop headless simulation (ticks: %llu, duration: %.2f s, average ticks/sec: %.1f)",
+		tickCounter, totalSeconds, (totalSeconds > 0.0) ? tickCounter / totalSeconds : 0.0
+	);
+
+	RpgPlatformConsole::SetInterruptCallback(nullptr);
+
+	world->DispatchStopPlay();
+	world.Release();
+	scripts.Clear(true);
+
+	return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "core/RpgPlatform.h"
+
+
+
+// Headless simulation mode. Runs world with physics, animation and scripts without window, D3D12 and render thread.
+// Enabled by command line "headless". Options:
+//	- headless_objects=<count>		Number of simulated game objects (default 1024)
+//	- headless_tickrate=<hz>		Fixed tick rate, 0 = uncapped (default 0)
+//	- headless_seconds=<seconds>	Run duration, 0 = until Ctrl+C (default 0)
+// Windows only. Timing, sleep and Ctrl+C go through RpgTimer and RpgPlatform, but RpgPlatform, RpgPlatformLog and RpgThreadPool
+// are implemented on Win32 only, headless mode does not build or run on Linux until those layers are ported.
+namespace RpgHeadless
+{
+	// Run headless simulation loop. Thread pool and frame allocator must be initialized
+	// @returns Process exit code
+	extern int Run() noexcept;
+
+};
@@ -7,7 +7,6 @@
 
 RpgScript_DebugCamera::RpgScript_DebugCamera() noexcept
 {
-	Flashlight = nullptr;
 	PitchValue = 0.0f;
 	YawValue = 0.0f;
 	bInitialized = false;
@@ -31,14 +30,14 @@ void RpgScript_DebugCamera::AttachedToGameObject() noexcept
 
 		World->GameObject_SetWorldTransform(GameObject, transform);
 
-		Flashlight = World->GameObject_AddComponent<RpgRenderComponent_Light>(GameObject);
-		Flashlight->Type = RpgRenderLight::TYPE_SPOT_LIGHT;
-		Flashlight->ColorIntensity = RpgColorLinear(1.0f, 1.0f, 1.0f, 2.0f);
-		Flashlight->AttenuationRadius = 1600.0f;
-		Flashlight->SpotInnerConeDegree = 20.0f;
-		Flashlight->SpotOuterConeDegree = 40.0f;
-		Flashlight->bCastShadow = false;
-		Flashlight->bIsVisible = false;
+		RpgRenderComponent_Light* flashlight = World->GameObject_AddComponent<RpgRenderComponent_Light>(GameObject);
+		flashlight->Type = RpgRenderLight::TYPE_SPOT_LIGHT;
+		flashlight->ColorIntensity = RpgColorLinear(1.0f, 1.0f, 1.0f, 2.0f);
+		flashlight->AttenuationRadius = 1600.0f;
+		flashlight->SpotInnerConeDegree = 20.0f;
+		flashlight->SpotOuterConeDegree = 40.0f;
+		flashlight->bCastShadow = false;
+		flashlight->bIsVisible = false;
 	}
 }
 
@@ -109,6 +108,12 @@ void RpgScript_DebugCamera::TickUpdate(float deltaTime) noexcept
 
 	if (g_InputManager->IsKeyButtonPressed(RpgInputKey::KEYBOARD_F))
 	{
-		Flashlight->bIsVisible = !Flashlight->bIsVisible;
+		// Component address changes when game object moves between archetypes, do not cache it
+		RpgRenderComponent_Light* flashlight = World->GameObject_GetComponent<RpgRenderComponent_Light>(GameObject);
+
+		if (flashlight)
+		{
+			flashlight->bIsVisible = !flashlight->bIsVisible;
+		}
 	}
 }
@@ -36,7 +36,6 @@ protected:
 
 
 private:
-	RpgRenderComponent_Light* Flashlight;
 	float PitchValue;
 	float YawValue;
 	RpgPointFloat SavedMousePos;
@@ -1,13 +1,17 @@
-#include "RpgPhysicsTypes.h"
+#include "RpgPhysicsGeometry.h"
+#include "RpgPhysicsDynamicTree.h"
 #include "core/world/RpgWorld.h"
 #include "thirdparty/libccd/ccd.h"
 #include "world/RpgPhysicsComponent.h"
+#include <immintrin.h>
 
 
 #define RPG_PHYSICS_COLLISION_GJK_MAX_ITERATIONS		(32)
 #define RPG_PHYSICS_COLLISION_GJK_MAX_EPA_TOLERANCE		(0.001f)
 #define RPG_PHYSICS_COLLISION_GJK_DISTANCE_TOLERANCE	(0.001f)
 
+#define RPG_PHYSICS_COLLISION_CAPSULE_BOX_ITERATIONS	(24)
+
 
 
 namespace RpgPhysicsGJK
@@ -64,6 +68,562 @@ namespace RpgPhysicsGJK
 		ccdVec3Set(vec, farthestPoint.X, farthestPoint.Y, farthestPoint.Z);
 	}
 
+
+	static bool TestOverlap(const void* first, ccd_support_fn firstSupport, const void* second, ccd_support_fn secondSupport, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		ccd_t ccd;
+		CCD_INIT(&ccd);
+		ccd.support1 = firstSupport;
+		ccd.support2 = secondSupport;
+		ccd.max_iterations = RPG_PHYSICS_COLLISION_GJK_MAX_ITERATIONS;
+		ccd.epa_tolerance = RPG_PHYSICS_COLLISION_GJK_MAX_EPA_TOLERANCE;
+		ccd.dist_tolerance = RPG_PHYSICS_COLLISION_GJK_DISTANCE_TOLERANCE;
+
+		if (optOut_Result == nullptr)
+		{
+			return ccdGJKIntersect(first, second, &ccd);
+		}
+
+		ccd_real_t depth = 0.0f;
+		ccd_vec3_t separationDirection;
+		ccd_vec3_t contactPoint;
+
+		const int ret = ccdGJKPenetration(first, second, &ccd, &depth, &separationDirection, &contactPoint);
+		RPG_Check(ret != -2);
+
+		if (ret != 0)
+		{
+			return false;
+		}
+
+		optOut_Result->ContactPoint = RpgVector3(contactPoint.v[0], contactPoint.v[1], contactPoint.v[2]);
+		optOut_Result->SeparationDirection = RpgVector3(separationDirection.v[0], separationDirection.v[1], separationDirection.v[2]);
+		optOut_Result->SeparationDirection.Normalize();
+		optOut_Result->PenetrationDepth = depth;
+
+		return true;
+	}
+
+
+	// Shape converted into object and support function for GJK
+	struct FSupportShape
+	{
+		RpgBoundingSphere Sphere;
+		RpgBoundingBox Box;
+		RpgBoundingCapsule Capsule;
+		const void* Object{ nullptr };
+		ccd_support_fn Support{ nullptr };
+	};
+
+
+	static bool MakeSupportShape(const RpgPhysicsCollision::FShape& shape, FSupportShape& out_Shape) noexcept
+	{
+		switch (shape.Type)
+		{
+			case RpgPhysicsCollision::SHAPE_SPHERE:
+				out_Shape.Sphere = RpgBoundingSphere(shape.Center, shape.Size.X);
+				out_Shape.Object = &out_Shape.Sphere;
+				out_Shape.Support = SupportSphere;
+				return true;
+
+			case RpgPhysicsCollision::SHAPE_BOX:
+				out_Shape.Box = RpgBoundingBox(shape.Center, RpgVector3(shape.Size.X, shape.Size.Y, shape.Size.Z), shape.Rotation);
+				out_Shape.Object = &out_Shape.Box;
+				out_Shape.Support = SupportBox;
+				return true;
+
+			case RpgPhysicsCollision::SHAPE_CAPSULE:
+				out_Shape.Capsule = RpgBoundingCapsule(shape.Center, shape.Size.Y, shape.Size.X);
+				out_Shape.Object = &out_Shape.Capsule;
+				out_Shape.Support = SupportCapsule;
+				return true;
+
+			default:
+				break;
+		}
+
+		return false;
+	}
+
+
+	// @returns Half length of shape projected on axis. Unsupported shape is never separated
+	static float GetProjectionRadius(const RpgPhysicsCollision::FShape& shape, const RpgVector3& axis) noexcept
+	{
+		switch (shape.Type)
+		{
+			case RpgPhysicsCollision::SHAPE_SPHERE:
+				return shape.Size.X;
+
+			case RpgPhysicsCollision::SHAPE_BOX:
+			{
+				const RpgVector3 right = RpgQuaternion::RotateVector(shape.Rotation, RpgVector3::RIGHT);
+				const RpgVector3 up = RpgQuaternion::RotateVector(shape.Rotation, RpgVector3::UP);
+				const RpgVector3 forward = RpgQuaternion::RotateVector(shape.Rotation, RpgVector3::FORWARD);
+
+				return shape.Size.X * RpgMath::Abs(RpgVector3::DotProduct(right, axis))
+					+ shape.Size.Y * RpgMath::Abs(RpgVector3::DotProduct(up, axis))
+					+ shape.Size.Z * RpgMath::Abs(RpgVector3::DotProduct(forward, axis));
+			}
+
+			// Capsule always sweep along y-axis (see SupportCapsule)
+			case RpgPhysicsCollision::SHAPE_CAPSULE:
+				return RpgMath::Abs(axis.Y) * shape.Size.Y + shape.Size.X;
+
+			default:
+				break;
+		}
+
+		return FLT_MAX;
+	}
+
+};
+
+
+
+namespace RpgPhysicsAnalytic
+{
+	using RpgPhysicsGeometry::FBoxAxes;
+	using RpgPhysicsGeometry::GetBoxAxes;
+	using RpgPhysicsGeometry::GetBoxProjectionRadius;
+	using RpgPhysicsGeometry::GetCapsuleSegment;
+	using RpgPhysicsGeometry::ClosestPointOnSegment;
+
+
+	// Closest points between segment (firstStart, firstEnd) and segment (secondStart, secondEnd)
+	static void ClosestPointsSegmentSegment(const RpgVector3& firstStart, const RpgVector3& firstEnd, const RpgVector3& secondStart, const RpgVector3& secondEnd, RpgVector3& out_FirstPoint, RpgVector3& out_SecondPoint) noexcept
+	{
+		const RpgVector3 d1 = firstEnd - firstStart;
+		const RpgVector3 d2 = secondEnd - secondStart;
+		const RpgVector3 r = firstStart - secondStart;
+		const float a = RpgVector3::DotProduct(d1, d1);
+		const float e = RpgVector3::DotProduct(d2, d2);
+		const float f = RpgVector3::DotProduct(d2, r);
+
+		float s = 0.0f;
+		float t = 0.0f;
+
+		if (a <= RPG_MATH_EPS_MP && e <= RPG_MATH_EPS_MP)
+		{
+			// Both segments degenerate into points
+		}
+		else if (a <= RPG_MATH_EPS_MP)
+		{
+			t = RpgMath::Clamp(f / e, 0.0f, 1.0f);
+		}
+		else
+		{
+			const float c = RpgVector3::DotProduct(d1, r);
+
+			if (e <= RPG_MATH_EPS_MP)
+			{
+				s = RpgMath::Clamp(-c / a, 0.0f, 1.0f);
+			}
+			else
+			{
+				const float b = RpgVector3::DotProduct(d1, d2);
+				const float denom = a * e - b * b;
+
+				// Parallel segments, any s is valid
+				s = (denom > RPG_MATH_EPS_MP) ? RpgMath::Clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+				t = (b * s + f) / e;
+
+				if (t < 0.0f)
+				{
+					t = 0.0f;
+					s = RpgMath::Clamp(-c / a, 0.0f, 1.0f);
+				}
+				else if (t > 1.0f)
+				{
+					t = 1.0f;
+					s = RpgMath::Clamp((b - c) / a, 0.0f, 1.0f);
+				}
+			}
+		}
+
+		out_FirstPoint = firstStart + d1 * s;
+		out_SecondPoint = secondStart + d2 * t;
+	}
+
+
+	// Separation direction points from first sphere to second sphere
+	static bool TestSpheres(const RpgVector3& firstCenter, float firstRadius, const RpgVector3& secondCenter, float secondRadius, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		const RpgVector3 delta = secondCenter - firstCenter;
+		const float distanceSqr = delta.GetMagnitudeSqr();
+		const float radius = firstRadius + secondRadius;
+
+		if (distanceSqr > radius * radius)
+		{
+			return false;
+		}
+
+		if (optOut_Result)
+		{
+			const float distance = RpgMath::Sqrt(distanceSqr);
+
+			// Concentric spheres, any direction separates
+			const RpgVector3 direction = (distance > RPG_MATH_EPS_LP) ? delta * (1.0f / distance) : RpgVector3::UP;
+
+			optOut_Result->SeparationDirection = direction;
+			optOut_Result->PenetrationDepth = radius - distance;
+			optOut_Result->ContactPoint = firstCenter + direction * (firstRadius - optOut_Result->PenetrationDepth * 0.5f);
+		}
+
+		return true;
+	}
+
+
+	// Separation direction points from box to sphere
+	static bool TestBoxSphere(const RpgPhysicsCollision::FShape& box, const FBoxAxes& boxAxes, const RpgVector3& center, float radius, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		const RpgVector3 delta = center - box.Center;
+		float local[3];
+		RpgVector3 closestPoint = box.Center;
+		bool bInside = true;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			local[i] = RpgVector3::DotProduct(delta, boxAxes.Axes[i]);
+			const float clamped = RpgMath::Clamp(local[i], -boxAxes.HalfExtents[i], boxAxes.HalfExtents[i]);
+			bInside &= (clamped == local[i]);
+			closestPoint += boxAxes.Axes[i] * clamped;
+		}
+
+		if (!bInside)
+		{
+			const RpgVector3 offset = center - closestPoint;
+			const float distanceSqr = offset.GetMagnitudeSqr();
+
+			if (distanceSqr > radius * radius)
+			{
+				return false;
+			}
+
+			if (optOut_Result)
+			{
+				const float distance = RpgMath::Sqrt(distanceSqr);
+				optOut_Result->SeparationDirection = (distance > RPG_MATH_EPS_LP) ? offset * (1.0f / distance) : delta.GetNormalize();
+				optOut_Result->PenetrationDepth = radius - distance;
+				optOut_Result->ContactPoint = closestPoint;
+			}
+
+			return true;
+		}
+
+		// Center inside box, push out through nearest face
+		if (optOut_Result)
+		{
+			int faceAxis = 0;
+			float faceDistance = FLT_MAX;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				const float distance = boxAxes.HalfExtents[i] - RpgMath::Abs(local[i]);
+
+				if (distance < faceDistance)
+				{
+					faceDistance = distance;
+					faceAxis = i;
+				}
+			}
+
+			const RpgVector3 direction = (local[faceAxis] >= 0.0f) ? boxAxes.Axes[faceAxis] : -boxAxes.Axes[faceAxis];
+			optOut_Result->SeparationDirection = direction;
+			optOut_Result->PenetrationDepth = faceDistance + radius;
+			optOut_Result->ContactPoint = center + direction * faceDistance;
+		}
+
+		return true;
+	}
+
+
+	// Signed distance from point to box surface, negative inside
+	static inline float GetBoxSignedDistance(const RpgPhysicsCollision::FShape& box, const FBoxAxes& boxAxes, const RpgVector3& point) noexcept
+	{
+		const RpgVector3 delta = point - box.Center;
+		float outsideSqr = 0.0f;
+		float insideMax = -FLT_MAX;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const float q = RpgMath::Abs(RpgVector3::DotProduct(delta, boxAxes.Axes[i])) - boxAxes.HalfExtents[i];
+			outsideSqr += (q > 0.0f) ? q * q : 0.0f;
+			insideMax = RpgMath::Max(insideMax, q);
+		}
+
+		return (outsideSqr > 0.0f) ? RpgMath::Sqrt(outsideSqr) : insideMax;
+	}
+
+
+	// Flip separation direction of contact result computed with swapped shapes
+	static inline bool FlipResult(bool bOverlapped, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		if (bOverlapped && optOut_Result)
+		{
+			optOut_Result->SeparationDirection = -optOut_Result->SeparationDirection;
+		}
+
+		return bOverlapped;
+	}
+
+
+
+	static bool SphereSphere(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		return TestSpheres(first.Center, first.Size.X, second.Center, second.Size.X, optOut_Result);
+	}
+
+
+	static bool SphereCapsule(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		RpgVector3 bottom, top;
+		GetCapsuleSegment(second, bottom, top);
+
+		return TestSpheres(first.Center, first.Size.X, ClosestPointOnSegment(bottom, top, first.Center), second.Size.X, optOut_Result);
+	}
+
+
+	static bool CapsuleSphere(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		return FlipResult(SphereCapsule(second, first, optOut_Result), optOut_Result);
+	}
+
+
+	static bool CapsuleCapsule(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		RpgVector3 firstBottom, firstTop, secondBottom, secondTop;
+		GetCapsuleSegment(first, firstBottom, firstTop);
+		GetCapsuleSegment(second, secondBottom, secondTop);
+
+		RpgVector3 firstPoint, secondPoint;
+		ClosestPointsSegmentSegment(firstBottom, firstTop, secondBottom, secondTop, firstPoint, secondPoint);
+
+		return TestSpheres(firstPoint, first.Size.X, secondPoint, second.Size.X, optOut_Result);
+	}
+
+
+	static bool BoxSphere(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		return TestBoxSphere(first, GetBoxAxes(first), second.Center, second.Size.X, optOut_Result);
+	}
+
+
+	static bool SphereBox(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		return FlipResult(BoxSphere(second, first, optOut_Result), optOut_Result);
+	}
+
+
+	static bool BoxCapsule(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		const FBoxAxes boxAxes = GetBoxAxes(first);
+
+		RpgVector3 bottom, top;
+		GetCapsuleSegment(second, bottom, top);
+		const RpgVector3 segment = top - bottom;
+
+		// Signed distance to box is convex along capsule segment, ternary search for the deepest point
+		float low = 0.0f;
+		float high = 1.0f;
+
+		for (int i = 0; i < RPG_PHYSICS_COLLISION_CAPSULE_BOX_ITERATIONS; ++i)
+		{
+			const float t0 = low + (high - low) * (1.0f / 3.0f);
+			const float t1 = high - (high - low) * (1.0f / 3.0f);
+
+			if (GetBoxSignedDistance(first, boxAxes, bottom + segment * t0) <= GetBoxSignedDistance(first, boxAxes, bottom + segment * t1))
+			{
+				high = t1;
+			}
+			else
+			{
+				low = t0;
+			}
+		}
+
+		const RpgVector3 deepestPoint = bottom + segment * ((low + high) * 0.5f);
+
+		// Segment outside box, closest point on segment gives exact contact
+		if (GetBoxSignedDistance(first, boxAxes, deepestPoint) > 0.0f)
+		{
+			return TestBoxSphere(first, boxAxes, deepestPoint, second.Size.X, optOut_Result);
+		}
+
+		// Segment intersects box, separation direction is the axis of minimum overlap (box face axes, box edges crossed with capsule axis)
+		if (optOut_Result)
+		{
+			const RpgVector3 delta = second.Center - first.Center;
+			float minOverlap = FLT_MAX;
+			RpgVector3 minAxis;
+
+			for (int i = 0; i < 6; ++i)
+			{
+				RpgVector3 axis = (i < 3) ? boxAxes.Axes[i] : RpgVector3::CrossProduct(boxAxes.Axes[i - 3], RpgVector3::UP);
+				const float lengthSqr = axis.GetMagnitudeSqr();
+
+				if (lengthSqr <= RPG_MATH_EPS_LP)
+				{
+					continue;
+				}
+
+				axis = axis * (1.0f / RpgMath::Sqrt(lengthSqr));
+				const float distance = RpgVector3::DotProduct(delta, axis);
+				const float overlap = GetBoxProjectionRadius(boxAxes, axis) + RpgMath::Abs(axis.Y) * second.Size.Y + second.Size.X - RpgMath::Abs(distance);
+
+				if (overlap < minOverlap)
+				{
+					minOverlap = overlap;
+					minAxis = (distance < 0.0f) ? -axis : axis;
+				}
+			}
+
+			optOut_Result->SeparationDirection = minAxis;
+			optOut_Result->PenetrationDepth = minOverlap;
+			optOut_Result->ContactPoint = deepestPoint;
+		}
+
+		return true;
+	}
+
+
+	static bool CapsuleBox(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		return FlipResult(BoxCapsule(second, first, optOut_Result), optOut_Result);
+	}
+
+
+	// Separating axis test over 15 axes (3 face axes of each box, 9 edge cross products). Separation direction is the axis of minimum overlap
+	static bool BoxBox(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		const FBoxAxes firstAxes = GetBoxAxes(first);
+		const FBoxAxes secondAxes = GetBoxAxes(second);
+		const RpgVector3 delta = second.Center - first.Center;
+
+		float minOverlap = FLT_MAX;
+		RpgVector3 minAxis;
+
+		auto testAxis = [&](const RpgVector3& axis) -> bool
+		{
+			const float lengthSqr = axis.GetMagnitudeSqr();
+
+			// Cross product of parallel edges, already covered by face axes
+			if (lengthSqr <= RPG_MATH_EPS_LP)
+			{
+				return true;
+			}
+
+			const RpgVector3 normalizedAxis = axis * (1.0f / RpgMath::Sqrt(lengthSqr));
+			const float distance = RpgVector3::DotProduct(delta, normalizedAxis);
+			const float overlap = GetBoxProjectionRadius(firstAxes, normalizedAxis) + GetBoxProjectionRadius(secondAxes, normalizedAxis) - RpgMath::Abs(distance);
+
+			if (overlap < 0.0f)
+			{
+				return false;
+			}
+
+			if (overlap < minOverlap)
+			{
+				minOverlap = overlap;
+				minAxis = (distance < 0.0f) ? -normalizedAxis : normalizedAxis;
+			}
+
+			return true;
+		};
+
+		for (int i = 0; i < 3; ++i)
+		{
+			if (!testAxis(firstAxes.Axes[i]) || !testAxis(secondAxes.Axes[i]))
+			{
+				return false;
+			}
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				if (!testAxis(RpgVector3::CrossProduct(firstAxes.Axes[i], secondAxes.Axes[j])))
+				{
+					return false;
+				}
+			}
+		}
+
+		if (optOut_Result)
+		{
+			// Deepest corner of second box along separation direction
+			RpgVector3 corner = second.Center;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				const float sign = (RpgVector3::DotProduct(secondAxes.Axes[i], minAxis) > 0.0f) ? -1.0f : 1.0f;
+				corner += secondAxes.Axes[i] * (secondAxes.HalfExtents[i] * sign);
+			}
+
+			optOut_Result->SeparationDirection = minAxis;
+			optOut_Result->PenetrationDepth = minOverlap;
+			optOut_Result->ContactPoint = corner + minAxis * (minOverlap * 0.5f);
+		}
+
+		return true;
+	}
+
+
+
+	typedef bool (*FTestOverlapFunction)(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second, RpgPhysicsCollision::FContactResult* optOut_Result);
+
+	// Indexed by [first shape][second shape]. Mesh shapes have no vertex data in FShape yet, convex hull goes through GJK once it does
+	static const FTestOverlapFunction TEST_OVERLAP_FUNCTIONS[RpgPhysicsCollision::SHAPE_MAX_COUNT][RpgPhysicsCollision::SHAPE_MAX_COUNT] =
+	{
+		//	NONE		SPHERE			BOX				CAPSULE			MESH_CONVEX		MESH_TRIANGLE
+		{	nullptr,	nullptr,		nullptr,		nullptr,		nullptr,		nullptr	},	// NONE
+		{	nullptr,	SphereSphere,	SphereBox,		SphereCapsule,	nullptr,		nullptr	},	// SPHERE
+		{	nullptr,	BoxSphere,		BoxBox,			BoxCapsule,		nullptr,		nullptr	},	// BOX
+		{	nullptr,	CapsuleSphere,	CapsuleBox,		CapsuleCapsule,	nullptr,		nullptr	},	// CAPSULE
+		{	nullptr,	nullptr,		nullptr,		nullptr,		nullptr,		nullptr	},	// MESH_CONVEX
+		{	nullptr,	nullptr,		nullptr,		nullptr,		nullptr,		nullptr	},	// MESH_TRIANGLE
+	};
+	static_assert(RpgPhysicsCollision::SHAPE_MAX_COUNT == 6, "RpgPhysicsAnalytic: Update TEST_OVERLAP_FUNCTIONS!");
+
+
+
+	// 4 lanes of float
+	struct FLane4
+	{
+		__m128 X;
+		__m128 Y;
+		__m128 Z;
+		__m128 Radius;
+		__m128 HalfHeight;
+	};
+
+
+	static inline FLane4 LoadLane4(const RpgPhysicsCollision::FShape* const* shapes) noexcept
+	{
+		FLane4 lane;
+		lane.X = _mm_setr_ps(shapes[0]->Center.X, shapes[1]->Center.X, shapes[2]->Center.X, shapes[3]->Center.X);
+		lane.Y = _mm_setr_ps(shapes[0]->Center.Y, shapes[1]->Center.Y, shapes[2]->Center.Y, shapes[3]->Center.Y);
+		lane.Z = _mm_setr_ps(shapes[0]->Center.Z, shapes[1]->Center.Z, shapes[2]->Center.Z, shapes[3]->Center.Z);
+		lane.Radius = _mm_setr_ps(shapes[0]->Size.X, shapes[1]->Size.X, shapes[2]->Size.X, shapes[3]->Size.X);
+		lane.HalfHeight = _mm_setr_ps(shapes[0]->Size.Y, shapes[1]->Size.Y, shapes[2]->Size.Y, shapes[3]->Size.Y);
+
+		return lane;
+	}
+
+
+	// Capsules are parallel (y-axis), closest distance between segments is horizontal distance and vertical gap outside both half heights
+	static inline int TestLane4(const FLane4& first, const FLane4& second, __m128 firstHalfHeight, __m128 secondHalfHeight) noexcept
+	{
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		const __m128 dx = _mm_sub_ps(second.X, first.X);
+		const __m128 dz = _mm_sub_ps(second.Z, first.Z);
+		const __m128 dy = _mm_max_ps(_mm_sub_ps(_mm_and_ps(_mm_sub_ps(second.Y, first.Y), absMask), _mm_add_ps(firstHalfHeight, secondHalfHeight)), _mm_setzero_ps());
+		const __m128 distanceSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		const __m128 radius = _mm_add_ps(first.Radius, second.Radius);
+
+		return _mm_movemask_ps(_mm_cmple_ps(distanceSqr, _mm_mul_ps(radius, radius)));
+	}
+
 };
 
 
@@ -108,155 +668,218 @@ namespace RpgPhysicsCollision
 
 
 
-// =========================================================================================================================================================== //
-// FILTER
-// =========================================================================================================================================================== //
-	void Filter::GeneratePairs(RpgArray<FPairTest>& out_Pairs, RpgWorld* world) noexcept
+	FFilterMask FFilterMask::Make(EChannel objectChannel, const FResponseChannels& responseChannels) noexcept
 	{
-		for (auto firstIt = world->Component_CreateIterator<RpgPhysicsComponent_Filter>(); firstIt; ++firstIt)
+		FFilterMask mask;
+		mask.ChannelBit = GetChannelBit(objectChannel);
+
+		for (int c = CHANNEL_NONE + 1; c < responseChannels.GetCount(); ++c)
 		{
-			RpgPhysicsComponent_Filter& firstFilter = firstIt.GetValue();
+			const FChannelMask channelBit = GetChannelBit(static_cast<EChannel>(c));
 
-			if (firstFilter.ObjectChannel == RpgPhysicsCollision::CHANNEL_NONE)
+			if (responseChannels[c] == RESPONSE_BLOCK)
 			{
-				continue;
+				mask.BlockMask |= channelBit;
+				mask.ResponseMask |= channelBit;
 			}
+			else if (responseChannels[c] == RESPONSE_OVERLAP)
+			{
+				mask.ResponseMask |= channelBit;
+			}
+		}
 
+		return mask;
+	}
 
-			for (auto secondIt = firstIt; secondIt; ++secondIt)
-			{
-				if (firstIt == secondIt)
-				{
-					continue;
-				}
 
-				const RpgPhysicsComponent_Filter& secondFilter = secondIt.GetValue();
 
-				if (secondFilter.ObjectChannel == RpgPhysicsCollision::CHANNEL_NONE)
-				{
-					continue;
-				}
 
-				if (firstFilter.ResponseChannels[secondFilter.ObjectChannel] == secondFilter.ResponseChannels[firstFilter.ObjectChannel])
-				{
-					RpgPhysicsComponent_Collision* firstCollision = world->GameObject_GetComponent<RpgPhysicsComponent_Collision>(firstFilter.GameObject);
-					RPG_Check(firstCollision && firstCollision->GameObject == firstFilter.GameObject);
+// =========================================================================================================================================================== //
+// BROADPHASE
+// =========================================================================================================================================================== //
+	void Broadphase::GeneratePairs(FPairTestArray& out_Pairs, const RpgPhysicsDynamicTree& firstTree, const FProxy* firstProxies, const RpgPhysicsDynamicTree& secondTree, const FProxy* secondProxies) noexcept
+	{
+		// Proxy pairs with overlapping fat AABBs that respond to each other
+		RpgArray<RpgPhysicsDynamicTree::FProxyPair> proxyPairs;
 
-					RpgPhysicsComponent_Collision* secondCollision = world->GameObject_GetComponent<RpgPhysicsComponent_Collision>(secondFilter.GameObject);
-					RPG_Check(secondCollision && secondCollision->GameObject == secondFilter.GameObject);
+		if (&firstTree == &secondTree)
+		{
+			firstTree.GeneratePairs(proxyPairs);
+		}
+		else
+		{
+			firstTree.GeneratePairs(secondTree, proxyPairs);
+		}
 
-					out_Pairs.AddValue({ firstCollision, secondCollision });
-				}
+		for (int i = 0; i < proxyPairs.GetCount(); ++i)
+		{
+			const FProxy& first = firstProxies[proxyPairs[i].FirstProxy];
+			const FProxy& second = secondProxies[proxyPairs[i].SecondProxy];
+
+			const RpgBoundingSphere& firstBound = first.Collision->GetBound();
+			const RpgBoundingSphere& secondBound = second.Collision->GetBound();
+			const float radius = firstBound.GetRadius() + secondBound.GetRadius();
+
+			if ((secondBound.GetCenter() - firstBound.GetCenter()).GetMagnitudeSqr() <= radius * radius)
+			{
+				out_Pairs.AddValue({ first.Collision, second.Collision, GetPairResponse(first.FilterMask, second.FilterMask) });
 			}
 		}
 	}
-	
+
 
 
 
 // =========================================================================================================================================================== //
-// BROADPHASE
+// NARROWPHASE
 // =========================================================================================================================================================== //
-	void Broadphase::GeneratePairs(RpgArray<FPairTest>& out_Pairs, const RpgArray<FPairTest>& filterPairs) noexcept
+	static FShape MakeShape(const RpgBoundingSphere& sphere) noexcept
 	{
+		FShape shape;
+		shape.Center = sphere.GetCenter();
+		shape.Size = RpgVector4(sphere.GetRadius());
+		shape.Type = SHAPE_SPHERE;
 
+		return shape;
 	}
 
 
+	static FShape MakeShape(const RpgBoundingBox& box) noexcept
+	{
+		FShape shape;
+		shape.Center = box.Center;
+		shape.Rotation = box.Rotation;
+		shape.Size = RpgVector4(box.HalfExtents.X, box.HalfExtents.Y, box.HalfExtents.Z, 0.0f);
+		shape.Type = SHAPE_BOX;
+
+		return shape;
+	}
 
 
-// =========================================================================================================================================================== //
-// NARROWPHASE
-// =========================================================================================================================================================== //
 	bool Narrowphase::TestOverlapSphereSphere(RpgBoundingSphere first, RpgBoundingSphere second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
 	{
-		const RpgVector3 firstCenter = first.GetCenter();
-		const float firstRadius = first.GetRadius();
+		return RpgPhysicsAnalytic::SphereSphere(MakeShape(first), MakeShape(second), optOut_Result);
+	}
 
-		const RpgVector3 secondCenter = second.GetCenter();
-		const float secondRadius = second.GetRadius();
 
-		const RpgVector3 delta = secondCenter - firstCenter;
-		const float magSqr = delta.GetMagnitudeSqr();
-		const float radiusSqr = (firstRadius + secondRadius) * (firstRadius * secondRadius);
-		const bool bOverlapped = magSqr <= radiusSqr;
+	bool Narrowphase::TestOverlapSphereBox(RpgBoundingSphere sphere, RpgBoundingBox box, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		return RpgPhysicsAnalytic::SphereBox(MakeShape(sphere), MakeShape(box), optOut_Result);
+	}
 
-		if (bOverlapped && optOut_Result)
-		{
-			const RpgVector3 deltaNormalized = delta.GetNormalize();
-			optOut_Result->SeparationDirection = deltaNormalized;
-			optOut_Result->ContactPoint = deltaNormalized * secondRadius;
-			optOut_Result->PenetrationDepth = RpgMath::Sqrt(magSqr);
-		}
 
-		return bOverlapped;
+	bool Narrowphase::TestOverlapBoxBox(RpgBoundingBox first, RpgBoundingBox second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	{
+		return RpgPhysicsAnalytic::BoxBox(MakeShape(first), MakeShape(second), optOut_Result);
 	}
 
 
-	bool Narrowphase::TestOverlapSphereBox(RpgBoundingSphere sphere, RpgBoundingBox box, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	bool Narrowphase::TestOverlapBoxSphere(RpgBoundingBox box, RpgBoundingSphere sphere, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
 	{
-		ccd_t ccd;
-		CCD_INIT(&ccd);
-		ccd.support1 = RpgPhysicsGJK::SupportSphere;
-		ccd.support2 = RpgPhysicsGJK::SupportBox;
-		ccd.max_iterations = RPG_PHYSICS_COLLISION_GJK_MAX_ITERATIONS;
-		ccd.epa_tolerance = RPG_PHYSICS_COLLISION_GJK_MAX_EPA_TOLERANCE;
-		ccd.dist_tolerance = RPG_PHYSICS_COLLISION_GJK_DISTANCE_TOLERANCE;
+		return RpgPhysicsAnalytic::BoxSphere(MakeShape(box), MakeShape(sphere), optOut_Result);
+	}
 
-		bool bOverlapped = false;
 
-		if (optOut_Result)
-		{
-			ccd_real_t depth = 0.0f;
-			ccd_vec3_t separationDirection;
-			ccd_vec3_t contactPoint;
+	bool Narrowphase::TestOverlap(const FShape& first, const FShape& second, FContactResult* optOut_Result) noexcept
+	{
+		RPG_Check(first.Type < SHAPE_MAX_COUNT && second.Type < SHAPE_MAX_COUNT);
+		const RpgPhysicsAnalytic::FTestOverlapFunction testFunction = RpgPhysicsAnalytic::TEST_OVERLAP_FUNCTIONS[first.Type][second.Type];
 
-			const int ret = ccdGJKPenetration(&sphere, &box, &ccd, &depth, &separationDirection, &contactPoint);
-			RPG_Check(ret != -2);
+		return testFunction ? testFunction(first, second, optOut_Result) : false;
+	}
 
-			if (ret == 0)
-			{
-				bOverlapped = true;
-				optOut_Result->ContactPoint = RpgVector3(contactPoint.v[0], contactPoint.v[1], contactPoint.v[2]);
-				optOut_Result->SeparationDirection = RpgVector3(separationDirection.v[0], separationDirection.v[1], separationDirection.v[2]);
-				optOut_Result->SeparationDirection.Normalize();
-				optOut_Result->PenetrationDepth = depth;
-			}
-		}
-		else
+
+	bool Narrowphase::TestOverlapGJK(const FShape& first, const FShape& second, FContactResult* optOut_Result) noexcept
+	{
+		RpgPhysicsGJK::FSupportShape firstSupport;
+		RpgPhysicsGJK::FSupportShape secondSupport;
+
+		if (!RpgPhysicsGJK::MakeSupportShape(first, firstSupport) || !RpgPhysicsGJK::MakeSupportShape(second, secondSupport))
 		{
-			bOverlapped = ccdGJKIntersect(&sphere, &box, &ccd);
+			return false;
 		}
 
-		return bOverlapped;
+		return RpgPhysicsGJK::TestOverlap(firstSupport.Object, firstSupport.Support, secondSupport.Object, secondSupport.Support, optOut_Result);
 	}
 
 
-	bool Narrowphase::TestOverlapBoxBox(RpgBoundingBox first, RpgBoundingBox second, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	int Narrowphase::TestOverlapBatch4_SphereSphere(const FShape* const* firsts, const FShape* const* seconds) noexcept
 	{
-		ccd_t ccd;
-		CCD_INIT(&ccd);
-		ccd.support1 = RpgPhysicsGJK::SupportBox;
-		ccd.support2 = RpgPhysicsGJK::SupportBox;
-		ccd.max_iterations = RPG_PHYSICS_COLLISION_GJK_MAX_ITERATIONS;
-		ccd.epa_tolerance = RPG_PHYSICS_COLLISION_GJK_MAX_EPA_TOLERANCE;
-		ccd.dist_tolerance = RPG_PHYSICS_COLLISION_GJK_DISTANCE_TOLERANCE;
+		const __m128 zero = _mm_setzero_ps();
+		return RpgPhysicsAnalytic::TestLane4(RpgPhysicsAnalytic::LoadLane4(firsts), RpgPhysicsAnalytic::LoadLane4(seconds), zero, zero);
+	}
 
-		return ccdGJKIntersect(&first, &second, &ccd);
+
+	int Narrowphase::TestOverlapBatch4_SphereCapsule(const FShape* const* firsts, const FShape* const* seconds) noexcept
+	{
+		const RpgPhysicsAnalytic::FLane4 capsules = RpgPhysicsAnalytic::LoadLane4(seconds);
+		return RpgPhysicsAnalytic::TestLane4(RpgPhysicsAnalytic::LoadLane4(firsts), capsules, _mm_setzero_ps(), capsules.HalfHeight);
 	}
 
 
-	bool Narrowphase::TestOverlapBoxSphere(RpgBoundingBox box, RpgBoundingSphere sphere, RpgPhysicsCollision::FContactResult* optOut_Result) noexcept
+	int Narrowphase::TestOverlapBatch4_CapsuleCapsule(const FShape* const* firsts, const FShape* const* seconds) noexcept
 	{
-		ccd_t ccd;
-		CCD_INIT(&ccd);
-		ccd.support1 = RpgPhysicsGJK::SupportBox;
-		ccd.support2 = RpgPhysicsGJK::SupportSphere;
-		ccd.max_iterations = RPG_PHYSICS_COLLISION_GJK_MAX_ITERATIONS;
-		ccd.epa_tolerance = RPG_PHYSICS_COLLISION_GJK_MAX_EPA_TOLERANCE;
-		ccd.dist_tolerance = RPG_PHYSICS_COLLISION_GJK_DISTANCE_TOLERANCE;
+		const RpgPhysicsAnalytic::FLane4 first = RpgPhysicsAnalytic::LoadLane4(firsts);
+		const RpgPhysicsAnalytic::FLane4 second = RpgPhysicsAnalytic::LoadLane4(seconds);
+		return RpgPhysicsAnalytic::TestLane4(first, second, first.HalfHeight, second.HalfHeight);
+	}
+
+
+	bool Narrowphase::TestSeparatingAxis(const FShape& first, const FShape& second, const RpgVector3& axis) noexcept
+	{
+		const float distance = RpgMath::Abs(RpgVector3::DotProduct(second.Center - first.Center, axis));
+
+		return distance > RpgPhysicsGJK::GetProjectionRadius(first, axis) + RpgPhysicsGJK::GetProjectionRadius(second, axis);
+	}
+
+
+	bool Narrowphase::FindSeparatingAxis(const FShape& first, const FShape& second, RpgVector3& out_Axis) noexcept
+	{
+		RpgArrayInline<RpgVector3, 9> axes;
+
+		const RpgVector3 delta = second.Center - first.Center;
+		if (delta.GetMagnitudeSqr() > RPG_MATH_EPS_LP)
+		{
+			axes.AddValue(delta.GetNormalize());
+		}
+
+		const FShape* shapes[2] = { &first, &second };
+
+		for (int i = 0; i < 2; ++i)
+		{
+			if (shapes[i]->Type == SHAPE_BOX)
+			{
+				axes.AddValue(RpgQuaternion::RotateVector(shapes[i]->Rotation, RpgVector3::RIGHT));
+				axes.AddValue(RpgQuaternion::RotateVector(shapes[i]->Rotation, RpgVector3::UP));
+				axes.AddValue(RpgQuaternion::RotateVector(shapes[i]->Rotation, RpgVector3::FORWARD));
+			}
+			else if (shapes[i]->Type == SHAPE_CAPSULE)
+			{
+				// Direction from closest point on capsule segment to center of other shape
+				const FShape& capsule = *shapes[i];
+				const FShape& other = *shapes[1 - i];
+
+				RpgVector3 closestPoint = capsule.Center;
+				closestPoint.Y += RpgMath::Clamp(other.Center.Y - capsule.Center.Y, -capsule.Size.Y, capsule.Size.Y);
+
+				const RpgVector3 direction = other.Center - closestPoint;
+				if (direction.GetMagnitudeSqr() > RPG_MATH_EPS_LP)
+				{
+					axes.AddValue(direction.GetNormalize());
+				}
+			}
+		}
+
+		for (int i = 0; i < axes.GetCount(); ++i)
+		{
+			if (TestSeparatingAxis(first, second, axes[i]))
+			{
+				out_Axis = axes[i];
+				return true;
+			}
+		}
 
-		return ccdGJKIntersect(&box, &sphere, &ccd);
+		return false;
 	}
 
 };
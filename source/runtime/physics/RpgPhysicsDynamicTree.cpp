@@ -0,0 +1,594 @@
+#include "RpgPhysicsDynamicTree.h"
+#include "core/dsa/RpgAlgorithm.h"
+
+
+
+static inline RpgBoundingAABB RpgPhysicsDynamicTree_Combine(const RpgBoundingAABB& a, const RpgBoundingAABB& b) noexcept
+{
+	return RpgBoundingAABB(RpgVector3::Min(a.Min, b.Min), RpgVector3::Max(a.Max, b.Max));
+}
+
+
+static inline bool RpgPhysicsDynamicTree_Contains(const RpgBoundingAABB& outer, const RpgBoundingAABB& inner) noexcept
+{
+	return outer.Min.X <= inner.Min.X && outer.Min.Y <= inner.Min.Y && outer.Min.Z <= inner.Min.Z &&
+		inner.Max.X <= outer.Max.X && inner.Max.Y <= outer.Max.Y && inner.Max.Z <= outer.Max.Z;
+}
+
+
+static inline float RpgPhysicsDynamicTree_SurfaceArea(const RpgBoundingAABB& aabb) noexcept
+{
+	const RpgVector3 d = aabb.Max - aabb.Min;
+	return 2.0f * (d.X * d.Y + d.Y * d.Z + d.Z * d.X);
+}
+
+
+
+RpgPhysicsDynamicTree::RpgPhysicsDynamicTree(float in_AabbMargin) noexcept
+{
+	RootIndex = RPG_INDEX_INVALID;
+	ProxyCount = 0;
+	AabbMargin = in_AabbMargin;
+}
+
+
+int RpgPhysicsDynamicTree::AllocateNode() noexcept
+{
+	const int index = Nodes.Add();
+
+	FNode& node = Nodes[index];
+	node.Parent = RPG_INDEX_INVALID;
+	node.Child1 = RPG_INDEX_INVALID;
+	node.Child2 = RPG_INDEX_INVALID;
+	node.Height = 0;
+	node.CategoryBits = 0;
+	node.MaskBits = 0;
+
+	return index;
+}
+
+
+int RpgPhysicsDynamicTree::CreateProxy(const RpgBoundingAABB& aabb, uint32_t categoryBits, uint32_t maskBits) noexcept
+{
+	const int proxyId = AllocateNode();
+
+	const RpgVector3 margin(AabbMargin);
+	FNode& node = Nodes[proxyId];
+	node.Aabb = RpgBoundingAABB(aabb.Min - margin, aabb.Max + margin);
+	node.CategoryBits = categoryBits;
+	node.MaskBits = maskBits;
+
+	InsertLeaf(proxyId);
+	++ProxyCount;
+
+	return proxyId;
+}
+
+
+void RpgPhysicsDynamicTree::DestroyProxy(int proxyId) noexcept
+{
+	RPG_Check(IsProxyValid(proxyId));
+
+	RemoveLeaf(proxyId);
+	Nodes.RemoveAt(proxyId);
+	--ProxyCount;
+}
+
+
+bool RpgPhysicsDynamicTree::MoveProxy(int proxyId, const RpgBoundingAABB& aabb, const RpgVector3& displacement) noexcept
+{
+	RPG_Check(IsProxyValid(proxyId));
+
+	FNode& node = Nodes[proxyId];
+
+	const RpgVector3 margin(AabbMargin);
+	RpgBoundingAABB fatAabb(aabb.Min - margin, aabb.Max + margin);
+
+	// Extend toward moving direction only
+	const RpgVector3 d = displacement * RPG_PHYSICS_DYNAMIC_TREE_DISPLACEMENT_MULTIPLIER;
+	(d.X < 0.0f ? fatAabb.Min.X : fatAabb.Max.X) += d.X;
+	(d.Y < 0.0f ? fatAabb.Min.Y : fatAabb.Max.Y) += d.Y;
+	(d.Z < 0.0f ? fatAabb.Min.Z : fatAabb.Max.Z) += d.Z;
+
+	if (RpgPhysicsDynamicTree_Contains(node.Aabb, aabb))
+	{
+		// Keep current fat AABB unless it is much larger than needed (proxy was moving fast and has slowed down)
+		const RpgVector3 largeMargin(AabbMargin * 4.0f);
+		const RpgBoundingAABB largeAabb(fatAabb.Min - largeMargin, fatAabb.Max + largeMargin);
+
+		if (RpgPhysicsDynamicTree_Contains(largeAabb, node.Aabb))
+		{
+			return false;
+		}
+	}
+
+	RemoveLeaf(proxyId);
+	node.Aabb = fatAabb;
+	InsertLeaf(proxyId);
+
+	return true;
+}
+
+
+void RpgPhysicsDynamicTree::Clear() noexcept
+{
+	Nodes.Clear();
+	RootIndex = RPG_INDEX_INVALID;
+	ProxyCount = 0;
+}
+
+
+void RpgPhysicsDynamicTree::InsertLeaf(int leafIndex) noexcept
+{
+	if (RootIndex == RPG_INDEX_INVALID)
+	{
+		RootIndex = leafIndex;
+		Nodes[leafIndex].Parent = RPG_INDEX_INVALID;
+		return;
+	}
+
+	const RpgBoundingAABB leafAabb = Nodes[leafIndex].Aabb;
+
+	// Find best sibling. Cost of a node is surface area of new parent plus area increase of all ancestors (inheritance cost)
+	int index = RootIndex;
+
+	while (!Nodes[index].IsLeaf())
+	{
+		const FNode& node = Nodes[index];
+		const FNode& child1 = Nodes[node.Child1];
+		const FNode& child2 = Nodes[node.Child2];
+
+		const float area = RpgPhysicsDynamicTree_SurfaceArea(node.Aabb);
+		const float combinedArea = RpgPhysicsDynamicTree_SurfaceArea(RpgPhysicsDynamicTree_Combine(node.Aabb, leafAabb));
+
+		// Cost of creating new parent for this node and the new leaf
+		const float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree
+		const float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float cost1 = RpgPhysicsDynamicTree_SurfaceArea(RpgPhysicsDynamicTree_Combine(child1.Aabb, leafAabb)) + inheritanceCost;
+		cost1 -= child1.IsLeaf() ? 0.0f : RpgPhysicsDynamicTree_SurfaceArea(child1.Aabb);
+
+		float cost2 = RpgPhysicsDynamicTree_SurfaceArea(RpgPhysicsDynamicTree_Combine(child2.Aabb, leafAabb)) + inheritanceCost;
+		cost2 -= child2.IsLeaf() ? 0.0f : RpgPhysicsDynamicTree_SurfaceArea(child2.Aabb);
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+
+		index = (cost1 < cost2) ? node.Child1 : node.Child2;
+	}
+
+	const int siblingIndex = index;
+	const int oldParentIndex = Nodes[siblingIndex].Parent;
+	const int newParentIndex = AllocateNode();
+
+	FNode& newParent = Nodes[newParentIndex];
+	newParent.Parent = oldParentIndex;
+	newParent.Aabb = RpgPhysicsDynamicTree_Combine(leafAabb, Nodes[siblingIndex].Aabb);
+	newParent.Height = Nodes[siblingIndex].Height + 1;
+	newParent.CategoryBits = Nodes[leafIndex].CategoryBits | Nodes[siblingIndex].CategoryBits;
+	newParent.MaskBits = Nodes[leafIndex].MaskBits | Nodes[siblingIndex].MaskBits;
+	newParent.Child1 = siblingIndex;
+	newParent.Child2 = leafIndex;
+
+	if (oldParentIndex != RPG_INDEX_INVALID)
+	{
+		FNode& oldParent = Nodes[oldParentIndex];
+		(oldParent.Child1 == siblingIndex ? oldParent.Child1 : oldParent.Child2) = newParentIndex;
+	}
+	else
+	{
+		RootIndex = newParentIndex;
+	}
+
+	Nodes[siblingIndex].Parent = newParentIndex;
+	Nodes[leafIndex].Parent = newParentIndex;
+
+	RefitAncestors(newParentIndex);
+}
+
+
+void RpgPhysicsDynamicTree::RemoveLeaf(int leafIndex) noexcept
+{
+	if (leafIndex == RootIndex)
+	{
+		RootIndex = RPG_INDEX_INVALID;
+		return;
+	}
+
+	const int parentIndex = Nodes[leafIndex].Parent;
+	const int grandParentIndex = Nodes[parentIndex].Parent;
+	const int siblingIndex = (Nodes[parentIndex].Child1 == leafIndex) ? Nodes[parentIndex].Child2 : Nodes[parentIndex].Child1;
+
+	Nodes.RemoveAt(parentIndex);
+	Nodes[siblingIndex].Parent = grandParentIndex;
+
+	if (grandParentIndex != RPG_INDEX_INVALID)
+	{
+		FNode& grandParent = Nodes[grandParentIndex];
+		(grandParent.Child1 == parentIndex ? grandParent.Child1 : grandParent.Child2) = siblingIndex;
+
+		RefitAncestors(grandParentIndex);
+	}
+	else
+	{
+		RootIndex = siblingIndex;
+	}
+
+	Nodes[leafIndex].Parent = RPG_INDEX_INVALID;
+}
+
+
+void RpgPhysicsDynamicTree::RefitAncestors(int index) noexcept
+{
+	while (index != RPG_INDEX_INVALID)
+	{
+		FNode& node = Nodes[index];
+		const FNode& child1 = Nodes[node.Child1];
+		const FNode& child2 = Nodes[node.Child2];
+		node.Height = 1 + RpgMath::Max(child1.Height, child2.Height);
+		node.Aabb = RpgPhysicsDynamicTree_Combine(child1.Aabb, child2.Aabb);
+		node.CategoryBits = child1.CategoryBits | child2.CategoryBits;
+		node.MaskBits = child1.MaskBits | child2.MaskBits;
+
+		// Rotation keeps AABB and bits of this node, only its descendants change
+		RotateNodes(index);
+
+		index = node.Parent;
+	}
+}
+
+
+void RpgPhysicsDynamicTree::RotateNodes(int indexA) noexcept
+{
+	FNode& a = Nodes[indexA];
+
+	if (a.Height < 2)
+	{
+		return;
+	}
+
+	const int indexB = a.Child1;
+	const int indexC = a.Child2;
+	FNode& b = Nodes[indexB];
+	FNode& c = Nodes[indexC];
+
+	enum ERotation
+	{
+		ROTATION_NONE = 0,
+		ROTATION_SWAP_B_F,
+		ROTATION_SWAP_B_G,
+		ROTATION_SWAP_C_D,
+		ROTATION_SWAP_C_E
+	};
+
+	// Only the area of node that receives swapped child changes. Pick the swap with the lowest total area of A children
+	ERotation rotation = ROTATION_NONE;
+	float bestCost = 0.0f;
+
+	RpgBoundingAABB aabbBF, aabbBG, aabbCD, aabbCE;
+
+	const float areaB = RpgPhysicsDynamicTree_SurfaceArea(b.Aabb);
+	const float areaC = RpgPhysicsDynamicTree_SurfaceArea(c.Aabb);
+
+	if (!c.IsLeaf())
+	{
+		// A(B, C(F, G)) -> A(F, C(B, G)) or A(G, C(F, B))
+		aabbBG = RpgPhysicsDynamicTree_Combine(b.Aabb, Nodes[c.Child2].Aabb);
+		aabbBF = RpgPhysicsDynamicTree_Combine(b.Aabb, Nodes[c.Child1].Aabb);
+
+		const float costBF = RpgPhysicsDynamicTree_SurfaceArea(aabbBG) - areaC;
+		const float costBG = RpgPhysicsDynamicTree_SurfaceArea(aabbBF) - areaC;
+
+		if (costBF < bestCost)
+		{
+			rotation = ROTATION_SWAP_B_F;
+			bestCost = costBF;
+		}
+
+		if (costBG < bestCost)
+		{
+			rotation = ROTATION_SWAP_B_G;
+			bestCost = costBG;
+		}
+	}
+
+	if (!b.IsLeaf())
+	{
+		// A(B(D, E), C) -> A(B(C, E), D) or A(B(D, C), E)
+		aabbCE = RpgPhysicsDynamicTree_Combine(c.Aabb, Nodes[b.Child2].Aabb);
+		aabbCD = RpgPhysicsDynamicTree_Combine(c.Aabb, Nodes[b.Child1].Aabb);
+
+		const float costCD = RpgPhysicsDynamicTree_SurfaceArea(aabbCE) - areaB;
+		const float costCE = RpgPhysicsDynamicTree_SurfaceArea(aabbCD) - areaB;
+
+		if (costCD < bestCost)
+		{
+			rotation = ROTATION_SWAP_C_D;
+			bestCost = costCD;
+		}
+
+		if (costCE < bestCost)
+		{
+			rotation = ROTATION_SWAP_C_E;
+			bestCost = costCE;
+		}
+	}
+
+	switch (rotation)
+	{
+		case ROTATION_SWAP_B_F:
+		{
+			const int indexF = c.Child1;
+			FNode& f = Nodes[indexF];
+			a.Child1 = indexF;
+			c.Child1 = indexB;
+			b.Parent = indexC;
+			f.Parent = indexA;
+			c.Aabb = aabbBG;
+			c.CategoryBits = b.CategoryBits | Nodes[c.Child2].CategoryBits;
+			c.MaskBits = b.MaskBits | Nodes[c.Child2].MaskBits;
+			c.Height = 1 + RpgMath::Max(b.Height, Nodes[c.Child2].Height);
+			a.Height = 1 + RpgMath::Max(c.Height, f.Height);
+			break;
+		}
+
+		case ROTATION_SWAP_B_G:
+		{
+			const int indexG = c.Child2;
+			FNode& g = Nodes[indexG];
+			a.Child1 = indexG;
+			c.Child2 = indexB;
+			b.Parent = indexC;
+			g.Parent = indexA;
+			c.Aabb = aabbBF;
+			c.CategoryBits = b.CategoryBits | Nodes[c.Child1].CategoryBits;
+			c.MaskBits = b.MaskBits | Nodes[c.Child1].MaskBits;
+			c.Height = 1 + RpgMath::Max(b.Height, Nodes[c.Child1].Height);
+			a.Height = 1 + RpgMath::Max(c.Height, g.Height);
+			break;
+		}
+
+		case ROTATION_SWAP_C_D:
+		{
+			const int indexD = b.Child1;
+			FNode& d = Nodes[indexD];
+			a.Child2 = indexD;
+			b.Child1 = indexC;
+			c.Parent = indexB;
+			d.Parent = indexA;
+			b.Aabb = aabbCE;
+			b.CategoryBits = c.CategoryBits | Nodes[b.Child2].CategoryBits;
+			b.MaskBits = c.MaskBits | Nodes[b.Child2].MaskBits;
+			b.Height = 1 + RpgMath::Max(c.Height, Nodes[b.Child2].Height);
+			a.Height = 1 + RpgMath::Max(b.Height, d.Height);
+			break;
+		}
+
+		case ROTATION_SWAP_C_E:
+		{
+			const int indexE = b.Child2;
+			FNode& e = Nodes[indexE];
+			a.Child2 = indexE;
+			b.Child2 = indexC;
+			c.Parent = indexB;
+			e.Parent = indexA;
+			b.Aabb = aabbCD;
+			b.CategoryBits = c.CategoryBits | Nodes[b.Child1].CategoryBits;
+			b.MaskBits = c.MaskBits | Nodes[b.Child1].MaskBits;
+			b.Height = 1 + RpgMath::Max(c.Height, Nodes[b.Child1].Height);
+			a.Height = 1 + RpgMath::Max(b.Height, e.Height);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+
+void RpgPhysicsDynamicTree::GeneratePairKeys(const RpgPhysicsDynamicTree& treeA, const RpgPhysicsDynamicTree& treeB, RpgArray<uint64_t>& out_PairKeys) noexcept
+{
+	const bool bSelf = (&treeA == &treeB);
+
+	// Node pairs to visit. In self traversal, same node on both sides means pairs within its subtree
+	RpgArray<int> stack;
+	stack.AddValue(treeA.RootIndex);
+	stack.AddValue(treeB.RootIndex);
+
+	while (stack.GetCount() > 0)
+	{
+		const int indexB = stack[stack.GetCount() - 1];
+		const int indexA = stack[stack.GetCount() - 2];
+		stack.Resize(stack.GetCount() - 2);
+
+		const FNode& a = treeA.Nodes[indexA];
+
+		if (bSelf && indexA == indexB)
+		{
+			if (!a.IsLeaf() && TestFilter(a, a))
+			{
+				stack.AddValue(a.Child1); stack.AddValue(a.Child1);
+				stack.AddValue(a.Child2); stack.AddValue(a.Child2);
+				stack.AddValue(a.Child1); stack.AddValue(a.Child2);
+			}
+
+			continue;
+		}
+
+		const FNode& b = treeB.Nodes[indexB];
+
+		if (!TestFilter(a, b) || !TestOverlap(a.Aabb, b.Aabb))
+		{
+			continue;
+		}
+
+		if (a.IsLeaf() && b.IsLeaf())
+		{
+			const uint64_t first = static_cast<uint64_t>(bSelf ? RpgMath::Min(indexA, indexB) : indexA);
+			const uint64_t second = static_cast<uint64_t>(bSelf ? RpgMath::Max(indexA, indexB) : indexB);
+			out_PairKeys.AddValue((first << 32) | second);
+		}
+		else if (b.IsLeaf() || (!a.IsLeaf() && RpgPhysicsDynamicTree_SurfaceArea(a.Aabb) >= RpgPhysicsDynamicTree_SurfaceArea(b.Aabb)))
+		{
+			// Descend larger node
+			stack.AddValue(a.Child1); stack.AddValue(indexB);
+			stack.AddValue(a.Child2); stack.AddValue(indexB);
+		}
+		else
+		{
+			stack.AddValue(indexA); stack.AddValue(b.Child1);
+			stack.AddValue(indexA); stack.AddValue(b.Child2);
+		}
+	}
+
+	// Subtrees of a node pair are disjoint, every pair is found exactly once
+	RpgAlgorithm::RadixSort(out_PairKeys.GetData(), out_PairKeys.GetCount());
+}
+
+
+static void RpgPhysicsDynamicTree_DecodePairKeys(const RpgArray<uint64_t>& pairKeys, RpgArray<RpgPhysicsDynamicTree::FProxyPair>& out_Pairs) noexcept
+{
+	out_Pairs.Resize(pairKeys.GetCount());
+
+	for (int i = 0; i < pairKeys.GetCount(); ++i)
+	{
+		out_Pairs[i].FirstProxy = static_cast<int>(pairKeys[i] >> 32);
+		out_Pairs[i].SecondProxy = static_cast<int>(pairKeys[i] & 0xFFFFFFFF);
+	}
+}
+
+
+void RpgPhysicsDynamicTree::GeneratePairs(RpgArray<FProxyPair>& out_Pairs) const noexcept
+{
+	out_Pairs.Clear();
+
+	if (RootIndex == RPG_INDEX_INVALID || Nodes[RootIndex].IsLeaf())
+	{
+		return;
+	}
+
+	RpgArray<uint64_t> pairKeys;
+	GeneratePairKeys(*this, *this, pairKeys);
+	RpgPhysicsDynamicTree_DecodePairKeys(pairKeys, out_Pairs);
+}
+
+
+void RpgPhysicsDynamicTree::GeneratePairs(const RpgPhysicsDynamicTree& other, RpgArray<FProxyPair>& out_Pairs) const noexcept
+{
+	RPG_Check(&other != this);
+
+	out_Pairs.Clear();
+
+	if (RootIndex == RPG_INDEX_INVALID || other.RootIndex == RPG_INDEX_INVALID)
+	{
+		return;
+	}
+
+	RpgArray<uint64_t> pairKeys;
+	GeneratePairKeys(*this, other, pairKeys);
+	RpgPhysicsDynamicTree_DecodePairKeys(pairKeys, out_Pairs);
+}
+
+
+void RpgPhysicsDynamicTree::Flatten(RpgArray<RpgPhysicsDynamicTree::FFlatNode>& out_Nodes) const noexcept
+{
+	if (RootIndex == RPG_INDEX_INVALID)
+	{
+		return;
+	}
+
+	out_Nodes.Reserve(out_Nodes.GetCount() + ProxyCount * 2 - 1);
+	FlattenNode(RootIndex, out_Nodes);
+}
+
+
+int RpgPhysicsDynamicTree::FlattenNode(int index, RpgArray<RpgPhysicsDynamicTree::FFlatNode>& out_Nodes) const noexcept
+{
+	const FNode& node = Nodes[index];
+	const int flatIndex = out_Nodes.GetCount();
+
+	FFlatNode& flatNode = out_Nodes.Add();
+	flatNode.Aabb = node.Aabb;
+	flatNode.SecondChild = RPG_INDEX_INVALID;
+	flatNode.ProxyId = node.IsLeaf() ? index : RPG_INDEX_INVALID;
+	flatNode.CategoryBits = node.CategoryBits;
+	flatNode.MaskBits = node.MaskBits;
+
+	if (!node.IsLeaf())
+	{
+		// Add may reallocate, access by index after children are flattened
+		FlattenNode(node.Child1, out_Nodes);
+		out_Nodes[flatIndex].SecondChild = FlattenNode(node.Child2, out_Nodes);
+	}
+
+	return flatIndex;
+}
+
+
+float RpgPhysicsDynamicTree::GetAreaRatio() const noexcept
+{
+	if (RootIndex == RPG_INDEX_INVALID)
+	{
+		return 0.0f;
+	}
+
+	const float rootArea = RpgPhysicsDynamicTree_SurfaceArea(Nodes[RootIndex].Aabb);
+	float totalArea = 0.0f;
+
+	for (auto it = Nodes.CreateConstIterator(); it; ++it)
+	{
+		totalArea += RpgPhysicsDynamicTree_SurfaceArea(it.GetValue().Aabb);
+	}
+
+	return (rootArea > 0.0f) ? totalArea / rootArea : 0.0f;
+}
+
+
+#ifndef RPG_BUILD_SHIPPING
+void RpgPhysicsDynamicTree::Validate() const noexcept
+{
+	if (RootIndex == RPG_INDEX_INVALID)
+	{
+		RPG_Check(ProxyCount == 0);
+		return;
+	}
+
+	RPG_Check(Nodes[RootIndex].Parent == RPG_INDEX_INVALID);
+
+	int leafCount = 0;
+	int nodeCount = 0;
+
+	for (auto it = Nodes.CreateConstIterator(); it; ++it)
+	{
+		const int index = it.GetIndex();
+		const FNode& node = it.GetValue();
+		++nodeCount;
+
+		if (node.Parent != RPG_INDEX_INVALID)
+		{
+			const FNode& parent = Nodes[node.Parent];
+			RPG_Check(parent.Child1 == index || parent.Child2 == index);
+		}
+
+		if (node.IsLeaf())
+		{
+			RPG_Check(node.Height == 0 && node.Child2 == RPG_INDEX_INVALID);
+			++leafCount;
+			continue;
+		}
+
+		const FNode& child1 = Nodes[node.Child1];
+		const FNode& child2 = Nodes[node.Child2];
+		RPG_Check(child1.Parent == index && child2.Parent == index);
+		RPG_Check(node.Height == 1 + RpgMath::Max(child1.Height, child2.Height));
+		RPG_Check(RpgPhysicsDynamicTree_Contains(node.Aabb, child1.Aabb) && RpgPhysicsDynamicTree_Contains(node.Aabb, child2.Aabb));
+		RPG_Check(node.CategoryBits == (child1.CategoryBits | child2.CategoryBits) && node.MaskBits == (child1.MaskBits | child2.MaskBits));
+	}
+
+	RPG_Check(leafCount == ProxyCount && nodeCount == 2 * ProxyCount - 1);
+}
+#endif // !RPG_BUILD_SHIPPING
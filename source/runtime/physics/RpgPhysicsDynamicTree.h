@@ -0,0 +1,250 @@
+#pragma once
+
+#include "core/RpgMath.h"
+#include "core/dsa/RpgFreeList.h"
+
+
+// Default margin added to each side of proxy AABB. Proxy is not reinserted while its AABB stays inside fat AABB
+#define RPG_PHYSICS_DYNAMIC_TREE_AABB_MARGIN				10.0f
+
+// Fat AABB of moved proxy is extended by displacement * multiplier toward its moving direction
+#define RPG_PHYSICS_DYNAMIC_TREE_DISPLACEMENT_MULTIPLIER	4.0f
+
+// Maximum node stack depth for tree traversal
+#define RPG_PHYSICS_DYNAMIC_TREE_STACK_SIZE					256
+
+
+
+// Dynamic AABB tree (bounding volume hierarchy) for broadphase.
+// Leaf node is proxy with fat AABB (AABB + margin). Internal node AABB encloses both children.
+// Insertion descends by surface area heuristic (SAH), then ancestors are refit on the way up and rebalanced with tree rotations that reduce surface area.
+// Each proxy has category bits and mask bits, two proxies are paired only if each mask has the category of the other.
+// Internal node holds union of children bits so traversal skips subtrees that can never pair.
+// Proxy ID is node index, stable until proxy is destroyed.
+class RpgPhysicsDynamicTree
+{
+	RPG_NOCOPY(RpgPhysicsDynamicTree)
+
+public:
+	struct FProxyPair
+	{
+		int FirstProxy;
+		int SecondProxy;
+	};
+
+
+	// Node of flattened tree. First child of internal node is the next node
+	struct FFlatNode
+	{
+		RpgBoundingAABB Aabb;
+
+		// Index of second child in output array, RPG_INDEX_INVALID for leaf
+		int SecondChild;
+
+		// Proxy ID for leaf, RPG_INDEX_INVALID for internal node
+		int ProxyId;
+
+		uint32_t CategoryBits;
+		uint32_t MaskBits;
+
+
+		inline bool IsLeaf() const noexcept
+		{
+			return SecondChild == RPG_INDEX_INVALID;
+		}
+	};
+
+
+public:
+	RpgPhysicsDynamicTree(float in_AabbMargin = RPG_PHYSICS_DYNAMIC_TREE_AABB_MARGIN) noexcept;
+
+
+	// Insert new proxy
+	// @param aabb - Proxy tight AABB
+	// @param categoryBits - Bits this proxy belongs to
+	// @param maskBits - Categories this proxy is paired with
+	// @returns Proxy ID
+	[[nodiscard]] int CreateProxy(const RpgBoundingAABB& aabb, uint32_t categoryBits = UINT32_MAX, uint32_t maskBits = UINT32_MAX) noexcept;
+
+	void DestroyProxy(int proxyId) noexcept;
+
+	// Update proxy AABB. Proxy is reinserted only when <aabb> leaves its fat AABB, or fat AABB becomes too large
+	// @param proxyId - Proxy ID
+	// @param aabb - New proxy tight AABB
+	// @param displacement - Predicted movement until next update, used to extend fat AABB
+	// @returns True if proxy was reinserted
+	bool MoveProxy(int proxyId, const RpgBoundingAABB& aabb, const RpgVector3& displacement) noexcept;
+
+	// Remove all proxies
+	void Clear() noexcept;
+
+
+	// Find every pair of proxies with overlapping fat AABBs by traversing tree against itself.
+	// Each pair is reported once (FirstProxy < SecondProxy), sorted by (FirstProxy, SecondProxy)
+	// @param out_Pairs - Output pairs, cleared before generating
+	// @returns None
+	void GeneratePairs(RpgArray<RpgPhysicsDynamicTree::FProxyPair>& out_Pairs) const noexcept;
+
+	// Find every pair of proxies with overlapping fat AABBs between this tree and <other> tree.
+	// FirstProxy is proxy of this tree, SecondProxy is proxy of <other> tree. Sorted by (FirstProxy, SecondProxy)
+	// @param other - Other tree, must not be this tree
+	// @param out_Pairs - Output pairs, cleared before generating
+	// @returns None
+	void GeneratePairs(const RpgPhysicsDynamicTree& other, RpgArray<RpgPhysicsDynamicTree::FProxyPair>& out_Pairs) const noexcept;
+
+
+	// Append nodes in depth-first order. Flattened copy can be traversed while this tree is modified
+	// @param out_Nodes - Output nodes, appended. Root is the first appended node
+	// @returns None
+	void Flatten(RpgArray<RpgPhysicsDynamicTree::FFlatNode>& out_Nodes) const noexcept;
+
+
+	// Call <callback>(proxyId) for every proxy with fat AABB overlapping <aabb> and category in <maskBits>. Return false from callback to stop query
+	// Read only, safe to call concurrently while tree is not modified
+	template<typename TCallback>
+	inline void QueryAABB(const RpgBoundingAABB& aabb, TCallback callback, uint32_t maskBits = UINT32_MAX) const noexcept
+	{
+		if (RootIndex == RPG_INDEX_INVALID)
+		{
+			return;
+		}
+
+		int stack[RPG_PHYSICS_DYNAMIC_TREE_STACK_SIZE];
+		int stackCount = 0;
+		stack[stackCount++] = RootIndex;
+
+		while (stackCount > 0)
+		{
+			const int index = stack[--stackCount];
+			const FNode& node = Nodes[index];
+
+			if ((node.CategoryBits & maskBits) == 0 || !TestOverlap(node.Aabb, aabb))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				if (!callback(index))
+				{
+					return;
+				}
+			}
+			else
+			{
+				RPG_Check(stackCount + 2 <= RPG_PHYSICS_DYNAMIC_TREE_STACK_SIZE);
+				stack[stackCount++] = node.Child1;
+				stack[stackCount++] = node.Child2;
+			}
+		}
+	}
+
+
+	[[nodiscard]] inline bool IsProxyValid(int proxyId) const noexcept
+	{
+		return Nodes.IsValid(proxyId) && Nodes[proxyId].IsLeaf();
+	}
+
+	[[nodiscard]] inline const RpgBoundingAABB& GetFatAABB(int proxyId) const noexcept
+	{
+		RPG_Check(IsProxyValid(proxyId));
+		return Nodes[proxyId].Aabb;
+	}
+
+	[[nodiscard]] inline uint32_t GetProxyCategoryBits(int proxyId) const noexcept
+	{
+		RPG_Check(IsProxyValid(proxyId));
+		return Nodes[proxyId].CategoryBits;
+	}
+
+	[[nodiscard]] inline uint32_t GetProxyMaskBits(int proxyId) const noexcept
+	{
+		RPG_Check(IsProxyValid(proxyId));
+		return Nodes[proxyId].MaskBits;
+	}
+
+	[[nodiscard]] inline int GetProxyCount() const noexcept
+	{
+		return ProxyCount;
+	}
+
+	[[nodiscard]] inline int GetNodeCount() const noexcept
+	{
+		return Nodes.GetCount();
+	}
+
+	[[nodiscard]] inline int GetHeight() const noexcept
+	{
+		return (RootIndex != RPG_INDEX_INVALID) ? Nodes[RootIndex].Height : 0;
+	}
+
+	// Sum of all node surface areas divided by root surface area. Lower is better
+	[[nodiscard]] float GetAreaRatio() const noexcept;
+
+
+#ifndef RPG_BUILD_SHIPPING
+	// Check parent links, heights and AABBs of every node
+	void Validate() const noexcept;
+#endif // !RPG_BUILD_SHIPPING
+
+
+private:
+	struct FNode
+	{
+		// Fat AABB for leaf, union of children for internal node
+		RpgBoundingAABB Aabb;
+
+		int Parent;
+		int Child1;
+		int Child2;
+
+		// Leaf = 0
+		int Height;
+
+		// Proxy bits for leaf, union of children for internal node
+		uint32_t CategoryBits;
+		uint32_t MaskBits;
+
+
+		inline bool IsLeaf() const noexcept
+		{
+			return Child1 == RPG_INDEX_INVALID;
+		}
+	};
+
+
+	static inline bool TestOverlap(const RpgBoundingAABB& a, const RpgBoundingAABB& b) noexcept
+	{
+		return !(a.Max.X < b.Min.X || a.Min.X > b.Max.X || a.Max.Y < b.Min.Y || a.Min.Y > b.Max.Y || a.Max.Z < b.Min.Z || a.Min.Z > b.Max.Z);
+	}
+
+	static inline bool TestFilter(const FNode& a, const FNode& b) noexcept
+	{
+		return (a.MaskBits & b.CategoryBits) != 0 && (b.MaskBits & a.CategoryBits) != 0;
+	}
+
+	// Traverse <treeA> against <treeB>. Pair key = (proxyA << 32) | proxyB. Same tree means pairs within that tree with proxyA < proxyB
+	static void GeneratePairKeys(const RpgPhysicsDynamicTree& treeA, const RpgPhysicsDynamicTree& treeB, RpgArray<uint64_t>& out_PairKeys) noexcept;
+
+
+	// @returns Index of flattened node
+	int FlattenNode(int index, RpgArray<RpgPhysicsDynamicTree::FFlatNode>& out_Nodes) const noexcept;
+
+	[[nodiscard]] int AllocateNode() noexcept;
+	void InsertLeaf(int leafIndex) noexcept;
+	void RemoveLeaf(int leafIndex) noexcept;
+
+	// Refit and rebalance ancestors starting from <index> up to root
+	void RefitAncestors(int index) noexcept;
+
+	// Swap child of <index> with grandchild from the other side when it reduces surface area of children
+	void RotateNodes(int index) noexcept;
+
+
+private:
+	RpgFreeList<FNode> Nodes;
+	int RootIndex;
+	int ProxyCount;
+	float AabbMargin;
+
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "RpgPhysicsTypes.h"
+
+
+
+// Shape geometry helpers shared by collision tests (RpgPhysicsCollision.cpp) and sweeps (RpgPhysicsTrace.cpp). Internal to physics module
+namespace RpgPhysicsGeometry
+{
+	// World axes and half extents of box
+	struct FBoxAxes
+	{
+		RpgVector3 Axes[3];
+		float HalfExtents[3];
+	};
+
+
+	[[nodiscard]] inline FBoxAxes GetBoxAxes(const RpgPhysicsCollision::FShape& box) noexcept
+	{
+		FBoxAxes axes;
+		axes.Axes[0] = RpgQuaternion::RotateVector(box.Rotation, RpgVector3::RIGHT);
+		axes.Axes[1] = RpgQuaternion::RotateVector(box.Rotation, RpgVector3::UP);
+		axes.Axes[2] = RpgQuaternion::RotateVector(box.Rotation, RpgVector3::FORWARD);
+		axes.HalfExtents[0] = box.Size.X;
+		axes.HalfExtents[1] = box.Size.Y;
+		axes.HalfExtents[2] = box.Size.Z;
+
+		return axes;
+	}
+
+
+	// Half length of box projected onto <axis>
+	[[nodiscard]] inline float GetBoxProjectionRadius(const FBoxAxes& box, const RpgVector3& axis) noexcept
+	{
+		return box.HalfExtents[0] * RpgMath::Abs(RpgVector3::DotProduct(box.Axes[0], axis))
+			+ box.HalfExtents[1] * RpgMath::Abs(RpgVector3::DotProduct(box.Axes[1], axis))
+			+ box.HalfExtents[2] * RpgMath::Abs(RpgVector3::DotProduct(box.Axes[2], axis));
+	}
+
+
+	// Capsule always along y-axis (see RpgPhysicsGJK::SupportCapsule)
+	inline void GetCapsuleSegment(const RpgVector3& center, float halfHeight, RpgVector3& out_Bottom, RpgVector3& out_Top) noexcept
+	{
+		out_Bottom = center + RpgVector3::DOWN * halfHeight;
+		out_Top = center + RpgVector3::UP * halfHeight;
+	}
+
+
+	inline void GetCapsuleSegment(const RpgPhysicsCollision::FShape& capsule, RpgVector3& out_Bottom, RpgVector3& out_Top) noexcept
+	{
+		GetCapsuleSegment(capsule.Center, capsule.Size.Y, out_Bottom, out_Top);
+	}
+
+
+	[[nodiscard]] inline RpgVector3 ClosestPointOnSegment(const RpgVector3& start, const RpgVector3& end, const RpgVector3& point) noexcept
+	{
+		const RpgVector3 direction = end - start;
+		const float lengthSqr = direction.GetMagnitudeSqr();
+
+		if (lengthSqr <= RPG_MATH_EPS_MP)
+		{
+			return start;
+		}
+
+		const float t = RpgMath::Clamp(RpgVector3::DotProduct(point - start, direction) / lengthSqr, 0.0f, 1.0f);
+
+		return start + direction * t;
+	}
+
+};
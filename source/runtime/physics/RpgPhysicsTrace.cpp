@@ -1,39 +1,1346 @@
-#include "RpgPhysicsTypes.h"
+#include "RpgPhysicsGeometry.h"
 #include "core/world/RpgWorld.h"
+#include "core/RpgProfiler.h"
+#include "world/RpgPhysicsWorldSubsystem.h"
+#include <immintrin.h>
+#include <bit>
+
+
+// Inverse direction of axis parallel line is clamped to stay finite. Slab test never multiplies zero by infinity
+#define RPG_PHYSICS_TRACE_INV_DIRECTION_MAX		(1e20f)
+
+#define RPG_PHYSICS_TRACE_SEGMENT_BOX_ITERATIONS	(24)
+
+
+
+namespace RpgPhysicsSweep
+{
+	// Sweep hit in sweep time [0, 1]
+	struct FSweepHit
+	{
+		float Time;
+
+		// Target surface normal, points toward moving shape
+		RpgVector3 Normal;
+
+		// Contact point on target surface
+		RpgVector3 Point;
+	};
+
+
+	using RpgPhysicsGeometry::FBoxAxes;
+	using RpgPhysicsGeometry::GetBoxAxes;
+	using RpgPhysicsGeometry::GetBoxProjectionRadius;
+	using RpgPhysicsGeometry::GetCapsuleSegment;
+	using RpgPhysicsGeometry::ClosestPointOnSegment;
+
+
+	static inline RpgVector3 GetBoxSupport(const RpgVector3& center, const FBoxAxes& box, const RpgVector3& direction) noexcept
+	{
+		RpgVector3 support = center;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			support += box.Axes[i] * ((RpgVector3::DotProduct(box.Axes[i], direction) >= 0.0f) ? box.HalfExtents[i] : -box.HalfExtents[i]);
+		}
+
+		return support;
+	}
+
+
+	// Closest point on box to point. Point inside box is returned as is
+	static inline RpgVector3 GetBoxClosestPoint(const RpgVector3& center, const FBoxAxes& box, const RpgVector3& point) noexcept
+	{
+		const RpgVector3 delta = point - center;
+		RpgVector3 closestPoint = center;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			closestPoint += box.Axes[i] * RpgMath::Clamp(RpgVector3::DotProduct(delta, box.Axes[i]), -box.HalfExtents[i], box.HalfExtents[i]);
+		}
+
+		return closestPoint;
+	}
+
+
+	// Closest point on segment to infinite line through <linePoint> along <lineDirection>
+	static inline RpgVector3 ClosestPointOnSegmentToLine(const RpgVector3& start, const RpgVector3& end, const RpgVector3& linePoint, const RpgVector3& lineDirection) noexcept
+	{
+		const RpgVector3 direction = end - start;
+		const RpgVector3 r = start - linePoint;
+		const float a = RpgVector3::DotProduct(direction, direction);
+		const float b = RpgVector3::DotProduct(direction, lineDirection);
+		const float c = RpgVector3::DotProduct(direction, r);
+		const float e = RpgVector3::DotProduct(lineDirection, lineDirection);
+		const float f = RpgVector3::DotProduct(lineDirection, r);
+		const float denom = a * e - b * b;
+
+		// Parallel, any point is closest
+		const float t = (denom > RPG_MATH_EPS_MP) ? RpgMath::Clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+
+		return start + direction * t;
+	}
+
+
+	// Closest point on sphere to point. Point inside sphere is returned as is
+	static inline RpgVector3 GetSphereClosestPoint(const RpgVector3& center, float radius, const RpgVector3& point) noexcept
+	{
+		const RpgVector3 offset = point - center;
+		const float distanceSqr = offset.GetMagnitudeSqr();
+
+		return (distanceSqr > radius * radius) ? center + offset * (radius / RpgMath::Sqrt(distanceSqr)) : point;
+	}
+
+
+	// Normal reported by shape that already overlaps at sweep start, opposite of sweep direction
+	static inline RpgVector3 GetStartOverlapNormal(const RpgVector3& delta) noexcept
+	{
+		const float lengthSqr = delta.GetMagnitudeSqr();
+
+		return (lengthSqr > RPG_MATH_EPS_MP) ? delta * (-1.0f / RpgMath::Sqrt(lengthSqr)) : RpgVector3::UP;
+	}
+
+
+	static inline float GetInverse(float value) noexcept
+	{
+		if (RpgMath::Abs(value) > 1.0f / RPG_PHYSICS_TRACE_INV_DIRECTION_MAX)
+		{
+			return 1.0f / value;
+		}
+
+		return (value >= 0.0f) ? RPG_PHYSICS_TRACE_INV_DIRECTION_MAX : -RPG_PHYSICS_TRACE_INV_DIRECTION_MAX;
+	}
+
+
+	// Radius of sphere swept by moving shape. Line (SHAPE_NONE) is sphere with zero radius
+	static inline float GetSweepRadius(const RpgPhysicsCollision::FShape& shape) noexcept
+	{
+		return (shape.Type == RpgPhysicsCollision::SHAPE_NONE) ? 0.0f : shape.Size.X;
+	}
+
+
+
+	// Ray (origin + delta * t) against sphere
+	static bool RaySphere(const RpgVector3& origin, const RpgVector3& delta, const RpgVector3& center, float radius, float& out_Time, RpgVector3& out_Normal) noexcept
+	{
+		const RpgVector3 m = origin - center;
+		const float c = RpgVector3::DotProduct(m, m) - radius * radius;
+
+		if (c <= 0.0f)
+		{
+			out_Time = 0.0f;
+			out_Normal = GetStartOverlapNormal(delta);
+
+			return true;
+		}
+
+		const float a = RpgVector3::DotProduct(delta, delta);
+		const float b = RpgVector3::DotProduct(m, delta);
+
+		// Not moving or moving away
+		if (a <= RPG_MATH_EPS_MP || b >= 0.0f)
+		{
+			return false;
+		}
+
+		const float discriminant = b * b - a * c;
+
+		if (discriminant < 0.0f)
+		{
+			return false;
+		}
+
+		const float t = (-b - RpgMath::Sqrt(discriminant)) / a;
+
+		if (t > 1.0f)
+		{
+			return false;
+		}
+
+		out_Time = RpgMath::Max(t, 0.0f);
+		out_Normal = (m + delta * out_Time).GetNormalize();
+
+		return true;
+	}
+
+
+	// Ray (origin + delta * t) against capsule of segment (bottom, top). Tests cylinder body, then both end spheres
+	static bool RayCapsule(const RpgVector3& origin, const RpgVector3& delta, const RpgVector3& bottom, const RpgVector3& top, float radius, float& out_Time, RpgVector3& out_Normal) noexcept
+	{
+		const RpgVector3 closestPoint = ClosestPointOnSegment(bottom, top, origin);
+
+		if ((origin - closestPoint).GetMagnitudeSqr() <= radius * radius)
+		{
+			out_Time = 0.0f;
+			out_Normal = GetStartOverlapNormal(delta);
+
+			return true;
+		}
+
+		bool bHit = false;
+		out_Time = FLT_MAX;
+
+		const RpgVector3 u = top - bottom;
+		const RpgVector3 m = origin - bottom;
+		const float dd = RpgVector3::DotProduct(u, u);
+
+		if (dd > RPG_MATH_EPS_MP)
+		{
+			const float md = RpgVector3::DotProduct(m, u);
+			const float nd = RpgVector3::DotProduct(delta, u);
+			const float a = dd * RpgVector3::DotProduct(delta, delta) - nd * nd;
+
+			// Ray parallel to axis enters through end spheres only
+			if (a > RPG_MATH_EPS_MP)
+			{
+				const float b = dd * RpgVector3::DotProduct(m, delta) - nd * md;
+				const float c = dd * (RpgVector3::DotProduct(m, m) - radius * radius) - md * md;
+				const float discriminant = b * b - a * c;
+
+				if (discriminant >= 0.0f)
+				{
+					const float t = (-b - RpgMath::Sqrt(discriminant)) / a;
+					const float s = md + nd * t;
+
+					if (t >= 0.0f && t <= 1.0f && s >= 0.0f && s <= dd)
+					{
+						const RpgVector3 hitLocation = origin + delta * t;
+						out_Time = t;
+						out_Normal = (hitLocation - (bottom + u * (s / dd))).GetNormalize();
+						bHit = true;
+					}
+				}
+			}
+		}
+
+		float sphereTime;
+		RpgVector3 sphereNormal;
+
+		if (RaySphere(origin, delta, bottom, radius, sphereTime, sphereNormal) && sphereTime < out_Time)
+		{
+			out_Time = sphereTime;
+			out_Normal = sphereNormal;
+			bHit = true;
+		}
+
+		if (RaySphere(origin, delta, top, radius, sphereTime, sphereNormal) && sphereTime < out_Time)
+		{
+			out_Time = sphereTime;
+			out_Normal = sphereNormal;
+			bHit = true;
+		}
+
+		return bHit;
+	}
+
+
+	// Ray (origin + delta * t) against box rounded by radius (box minkowski sum sphere). Ray against box expanded by radius, hit in edge or corner region is resolved against edge capsules
+	static bool RayRoundedBox(const RpgVector3& origin, const RpgVector3& delta, const RpgVector3& center, const FBoxAxes& box, float radius, FSweepHit& out_Hit) noexcept
+	{
+		const RpgVector3 closestPoint = GetBoxClosestPoint(center, box, origin);
+
+		if ((origin - closestPoint).GetMagnitudeSqr() <= radius * radius)
+		{
+			out_Hit.Time = 0.0f;
+			out_Hit.Normal = GetStartOverlapNormal(delta);
+			out_Hit.Point = closestPoint;
+
+			return true;
+		}
+
+		const RpgVector3 originDelta = origin - center;
+		float localOrigin[3];
+		float localDelta[3];
+		float enterTime = -FLT_MAX;
+		float exitTime = FLT_MAX;
+		int enterAxis = RPG_INDEX_INVALID;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			localOrigin[i] = RpgVector3::DotProduct(originDelta, box.Axes[i]);
+			localDelta[i] = RpgVector3::DotProduct(delta, box.Axes[i]);
+			const float extent = box.HalfExtents[i] + radius;
+
+			if (RpgMath::Abs(localDelta[i]) <= RPG_MATH_EPS_MP)
+			{
+				if (RpgMath::Abs(localOrigin[i]) > extent)
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			const float inverse = 1.0f / localDelta[i];
+			const float t1 = (-extent - localOrigin[i]) * inverse;
+			const float t2 = (extent - localOrigin[i]) * inverse;
+			const float nearTime = RpgMath::Min(t1, t2);
+
+			if (nearTime > enterTime)
+			{
+				enterTime = nearTime;
+				enterAxis = i;
+			}
+
+			exitTime = RpgMath::Min(exitTime, RpgMath::Max(t1, t2));
+
+			if (enterTime > exitTime || exitTime < 0.0f)
+			{
+				return false;
+			}
+		}
+
+		if (enterTime > 1.0f)
+		{
+			return false;
+		}
+
+		// Origin outside box but inside expanded box can only be in edge or corner region
+		bool bFaceRegion = (enterAxis != RPG_INDEX_INVALID && enterTime >= 0.0f);
+
+		if (bFaceRegion)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				if (i != enterAxis && RpgMath::Abs(localOrigin[i] + localDelta[i] * enterTime) > box.HalfExtents[i])
+				{
+					bFaceRegion = false;
+					break;
+				}
+			}
+		}
+
+		if (bFaceRegion)
+		{
+			const float side = (localOrigin[enterAxis] + localDelta[enterAxis] * enterTime >= 0.0f) ? 1.0f : -1.0f;
+			out_Hit.Time = enterTime;
+			out_Hit.Normal = box.Axes[enterAxis] * side;
+			out_Hit.Point = origin + delta * enterTime - out_Hit.Normal * radius;
+
+			return true;
+		}
+
+		// Rounded edges and corners are union of 12 edge capsules
+		bool bHit = false;
+		out_Hit.Time = FLT_MAX;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const int j = (i + 1) % 3;
+			const int k = (i + 2) % 3;
+			const RpgVector3 edgeHalf = box.Axes[i] * box.HalfExtents[i];
+
+			for (int e = 0; e < 4; ++e)
+			{
+				const float signJ = (e & 1) ? 1.0f : -1.0f;
+				const float signK = (e & 2) ? 1.0f : -1.0f;
+				const RpgVector3 edgeCenter = center + box.Axes[j] * (box.HalfExtents[j] * signJ) + box.Axes[k] * (box.HalfExtents[k] * signK);
+
+				float time;
+				RpgVector3 normal;
+
+				if (RayCapsule(origin, delta, edgeCenter - edgeHalf, edgeCenter + edgeHalf, radius, time, normal) && time < out_Hit.Time)
+				{
+					out_Hit.Time = time;
+					out_Hit.Normal = normal;
+					bHit = true;
+				}
+			}
+		}
+
+		if (bHit)
+		{
+			out_Hit.Point = origin + delta * out_Hit.Time - out_Hit.Normal * radius;
+		}
+
+		return bHit;
+	}
+
+
+	// Distance between segment and box, 0 if segment touches box. Distance to convex box is convex along segment, solved by ternary search
+	static float GetSegmentBoxDistance(const RpgVector3& start, const RpgVector3& end, const RpgVector3& center, const FBoxAxes& box, RpgVector3& out_SegmentPoint, RpgVector3& out_BoxPoint) noexcept
+	{
+		const RpgVector3 direction = end - start;
+		float low = 0.0f;
+		float high = 1.0f;
+
+		for (int i = 0; i < RPG_PHYSICS_TRACE_SEGMENT_BOX_ITERATIONS; ++i)
+		{
+			const float t1 = low + (high - low) / 3.0f;
+			const float t2 = high - (high - low) / 3.0f;
+			const RpgVector3 p1 = start + direction * t1;
+			const RpgVector3 p2 = start + direction * t2;
+
+			if ((p1 - GetBoxClosestPoint(center, box, p1)).GetMagnitudeSqr() <= (p2 - GetBoxClosestPoint(center, box, p2)).GetMagnitudeSqr())
+			{
+				high = t2;
+			}
+			else
+			{
+				low = t1;
+			}
+		}
+
+		out_SegmentPoint = start + direction * ((low + high) * 0.5f);
+		out_BoxPoint = GetBoxClosestPoint(center, box, out_SegmentPoint);
+
+		return (out_SegmentPoint - out_BoxPoint).GetMagnitude();
+	}
+
+
+
+	typedef bool(*FSweepFunction)(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit);
+
+
+	// Sweep target by -delta against shape at start, then convert hit back. Sweep time is the same for both
+	static inline bool SweepReversed(FSweepFunction function, const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit) noexcept
+	{
+		RpgPhysicsCollision::FShape staticShape = shape;
+		staticShape.Center = start;
+
+		if (!function(target, target.Center, -delta, staticShape, out_Hit))
+		{
+			return false;
+		}
+
+		out_Hit.Normal = -out_Hit.Normal;
+		out_Hit.Point += delta * out_Hit.Time;
+
+		return true;
+	}
+
+
+	// Sphere (or line) against sphere is line against sphere with sum of radius
+	static bool SphereSphere(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		const float radius = GetSweepRadius(shape);
+
+		if (!RaySphere(start, delta, target.Center, radius + target.Size.X, out_Hit.Time, out_Hit.Normal))
+		{
+			return false;
+		}
+
+		out_Hit.Point = GetSphereClosestPoint(target.Center, target.Size.X, start + delta * out_Hit.Time);
+
+		return true;
+	}
+
+
+	static bool SphereBox(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		return RayRoundedBox(start, delta, target.Center, GetBoxAxes(target), GetSweepRadius(shape), out_Hit);
+	}
+
+
+	// Sphere (or line) against capsule is line against capsule with sum of radius
+	static bool SphereCapsule(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		const float radius = GetSweepRadius(shape);
+
+		RpgVector3 bottom, top;
+		GetCapsuleSegment(target.Center, target.Size.Y, bottom, top);
+
+		if (!RayCapsule(start, delta, bottom, top, radius + target.Size.X, out_Hit.Time, out_Hit.Normal))
+		{
+			return false;
+		}
+
+		const RpgVector3 hitLocation = start + delta * out_Hit.Time;
+		out_Hit.Point = GetSphereClosestPoint(ClosestPointOnSegment(bottom, top, hitLocation), target.Size.X, hitLocation);
+
+		return true;
+	}
+
+
+	static bool BoxSphere(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		return SweepReversed(SphereBox, shape, start, delta, target, out_Hit);
+	}
+
+
+	// Separating axis test over time. Each of 15 axes gives interval of time when projections overlap, boxes touch at the latest entry time
+	static bool BoxBox(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		const FBoxAxes movingBox = GetBoxAxes(shape);
+		const FBoxAxes targetBox = GetBoxAxes(target);
+
+		// Index of box axis (or edge direction) that makes each separating axis, RPG_INDEX_INVALID if not used
+		RpgVector3 axes[15];
+		int movingAxes[15];
+		int targetAxes[15];
+		int axisCount = 0;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			axes[axisCount] = movingBox.Axes[i];
+			movingAxes[axisCount] = i;
+			targetAxes[axisCount++] = RPG_INDEX_INVALID;
+
+			axes[axisCount] = targetBox.Axes[i];
+			movingAxes[axisCount] = RPG_INDEX_INVALID;
+			targetAxes[axisCount++] = i;
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				const RpgVector3 axis = RpgVector3::CrossProduct(movingBox.Axes[i], targetBox.Axes[j]);
+				const float lengthSqr = axis.GetMagnitudeSqr();
+
+				// Parallel edges, covered by face axes
+				if (lengthSqr > RPG_MATH_EPS_LP)
+				{
+					axes[axisCount] = axis * (1.0f / RpgMath::Sqrt(lengthSqr));
+					movingAxes[axisCount] = i;
+					targetAxes[axisCount++] = j;
+				}
+			}
+		}
+
+		const RpgVector3 centerDelta = start - target.Center;
+		float enterTime = -FLT_MAX;
+		float exitTime = FLT_MAX;
+		RpgVector3 enterNormal;
+		int enterAxis = RPG_INDEX_INVALID;
+
+		for (int a = 0; a < axisCount; ++a)
+		{
+			const RpgVector3& axis = axes[a];
+			const float distance = RpgVector3::DotProduct(centerDelta, axis);
+			const float speed = RpgVector3::DotProduct(delta, axis);
+			const float radius = GetBoxProjectionRadius(movingBox, axis) + GetBoxProjectionRadius(targetBox, axis);
+
+			if (RpgMath::Abs(speed) <= RPG_MATH_EPS_MP)
+			{
+				if (RpgMath::Abs(distance) > radius)
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			const float t1 = (-radius - distance) / speed;
+			const float t2 = (radius - distance) / speed;
+			const float nearTime = RpgMath::Min(t1, t2);
+
+			if (nearTime > enterTime)
+			{
+				enterTime = nearTime;
+				enterAxis = a;
+
+				// Moving box enters from negative side if moving along axis
+				enterNormal = (speed > 0.0f) ? -axis : axis;
+			}
+
+			exitTime = RpgMath::Min(exitTime, RpgMath::Max(t1, t2));
+
+			if (enterTime > exitTime || exitTime < 0.0f || enterTime > 1.0f)
+			{
+				return false;
+			}
+		}
+
+		if (enterTime <= 0.0f)
+		{
+			out_Hit.Time = 0.0f;
+			out_Hit.Normal = GetStartOverlapNormal(delta);
+			out_Hit.Point = GetBoxClosestPoint(target.Center, targetBox, start);
+
+			return true;
+		}
+
+		out_Hit.Time = enterTime;
+		out_Hit.Normal = enterNormal;
+
+		const RpgVector3 movingCenter = start + delta * enterTime;
+		const int movingAxis = movingAxes[enterAxis];
+		const int targetAxis = targetAxes[enterAxis];
+
+		if (movingAxis == RPG_INDEX_INVALID)
+		{
+			// Target face, moving vertex touches it
+			out_Hit.Point = GetBoxClosestPoint(target.Center, targetBox, GetBoxSupport(movingCenter, movingBox, -enterNormal));
+		}
+		else if (targetAxis == RPG_INDEX_INVALID)
+		{
+			// Moving face, target vertex touches it
+			out_Hit.Point = GetBoxSupport(target.Center, targetBox, enterNormal);
+		}
+		else
+		{
+			// Edge - edge, point on target edge closest to moving edge
+			const RpgVector3 targetSupport = GetBoxSupport(target.Center, targetBox, enterNormal);
+			const RpgVector3 targetEdge = targetBox.Axes[targetAxis];
+			const RpgVector3 targetEdgeCenter = targetSupport - targetEdge * RpgVector3::DotProduct(targetSupport - target.Center, targetEdge);
+			const RpgVector3 targetEdgeHalf = targetEdge * targetBox.HalfExtents[targetAxis];
+
+			out_Hit.Point = ClosestPointOnSegmentToLine(targetEdgeCenter - targetEdgeHalf, targetEdgeCenter + targetEdgeHalf, GetBoxSupport(movingCenter, movingBox, -enterNormal), movingBox.Axes[movingAxis]);
+		}
+
+		return true;
+	}
+
+
+	// Conservative advancement. Plane at closest point separates both shapes, capsule is advanced until it reaches that plane
+	static bool CapsuleBox(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		const FBoxAxes targetBox = GetBoxAxes(target);
+		const float radius = shape.Size.X;
+		float time = 0.0f;
+
+		for (int i = 0; i < RPG_PHYSICS_TRACE_SWEEP_MAX_ITERATIONS; ++i)
+		{
+			RpgVector3 bottom, top;
+			GetCapsuleSegment(start + delta * time, shape.Size.Y, bottom, top);
+
+			RpgVector3 segmentPoint, boxPoint;
+			const float distance = GetSegmentBoxDistance(bottom, top, target.Center, targetBox, segmentPoint, boxPoint) - radius;
+
+			if (distance <= 0.0f && time == 0.0f)
+			{
+				out_Hit.Time = 0.0f;
+				out_Hit.Normal = GetStartOverlapNormal(delta);
+				out_Hit.Point = boxPoint;
+
+				return true;
+			}
+
+			const RpgVector3 normal = (segmentPoint - boxPoint).GetNormalize();
+
+			if (distance <= RPG_PHYSICS_TRACE_SWEEP_TOLERANCE)
+			{
+				out_Hit.Time = time;
+				out_Hit.Normal = normal;
+				out_Hit.Point = boxPoint;
+
+				return true;
+			}
+
+			const float approachSpeed = -RpgVector3::DotProduct(delta, normal);
+
+			if (approachSpeed <= RPG_MATH_EPS_MP)
+			{
+				return false;
+			}
+
+			time += distance / approachSpeed;
+
+			if (time > 1.0f)
+			{
+				return false;
+			}
+		}
+
+		return false;
+	}
+
+
+	// Both capsules are along y-axis, minkowski sum is capsule with sum of half height and sum of radius
+	static bool CapsuleCapsule(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		RpgVector3 bottom, top;
+		GetCapsuleSegment(target.Center, shape.Size.Y + target.Size.Y, bottom, top);
+
+		if (!RayCapsule(start, delta, bottom, top, shape.Size.X + target.Size.X, out_Hit.Time, out_Hit.Normal))
+		{
+			return false;
+		}
+
+		RpgVector3 targetBottom, targetTop;
+		GetCapsuleSegment(target.Center, target.Size.Y, targetBottom, targetTop);
+
+		const RpgVector3 hitLocation = start + delta * out_Hit.Time;
+		const RpgVector3 axisPoint = ClosestPointOnSegment(targetBottom, targetTop, ClosestPointOnSegment(bottom, top, hitLocation));
+		out_Hit.Point = axisPoint + out_Hit.Normal * target.Size.X;
+
+		return true;
+	}
+
+
+	static bool BoxCapsule(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		return SweepReversed(CapsuleBox, shape, start, delta, target, out_Hit);
+	}
+
+
+	static bool CapsuleSphere(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsCollision::FShape& target, FSweepHit& out_Hit)
+	{
+		return SweepReversed(SphereCapsule, shape, start, delta, target, out_Hit);
+	}
+
+
+	// Indexed by [moving shape][target shape]. Line (SHAPE_NONE) sweeps as sphere with zero radius
+	static const FSweepFunction SWEEP_FUNCTIONS[RpgPhysicsCollision::SHAPE_MAX_COUNT][RpgPhysicsCollision::SHAPE_MAX_COUNT] =
+	{
+		//	NONE		SPHERE			BOX				CAPSULE			MESH_CONVEX		MESH_TRIANGLE
+		{	nullptr,	SphereSphere,	SphereBox,		SphereCapsule,	nullptr,		nullptr	},	// NONE
+		{	nullptr,	SphereSphere,	SphereBox,		SphereCapsule,	nullptr,		nullptr	},	// SPHERE
+		{	nullptr,	BoxSphere,		BoxBox,			BoxCapsule,		nullptr,		nullptr	},	// BOX
+		{	nullptr,	CapsuleSphere,	CapsuleBox,		CapsuleCapsule,	nullptr,		nullptr	},	// CAPSULE
+		{	nullptr,	nullptr,		nullptr,		nullptr,		nullptr,		nullptr	},	// MESH_CONVEX
+		{	nullptr,	nullptr,		nullptr,		nullptr,		nullptr,		nullptr	},	// MESH_TRIANGLE
+	};
+	static_assert(RpgPhysicsCollision::SHAPE_MAX_COUNT == 6, "RpgPhysicsSweep: Update SWEEP_FUNCTIONS!");
+
+};
+
+
+
+namespace RpgPhysicsTraceScene
+{
+	// Sweep along origin + delta * t, t in [0, 1]. Node AABB is expanded by extent of swept shape
+	struct FQuery
+	{
+		RpgVector3 Origin;
+		RpgVector3 Delta;
+		float InvDelta[3];
+		float Extent[3];
+		RpgPhysicsCollision::FChannelMask TraceBit;
+	};
+
+
+	static inline FQuery MakeQuery(const RpgVector3& origin, const RpgVector3& delta, const RpgVector3& extent, RpgPhysicsCollision::EChannel channel) noexcept
+	{
+		FQuery query;
+		query.Origin = origin;
+		query.Delta = delta;
+		query.InvDelta[0] = RpgPhysicsSweep::GetInverse(delta.X);
+		query.InvDelta[1] = RpgPhysicsSweep::GetInverse(delta.Y);
+		query.InvDelta[2] = RpgPhysicsSweep::GetInverse(delta.Z);
+		query.Extent[0] = extent.X;
+		query.Extent[1] = extent.Y;
+		query.Extent[2] = extent.Z;
+		query.TraceBit = RpgPhysicsCollision::GetChannelBit(channel);
+
+		return query;
+	}
+
+
+	// Half extents of world AABB of shape
+	static inline RpgVector3 GetShapeExtent(const RpgPhysicsCollision::FShape& shape) noexcept
+	{
+		switch (shape.Type)
+		{
+			case RpgPhysicsCollision::SHAPE_SPHERE:
+				return RpgVector3(shape.Size.X);
+
+			case RpgPhysicsCollision::SHAPE_CAPSULE:
+				return RpgVector3(shape.Size.X, shape.Size.X + shape.Size.Y, shape.Size.X);
+
+			case RpgPhysicsCollision::SHAPE_BOX:
+			{
+				const RpgPhysicsGeometry::FBoxAxes box = RpgPhysicsGeometry::GetBoxAxes(shape);
+				return RpgVector3(
+					RpgPhysicsGeometry::GetBoxProjectionRadius(box, RpgVector3::RIGHT),
+					RpgPhysicsGeometry::GetBoxProjectionRadius(box, RpgVector3::UP),
+					RpgPhysicsGeometry::GetBoxProjectionRadius(box, RpgVector3::FORWARD)
+				);
+			}
+
+			default:
+				break;
+		}
+
+		return RpgVector3::ZERO;
+	}
+
+
+	static inline bool TestQueryAABB(const FQuery& query, const RpgBoundingAABB& aabb, float maxTime) noexcept
+	{
+		const float origin[3] = { query.Origin.X, query.Origin.Y, query.Origin.Z };
+		const float minBound[3] = { aabb.Min.X, aabb.Min.Y, aabb.Min.Z };
+		const float maxBound[3] = { aabb.Max.X, aabb.Max.Y, aabb.Max.Z };
+		float enterTime = 0.0f;
+		float exitTime = maxTime;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const float t1 = (minBound[i] - query.Extent[i] - origin[i]) * query.InvDelta[i];
+			const float t2 = (maxBound[i] + query.Extent[i] - origin[i]) * query.InvDelta[i];
+			enterTime = RpgMath::Max(enterTime, RpgMath::Min(t1, t2));
+			exitTime = RpgMath::Min(exitTime, RpgMath::Max(t1, t2));
+		}
+
+		return enterTime <= exitTime;
+	}
+
+
+	static inline bool IsNodeFiltered(const RpgPhysicsDynamicTree::FFlatNode& node, RpgPhysicsCollision::FChannelMask traceBit) noexcept
+	{
+		return traceBit != 0 && (node.MaskBits & traceBit) == 0;
+	}
+
+
+	// Call <callback>(objectIndex) for every object whose AABB is touched by query before <inout_MaxTime>. Callback may shorten <inout_MaxTime>
+	template<typename TCallback>
+	static void Traverse(const RpgPhysicsTrace::FScene& scene, const FQuery& query, float& inout_MaxTime, TCallback callback) noexcept
+	{
+		int stack[RPG_PHYSICS_DYNAMIC_TREE_STACK_SIZE];
+
+		for (int r = 0; r < scene.Roots.GetCount(); ++r)
+		{
+			int stackCount = 0;
+			stack[stackCount++] = scene.Roots[r];
+
+			while (stackCount > 0)
+			{
+				const int nodeIndex = stack[--stackCount];
+				const RpgPhysicsDynamicTree::FFlatNode& node = scene.Nodes[nodeIndex];
+
+				if (IsNodeFiltered(node, query.TraceBit) || !TestQueryAABB(query, node.Aabb, inout_MaxTime))
+				{
+					continue;
+				}
+
+				if (node.IsLeaf())
+				{
+					callback(node.ProxyId);
+				}
+				else
+				{
+					RPG_Check(stackCount + 2 <= RPG_PHYSICS_DYNAMIC_TREE_STACK_SIZE);
+					stack[stackCount++] = node.SecondChild;
+					stack[stackCount++] = nodeIndex + 1;
+				}
+			}
+		}
+	}
+
+
+	static inline RpgPhysicsCollision::EResponse GetResponse(const RpgPhysicsTrace::FSceneObject& object, const RpgPhysicsTrace::FOption& option, RpgPhysicsCollision::FChannelMask traceBit) noexcept
+	{
+		if (option.IgnoredGameObjects.FindIndexByValue(object.GameObject) != RPG_INDEX_INVALID)
+		{
+			return RpgPhysicsCollision::RESPONSE_IGNORE;
+		}
+
+		if (traceBit == 0 || (object.FilterMask.BlockMask & traceBit))
+		{
+			return RpgPhysicsCollision::RESPONSE_BLOCK;
+		}
+
+		return (object.FilterMask.ResponseMask & traceBit) ? RpgPhysicsCollision::RESPONSE_OVERLAP : RpgPhysicsCollision::RESPONSE_IGNORE;
+	}
+
+
+	static inline void SetResultObject(RpgPhysicsTrace::FResult& out_Result, const RpgPhysicsTrace::FScene& scene, int objectIndex, bool bBlockingHit) noexcept
+	{
+		const RpgPhysicsTrace::FSceneObject& object = scene.Objects[objectIndex];
+		out_Result.GameObject = object.GameObject;
+		out_Result.ObjectIndex = objectIndex;
+		out_Result.bBlockingHit = bBlockingHit;
+	}
+
+
+	// Insert result sorted by <less>. Full array drops its last result
+	template<typename TLess>
+	static void InsertSorted(RpgPhysicsTrace::FResultArray& results, const RpgPhysicsTrace::FResult& result, TLess less) noexcept
+	{
+		int index = results.GetCount();
+
+		while (index > 0 && less(result, results[index - 1]))
+		{
+			--index;
+		}
+
+		if (index >= results.GetCapacity())
+		{
+			return;
+		}
+
+		if (results.GetCount() < results.GetCapacity())
+		{
+			results.Add();
+		}
+
+		for (int i = results.GetCount() - 1; i > index; --i)
+		{
+			results[i] = results[i - 1];
+		}
+
+		results[index] = result;
+	}
+
+
+	static inline bool IsNearer(const RpgPhysicsTrace::FResult& a, const RpgPhysicsTrace::FResult& b) noexcept
+	{
+		return a.Distance < b.Distance;
+	}
+
+
+	static inline bool IsDeeper(const RpgPhysicsTrace::FResult& a, const RpgPhysicsTrace::FResult& b) noexcept
+	{
+		return a.Distance > b.Distance;
+	}
+
+
+	static bool SweepObject(const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsTrace::FSceneObject& object, RpgPhysicsSweep::FSweepHit& out_Hit) noexcept
+	{
+		const RpgPhysicsSweep::FSweepFunction function = RpgPhysicsSweep::SWEEP_FUNCTIONS[shape.Type][object.Shape.Type];
+
+		return function ? function(shape, start, delta, object.Shape, out_Hit) : false;
+	}
+
+
+	static inline void SetResultHit(RpgPhysicsTrace::FResult& out_Result, const RpgVector3& start, const RpgVector3& delta, const RpgPhysicsSweep::FSweepHit& hit) noexcept
+	{
+		out_Result.HitLocation = start + delta * hit.Time;
+		out_Result.ContactLocation = hit.Point;
+		out_Result.ContactNormal = hit.Normal;
+		out_Result.Distance = delta.GetMagnitude() * hit.Time;
+	}
+
+
+	static RpgPhysicsTrace::FResult SweepOne(const RpgPhysicsTrace::FScene& scene, const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& end, const RpgPhysicsTrace::FOption& option) noexcept
+	{
+		const RpgVector3 delta = end - start;
+		const FQuery query = MakeQuery(start, delta, GetShapeExtent(shape), option.Channel);
+
+		RpgPhysicsTrace::FResult result;
+		RpgPhysicsSweep::FSweepHit bestHit;
+		float maxTime = 1.0f;
+
+		Traverse(scene, query, maxTime,
+			[&](int objectIndex)
+			{
+				const RpgPhysicsTrace::FSceneObject& object = scene.Objects[objectIndex];
+				RpgPhysicsSweep::FSweepHit hit;
+
+				if (GetResponse(object, option, query.TraceBit) == RpgPhysicsCollision::RESPONSE_BLOCK && SweepObject(shape, start, delta, object, hit) && hit.Time < maxTime)
+				{
+					maxTime = hit.Time;
+					bestHit = hit;
+					SetResultObject(result, scene, objectIndex, true);
+				}
+			}
+		);
+
+		if (result.IsHit())
+		{
+			SetResultHit(result, start, delta, bestHit);
+		}
+
+		return result;
+	}
+
+
+	static RpgPhysicsTrace::FResultArray SweepMany(const RpgPhysicsTrace::FScene& scene, const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& end, const RpgPhysicsTrace::FOption& option) noexcept
+	{
+		const RpgVector3 delta = end - start;
+		const FQuery query = MakeQuery(start, delta, GetShapeExtent(shape), option.Channel);
+
+		RpgPhysicsTrace::FResultArray results;
+		RpgPhysicsTrace::FResult blockResult;
+		float maxTime = 1.0f;
+
+		Traverse(scene, query, maxTime,
+			[&](int objectIndex)
+			{
+				const RpgPhysicsTrace::FSceneObject& object = scene.Objects[objectIndex];
+				const RpgPhysicsCollision::EResponse response = GetResponse(object, option, query.TraceBit);
+				RpgPhysicsSweep::FSweepHit hit;
+
+				if (response == RpgPhysicsCollision::RESPONSE_IGNORE || !SweepObject(shape, start, delta, object, hit) || hit.Time > maxTime)
+				{
+					return;
+				}
+
+				RpgPhysicsTrace::FResult result;
+				SetResultObject(result, scene, objectIndex, response == RpgPhysicsCollision::RESPONSE_BLOCK);
+				SetResultHit(result, start, delta, hit);
+
+				if (result.bBlockingHit)
+				{
+					if (hit.Time < maxTime || !blockResult.IsHit())
+					{
+						maxTime = hit.Time;
+						blockResult = result;
+					}
+				}
+				else
+				{
+					InsertSorted(results, result, IsNearer);
+				}
+			}
+		);
+
+		if (blockResult.IsHit())
+		{
+			// Overlaps collected before blocking hit was found may be behind it
+			while (results.GetCount() > 0 && results[results.GetCount() - 1].Distance > blockResult.Distance)
+			{
+				results.RemoveAt(results.GetCount() - 1);
+			}
+
+			if (results.GetCount() == results.GetCapacity())
+			{
+				results.RemoveAt(results.GetCount() - 1);
+			}
+
+			results.AddValue(blockResult);
+		}
+
+		return results;
+	}
+
+
+	// Traverse overlap query as sweep without movement, node test is AABB test
+	template<typename TCallback>
+	static void OverlapSphere(const RpgPhysicsTrace::FScene& scene, const RpgVector3& center, float radius, const RpgPhysicsTrace::FOption& option, TCallback callback) noexcept
+	{
+		const FQuery query = MakeQuery(center, RpgVector3::ZERO, RpgVector3(radius), option.Channel);
+
+		RpgPhysicsCollision::FShape sphere;
+		sphere.Center = center;
+		sphere.Size = RpgVector4(radius);
+		sphere.Type = RpgPhysicsCollision::SHAPE_SPHERE;
+
+		float maxTime = 1.0f;
+
+		Traverse(scene, query, maxTime,
+			[&](int objectIndex)
+			{
+				const RpgPhysicsTrace::FSceneObject& object = scene.Objects[objectIndex];
+				const RpgPhysicsCollision::EResponse response = GetResponse(object, option, query.TraceBit);
+				RpgPhysicsCollision::FContactResult contact;
+
+				if (response == RpgPhysicsCollision::RESPONSE_IGNORE || !RpgPhysicsCollision::Narrowphase::TestOverlap(sphere, object.Shape, &contact))
+				{
+					return;
+				}
+
+				RpgPhysicsTrace::FResult result;
+				SetResultObject(result, scene, objectIndex, response == RpgPhysicsCollision::RESPONSE_BLOCK);
+				result.HitLocation = center;
+				result.ContactLocation = contact.ContactPoint;
+				result.ContactNormal = -contact.SeparationDirection;
+				result.Distance = contact.PenetrationDepth;
+
+				callback(result);
+			}
+		);
+	}
+
+
+
+	// 4 lines in SIMD lanes
+	struct FPacket4
+	{
+		__m128 OriginX;
+		__m128 OriginY;
+		__m128 OriginZ;
+		__m128 InvDeltaX;
+		__m128 InvDeltaY;
+		__m128 InvDeltaZ;
+		__m128 MaxTime;
+	};
+
+
+	// @returns Bit mask of lanes that hit AABB before their max time
+	static inline int TestPacketAABB(const FPacket4& packet, const RpgBoundingAABB& aabb) noexcept
+	{
+		const __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.Min.X), packet.OriginX), packet.InvDeltaX);
+		const __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.Max.X), packet.OriginX), packet.InvDeltaX);
+		const __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.Min.Y), packet.OriginY), packet.InvDeltaY);
+		const __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.Max.Y), packet.OriginY), packet.InvDeltaY);
+		const __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.Min.Z), packet.OriginZ), packet.InvDeltaZ);
+		const __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.Max.Z), packet.OriginZ), packet.InvDeltaZ);
+
+		const __m128 enterTime = _mm_max_ps(_mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y)), _mm_max_ps(_mm_min_ps(t1z, t2z), _mm_setzero_ps()));
+		const __m128 exitTime = _mm_min_ps(_mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y)), _mm_min_ps(_mm_max_ps(t1z, t2z), packet.MaxTime));
+
+		return _mm_movemask_ps(_mm_cmple_ps(enterTime, exitTime));
+	}
+
+
+	// Trace up to 4 lines with "One" semantics. Tree is traversed once for all lines, node is skipped when no active lane hits it
+	static void LinePacket4(const RpgPhysicsTrace::FScene& scene, const RpgPhysicsTrace::FLine* lines, int lineCount, const RpgPhysicsTrace::FOption& option, RpgPhysicsTrace::FResult* out_Results) noexcept
+	{
+		const RpgPhysicsCollision::FChannelMask traceBit = RpgPhysicsCollision::GetChannelBit(option.Channel);
+
+		RpgPhysicsCollision::FShape line;
+		RpgVector3 deltas[4];
+		RpgPhysicsSweep::FSweepHit bestHits[4];
+		alignas(16) float origins[3][4];
+		alignas(16) float invDeltas[3][4];
+		alignas(16) float maxTimes[4];
+
+		for (int l = 0; l < 4; ++l)
+		{
+			// Unused lanes repeat the first line and are masked out
+			const RpgPhysicsTrace::FLine& lane = lines[(l < lineCount) ? l : 0];
+			deltas[l] = lane.End - lane.Start;
+			origins[0][l] = lane.Start.X;
+			origins[1][l] = lane.Start.Y;
+			origins[2][l] = lane.Start.Z;
+			invDeltas[0][l] = RpgPhysicsSweep::GetInverse(deltas[l].X);
+			invDeltas[1][l] = RpgPhysicsSweep::GetInverse(deltas[l].Y);
+			invDeltas[2][l] = RpgPhysicsSweep::GetInverse(deltas[l].Z);
+			maxTimes[l] = 1.0f;
+
+			if (l < lineCount)
+			{
+				out_Results[l] = RpgPhysicsTrace::FResult();
+			}
+		}
+
+		FPacket4 packet;
+		packet.OriginX = _mm_load_ps(origins[0]);
+		packet.OriginY = _mm_load_ps(origins[1]);
+		packet.OriginZ = _mm_load_ps(origins[2]);
+		packet.InvDeltaX = _mm_load_ps(invDeltas[0]);
+		packet.InvDeltaY = _mm_load_ps(invDeltas[1]);
+		packet.InvDeltaZ = _mm_load_ps(invDeltas[2]);
+		packet.MaxTime = _mm_load_ps(maxTimes);
+
+		const int laneMask = (1 << lineCount) - 1;
+		int stack[RPG_PHYSICS_DYNAMIC_TREE_STACK_SIZE];
+
+		for (int r = 0; r < scene.Roots.GetCount(); ++r)
+		{
+			int stackCount = 0;
+			stack[stackCount++] = scene.Roots[r];
+
+			while (stackCount > 0)
+			{
+				const int nodeIndex = stack[--stackCount];
+				const RpgPhysicsDynamicTree::FFlatNode& node = scene.Nodes[nodeIndex];
+
+				if (IsNodeFiltered(node, traceBit))
+				{
+					continue;
+				}
+
+				int hitMask = TestPacketAABB(packet, node.Aabb) & laneMask;
+
+				if (hitMask == 0)
+				{
+					continue;
+				}
+
+				if (!node.IsLeaf())
+				{
+					RPG_Check(stackCount + 2 <= RPG_PHYSICS_DYNAMIC_TREE_STACK_SIZE);
+					stack[stackCount++] = node.SecondChild;
+					stack[stackCount++] = nodeIndex + 1;
+
+					continue;
+				}
+
+				const RpgPhysicsTrace::FSceneObject& object = scene.Objects[node.ProxyId];
+
+				if (GetResponse(object, option, traceBit) != RpgPhysicsCollision::RESPONSE_BLOCK)
+				{
+					continue;
+				}
+
+				bool bUpdated = false;
+
+				while (hitMask)
+				{
+					const int l = std::countr_zero(static_cast<uint32_t>(hitMask));
+					hitMask &= hitMask - 1;
+
+					RpgPhysicsSweep::FSweepHit hit;
+					const RpgVector3 start(origins[0][l], origins[1][l], origins[2][l]);
+
+					if (SweepObject(line, start, deltas[l], object, hit) && hit.Time < maxTimes[l])
+					{
+						maxTimes[l] = hit.Time;
+						bestHits[l] = hit;
+						SetResultObject(out_Results[l], scene, node.ProxyId, true);
+						bUpdated = true;
+					}
+				}
+
+				if (bUpdated)
+				{
+					packet.MaxTime = _mm_load_ps(maxTimes);
+				}
+			}
+		}
+
+		for (int l = 0; l < lineCount; ++l)
+		{
+			if (out_Results[l].IsHit())
+			{
+				SetResultHit(out_Results[l], lines[l].Start, deltas[l], bestHits[l]);
+			}
+		}
+	}
+
+
+	static const RpgPhysicsTrace::FScene* GetWorldScene(const RpgWorld* world) noexcept
+	{
+		const RpgPhysicsWorldSubsystem* physicsSubsystem = world ? world->Subsystem_Get<RpgPhysicsWorldSubsystem>() : nullptr;
+
+		return physicsSubsystem ? &physicsSubsystem->GetTraceScene() : nullptr;
+	}
+
+};
 
 
 
 namespace RpgPhysicsTrace
 {
+	void FScene::AddTree(const RpgPhysicsDynamicTree& tree, const FSceneObject* proxyObjects) noexcept
+	{
+		const int nodeStart = Nodes.GetCount();
+		tree.Flatten(Nodes);
+
+		if (Nodes.GetCount() == nodeStart)
+		{
+			return;
+		}
+
+		Roots.AddValue(nodeStart);
+
+		for (int i = nodeStart; i < Nodes.GetCount(); ++i)
+		{
+			RpgPhysicsDynamicTree::FFlatNode& node = Nodes[i];
+
+			if (node.IsLeaf())
+			{
+				Objects.AddValue(proxyObjects[node.ProxyId]);
+				node.ProxyId = Objects.GetCount() - 1;
+			}
+		}
+	}
+
+
+
 	FResult LineOne(const RpgWorld* world, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept
 	{
-		FResult result;
+		const FScene* scene = RpgPhysicsTraceScene::GetWorldScene(world);
 
-		return result;
+		return scene ? LineOne(*scene, start, end, option) : FResult();
+	}
+
+
+	FResult LineOne(const FScene& scene, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept
+	{
+		return RpgPhysicsTraceScene::SweepOne(scene, RpgPhysicsCollision::FShape(), start, end, option);
 	}
 
 
 	FResultArray LineMany(const RpgWorld* world, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept
 	{
-		FResultArray results;
+		const FScene* scene = RpgPhysicsTraceScene::GetWorldScene(world);
 
-		return results;
+		return scene ? LineMany(*scene, start, end, option) : FResultArray();
+	}
+
+
+	FResultArray LineMany(const FScene& scene, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept
+	{
+		return RpgPhysicsTraceScene::SweepMany(scene, RpgPhysicsCollision::FShape(), start, end, option);
 	}
 
 
 	FResult SphereOne(const RpgWorld* world, RpgVector3 center, float radius, const FOption& option) noexcept
 	{
-		FResult result;
+		const FScene* scene = RpgPhysicsTraceScene::GetWorldScene(world);
 
-		return result;
+		return scene ? SphereOne(*scene, center, radius, option) : FResult();
+	}
+
+
+	FResult SphereOne(const FScene& scene, RpgVector3 center, float radius, const FOption& option) noexcept
+	{
+		FResult deepest;
+
+		RpgPhysicsTraceScene::OverlapSphere(scene, center, radius, option,
+			[&deepest](const FResult& result)
+			{
+				if (result.bBlockingHit && (!deepest.IsHit() || result.Distance > deepest.Distance))
+				{
+					deepest = result;
+				}
+			}
+		);
+
+		return deepest;
 	}
 
 
 	FResultArray SphereMany(const RpgWorld* world, RpgVector3 center, float radius, const FOption& option) noexcept
+	{
+		const FScene* scene = RpgPhysicsTraceScene::GetWorldScene(world);
+
+		return scene ? SphereMany(*scene, center, radius, option) : FResultArray();
+	}
+
+
+	FResultArray SphereMany(const FScene& scene, RpgVector3 center, float radius, const FOption& option) noexcept
 	{
 		FResultArray results;
 
+		RpgPhysicsTraceScene::OverlapSphere(scene, center, radius, option,
+			[&results](const FResult& result)
+			{
+				RpgPhysicsTraceScene::InsertSorted(results, result, RpgPhysicsTraceScene::IsDeeper);
+			}
+		);
+
 		return results;
 	}
 
+
+	FResult SweepOne(const RpgWorld* world, const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept
+	{
+		const FScene* scene = RpgPhysicsTraceScene::GetWorldScene(world);
+
+		return scene ? SweepOne(*scene, shape, start, end, option) : FResult();
+	}
+
+
+	FResult SweepOne(const FScene& scene, const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept
+	{
+		return RpgPhysicsTraceScene::SweepOne(scene, shape, start, end, option);
+	}
+
+
+	FResultArray SweepMany(const RpgWorld* world, const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept
+	{
+		const FScene* scene = RpgPhysicsTraceScene::GetWorldScene(world);
+
+		return scene ? SweepMany(*scene, shape, start, end, option) : FResultArray();
+	}
+
+
+	FResultArray SweepMany(const FScene& scene, const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept
+	{
+		return RpgPhysicsTraceScene::SweepMany(scene, shape, start, end, option);
+	}
+
+
+	void LineBatch(const FScene& scene, const FLine* lines, int count, const FOption& option, FResult* out_Results) noexcept
+	{
+		RPG_PROFILE_SCOPE("RpgPhysicsTrace_LineBatch");
+
+		for (int i = 0; i < count; i += 4)
+		{
+			RpgPhysicsTraceScene::LinePacket4(scene, lines + i, RpgMath::Min(4, count - i), option, out_Results + i);
+		}
+	}
+
+
+	bool TestSweep(const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const RpgPhysicsCollision::FShape& target, FResult& out_Result) noexcept
+	{
+		const RpgPhysicsSweep::FSweepFunction function = RpgPhysicsSweep::SWEEP_FUNCTIONS[shape.Type][target.Type];
+		const RpgVector3 delta = end - start;
+		RpgPhysicsSweep::FSweepHit hit;
+
+		if (function == nullptr || !function(shape, start, delta, target, hit))
+		{
+			return false;
+		}
+
+		RpgPhysicsTraceScene::SetResultHit(out_Result, start, delta, hit);
+
+		return true;
+	}
+
 };
@@ -2,13 +2,24 @@
 
 #include "core/RpgMath.h"
 #include "core/dsa/RpgArray.h"
+#include "core/dsa/RpgMap.h"
 #include "core/world/RpgGameObject.h"
+#include "RpgPhysicsDynamicTree.h"
 
 
 #define RPG_PHYSICS_COLLISION_MAX_CONVEX_VERTICES	32
 #define RPG_PHYSICS_COLLISION_MAX_CONTACT_RESULT	8
 #define RPG_PHYSICS_TRACE_MAX_HIT_RESULT			10
 
+// Distance tolerance for sweeps solved by conservative advancement (capsule - box)
+#define RPG_PHYSICS_TRACE_SWEEP_TOLERANCE			0.001f
+#define RPG_PHYSICS_TRACE_SWEEP_MAX_ITERATIONS		32
+
+#define RPG_PHYSICS_NARROWPHASE_MAX_TASK					16
+#define RPG_PHYSICS_NARROWPHASE_MIN_PAIR_PER_TASK			32
+#define RPG_PHYSICS_NARROWPHASE_CONTACT_REUSE_DISTANCE		0.5f
+#define RPG_PHYSICS_NARROWPHASE_CONTACT_REUSE_ROTATION_DOT	0.9999f
+
 
 class RpgPhysicsComponent_Filter;
 class RpgPhysicsComponent_Collision;
@@ -67,6 +78,23 @@ namespace RpgPhysicsCollision
 	{
 		RpgPhysicsComponent_Collision* FirstCollision{ nullptr };
 		RpgPhysicsComponent_Collision* SecondCollision{ nullptr };
+		EResponse Response{ RESPONSE_IGNORE };
+	};
+
+	// Pairs are rebuilt every tick, allocated from frame arena
+	typedef RpgArray<FPairTest, 1, RpgAllocatorFrame> FPairTestArray;
+
+
+	// Collision shape in world space, updated by update shape task
+	struct FShape
+	{
+		RpgVector3 Center;
+		RpgQuaternion Rotation;
+
+		// Same layout as collision component size (see RpgPhysicsComponent_Collision::Size)
+		RpgVector4 Size;
+
+		EShape Type{ SHAPE_NONE };
 	};
 
 
@@ -82,6 +110,7 @@ namespace RpgPhysicsCollision
 	{
 		RpgPhysicsComponent_Collision* FirstCollision{ nullptr };
 		RpgPhysicsComponent_Collision* SecondCollision{ nullptr };
+		EResponse Response{ RESPONSE_IGNORE };
 		RpgArrayInline<FContactResult, RPG_PHYSICS_COLLISION_MAX_CONTACT_RESULT> FirstContactResults;
 		RpgArrayInline<FContactResult, RPG_PHYSICS_COLLISION_MAX_CONTACT_RESULT> SecondContactResults;
 	};
@@ -99,16 +128,85 @@ namespace RpgPhysicsCollision
 	extern const FResponseChannels DEFAULT_COLLISION_RESPONSE_CHANNELS_Character;
 
 
-	
-	namespace Filter
+	// One bit per channel. CHANNEL_NONE has no bit
+	typedef uint8_t FChannelMask;
+	static_assert(CHANNEL_MAX_COUNT <= 8, "RpgPhysicsCollision: FChannelMask is too small for CHANNEL_MAX_COUNT!");
+
+	[[nodiscard]] constexpr inline FChannelMask GetChannelBit(EChannel channel) noexcept
 	{
-		extern void GeneratePairs(RpgArray<FPairTest>& out_Pairs, RpgWorld* world) noexcept;
+		return (channel == CHANNEL_NONE) ? 0 : static_cast<FChannelMask>(1u << channel);
+	}
+
+
+	// Object channel and response channels compacted into bit masks. Computed once when filter changes
+	struct FFilterMask
+	{
+		FChannelMask ChannelBit{ 0 };
+
+		// Channels this object blocks
+		FChannelMask BlockMask{ 0 };
+
+		// Channels this object blocks or overlaps
+		FChannelMask ResponseMask{ 0 };
+
+
+		[[nodiscard]] static FFilterMask Make(EChannel objectChannel, const FResponseChannels& responseChannels) noexcept;
+
+		inline bool operator==(const FFilterMask& rhs) const noexcept
+		{
+			return ChannelBit == rhs.ChannelBit && BlockMask == rhs.BlockMask && ResponseMask == rhs.ResponseMask;
+		}
+
+		inline bool operator!=(const FFilterMask& rhs) const noexcept
+		{
+			return !(*this == rhs);
+		}
 	};
 
 
+	// @returns True if both objects respond (block or overlap) to channel of each other
+	[[nodiscard]] inline bool ShouldPair(const FFilterMask& first, const FFilterMask& second) noexcept
+	{
+		return (first.ResponseMask & second.ChannelBit) && (second.ResponseMask & first.ChannelBit);
+	}
+
+	// @returns RESPONSE_BLOCK if both objects block each other, RESPONSE_OVERLAP if both respond but at least one overlaps, otherwise RESPONSE_IGNORE
+	[[nodiscard]] inline EResponse GetPairResponse(const FFilterMask& first, const FFilterMask& second) noexcept
+	{
+		if (!ShouldPair(first, second))
+		{
+			return RESPONSE_IGNORE;
+		}
+
+		return ((first.BlockMask & second.ChannelBit) && (second.BlockMask & first.ChannelBit)) ? RESPONSE_BLOCK : RESPONSE_OVERLAP;
+	}
+
+
+	
 	namespace Broadphase
 	{
-		extern void GeneratePairs(RpgArray<FPairTest>& out_Pairs, const RpgArray<FPairTest>& filterPairs) noexcept;
+		// Broadphase tree proxy data, indexed by proxy ID
+		struct FProxy
+		{
+			RpgGameObjectID GameObject;
+			RpgPhysicsComponent_Collision* Collision{ nullptr };
+
+			// Copy of filter mask, pairs are filtered without accessing filter component
+			FFilterMask FilterMask;
+
+			// Tick number of the latest proxy sync. Proxy that is not synced in the current tick is destroyed
+			uint32_t SyncTick{ 0 };
+		};
+
+
+		// Generate pairs from proxy pairs of broadphase trees. Tree traversal skips proxies that do not respond to each other, pairs are then tested for bounds overlap
+		// @param out_Pairs - Output pairs, appended
+		// @param firstTree - First broadphase tree
+		// @param firstProxies - Proxy data of <firstTree> indexed by proxy ID
+		// @param secondTree - Second broadphase tree. Same as <firstTree> to generate pairs within one tree
+		// @param secondProxies - Proxy data of <secondTree> indexed by proxy ID
+		// @returns None
+		extern void GeneratePairs(FPairTestArray& out_Pairs, const RpgPhysicsDynamicTree& firstTree, const FProxy* firstProxies, const RpgPhysicsDynamicTree& secondTree, const FProxy* secondProxies) noexcept;
 	};
 
 
@@ -118,6 +216,81 @@ namespace RpgPhysicsCollision
 		extern bool TestOverlapSphereBox(RpgBoundingSphere sphere, RpgBoundingBox box, FContactResult* optOut_Result = nullptr) noexcept;
 		extern bool TestOverlapBoxBox(RpgBoundingBox first, RpgBoundingBox second, FContactResult* optOut_Result = nullptr) noexcept;
 		extern bool TestOverlapBoxSphere(RpgBoundingBox box, RpgBoundingSphere sphere, FContactResult* optOut_Result = nullptr) noexcept;
+
+
+		// Test overlap between world shapes. Dispatched by shape pair to closed form routines (sphere, box, capsule). Unsupported pairs never overlap
+		// @param first - First shape
+		// @param second - Second shape
+		// @param optOut_Result - (Optional) Contact result. Separation direction points from <first> to <second>
+		// @returns True if overlapped
+		extern bool TestOverlap(const FShape& first, const FShape& second, FContactResult* optOut_Result = nullptr) noexcept;
+
+		// Test overlap between world shapes using GJK/EPA. Much slower than TestOverlap, intended for convex hulls
+		// @param first - First shape
+		// @param second - Second shape
+		// @param optOut_Result - (Optional) Contact result. Separation direction points from <first> to <second>
+		// @returns True if overlapped
+		extern bool TestOverlapGJK(const FShape& first, const FShape& second, FContactResult* optOut_Result = nullptr) noexcept;
+
+
+		// Test overlap of 4 pairs at once using SIMD. Contact results are not computed
+		// @param firsts - First shapes of 4 pairs, shape type in function name order
+		// @param seconds - Second shapes of 4 pairs
+		// @returns Bit mask of overlapped pairs, bit <i> is set if pair <i> is overlapped
+		extern int TestOverlapBatch4_SphereSphere(const FShape* const* firsts, const FShape* const* seconds) noexcept;
+		extern int TestOverlapBatch4_SphereCapsule(const FShape* const* firsts, const FShape* const* seconds) noexcept;
+		extern int TestOverlapBatch4_CapsuleCapsule(const FShape* const* firsts, const FShape* const* seconds) noexcept;
+
+		// Test whether axis separates both shapes. Much cheaper than GJK, used to early out pairs that were separated by the same axis last tick
+		// @param first - First shape
+		// @param second - Second shape
+		// @param axis - Normalized axis
+		// @returns True if projections of both shapes on <axis> do not overlap
+		extern bool TestSeparatingAxis(const FShape& first, const FShape& second, const RpgVector3& axis) noexcept;
+
+		// Find axis that separates both shapes from a few candidates (center direction, box face normals, capsule segment direction)
+		// @param first - First shape
+		// @param second - Second shape
+		// @param out_Axis - Separating axis if found
+		// @returns True if separating axis found
+		extern bool FindSeparatingAxis(const FShape& first, const FShape& second, RpgVector3& out_Axis) noexcept;
+
+
+		// Narrowphase result of one pair, persists across ticks. Keyed by pair ID (see GetPairId)
+		struct FManifoldCacheEntry
+		{
+			RpgGameObjectID FirstGameObject;
+			RpgGameObjectID SecondGameObject;
+
+			// Shape transforms at the time of the latest full test
+			RpgVector3 FirstCenter;
+			RpgQuaternion FirstRotation;
+			RpgVector3 SecondCenter;
+			RpgQuaternion SecondRotation;
+
+			// Valid if not overlapped and separating axis was found
+			RpgVector3 SeparatingAxis;
+			bool bHasSeparatingAxis{ false };
+
+			// Valid if overlapped, relative to first game object
+			FContactResult Contact;
+			bool bOverlapped{ false };
+
+			// Tick number of the latest test. Entry that is not tested in the current tick is evicted
+			uint32_t Tick{ 0 };
+		};
+
+		typedef RpgMap<uint64_t, FManifoldCacheEntry> FManifoldCache;
+
+
+		// @returns Pair ID, same value regardless of order of game objects
+		[[nodiscard]] inline uint64_t GetPairId(RpgGameObjectID first, RpgGameObjectID second) noexcept
+		{
+			const uint32_t firstIndex = static_cast<uint32_t>(first.GetIndex());
+			const uint32_t secondIndex = static_cast<uint32_t>(second.GetIndex());
+
+			return (firstIndex < secondIndex) ? ((static_cast<uint64_t>(firstIndex) << 32) | secondIndex) : ((static_cast<uint64_t>(secondIndex) << 32) | firstIndex);
+		}
 	};
 
 };
@@ -130,26 +303,133 @@ namespace RpgPhysicsTrace
 	struct FOption
 	{
 		RpgArray<RpgGameObjectID> IgnoredGameObjects;
+
+		// Trace channel. Objects that block this channel stop the trace, objects that overlap it are reported by Many queries. CHANNEL_NONE is blocked by everything
 		RpgPhysicsCollision::EChannel Channel{ RpgPhysicsCollision::CHANNEL_NONE };
 	};
 
 
 	struct FResult
 	{
+		// Line/shape center at the time of hit. For sphere overlap, center of the sphere
 		RpgVector3 HitLocation;
+
+		// Contact point on hit object surface
 		RpgVector3 ContactLocation;
+
+		// Hit object surface normal, points toward the trace
 		RpgVector3 ContactNormal;
-		RpgPhysicsComponent_Collision* Component{ nullptr };
+
+		// Hit game object. Component pointers are not kept, result may be read after the traced scene is rebuilt
+		RpgGameObjectID GameObject;
+
+		// Index of hit object in trace scene (see FScene::Objects)
+		int ObjectIndex{ RPG_INDEX_INVALID };
+
+		// Distance traveled from start. For sphere overlap, penetration depth
+		float Distance{ 0.0f };
+
+		// False if hit object only overlaps trace channel
+		bool bBlockingHit{ false };
+
+
+		inline bool IsHit() const noexcept
+		{
+			return ObjectIndex != RPG_INDEX_INVALID;
+		}
 	};
 
 	typedef RpgArrayInline<FResult, RPG_PHYSICS_TRACE_MAX_HIT_RESULT> FResultArray;
 
 
+	// Object data copied into trace scene, trace never reads components
+	struct FSceneObject
+	{
+		RpgGameObjectID GameObject;
+		RpgPhysicsCollision::FShape Shape;
+		RpgPhysicsCollision::FFilterMask FilterMask;
+	};
+
+
+	// Read only snapshot of collision objects for trace queries. Physics world subsystem rebuilds it at the end of every tick (see RpgPhysicsWorldSubsystem::GetTraceScene).
+	// Queries only read the scene, any number of tasks may trace the same scene concurrently
+	struct FScene
+	{
+		// Flattened broadphase trees. Leaf proxy ID is remapped to index of object
+		RpgArray<RpgPhysicsDynamicTree::FFlatNode> Nodes;
+
+		// Index of root node of each tree
+		RpgArray<int> Roots;
 
+		RpgArray<FSceneObject> Objects;
+
+
+		inline void Clear() noexcept
+		{
+			Nodes.Clear();
+			Roots.Clear();
+			Objects.Clear();
+		}
+
+		// Append broadphase tree
+		// @param tree - Broadphase tree
+		// @param proxyObjects - Object data of <tree> indexed by proxy ID
+		// @returns None
+		void AddTree(const RpgPhysicsDynamicTree& tree, const FSceneObject* proxyObjects) noexcept;
+	};
+
+
+	struct FLine
+	{
+		RpgVector3 Start;
+		RpgVector3 End;
+	};
+
+
+
+	// Trace line against world, returns the nearest blocking hit
 	extern FResult LineOne(const RpgWorld* world, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept;
+	extern FResult LineOne(const FScene& scene, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept;
+
+	// Trace line against world, returns overlap hits before the nearest blocking hit followed by the blocking hit, sorted by distance
 	extern FResultArray LineMany(const RpgWorld* world, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept;
-		   
+	extern FResultArray LineMany(const FScene& scene, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept;
+
+	// Test sphere overlap against world, returns the deepest blocking hit
 	extern FResult SphereOne(const RpgWorld* world, RpgVector3 center, float radius, const FOption& option) noexcept;
+	extern FResult SphereOne(const FScene& scene, RpgVector3 center, float radius, const FOption& option) noexcept;
+
+	// Test sphere overlap against world, returns all blocking and overlap hits sorted by penetration depth (deepest first)
 	extern FResultArray SphereMany(const RpgWorld* world, RpgVector3 center, float radius, const FOption& option) noexcept;
+	extern FResultArray SphereMany(const FScene& scene, RpgVector3 center, float radius, const FOption& option) noexcept;
+
+	// Sweep shape (sphere, box, capsule) from <start> to <end>, returns the nearest blocking hit. Center of <shape> is ignored
+	extern FResult SweepOne(const RpgWorld* world, const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept;
+	extern FResult SweepOne(const FScene& scene, const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept;
+
+	// Sweep shape (sphere, box, capsule) from <start> to <end>, returns overlap hits before the nearest blocking hit followed by the blocking hit, sorted by distance
+	extern FResultArray SweepMany(const RpgWorld* world, const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept;
+	extern FResultArray SweepMany(const FScene& scene, const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const FOption& option) noexcept;
+
+
+	// Trace many lines, each one returns the nearest blocking hit (same as LineOne). Lines are traversed in packets of 4 with SIMD slab tests.
+	// Read only, safe to call concurrently from worker tasks
+	// @param scene - Trace scene
+	// @param lines - Lines to trace
+	// @param count - Number of lines
+	// @param option - Trace option shared by all lines
+	// @param out_Results - Output results, one per line
+	// @returns None
+	extern void LineBatch(const FScene& scene, const FLine* lines, int count, const FOption& option, FResult* out_Results) noexcept;
+
+
+	// Sweep shape against one target shape. Shape type SHAPE_NONE sweeps a line. Shape already overlapping at <start> hits at distance 0
+	// @param shape - Moving shape, center is ignored
+	// @param start - Start location of moving shape
+	// @param end - End location of moving shape
+	// @param target - Target shape
+	// @param out_Result - Hit location, contact and distance if hit. Object data is not set
+	// @returns True if hit
+	extern bool TestSweep(const RpgPhysicsCollision::FShape& shape, RpgVector3 start, RpgVector3 end, const RpgPhysicsCollision::FShape& target, FResult& out_Result) noexcept;
 
 };
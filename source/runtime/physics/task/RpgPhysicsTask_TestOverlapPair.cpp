@@ -1 +1,241 @@
 #include "RpgPhysicsTask_TestOverlapPair.h"
+
+
+
+RpgPhysicsTask_TestOverlapPair::RpgPhysicsTask_TestOverlapPair() noexcept
+{
+	Pairs = nullptr;
+	PairCount = 0;
+	ManifoldCache = nullptr;
+	Tick = 0;
+	FullTestCount = 0;
+	CachedSeparatedCount = 0;
+	CachedContactCount = 0;
+	BatchTestCount = 0;
+}
+
+
+void RpgPhysicsTask_TestOverlapPair::Reset() noexcept
+{
+	RpgThreadTask::Reset();
+
+	Pairs = nullptr;
+	PairCount = 0;
+	ManifoldCache = nullptr;
+	Tick = 0;
+	Manifolds.Clear();
+	CacheUpdates.Clear();
+	PendingTests.Clear();
+	FullTestCount = 0;
+	CachedSeparatedCount = 0;
+	CachedContactCount = 0;
+	BatchTestCount = 0;
+}
+
+
+void RpgPhysicsTask_TestOverlapPair::Execute() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	CacheUpdates.Reserve(PairCount);
+
+	const float reuseDistanceSqr = RPG_PHYSICS_NARROWPHASE_CONTACT_REUSE_DISTANCE * RPG_PHYSICS_NARROWPHASE_CONTACT_REUSE_DISTANCE;
+
+	for (int i = 0; i < PairCount; ++i)
+	{
+		const FPairTest& pair = Pairs[i];
+		RpgPhysicsComponent_Collision* firstCollision = pair.FirstCollision;
+		RpgPhysicsComponent_Collision* secondCollision = pair.SecondCollision;
+
+		// Order by game object index, cached contact is always relative to the same game object
+		if (secondCollision->GameObject.GetIndex() < firstCollision->GameObject.GetIndex())
+		{
+			RpgPhysicsComponent_Collision* temp = firstCollision;
+			firstCollision = secondCollision;
+			secondCollision = temp;
+		}
+
+		const FShape& firstShape = firstCollision->GetWorldShape();
+		const FShape& secondShape = secondCollision->GetWorldShape();
+		const uint64_t pairId = Narrowphase::GetPairId(firstCollision->GameObject, secondCollision->GameObject);
+
+		// Entry of destroyed game object may be reused by other game object at the same index
+		const Narrowphase::FManifoldCacheEntry* cached = ManifoldCache->GetValueByKey(pairId);
+		if (cached && (cached->FirstGameObject != firstCollision->GameObject || cached->SecondGameObject != secondCollision->GameObject))
+		{
+			cached = nullptr;
+		}
+
+		FCacheUpdate& update = CacheUpdates.Add();
+		update.PairId = pairId;
+		Narrowphase::FManifoldCacheEntry& entry = update.Entry;
+		FContactResult contact;
+		bool bResolved = false;
+
+		if (cached)
+		{
+			if (cached->bHasSeparatingAxis && Narrowphase::TestSeparatingAxis(firstShape, secondShape, cached->SeparatingAxis))
+			{
+				// Still separated by the same axis
+				entry = *cached;
+				bResolved = true;
+				++CachedSeparatedCount;
+			}
+			else if (cached->bOverlapped)
+			{
+				const RpgVector3 firstMove = firstShape.Center - cached->FirstCenter;
+				const RpgVector3 secondMove = secondShape.Center - cached->SecondCenter;
+
+				// Stable contact, both shapes barely moved relative to each other since the latest full test
+				if ((secondMove - firstMove).GetMagnitudeSqr() <= reuseDistanceSqr &&
+					RpgMath::Abs(RpgQuaternion::DotProduct(firstShape.Rotation, cached->FirstRotation)) >= RPG_PHYSICS_NARROWPHASE_CONTACT_REUSE_ROTATION_DOT &&
+					RpgMath::Abs(RpgQuaternion::DotProduct(secondShape.Rotation, cached->SecondRotation)) >= RPG_PHYSICS_NARROWPHASE_CONTACT_REUSE_ROTATION_DOT)
+				{
+					entry = *cached;
+					contact = cached->Contact;
+					contact.ContactPoint += firstMove;
+					bResolved = true;
+					++CachedContactCount;
+				}
+			}
+		}
+
+		if (!bResolved)
+		{
+			entry.FirstGameObject = firstCollision->GameObject;
+			entry.SecondGameObject = secondCollision->GameObject;
+			entry.FirstCenter = firstShape.Center;
+			entry.FirstRotation = firstShape.Rotation;
+			entry.SecondCenter = secondShape.Center;
+			entry.SecondRotation = secondShape.Rotation;
+			PendingTests.AddValue({ firstCollision, secondCollision, pair.Response, CacheUpdates.GetCount() - 1, -1 });
+			continue;
+		}
+
+		entry.Tick = Tick;
+
+		if (entry.bOverlapped)
+		{
+			AddManifold(firstCollision, secondCollision, pair.Response, contact);
+		}
+	}
+
+	TestPendingBatch4();
+
+	for (int i = 0; i < PendingTests.GetCount(); ++i)
+	{
+		const FPendingTest& test = PendingTests[i];
+		const FShape& firstShape = test.FirstCollision->GetWorldShape();
+		const FShape& secondShape = test.SecondCollision->GetWorldShape();
+		Narrowphase::FManifoldCacheEntry& entry = CacheUpdates[test.CacheUpdateIndex].Entry;
+
+		entry.bOverlapped = (test.BatchResult != 0) && Narrowphase::TestOverlap(firstShape, secondShape, &entry.Contact);
+		entry.bHasSeparatingAxis = !entry.bOverlapped && Narrowphase::FindSeparatingAxis(firstShape, secondShape, entry.SeparatingAxis);
+		entry.Tick = Tick;
+		++FullTestCount;
+
+		if (entry.bOverlapped)
+		{
+			AddManifold(test.FirstCollision, test.SecondCollision, test.Response, entry.Contact);
+		}
+	}
+}
+
+
+void RpgPhysicsTask_TestOverlapPair::TestPendingBatch4() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	typedef int (*FBatchFunction)(const FShape* const* firsts, const FShape* const* seconds);
+
+	struct FBatch
+	{
+		EShape FirstType;
+		EShape SecondType;
+		FBatchFunction Function;
+	};
+
+	static const FBatch BATCHES[3] =
+	{
+		{ SHAPE_SPHERE, SHAPE_SPHERE, Narrowphase::TestOverlapBatch4_SphereSphere },
+		{ SHAPE_SPHERE, SHAPE_CAPSULE, Narrowphase::TestOverlapBatch4_SphereCapsule },
+		{ SHAPE_CAPSULE, SHAPE_CAPSULE, Narrowphase::TestOverlapBatch4_CapsuleCapsule },
+	};
+
+	for (int b = 0; b < 3; ++b)
+	{
+		const FBatch& batch = BATCHES[b];
+		const FShape* firsts[4];
+		const FShape* seconds[4];
+		int testIndices[4];
+		int laneCount = 0;
+
+		for (int i = 0; i <= PendingTests.GetCount(); ++i)
+		{
+			if (i < PendingTests.GetCount())
+			{
+				const FPendingTest& test = PendingTests[i];
+				const FShape* first = &test.FirstCollision->GetWorldShape();
+				const FShape* second = &test.SecondCollision->GetWorldShape();
+
+				// Overlap result does not depend on order
+				if (first->Type == batch.SecondType && second->Type == batch.FirstType)
+				{
+					const FShape* temp = first;
+					first = second;
+					second = temp;
+				}
+
+				if (first->Type != batch.FirstType || second->Type != batch.SecondType)
+				{
+					continue;
+				}
+
+				firsts[laneCount] = first;
+				seconds[laneCount] = second;
+				testIndices[laneCount] = i;
+
+				if (++laneCount < 4)
+				{
+					continue;
+				}
+			}
+
+			if (laneCount == 0)
+			{
+				continue;
+			}
+
+			// Pad unused lanes of the last batch
+			for (int l = laneCount; l < 4; ++l)
+			{
+				firsts[l] = firsts[0];
+				seconds[l] = seconds[0];
+			}
+
+			const int overlappedMask = batch.Function(firsts, seconds);
+
+			for (int l = 0; l < laneCount; ++l)
+			{
+				PendingTests[testIndices[l]].BatchResult = (overlappedMask >> l) & 1;
+			}
+
+			BatchTestCount += laneCount;
+			laneCount = 0;
+		}
+	}
+}
+
+
+void RpgPhysicsTask_TestOverlapPair::AddManifold(RpgPhysicsComponent_Collision* firstCollision, RpgPhysicsComponent_Collision* secondCollision, RpgPhysicsCollision::EResponse response, const RpgPhysicsCollision::FContactResult& contact) noexcept
+{
+	RpgPhysicsCollision::FContactManifold& manifold = Manifolds.Add();
+	manifold.FirstCollision = firstCollision;
+	manifold.SecondCollision = secondCollision;
+	manifold.Response = response;
+	manifold.FirstContactResults.AddValue(contact);
+
+	RpgPhysicsCollision::FContactResult secondContact = contact;
+	secondContact.SeparationDirection = -contact.SeparationDirection;
+	manifold.SecondContactResults.AddValue(secondContact);
+}
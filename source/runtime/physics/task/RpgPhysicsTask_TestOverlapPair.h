@@ -1,11 +1,78 @@
 #pragma once
 
 #include "core/RpgThreadPool.h"
+#include "../world/RpgPhysicsComponent.h"
 
 
 
+// Narrowphase test for a chunk of broadphase pairs. Each task writes to its own output buffers, merged by physics world subsystem after all tasks finished
 class RpgPhysicsTask_TestOverlapPair : public RpgThreadTask
 {
+public:
+	// Cache entry to insert or replace after merge
+	struct FCacheUpdate
+	{
+		uint64_t PairId{ 0 };
+		RpgPhysicsCollision::Narrowphase::FManifoldCacheEntry Entry;
+	};
+
+
+public:
+	// [Input] Chunk of broadphase pairs
+	const RpgPhysicsCollision::FPairTest* Pairs;
+	int PairCount;
+
+	// [Input] Manifold cache from previous ticks. Read only while task is running
+	const RpgPhysicsCollision::Narrowphase::FManifoldCache* ManifoldCache;
+
+	// [Input] Current narrowphase tick number
+	uint32_t Tick;
+
+	// [Output] Manifolds of overlapped pairs
+	RpgArray<RpgPhysicsCollision::FContactManifold> Manifolds;
+
+	// [Output] Entries for every tested pair
+	RpgArray<FCacheUpdate> CacheUpdates;
+
+	// [Output] Stats
+	int FullTestCount;
+	int CachedSeparatedCount;
+	int CachedContactCount;
+	int BatchTestCount;
+
+
+public:
+	RpgPhysicsTask_TestOverlapPair() noexcept;
+	virtual void Reset() noexcept override;
+	virtual void Execute() noexcept override;
+
+
+	virtual const char* GetTaskName() const noexcept override
+	{
+		return "RpgPhysicsTask_TestOverlapPair";
+	}
+
+
+private:
+	// Batch test pending pairs of common shape pairs 4 at a time. Only overlapped pairs need full test for contact result
+	void TestPendingBatch4() noexcept;
+
+	void AddManifold(RpgPhysicsComponent_Collision* firstCollision, RpgPhysicsComponent_Collision* secondCollision, RpgPhysicsCollision::EResponse response, const RpgPhysicsCollision::FContactResult& contact) noexcept;
+
+
+private:
+	// Pair that can not be resolved from manifold cache
+	struct FPendingTest
+	{
+		RpgPhysicsComponent_Collision* FirstCollision;
+		RpgPhysicsComponent_Collision* SecondCollision;
+		RpgPhysicsCollision::EResponse Response;
+		int CacheUpdateIndex;
+
+		// -1 = Not batch tested, 0 = Separated, 1 = Overlapped
+		int BatchResult;
+	};
+
+	RpgArray<FPendingTest> PendingTests;
 
 };
- 
\ No newline at end of file
@@ -18,5 +18,40 @@ void RpgPhysicsTask_UpdateBound::Reset() noexcept
 
 void RpgPhysicsTask_UpdateBound::Execute() noexcept
 {
-
+	const RpgWorld* world = World;
+
+	World->Component_Query<RpgPhysicsComponent_Collision>().ParallelForEach(
+		[world](RpgPhysicsComponent_Collision& comp)
+		{
+			if (!comp.bUpdateBounding && !world->GameObject_IsTransformUpdated(comp.GameObject))
+			{
+				return;
+			}
+
+			float radius = 0.0f;
+
+			switch (comp.Shape)
+			{
+				case RpgPhysicsCollision::SHAPE_SPHERE:
+					radius = comp.Size.X;
+					break;
+
+				case RpgPhysicsCollision::SHAPE_BOX:
+					radius = RpgVector3(comp.Size.X, comp.Size.Y, comp.Size.Z).GetMagnitude();
+					break;
+
+				case RpgPhysicsCollision::SHAPE_CAPSULE:
+					radius = comp.Size.X + comp.Size.Y;
+					break;
+
+				default:
+					break;
+			}
+
+			comp.Bound = RpgBoundingSphere(world->GameObject_GetWorldTransformMatrix(comp.GameObject).GetPosition(), radius);
+			comp.bUpdateBounding = false;
+			comp.bBoundUpdated = true;
+		}
+		, 64
+	);
 }
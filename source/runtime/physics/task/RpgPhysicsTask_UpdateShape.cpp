@@ -18,5 +18,27 @@ void RpgPhysicsTask_UpdateShape::Reset() noexcept
 
 void RpgPhysicsTask_UpdateShape::Execute() noexcept
 {
-
+	const RpgWorld* world = World;
+
+	World->Component_Query<RpgPhysicsComponent_Collision>().ParallelForEach(
+		[world](RpgPhysicsComponent_Collision& comp)
+		{
+			if (!comp.bUpdateShape && !world->GameObject_IsTransformUpdated(comp.GameObject))
+			{
+				return;
+			}
+
+			RpgVector3 position;
+			RpgQuaternion rotation;
+			RpgVector3 scale;
+			world->GameObject_GetWorldTransformMatrix(comp.GameObject).Decompose(position, rotation, scale);
+
+			comp.WorldShape.Center = position;
+			comp.WorldShape.Rotation = rotation;
+			comp.WorldShape.Size = comp.Size;
+			comp.WorldShape.Type = comp.Shape;
+			comp.bUpdateShape = false;
+		}
+		, 64
+	);
 }
@@ -10,18 +10,11 @@ class RpgPhysicsComponent_Filter
 	RPG_COMPONENT_TYPE("RpgComponent (Physics) - Filter");
 
 public:
-	// Object collision channel
-	RpgPhysicsCollision::EChannel ObjectChannel;
+	static constexpr uint32_t SNAPSHOT_VERSION = 1;
 
-	// Object response againts other channels
-	RpgPhysicsCollision::FResponseChannels ResponseChannels;
-
-
-public:
 	RpgPhysicsComponent_Filter() noexcept
 	{
-		ObjectChannel = RpgPhysicsCollision::CHANNEL_NONE;
-		ResponseChannels = RpgPhysicsCollision::DEFAULT_COLLISION_RESPONSE_CHANNELS_IgnoreAll;
+		SetChannel(RpgPhysicsCollision::CHANNEL_NONE, RpgPhysicsCollision::DEFAULT_COLLISION_RESPONSE_CHANNELS_IgnoreAll);
 	}
 
 
@@ -30,6 +23,58 @@ public:
 		// Nothing to do
 	}
 
+
+	inline void Serialize(RpgStreamWriter& writer) const noexcept
+	{
+		writer.Write(ObjectChannel);
+		writer.WriteArray(ResponseChannels);
+	}
+
+
+	inline void Deserialize(RpgStreamReader& reader) noexcept
+	{
+		reader.Read(ObjectChannel);
+		ResponseChannels.Clear();
+		reader.ReadArray(ResponseChannels);
+		FilterMask = RpgPhysicsCollision::FFilterMask::Make(ObjectChannel, ResponseChannels);
+	}
+
+
+	// Set object channel and its response againts other channels. Filter mask is recomputed
+	inline void SetChannel(RpgPhysicsCollision::EChannel objectChannel, const RpgPhysicsCollision::FResponseChannels& responseChannels) noexcept
+	{
+		ObjectChannel = objectChannel;
+		ResponseChannels = responseChannels;
+		FilterMask = RpgPhysicsCollision::FFilterMask::Make(ObjectChannel, ResponseChannels);
+	}
+
+
+	[[nodiscard]] inline RpgPhysicsCollision::EChannel GetObjectChannel() const noexcept
+	{
+		return ObjectChannel;
+	}
+
+	[[nodiscard]] inline const RpgPhysicsCollision::FResponseChannels& GetResponseChannels() const noexcept
+	{
+		return ResponseChannels;
+	}
+
+	[[nodiscard]] inline const RpgPhysicsCollision::FFilterMask& GetFilterMask() const noexcept
+	{
+		return FilterMask;
+	}
+
+
+private:
+	// Object collision channel
+	RpgPhysicsCollision::EChannel ObjectChannel;
+
+	// Object response againts other channels
+	RpgPhysicsCollision::FResponseChannels ResponseChannels;
+
+	// Compacted from ObjectChannel and ResponseChannels, used to filter pairs
+	RpgPhysicsCollision::FFilterMask FilterMask;
+
 };
 
 
@@ -42,7 +87,11 @@ public:
 	RpgPhysicsComponent_Collision() noexcept
 	{
 		Shape = RpgPhysicsCollision::SHAPE_NONE;
+		BroadphaseProxyId = RPG_INDEX_INVALID;
+		BroadphaseChannel = RpgPhysicsCollision::CHANNEL_NONE;
 		bUpdateBounding = false;
+		bBoundUpdated = false;
+		bUpdateShape = false;
 	}
 
 
@@ -57,6 +106,7 @@ public:
 		Size = RpgVector4(radius);
 		Shape = RpgPhysicsCollision::SHAPE_SPHERE;
 		bUpdateBounding = true;
+		bUpdateShape = true;
 	}
 
 
@@ -65,6 +115,7 @@ public:
 		Size = RpgVector4(halfExtents.X, halfExtents.Y, halfExtents.Z, 0.0f);
 		Shape = RpgPhysicsCollision::SHAPE_BOX;
 		bUpdateBounding = true;
+		bUpdateShape = true;
 	}
 
 
@@ -73,6 +124,7 @@ public:
 		Size = RpgVector4(radius, halfHeight, 0.0f, 0.0f);
 		Shape = RpgPhysicsCollision::SHAPE_CAPSULE;
 		bUpdateBounding = true;
+		bUpdateShape = true;
 	}
 
 
@@ -82,6 +134,18 @@ public:
 	}
 
 
+	inline const RpgBoundingSphere& GetBound() const noexcept
+	{
+		return Bound;
+	}
+
+
+	inline const RpgPhysicsCollision::FShape& GetWorldShape() const noexcept
+	{
+		return WorldShape;
+	}
+
+
 private:
 	// Internal bounding sphere for broadphase
 	RpgBoundingSphere Bound;
@@ -94,15 +158,28 @@ private:
 	// Collision shape
 	RpgPhysicsCollision::EShape Shape;
 
+	// Collision shape in world space for narrowphase
+	RpgPhysicsCollision::FShape WorldShape;
+
 	// Linear velocity, rate of position change over time
 	RpgVector3 Velocity;
 
 	// Angular velocity, rate of orientation change over time
 	RpgVector3 AngularVelocity;
 
+	// Proxy in broadphase tree of BroadphaseChannel. Only valid if proxy is owned by the same game object (component data can be copied from other game object)
+	int BroadphaseProxyId;
+	RpgPhysicsCollision::EChannel BroadphaseChannel;
+
 	// Set true to update internal bounding AABB
 	bool bUpdateBounding;
 
+	// Set by update bound task when bound has changed. Broadphase proxy is moved only when this is true
+	bool bBoundUpdated;
+
+	// Set true to update world shape
+	bool bUpdateShape;
+
 
 	friend RpgPhysicsWorldSubsystem;
 	friend RpgPhysicsTask_UpdateBound;
@@ -1,11 +1,15 @@
 #include "RpgPhysicsWorldSubsystem.h"
 #include "RpgPhysicsComponent.h"
+#include "core/RpgProfiler.h"
 
 
 
 RpgPhysicsWorldSubsystem::RpgPhysicsWorldSubsystem() noexcept
 {
 	Name = "PhysicsWorldSubsystem";
+	BroadphaseSyncTick = 0;
+	NarrowphaseTick = 0;
+	TraceSceneIndex = 0;
 	bTickUpdateCollision = false;
 
 #ifndef RPG_BUILD_SHIPPING
@@ -16,6 +20,14 @@ RpgPhysicsWorldSubsystem::RpgPhysicsWorldSubsystem() noexcept
 }
 
 
+void RpgPhysicsWorldSubsystem::DeclareAccess(RpgWorldSubsystemAccess& out_Access) const noexcept
+{
+	out_Access.ReadTransform();
+	out_Access.ReadComponent<RpgPhysicsComponent_Filter>();
+	out_Access.WriteComponent<RpgPhysicsComponent_Collision>();
+}
+
+
 void RpgPhysicsWorldSubsystem::StartPlay() noexcept
 {
 	bTickUpdateCollision = true;
@@ -25,6 +37,258 @@ void RpgPhysicsWorldSubsystem::StartPlay() noexcept
 void RpgPhysicsWorldSubsystem::StopPlay() noexcept
 {
 	bTickUpdateCollision = false;
+
+	for (int c = 0; c < RpgPhysicsCollision::CHANNEL_MAX_COUNT; ++c)
+	{
+		BroadphasePools[c].Tree.Clear();
+		BroadphasePools[c].Proxies.Clear();
+		BroadphasePools[c].ResponseMask = 0;
+	}
+
+	ManifoldCache.Clear();
+	ContactManifolds.Clear();
+	NarrowphaseStats = FNarrowphaseStats();
+
+	TraceScenes[0].Clear();
+	TraceScenes[1].Clear();
+	TraceProxyObjects.Clear();
+}
+
+
+void RpgPhysicsWorldSubsystem::UpdateBroadphaseProxies(float deltaTime) noexcept
+{
+	RPG_PROFILE_SCOPE("RpgPhysicsWorldSubsystem_UpdateBroadphaseProxies");
+
+	++BroadphaseSyncTick;
+
+	for (int c = 0; c < RpgPhysicsCollision::CHANNEL_MAX_COUNT; ++c)
+	{
+		BroadphasePools[c].ResponseMask = 0;
+	}
+
+	GetWorld()->Component_Query<RpgPhysicsComponent_Filter, RpgPhysicsComponent_Collision>().ForEach(
+		[this, deltaTime](const RpgPhysicsComponent_Filter& filter, RpgPhysicsComponent_Collision& collision)
+		{
+			const RpgPhysicsCollision::EChannel channel = filter.GetObjectChannel();
+			const RpgPhysicsCollision::FFilterMask& filterMask = filter.GetFilterMask();
+
+			FBroadphasePool& prevPool = BroadphasePools[collision.BroadphaseChannel];
+			const int proxyId = collision.BroadphaseProxyId;
+			bool bValidProxy = prevPool.Tree.IsProxyValid(proxyId) && prevPool.Proxies[proxyId].GameObject == collision.GameObject;
+
+			// Filter has changed, proxy is recreated in pool of new channel
+			if (bValidProxy && (collision.BroadphaseChannel != channel || prevPool.Proxies[proxyId].FilterMask != filterMask))
+			{
+				prevPool.Tree.DestroyProxy(proxyId);
+				prevPool.Proxies[proxyId] = RpgPhysicsCollision::Broadphase::FProxy();
+				bValidProxy = false;
+			}
+
+			if (channel == RpgPhysicsCollision::CHANNEL_NONE)
+			{
+				collision.BroadphaseProxyId = RPG_INDEX_INVALID;
+				collision.BroadphaseChannel = RpgPhysicsCollision::CHANNEL_NONE;
+				return;
+			}
+
+			FBroadphasePool& pool = BroadphasePools[channel];
+
+			const RpgBoundingSphere& bound = collision.Bound;
+			const RpgVector3 radius(bound.GetRadius());
+			const RpgBoundingAABB aabb(bound.GetCenter() - radius, bound.GetCenter() + radius);
+
+			if (bValidProxy)
+			{
+				if (collision.bBoundUpdated)
+				{
+					pool.Tree.MoveProxy(proxyId, aabb, collision.Velocity * deltaTime);
+				}
+			}
+			else
+			{
+				collision.BroadphaseProxyId = pool.Tree.CreateProxy(aabb, filterMask.ChannelBit, filterMask.ResponseMask);
+				collision.BroadphaseChannel = channel;
+
+				if (collision.BroadphaseProxyId >= pool.Proxies.GetCount())
+				{
+					pool.Proxies.Resize(collision.BroadphaseProxyId + 1);
+				}
+			}
+
+			collision.bBoundUpdated = false;
+
+			RpgPhysicsCollision::Broadphase::FProxy& proxy = pool.Proxies[collision.BroadphaseProxyId];
+			proxy.GameObject = collision.GameObject;
+			proxy.Collision = &collision;
+			proxy.FilterMask = filterMask;
+			proxy.SyncTick = BroadphaseSyncTick;
+
+			pool.ResponseMask |= filterMask.ResponseMask;
+		}
+	);
+
+	// Destroy proxies of game objects that no longer have collision
+	for (int c = 0; c < RpgPhysicsCollision::CHANNEL_MAX_COUNT; ++c)
+	{
+		FBroadphasePool& pool = BroadphasePools[c];
+
+		for (int i = 0; i < pool.Proxies.GetCount(); ++i)
+		{
+			RpgPhysicsCollision::Broadphase::FProxy& proxy = pool.Proxies[i];
+
+			if (proxy.GameObject.IsValid() && proxy.SyncTick != BroadphaseSyncTick)
+			{
+				pool.Tree.DestroyProxy(i);
+				proxy = RpgPhysicsCollision::Broadphase::FProxy();
+			}
+		}
+	}
+}
+
+
+void RpgPhysicsWorldSubsystem::GenerateBroadphasePairs() noexcept
+{
+	RPG_PROFILE_SCOPE("RpgPhysicsWorldSubsystem_GenerateBroadphasePairs");
+
+	for (int a = RpgPhysicsCollision::CHANNEL_NONE + 1; a < RpgPhysicsCollision::CHANNEL_MAX_COUNT; ++a)
+	{
+		const FBroadphasePool& poolA = BroadphasePools[a];
+
+		if (poolA.Tree.GetProxyCount() == 0)
+		{
+			continue;
+		}
+
+		const RpgPhysicsCollision::FChannelMask channelBitA = RpgPhysicsCollision::GetChannelBit(static_cast<RpgPhysicsCollision::EChannel>(a));
+
+		for (int b = a; b < RpgPhysicsCollision::CHANNEL_MAX_COUNT; ++b)
+		{
+			const FBroadphasePool& poolB = BroadphasePools[b];
+			const RpgPhysicsCollision::FChannelMask channelBitB = RpgPhysicsCollision::GetChannelBit(static_cast<RpgPhysicsCollision::EChannel>(b));
+
+			if (poolB.Tree.GetProxyCount() == 0 || (poolA.ResponseMask & channelBitB) == 0 || (poolB.ResponseMask & channelBitA) == 0)
+			{
+				continue;
+			}
+
+			RpgPhysicsCollision::Broadphase::GeneratePairs(NarrowphaseCollisionPairs, poolA.Tree, poolA.Proxies.GetData(), poolB.Tree, poolB.Proxies.GetData());
+		}
+	}
+}
+
+
+void RpgPhysicsWorldSubsystem::UpdateNarrowphase() noexcept
+{
+	RPG_PROFILE_SCOPE("RpgPhysicsWorldSubsystem_UpdateNarrowphase");
+
+	++NarrowphaseTick;
+
+	const int pairCount = NarrowphaseCollisionPairs.GetCount();
+	int taskCount = 0;
+
+	if (pairCount > 0)
+	{
+		taskCount = (pairCount + RPG_PHYSICS_NARROWPHASE_MIN_PAIR_PER_TASK - 1) / RPG_PHYSICS_NARROWPHASE_MIN_PAIR_PER_TASK;
+		taskCount = RpgMath::Min(taskCount, RpgThreadPool::GetWorkerCount() + 1);
+		taskCount = RpgMath::Clamp(taskCount, 1, RPG_PHYSICS_NARROWPHASE_MAX_TASK);
+
+		const int pairPerTask = (pairCount + taskCount - 1) / taskCount;
+		RpgThreadTask* submitTasks[RPG_PHYSICS_NARROWPHASE_MAX_TASK];
+
+		for (int t = 0; t < taskCount; ++t)
+		{
+			const int pairStart = t * pairPerTask;
+
+			RpgPhysicsTask_TestOverlapPair& task = TaskTestOverlapPairs[t];
+			task.Reset();
+			task.Pairs = NarrowphaseCollisionPairs.GetData() + pairStart;
+			task.PairCount = RpgMath::Min(pairPerTask, pairCount - pairStart);
+			task.ManifoldCache = &ManifoldCache;
+			task.Tick = NarrowphaseTick;
+			submitTasks[t] = &task;
+		}
+
+		RpgThreadPool::SubmitTasks(submitTasks, taskCount);
+		RPG_THREAD_TASK_WaitAll(submitTasks, taskCount);
+	}
+
+	// Cache is only read while tasks are running. Merge on this thread, no locks needed
+	ContactManifolds.Clear();
+	NarrowphaseStats = FNarrowphaseStats();
+	NarrowphaseStats.PairCount = pairCount;
+	NarrowphaseStats.TaskCount = taskCount;
+
+	for (int t = 0; t < taskCount; ++t)
+	{
+		const RpgPhysicsTask_TestOverlapPair& task = TaskTestOverlapPairs[t];
+		ContactManifolds.InsertAtRange(task.Manifolds, ContactManifolds.GetCount());
+
+		for (int i = 0; i < task.CacheUpdates.GetCount(); ++i)
+		{
+			const RpgPhysicsTask_TestOverlapPair::FCacheUpdate& update = task.CacheUpdates[i];
+			ManifoldCache.Add(update.PairId) = update.Entry;
+		}
+
+		NarrowphaseStats.FullTestCount += task.FullTestCount;
+		NarrowphaseStats.CachedSeparatedCount += task.CachedSeparatedCount;
+		NarrowphaseStats.CachedContactCount += task.CachedContactCount;
+		NarrowphaseStats.BatchTestCount += task.BatchTestCount;
+	}
+
+	// Evict pairs that are no longer generated by broadphase. Removing swaps with last entry, iterate backward
+	for (int i = ManifoldCache.GetCount() - 1; i >= 0; --i)
+	{
+		if (ManifoldCache.GetValueByIndex(i).Tick != NarrowphaseTick)
+		{
+			ManifoldCache.RemoveAt(i);
+		}
+	}
+
+	NarrowphaseStats.ManifoldCount = ContactManifolds.GetCount();
+	NarrowphaseStats.CacheEntryCount = ManifoldCache.GetCount();
+}
+
+
+void RpgPhysicsWorldSubsystem::UpdateTraceScene() noexcept
+{
+	RPG_PROFILE_SCOPE("RpgPhysicsWorldSubsystem_UpdateTraceScene");
+
+	const int backIndex = (TraceSceneIndex + 1) % 2;
+	RpgPhysicsTrace::FScene& scene = TraceScenes[backIndex];
+	scene.Clear();
+
+	for (int c = RpgPhysicsCollision::CHANNEL_NONE + 1; c < RpgPhysicsCollision::CHANNEL_MAX_COUNT; ++c)
+	{
+		const FBroadphasePool& pool = BroadphasePools[c];
+
+		if (pool.Tree.GetProxyCount() == 0)
+		{
+			continue;
+		}
+
+		// Copy shapes now, components may change while the scene is traced
+		TraceProxyObjects.Resize(pool.Proxies.GetCount());
+
+		for (int i = 0; i < pool.Proxies.GetCount(); ++i)
+		{
+			const RpgPhysicsCollision::Broadphase::FProxy& proxy = pool.Proxies[i];
+
+			if (proxy.Collision == nullptr || !pool.Tree.IsProxyValid(i))
+			{
+				continue;
+			}
+
+			RpgPhysicsTrace::FSceneObject& object = TraceProxyObjects[i];
+			object.GameObject = proxy.GameObject;
+			object.Shape = proxy.Collision->GetWorldShape();
+			object.FilterMask = proxy.FilterMask;
+		}
+
+		scene.AddTree(pool.Tree, TraceProxyObjects.GetData());
+	}
+
+	// Publish after scene is fully built. Interlocked exchange is a full barrier, GetTraceScene reads the index through volatile load
+	InterlockedExchange(&TraceSceneIndex, backIndex);
 }
 
 
@@ -35,8 +299,12 @@ void RpgPhysicsWorldSubsystem::TickUpdate(float deltaTime) noexcept
 		return;
 	}
 
-	BroadphaseCollisionPairs.Clear();
-	NarrowphaseCollisionPairs.Clear();
+	RPG_MEMORY_SCOPE_TAG(TAG_PHYSICS);
+
+	// Pairs memory from previous tick belongs to other frame arena. Reserve previous count to avoid growing one by one
+	const int prevNarrowphasePairCount = NarrowphaseCollisionPairs.GetCount();
+	NarrowphaseCollisionPairs.Clear(true);
+	NarrowphaseCollisionPairs.Reserve(prevNarrowphasePairCount);
 
 	RpgWorld* world = GetWorld();
 
@@ -57,30 +325,21 @@ void RpgPhysicsWorldSubsystem::TickUpdate(float deltaTime) noexcept
 	RpgThreadPool::SubmitTasks(submitTasks.GetData(), submitTasks.GetCount());
 
 
-	// generate pairs for broadphase
-	RpgPhysicsCollision::Filter::GeneratePairs(BroadphaseCollisionPairs, world);
-
-	if (BroadphaseCollisionPairs.IsEmpty())
-	{
-		return;
-	}
-
-
 	// wait update bound finished
 	TaskUpdateBound.Wait();
 
-	// generate pairs for narrowphase
-	RpgPhysicsCollision::Broadphase::GeneratePairs(NarrowphaseCollisionPairs, BroadphaseCollisionPairs);
-
+	// refit moved proxies, then generate pairs for narrowphase from broadphase pools
+	UpdateBroadphaseProxies(deltaTime);
+	GenerateBroadphasePairs();
 
 	// wait update shape finished
 	TaskUpdateShape.Wait();
 
-	// test overlaps
-	for (int i = 0; i < NarrowphaseCollisionPairs.GetCount(); ++i)
-	{
+	// test overlaps. Also runs without pairs to clear manifolds and evict cache
+	UpdateNarrowphase();
 
-	}
+	// publish snapshot for trace queries
+	UpdateTraceScene();
 }
 
 
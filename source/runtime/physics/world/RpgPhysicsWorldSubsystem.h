@@ -1,28 +1,108 @@
 #pragma once
 
 #include "core/world/RpgWorld.h"
+#include "../RpgPhysicsDynamicTree.h"
 #include "../task/RpgPhysicsTask_UpdateBound.h"
 #include "../task/RpgPhysicsTask_UpdateShape.h"
+#include "../task/RpgPhysicsTask_TestOverlapPair.h"
 
 
 
 class RpgPhysicsWorldSubsystem : public RpgWorldSubsystem
 {
+public:
+	// Narrowphase stats of the latest tick
+	struct FNarrowphaseStats
+	{
+		int PairCount{ 0 };
+		int TaskCount{ 0 };
+		int ManifoldCount{ 0 };
+		int FullTestCount{ 0 };
+		int CachedSeparatedCount{ 0 };
+		int CachedContactCount{ 0 };
+		int BatchTestCount{ 0 };
+		int CacheEntryCount{ 0 };
+	};
+
+
 public:
 	RpgPhysicsWorldSubsystem() noexcept;
 
+
+	// @returns Contact manifolds of overlapped pairs from the latest tick
+	[[nodiscard]] inline const RpgArray<RpgPhysicsCollision::FContactManifold>& GetContactManifolds() const noexcept
+	{
+		return ContactManifolds;
+	}
+
+	[[nodiscard]] inline const FNarrowphaseStats& GetNarrowphaseStats() const noexcept
+	{
+		return NarrowphaseStats;
+	}
+
+	// Can be called from any thread. Tasks tracing the scene must finish before the end of the next tick
+	// @returns Trace scene published at the end of the latest tick. Scene stays valid and unchanged until the end of the next tick
+	[[nodiscard]] inline const RpgPhysicsTrace::FScene& GetTraceScene() const noexcept
+	{
+		return TraceScenes[TraceSceneIndex];
+	}
+
+
 protected:
+	virtual void DeclareAccess(RpgWorldSubsystemAccess& out_Access) const noexcept override;
 	virtual void StartPlay() noexcept override;
 	virtual void StopPlay() noexcept override;
 	virtual void TickUpdate(float deltaTime) noexcept override;
 	virtual void Render(int frameIndex, RpgRenderer* renderer) noexcept override;
 
 
+private:
+	// Create proxies for new collisions, move proxies of updated bounds and destroy proxies of removed collisions (or changed filters)
+	void UpdateBroadphaseProxies(float deltaTime) noexcept;
+
+	// Generate pairs within each pool and between pools whose channels respond to each other
+	void GenerateBroadphasePairs() noexcept;
+
+	// Split broadphase pairs into chunks tested in parallel, then merge task outputs into contact manifolds and manifold cache
+	void UpdateNarrowphase() noexcept;
+
+	// Rebuild back trace scene from broadphase pools and world shapes, then publish it
+	void UpdateTraceScene() noexcept;
+
+
+private:
+	// Proxies of one object channel. Pools of channels that never respond to each other are never tested against each other
+	struct FBroadphasePool
+	{
+		RpgPhysicsDynamicTree Tree;
+
+		// Indexed by proxy ID
+		RpgArray<RpgPhysicsCollision::Broadphase::FProxy> Proxies;
+
+		// Union of response masks of all proxies in pool, rebuilt every sync
+		RpgPhysicsCollision::FChannelMask ResponseMask{ 0 };
+	};
+
+
 private:
 	RpgPhysicsTask_UpdateBound TaskUpdateBound;
 	RpgPhysicsTask_UpdateShape TaskUpdateShape;
-	RpgArray<RpgPhysicsCollision::FPairTest> BroadphaseCollisionPairs;
-	RpgArray<RpgPhysicsCollision::FPairTest> NarrowphaseCollisionPairs;
+	FBroadphasePool BroadphasePools[RpgPhysicsCollision::CHANNEL_MAX_COUNT];
+	uint32_t BroadphaseSyncTick;
+	RpgPhysicsCollision::FPairTestArray NarrowphaseCollisionPairs;
+	RpgPhysicsTask_TestOverlapPair TaskTestOverlapPairs[RPG_PHYSICS_NARROWPHASE_MAX_TASK];
+	RpgPhysicsCollision::Narrowphase::FManifoldCache ManifoldCache;
+	RpgArray<RpgPhysicsCollision::FContactManifold> ContactManifolds;
+	FNarrowphaseStats NarrowphaseStats;
+	uint32_t NarrowphaseTick;
+
+	// Double buffered, tasks tracing published scene are not affected by rebuild of the other scene
+	RpgPhysicsTrace::FScene TraceScenes[2];
+
+	// Index of published scene. Written only by UpdateTraceScene on game thread, read by any thread
+	RpgAtomicInt TraceSceneIndex;
+	RpgArray<RpgPhysicsTrace::FSceneObject> TraceProxyObjects;
+
 	bool bTickUpdateCollision;
 
 
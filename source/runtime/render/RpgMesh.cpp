@@ -21,6 +21,8 @@ void RpgMesh::UpdateVertexData(int vertexCount, const RpgVertex::FMeshPosition*
 	RPG_Assert(indexCount > 0);
 	RPG_Assert(indexData);
 
+	RPG_MEMORY_SCOPE_TAG(TAG_MESH);
+
 	Flags = FLAG_None;
 
 	WriteLockAll();
@@ -67,6 +69,8 @@ void RpgMesh::AddBatchVertexData(int vertexCount, const RpgVertex::FMeshPosition
 	RPG_Assert(indexCount > 0);
 	RPG_Assert(indexData);
 
+	RPG_MEMORY_SCOPE_TAG(TAG_MESH);
+
 	const uint32_t baseVertex = static_cast<uint32_t>(Positions.GetCount());
 	if (baseVertex == 0)
 	{
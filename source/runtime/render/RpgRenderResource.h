@@ -195,7 +195,7 @@ public:
 	RpgMeshSkinnedResource() noexcept;
 	
 	FMeshID AddMesh(const RpgSharedMesh& mesh, int& out_IndexCount, int& out_IndexStart, int& out_IndexVertexOffset) noexcept;
-	FSkeletonID AddObjectBoneSkinningTransforms(FMeshID meshId, const RpgArray<RpgMatrixTransform>& boneSkinningTransforms) noexcept;
+	FSkeletonID AddObjectBoneSkinningTransforms(FMeshID meshId, const RpgMatrixTransform* boneSkinningTransforms, int boneCount) noexcept;
 
 	void UpdateResources() noexcept;
 	void CommandCopy(ID3D12GraphicsCommandList* cmdList) noexcept;
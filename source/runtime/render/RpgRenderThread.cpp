@@ -1,5 +1,6 @@
 #include "RpgRenderThread.h"
 #include "RpgRenderer.h"
+#include "core/RpgProfiler.h"
 
 
 
@@ -23,6 +24,9 @@ namespace RpgRenderThread
 	{
 		RPG_Log(RpgLogSystem, "[Thread-render] running...");
 
+		RpgPlatformMemory::SetThreadTag(RpgPlatformMemory::TAG_RENDER);
+		RPG_PROFILE_THREAD_NAME("Render");
+
 		static int FrameCounter = 0;
 
 		while (bRunning)
@@ -41,7 +45,10 @@ namespace RpgRenderThread
 
 			FFrameData& frame = FrameDatas[frameIndex];
 			RPG_Check(frame.Renderer);
-			frame.Renderer->Execute(FrameCounter, frameIndex, frame.DeltaTime);
+			{
+				RPG_PROFILE_SCOPE("RpgRenderThread_ExecuteFrame");
+				frame.Renderer->Execute(FrameCounter, frameIndex, frame.DeltaTime);
+			}
 			frame.Renderer = nullptr;
 
 			//RPG_Log(RpgLogSystem, "[Thread-render] Finish frame (%i)", frameIndex);
@@ -65,6 +65,8 @@ RpgRenderer::~RpgRenderer() noexcept
 
 void RpgRenderer::BeginRender(int frameIndex, float deltaTime) noexcept
 {
+	RPG_MEMORY_SCOPE_TAG(TAG_RENDER);
+
 	WaitFrameFinished(frameIndex);
 
 	FFrameData& frame = FrameDatas[frameIndex];
@@ -79,10 +79,17 @@ private:
 	};
 
 
+	// Clips of previous use of the frame index are destroyed after frame arena reset, must not have destructor that touches memory
+	static_assert(std::is_trivially_destructible<FClip>::value, "RpgRenderer2D: FClip must be trivially destructible!");
+
+
 	struct FOrder
 	{
 		uint8_t Value{ 255 };
-		RpgArray<FClip, 8> Clips;
+
+		// Orders are rebuilt every frame, allocated from frame arena
+		RpgArray<FClip, 8, RpgAllocatorFrame> Clips;
+
 		int CurrentClipIndex{ RPG_INDEX_INVALID };
 	};
 
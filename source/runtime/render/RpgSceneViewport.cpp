@@ -28,12 +28,23 @@ RpgSceneViewport::RpgSceneViewport() noexcept
 }
 
 
+template<typename T>
+static void SceneViewport_ResetFrameArray(RpgArray<T, 1, RpgAllocatorFrame>& frameArray, int frameIndex) noexcept
+{
+	// Memory is from previous use of this frame index. Reserve previous count to avoid growing one by one
+	const int prevCount = frameArray.GetCount();
+	frameArray.Clear(true);
+	frameArray.SetAllocator(RpgAllocatorFrame(frameIndex));
+	frameArray.Reserve(prevCount);
+}
+
+
 void RpgSceneViewport::PreRender(RpgRenderFrameContext& frameContext, RpgWorldResource* worldResource, const RpgWorld* world) noexcept
 {
 	FFrameData& frame = FrameDatas[frameContext.Index];
-	frame.DrawOpaqueMeshes.Clear();
-	frame.DrawOpaqueSkinnedMeshes.Clear();
-	frame.DrawTransparencies.Clear();
+	SceneViewport_ResetFrameArray(frame.DrawOpaqueMeshes, frameContext.Index);
+	SceneViewport_ResetFrameArray(frame.DrawOpaqueSkinnedMeshes, frameContext.Index);
+	SceneViewport_ResetFrameArray(frame.DrawTransparencies, frameContext.Index);
 
 
 	// Resize render target
@@ -69,7 +80,7 @@ void RpgSceneViewport::PreRender(RpgRenderFrameContext& frameContext, RpgWorldRe
 
 	const RpgWorldResource::FViewID cameraId = worldResource->AddView(ViewMatrix, ProjectionMatrix, ViewPosition, NearClipZ, FarClipZ);
 
-	RpgArray<RpgMatrixTransform> tempBoneSkinningTransforms;
+	RpgArray<RpgMatrixTransform, 1, RpgAllocatorFrame> tempBoneSkinningTransforms(RpgAllocatorFrame(frameContext.Index));
 
 	for (int m = 0; m < frame.Meshes.GetCount(); ++m)
 	{
@@ -104,7 +115,7 @@ void RpgSceneViewport::PreRender(RpgRenderFrameContext& frameContext, RpgWorldRe
 				}
 
 				const RpgMeshSkinnedResource::FMeshID meshId = meshSkinnedResource->AddMesh(data.Mesh, draw.IndexCount, draw.IndexStart, draw.IndexVertexOffset);
-				meshSkinnedResource->AddObjectBoneSkinningTransforms(meshId, tempBoneSkinningTransforms);
+				meshSkinnedResource->AddObjectBoneSkinningTransforms(meshId, tempBoneSkinningTransforms.GetData(), tempBoneSkinningTransforms.GetCount());
 			}
 		}
 
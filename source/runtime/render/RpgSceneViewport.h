@@ -112,10 +112,11 @@ private:
 		RpgArray<RpgSceneMesh> Meshes;
 		RpgArray<RpgSceneLight> Lights;
 
-		RpgArray<RpgDrawIndexed> DrawOpaqueMeshes;
-		RpgArray<RpgDrawIndexed> DrawOpaqueSkinnedMeshes;
+		// Draw lists are rebuilt by render thread every frame, allocated from frame arena
+		RpgArray<RpgDrawIndexed, 1, RpgAllocatorFrame> DrawOpaqueMeshes;
+		RpgArray<RpgDrawIndexed, 1, RpgAllocatorFrame> DrawOpaqueSkinnedMeshes;
 
-		RpgArray<RpgDrawIndexed> DrawTransparencies;
+		RpgArray<RpgDrawIndexed, 1, RpgAllocatorFrame> DrawTransparencies;
 
 		RpgRenderTask_RenderPassForward TaskRenderPassForward;
 	};
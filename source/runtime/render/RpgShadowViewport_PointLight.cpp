@@ -26,7 +26,7 @@ void RpgShadowViewport_PointLight::PreRender(RpgRenderFrameContext& frameContext
 	depthTexture->Resize(shadowTextureDimension, shadowTextureDimension);
 	depthTexture->GPU_UpdateResource();
 
-	RpgTransform transform = world->GameObject_GetWorldTransform(GameObject);
+	RpgTransform transform = world->GameObject_GetInterpolatedWorldTransform(GameObject);
 	const float fovDegree = 91.0f;
 	const float nearClipZ = 1.0f;
 	const float farClipZ = AttenuationRadius * 1.05f;
@@ -94,7 +94,7 @@ void RpgShadowViewport_PointLight::PreRender(RpgRenderFrameContext& frameContext
 			continue;
 		}
 
-		const RpgMatrixTransform worldTransformMatrix = world->GameObject_GetWorldTransformMatrix(comp.GameObject);
+		const RpgMatrixTransform worldTransformMatrix = world->GameObject_GetInterpolatedWorldTransformMatrix(comp.GameObject);
 
 		/*
 		const RpgSharedModel& model = comp.Model;
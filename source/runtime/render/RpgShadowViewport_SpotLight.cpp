@@ -28,7 +28,7 @@ void RpgShadowViewport_SpotLight::PreRender(RpgRenderFrameContext& frameContext,
 	depthTexture->Resize(shadowTextureDimension, shadowTextureDimension);
 	depthTexture->GPU_UpdateResource();
 
-	const RpgTransform transform = world->GameObject_GetWorldTransform(GameObject);
+	const RpgTransform transform = world->GameObject_GetInterpolatedWorldTransform(GameObject);
 	const RpgMatrixTransform viewMatrix = transform.ToMatrixTransform().GetInverse();
 	const float fovDegree = SpotInnerConeDegree * 2.0f;
 	const float nearClipZ = 1.0f;
@@ -50,7 +50,7 @@ void RpgShadowViewport_SpotLight::PreRender(RpgRenderFrameContext& frameContext,
 			continue;
 		}
 
-		const RpgMatrixTransform worldTransformMatrix = world->GameObject_GetWorldTransformMatrix(comp.GameObject);
+		const RpgMatrixTransform worldTransformMatrix = world->GameObject_GetInterpolatedWorldTransformMatrix(comp.GameObject);
 
 		/*
 		const RpgSharedModel& model = comp.Model;
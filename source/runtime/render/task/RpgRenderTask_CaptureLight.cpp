@@ -44,7 +44,7 @@ void RpgRenderTask_CaptureLight::Execute() noexcept
 
 		RpgSceneLight& data = sceneLights.Add();
 		data.GameObject = comp.GameObject;
-		data.WorldTransform = World->GameObject_GetWorldTransform(comp.GameObject);
+		data.WorldTransform = World->GameObject_GetInterpolatedWorldTransform(comp.GameObject);
 		data.Type = comp.Type;
 		data.ColorIntensity = comp.ColorIntensity;
 		data.AttenuationRadius = comp.AttenuationRadius;
@@ -46,7 +46,7 @@ void RpgRenderTask_CaptureMesh::Execute() noexcept
 			continue;
 		}
 
-		const RpgMatrixTransform worldTransformMatrix = World->GameObject_GetWorldTransformMatrix(comp.GameObject);
+		const RpgMatrixTransform worldTransformMatrix = World->GameObject_GetInterpolatedWorldTransformMatrix(comp.GameObject);
 
 		RpgSceneMesh& data = sceneMeshes.Add();
 		data.GameObject = comp.GameObject;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/world/RpgComponent.h"
+#include "core/world/RpgWorldSnapshotAsset.h"
 #include "../RpgModel.h"
 #include "../RpgSceneViewport.h"
 #include "../RpgShadowViewport.h"
@@ -17,6 +18,8 @@ class RpgRenderComponent_Mesh
 	RPG_COMPONENT_TYPE("RpgComponent (Render) - Mesh");
 
 public:
+	static constexpr uint32_t SNAPSHOT_VERSION = 2;
+
 	RpgBoundingAABB Bound;
 	RpgSharedMesh Mesh;
 	RpgSharedMaterial Material;
@@ -37,6 +40,31 @@ public:
 	}
 
 
+	// Mesh and material are saved by name, they must be registered in RpgWorldSnapshotAsset to be resolved on load
+	inline void Serialize(RpgStreamWriter& writer) const noexcept
+	{
+		writer.Write(Bound);
+		writer.Write(bIsVisible);
+		RpgWorldSnapshotAsset<RpgMesh>::Write(writer, Mesh);
+		RpgWorldSnapshotAsset<RpgMaterial>::Write(writer, Material);
+	}
+
+
+	inline void Deserialize(RpgStreamReader& reader) noexcept
+	{
+		reader.Read(Bound);
+		reader.Read(bIsVisible);
+		RpgWorldSnapshotAsset<RpgMesh>::Read(reader, Mesh);
+		RpgWorldSnapshotAsset<RpgMaterial>::Read(reader, Material);
+	}
+
+
+	[[nodiscard]] inline bool IsSnapshotSupported() const noexcept
+	{
+		return RpgWorldSnapshotAsset<RpgMesh>::IsRegistered(Mesh) && RpgWorldSnapshotAsset<RpgMaterial>::IsRegistered(Material);
+	}
+
+
 	friend RpgRenderWorldSubsystem;
 
 };
@@ -48,6 +76,8 @@ class RpgRenderComponent_Light
 	RPG_COMPONENT_TYPE("RpgComponent (Render) - Light");
 
 public:
+	static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
 	// Light type (point light, spot light, directional light)
 	RpgRenderLight::EType Type;
 
@@ -94,6 +124,33 @@ public:
 	}
 
 
+	// Shadow viewport is recreated by render subsystem
+	inline void Serialize(RpgStreamWriter& writer) const noexcept
+	{
+		writer.Write(Type);
+		writer.Write(ColorIntensity);
+		writer.Write(AttenuationRadius);
+		writer.Write(AttenuationFallOffExp);
+		writer.Write(SpotInnerConeDegree);
+		writer.Write(SpotOuterConeDegree);
+		writer.Write(bCastShadow);
+		writer.Write(bIsVisible);
+	}
+
+
+	inline void Deserialize(RpgStreamReader& reader) noexcept
+	{
+		reader.Read(Type);
+		reader.Read(ColorIntensity);
+		reader.Read(AttenuationRadius);
+		reader.Read(AttenuationFallOffExp);
+		reader.Read(SpotInnerConeDegree);
+		reader.Read(SpotOuterConeDegree);
+		reader.Read(bCastShadow);
+		reader.Read(bIsVisible);
+	}
+
+
 	inline RpgShadowViewport* GetShadowViewport() noexcept
 	{
 		return ShadowViewport.Get();
@@ -115,6 +172,8 @@ class RpgRenderComponent_Camera
 	RPG_COMPONENT_TYPE("RpgComponent (Render) - Camera");
 
 public:
+	static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
 	RpgPointInt RenderTargetDimension;
 	RpgRenderProjectionMode ProjectionMode;
 	float PerspectiveFoVDegree;
@@ -146,6 +205,31 @@ public:
 	}
 
 
+	// Viewport is runtime data and not serialized
+	inline void Serialize(RpgStreamWriter& writer) const noexcept
+	{
+		writer.Write(RenderTargetDimension);
+		writer.Write(ProjectionMode);
+		writer.Write(PerspectiveFoVDegree);
+		writer.Write(NearClipZ);
+		writer.Write(FarClipZ);
+		writer.Write(bActivated);
+		writer.Write(bFrustumCulling);
+	}
+
+
+	inline void Deserialize(RpgStreamReader& reader) noexcept
+	{
+		reader.Read(RenderTargetDimension);
+		reader.Read(ProjectionMode);
+		reader.Read(PerspectiveFoVDegree);
+		reader.Read(NearClipZ);
+		reader.Read(FarClipZ);
+		reader.Read(bActivated);
+		reader.Read(bFrustumCulling);
+	}
+
+
 	inline RpgSceneViewport* GetSceneViewport() noexcept
 	{
 		if (Viewport)
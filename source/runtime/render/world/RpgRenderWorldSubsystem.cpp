@@ -18,23 +18,39 @@ RpgRenderWorldSubsystem::RpgRenderWorldSubsystem() noexcept
 }
 
 
+void RpgRenderWorldSubsystem::DeclareAccess(RpgWorldSubsystemAccess& out_Access) const noexcept
+{
+	// Nothing to tick, all work is done in Render
+	out_Access.bMainThread = true;
+}
+
+
 void RpgRenderWorldSubsystem::Render(int frameIndex, RpgRenderer* renderer) noexcept
 {
 	RpgWorld* world = GetWorld();
 
-	for (auto it = world->Component_CreateIterator<RpgRenderComponent_Mesh>(); it; ++it)
+	// Only game objects whose transform or components changed this frame need bound update
+	for (int i = 0; i < world->ChangeList_GetCount(); ++i)
 	{
-		RpgRenderComponent_Mesh& comp = it.GetValue();
+		const RpgGameObjectID gameObject = world->ChangeList_GetGameObject(i);
+
+		if (!world->GameObject_IsValid(gameObject))
+		{
+			continue;
+		}
+
+		RpgRenderComponent_Mesh* mesh = world->GameObject_GetComponent<RpgRenderComponent_Mesh>(gameObject);
 
-		if (!world->GameObject_IsTransformUpdated(comp.GameObject))
+		if (mesh == nullptr)
 		{
 			continue;
 		}
 
+		RpgRenderComponent_Mesh& comp = *mesh;
 		comp.Bound = comp.Mesh ? comp.Mesh->GetBound() : RpgBoundingAABB(RpgVector3(-32.0f), RpgVector3(32.0f));
 
 		// transform bound into world space
-		comp.Bound = RpgBoundingBox(comp.Bound, world->GameObject_GetWorldTransformMatrix(comp.GameObject)).ToAABB();
+		comp.Bound = RpgBoundingBox(comp.Bound, world->GameObject_GetInterpolatedWorldTransformMatrix(comp.GameObject)).ToAABB();
 	}
 
 
@@ -98,7 +114,7 @@ void RpgRenderWorldSubsystem::Render(int frameIndex, RpgRenderer* renderer) noex
 		RpgSceneViewport* sceneViewport = comp.GetSceneViewport();
 		sceneViewport->RenderTargetDimension = comp.RenderTargetDimension;
 
-		const RpgTransform worldTransform = world->GameObject_GetWorldTransform(comp.GameObject);
+		const RpgTransform worldTransform = world->GameObject_GetInterpolatedWorldTransform(comp.GameObject);
 		sceneViewport->SetViewRotationAndPosition(worldTransform.Rotation, worldTransform.Position);
 
 		if (comp.ProjectionMode == RpgRenderProjectionMode::PERSPECTIVE)
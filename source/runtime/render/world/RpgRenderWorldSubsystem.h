@@ -10,6 +10,7 @@ public:
 	RpgRenderWorldSubsystem() noexcept;
 
 protected:
+	virtual void DeclareAccess(RpgWorldSubsystemAccess& out_Access) const noexcept override;
 	virtual void Render(int frameIndex, RpgRenderer* renderer) noexcept override;
 
 
@@ -13,6 +13,15 @@ namespace RpgTest
 		extern void Test_FilePath() noexcept;
 		extern void Test_Pointer() noexcept;
 
+		// Save, load with remapped component types and reused game object slots, external parents, schema change and truncated data
+		extern void Test_World_Snapshot() noexcept;
+
+		// Compare RpgMap against linear scan lookup for 1k - 1M entries. Results are written to console
+		extern void Benchmark_DSA_Map() noexcept;
+
+		// Compare RpgAlgorithm sorts against std::sort/std::stable_sort for 10k - 10M keys. Results are written to console
+		extern void Benchmark_DSA_Algorithm() noexcept;
+
 
 		inline void Execute() noexcept
 		{
@@ -23,6 +32,7 @@ namespace RpgTest
 			Test_String();
 			Test_FilePath();
 			Test_Pointer();
+			Test_World_Snapshot();
 		}
 
 	};
@@ -1,5 +1,10 @@
 #include "RpgTestCore.h"
 #include "core/dsa/RpgAlgorithm.h"
+#include "core/RpgThreadPool.h"
+#include "core/RpgString.h"
+#include "core/RpgConsoleSystem.h"
+#include "core/RpgTimer.h"
+#include <algorithm>
 
 
 
@@ -241,6 +246,228 @@ static void Test_Array_InsertElements() noexcept
 }
 
 
+// Deterministic pseudo random values (xorshift)
+static uint32_t TestRandom(uint32_t& state) noexcept
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+
+template<typename T>
+static bool IsEqual(const T* a, const T* b, int count) noexcept
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (a[i] != b[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+template<typename T>
+static bool IsSorted(const T* data, int count) noexcept
+{
+	for (int i = 1; i < count; ++i)
+	{
+		if (data[i] < data[i - 1])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static void Test_Sort() noexcept
+{
+	constexpr int COUNT = 5000;
+	uint32_t state = 12345;
+
+	RpgArray<int> values(COUNT);
+	RpgArray<int> expected(COUNT);
+
+	// Random, few unique, sorted, reverse sorted
+	for (int pattern = 0; pattern < 4; ++pattern)
+	{
+		for (int i = 0; i < COUNT; ++i)
+		{
+			switch (pattern)
+			{
+				case 0: values[i] = static_cast<int>(TestRandom(state)); break;
+				case 1: values[i] = static_cast<int>(TestRandom(state) % 4); break;
+				case 2: values[i] = i; break;
+				default: values[i] = COUNT - i; break;
+			}
+
+			expected[i] = values[i];
+		}
+
+		std::sort(expected.GetData(), expected.GetData() + COUNT);
+
+		RpgArray<int> sorted = values;
+		sorted.Sort();
+		RPG_Assert(IsEqual(sorted.GetData(), expected.GetData(), COUNT));
+
+		sorted = values;
+		sorted.StableSort();
+		RPG_Assert(IsEqual(sorted.GetData(), expected.GetData(), COUNT));
+
+		sorted = values;
+		RpgAlgorithm::Sort(sorted.GetData(), COUNT, [](int a, int b) { return a > b; });
+
+		for (int i = 0; i < COUNT; ++i)
+		{
+			RPG_Assert(sorted[i] == expected[COUNT - 1 - i]);
+		}
+
+		sorted = values;
+		const int nth = COUNT / 3;
+		RpgAlgorithm::NthElement(sorted.GetData(), COUNT, nth);
+		RPG_Assert(sorted[nth] == expected[nth]);
+
+		for (int i = 0; i < COUNT; ++i)
+		{
+			RPG_Assert(i < nth ? sorted[i] <= sorted[nth] : sorted[i] >= sorted[nth]);
+		}
+	}
+}
+
+
+static void Test_StableSort() noexcept
+{
+	struct FItem
+	{
+		int Key;
+		int Order;
+	};
+
+	constexpr int COUNT = 1000;
+	uint32_t state = 777;
+
+	RpgArray<FItem> items(COUNT);
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		items[i] = { static_cast<int>(TestRandom(state) % 10), i };
+	}
+
+	items.StableSort([](const FItem& a, const FItem& b) { return a.Key < b.Key; });
+
+	for (int i = 1; i < COUNT; ++i)
+	{
+		RPG_Assert(items[i - 1].Key < items[i].Key || (items[i - 1].Key == items[i].Key && items[i - 1].Order < items[i].Order));
+	}
+
+	// Non trivially copyable type
+	RpgArray<RpgString> names;
+	names.AddValue(RpgString("delta"));
+	names.AddValue(RpgString("alpha"));
+	names.AddValue(RpgString("charlie"));
+	names.AddValue(RpgString("bravo"));
+
+	RpgAlgorithm::StableSort(names.GetData(), names.GetCount(), [](const RpgString& a, const RpgString& b) { return strcmp(*a, *b) < 0; });
+	RPG_Assert(names[0].Equals("alpha") && names[1].Equals("bravo") && names[2].Equals("charlie") && names[3].Equals("delta"));
+}
+
+
+static void Test_RadixSort() noexcept
+{
+	constexpr int COUNT = 100000;
+	uint32_t state = 99;
+
+	RpgArray<uint32_t> keys32(COUNT);
+	RpgArray<uint64_t> keys64(COUNT);
+	RpgArray<int> values(COUNT);
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		keys32[i] = TestRandom(state) % 1000;
+		keys64[i] = (static_cast<uint64_t>(TestRandom(state)) << 32) | TestRandom(state);
+		values[i] = i;
+	}
+
+	RpgArray<uint32_t> expected32 = keys32;
+	std::stable_sort(expected32.GetData(), expected32.GetData() + COUNT);
+
+	RpgArray<uint32_t> sorted32 = keys32;
+	RpgArray<int> sortedValues = values;
+	RpgAlgorithm::RadixSort_KeyValue(sorted32.GetData(), sortedValues.GetData(), COUNT);
+	RPG_Assert(IsEqual(sorted32.GetData(), expected32.GetData(), COUNT));
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		// Value follows its key, equal keys keep original order
+		RPG_Assert(keys32[sortedValues[i]] == sorted32[i]);
+		RPG_Assert(i == 0 || sorted32[i - 1] != sorted32[i] || sortedValues[i - 1] < sortedValues[i]);
+	}
+
+	sorted32 = keys32;
+	sortedValues = values;
+	RpgThreadPool::ParallelRadixSort_KeyValue(sorted32.GetData(), sortedValues.GetData(), COUNT);
+	RPG_Assert(IsEqual(sorted32.GetData(), expected32.GetData(), COUNT));
+
+	for (int i = 1; i < COUNT; ++i)
+	{
+		RPG_Assert(sorted32[i - 1] != sorted32[i] || sortedValues[i - 1] < sortedValues[i]);
+	}
+
+	RpgArray<uint64_t> sorted64 = keys64;
+	RpgAlgorithm::RadixSort(sorted64.GetData(), COUNT);
+	RPG_Assert(IsSorted(sorted64.GetData(), COUNT));
+
+	sorted64 = keys64;
+	RpgThreadPool::ParallelRadixSort(sorted64.GetData(), COUNT);
+	RPG_Assert(IsSorted(sorted64.GetData(), COUNT));
+
+	// Signed and float keys
+	const float floats[] = { 3.5f, -1.0f, 0.0f, -100.25f, 2.0f, -0.5f };
+	uint32_t floatKeys[6];
+	int floatOrder[6];
+
+	for (int i = 0; i < 6; ++i)
+	{
+		floatKeys[i] = RpgAlgorithm::RadixKey_FromFloat(floats[i]);
+		floatOrder[i] = i;
+	}
+
+	RpgAlgorithm::RadixSort_KeyValue(floatKeys, floatOrder, 6);
+	RPG_Assert(floatOrder[0] == 3 && floatOrder[1] == 1 && floatOrder[2] == 5 && floatOrder[3] == 2 && floatOrder[4] == 4 && floatOrder[5] == 0);
+	RPG_Assert(RpgAlgorithm::RadixKey_FromInt(-5) < RpgAlgorithm::RadixKey_FromInt(3));
+}
+
+
+static void Test_BinarySearch() noexcept
+{
+	const int data[] = { 1, 3, 3, 3, 7, 9 };
+
+	RPG_Assert(RpgAlgorithm::BinarySearch_LowerBound(data, 6, 3) == 1);
+	RPG_Assert(RpgAlgorithm::BinarySearch_UpperBound(data, 6, 3) == 4);
+	RPG_Assert(RpgAlgorithm::BinarySearch_LowerBound(data, 6, 0) == 0);
+	RPG_Assert(RpgAlgorithm::BinarySearch_LowerBound(data, 6, 10) == 6);
+	RPG_Assert(RpgAlgorithm::BinarySearch_UpperBound(data, 6, 9) == 6);
+	RPG_Assert(RpgAlgorithm::BinarySearch_FindIndexByValue(data, 6, 7) == 4);
+	RPG_Assert(RpgAlgorithm::BinarySearch_FindIndexByValue(data, 6, 5) == RPG_INDEX_INVALID);
+	RPG_Assert(RpgAlgorithm::BinarySearch_FindIndexByValue(data, 0, 5) == RPG_INDEX_INVALID);
+
+	int values[] = { 5, 2, 8, 1, 9, 4 };
+	const int evenCount = RpgAlgorithm::Partition(values, 6, [](int v) { return v % 2 == 0; });
+	RPG_Assert(evenCount == 3);
+
+	for (int i = 0; i < 6; ++i)
+	{
+		RPG_Assert((values[i] % 2 == 0) == (i < evenCount));
+	}
+}
+
+
 void RpgTest::Core::Test_DSA_Algorithm() noexcept
 {
 	Test_Swap();
@@ -249,4 +476,54 @@ void RpgTest::Core::Test_DSA_Algorithm() noexcept
 	Test_Array_ShiftElements();
 	Test_Array_RemoveElements();
 	Test_Array_InsertElements();
+	Test_Sort();
+	Test_StableSort();
+	Test_RadixSort();
+	Test_BinarySearch();
+}
+
+
+
+template<typename TFunction>
+static float Benchmark_Measure(const RpgArray<uint32_t>& source, RpgArray<uint32_t>& work, TFunction&& function) noexcept
+{
+	work = source;
+
+	RpgTimer timer;
+	timer.Start();
+	function(work.GetData(), work.GetCount());
+	const float ms = timer.Tick() / 1000.0f;
+
+	RPG_Assert(IsSorted(work.GetData(), work.GetCount()));
+
+	return ms;
+}
+
+
+void RpgTest::Core::Benchmark_DSA_Algorithm() noexcept
+{
+	RPG_CONSOLE_Log(RpgLogSystem, "Benchmark sort (uint32_t, random keys, %i worker threads):", RpgThreadPool::GetWorkerCount());
+
+	for (int count = 10000; count <= 10000000; count *= 10)
+	{
+		RpgArray<uint32_t> source(count);
+		RpgArray<uint32_t> work;
+		uint32_t state = 2024;
+
+		for (int i = 0; i < count; ++i)
+		{
+			source[i] = TestRandom(state);
+		}
+
+		const float stdSortMs = Benchmark_Measure(source, work, [](uint32_t* data, int n) { std::sort(data, data + n); });
+		const float stdStableMs = Benchmark_Measure(source, work, [](uint32_t* data, int n) { std::stable_sort(data, data + n); });
+		const float sortMs = Benchmark_Measure(source, work, [](uint32_t* data, int n) { RpgAlgorithm::Sort(data, n); });
+		const float stableMs = Benchmark_Measure(source, work, [](uint32_t* data, int n) { RpgAlgorithm::StableSort(data, n); });
+		const float radixMs = Benchmark_Measure(source, work, [](uint32_t* data, int n) { RpgAlgorithm::RadixSort(data, n); });
+		const float parallelRadixMs = Benchmark_Measure(source, work, [](uint32_t* data, int n) { RpgThreadPool::ParallelRadixSort(data, n); });
+
+		RPG_CONSOLE_Log(RpgLogSystem, "  [%i] std::sort: %.3f ms, std::stable_sort: %.3f ms, Sort: %.3f ms, StableSort: %.3f ms, RadixSort: %.3f ms, ParallelRadixSort: %.3f ms", 
+			count, stdSortMs, stdStableMs, sortMs, stableMs, radixMs, parallelRadixMs
+		);
+	}
 }
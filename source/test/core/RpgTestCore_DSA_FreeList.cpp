@@ -1,7 +1,200 @@
 #include "RpgTestCore.h"
+#include "core/dsa/RpgFreeList.h"
+#include "core/RpgString.h"
 
 
-void RpgTest::Core::Test_DSA_FreeList() noexcept
+
+static void Test_AddRemove() noexcept
+{
+	RpgFreeList<int, 64> freeList;
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		RPG_Assert(freeList.Add(i) == i);
+	}
+
+	RPG_Assert(freeList.GetCount() == 1000);
+	RPG_Assert(freeList.GetIndexEnd() == 1000);
+	RPG_Assert(!freeList.IsValid(-1) && !freeList.IsValid(1000) && !freeList.IsValid(freeList.GetCapacity()));
+
+	// Element address is stable while list grows
+	const int* first = &freeList[0];
+	const int* last = &freeList[999];
+
+	for (int i = 0; i < 1000; i += 3)
+	{
+		freeList.RemoveAt(i);
+	}
+
+	RPG_Assert(freeList.GetCount() == 666);
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		RPG_Assert(freeList.IsValid(i) == (i % 3 != 0));
+	}
+
+	// Removed slot is reused (LIFO)
+	RPG_Assert(freeList.Add(-1) == 999);
+	RPG_Assert(freeList.Add(-2) == 996);
+
+	for (int i = 0; i < 5000; ++i)
+	{
+		(void)freeList.Add(i);
+	}
+
+	RPG_Assert(&freeList[999] == last && *last == -1);
+	RPG_Assert(&freeList[0] == first);
+
+	freeList.Clear();
+	RPG_Assert(freeList.IsEmpty() && freeList.GetIndexEnd() == 0 && !freeList.IsValid(1));
+	RPG_Assert(freeList.Add(7) == 0);
+}
+
+
+static void Test_ReserveRange() noexcept
+{
+	RpgFreeList<RpgName, 64> freeList;
+	(void)freeList.Add("a");
+	(void)freeList.Add("b");
+	freeList.RemoveAt(0);
+
+	// Appends after index end, removed slot is kept for Add
+	RPG_Assert(freeList.ReserveRange(200) == 2);
+	RPG_Assert(freeList.GetCount() == 1 && freeList.GetIndexEnd() == 202);
+	RPG_Assert(!freeList.IsValid(0) && freeList.IsValid(1) && !freeList.IsValid(2) && !freeList.IsValid(64) && !freeList.IsValid(201));
+
+	// Reserved slots are not visited until emplaced
+	for (auto it = freeList.CreateConstIterator(); it; ++it)
+	{
+		RPG_Assert(it.GetIndex() == 1);
+	}
+
+	RPG_Assert(freeList.Add("c") == 0);
+	RPG_Assert(freeList.Add("d") == 202);
+
+	freeList.EmplaceAt(64, "e");
+	freeList.EmplaceAt(201, "f");
+	RPG_Assert(freeList.GetCount() == 5 && freeList[64] == "e" && freeList[201] == "f");
+
+	const int expected[] = { 0, 1, 64, 201, 202 };
+	int n = 0;
+
+	for (auto it = freeList.CreateConstIterator(); it; ++it)
+	{
+		RPG_Assert(n < 5 && it.GetIndex() == expected[n]);
+		++n;
+	}
+
+	RPG_Assert(n == 5);
+	RPG_Assert(freeList.ReserveRange(0) == 203);
+
+	// Reserve only, nothing is visited
+	RpgFreeList<RpgName, 64> reserved;
+	RPG_Assert(reserved.ReserveRange(100) == 0);
+	RPG_Assert(reserved.IsEmpty() && reserved.GetIndexEnd() == 100);
+	RPG_Assert(!reserved.CreateConstIterator());
+
+	for (auto it = reserved.CreateIterator(); it; ++it)
+	{
+		RPG_Assert(0);
+	}
+}
+
+
+static void Test_Iterate() noexcept
+{
+	RpgFreeList<int, 64> freeList;
+
+	for (int i = 0; i < 300; ++i)
+	{
+		(void)freeList.Add(i);
+	}
+
+	// Leave whole empty words between valid elements
+	for (int i = 0; i < 300; ++i)
+	{
+		if (i != 5 && i != 63 && i != 64 && i != 200 && i != 299)
+		{
+			freeList.RemoveAt(i);
+		}
+	}
+
+	const int expected[] = { 5, 63, 64, 200, 299 };
+	int n = 0;
+
+	for (auto it = freeList.CreateConstIterator(); it; ++it)
+	{
+		RPG_Assert(n < 5);
+		RPG_Assert(it.GetIndex() == expected[n] && it.GetValue() == expected[n]);
+		++n;
+	}
+
+	RPG_Assert(n == 5);
+
+	RpgFreeList<int, 64> empty;
+	RPG_Assert(!empty.CreateIterator());
+}
+
+
+static void Test_Defragment() noexcept
 {
+	RpgFreeList<RpgName, 64> freeList;
+	char buffer[16];
 
-}
\ No newline at end of file
+	for (int i = 0; i < 200; ++i)
+	{
+		snprintf(buffer, 16, "n%i", i);
+		(void)freeList.Add(buffer);
+	}
+
+	for (int i = 0; i < 200; ++i)
+	{
+		if (i % 4 != 1)
+		{
+			freeList.RemoveAt(i);
+		}
+	}
+
+	RpgArray<int> remap;
+	freeList.Defragment(&remap);
+
+	RPG_Assert(freeList.GetCount() == 50 && freeList.GetIndexEnd() == 50);
+	RPG_Assert(remap.GetCount() == 200);
+
+	for (int i = 0; i < 50; ++i)
+	{
+		RPG_Assert(freeList.IsValid(i));
+	}
+
+	for (int i = 0; i < 200; ++i)
+	{
+		if (i % 4 != 1)
+		{
+			RPG_Assert(remap[i] == RPG_INDEX_INVALID);
+		}
+		else
+		{
+			snprintf(buffer, 16, "n%i", i);
+			RPG_Assert(freeList[remap[i]] == buffer);
+		}
+	}
+
+	// Next add continues after compacted range
+	RPG_Assert(freeList.Add("x") == 50);
+
+	RpgFreeList<RpgName, 64> copy = freeList;
+	freeList.Clear(true);
+	RPG_Assert(copy.GetCount() == 51 && copy[50] == "x");
+
+	RpgFreeList<RpgName, 64> moved = std::move(copy);
+	RPG_Assert(moved.GetCount() == 51 && copy.GetCount() == 0);
+}
+
+
+void RpgTest::Core::Test_DSA_FreeList() noexcept
+{
+	Test_AddRemove();
+	Test_ReserveRange();
+	Test_Iterate();
+	Test_Defragment();
+}
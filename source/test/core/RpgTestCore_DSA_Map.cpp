@@ -1,7 +1,286 @@
 #include "RpgTestCore.h"
+#include "core/dsa/RpgMap.h"
+#include "core/RpgString.h"
+#include "core/RpgConsoleSystem.h"
+#include "core/RpgTimer.h"
+
+
+
+static void Test_AddFind() noexcept
+{
+	RpgMap<int, int> map;
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		map.Add(i) = i * 10;
+	}
+
+	RPG_Assert(map.GetCount() == 1000);
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		int index = RPG_INDEX_INVALID;
+		RPG_Assert(map.Exists(i, &index));
+		RPG_Assert(index == i);
+		RPG_Assert(map[i] == i * 10);
+	}
+
+	RPG_Assert(!map.Exists(-1));
+	RPG_Assert(!map.Exists(1000));
+	RPG_Assert(map.GetValueByKey(5000) == nullptr);
+
+	// Add existing key returns existing value
+	int index = RPG_INDEX_INVALID;
+	map.Add(42, &index) += 1;
+	RPG_Assert(index == 42);
+	RPG_Assert(map[42] == 421);
+	RPG_Assert(map.GetCount() == 1000);
+
+	map.Add(42, 7);
+	RPG_Assert(map[42] == 7);
+	RPG_Assert(map.GetCount() == 1000);
+}
+
+
+static void Test_InsertionOrder() noexcept
+{
+	RpgMap<RpgName, int> map;
+	map.Add("c") = 0;
+	map.Add("a") = 1;
+	map.Add("b") = 2;
+	map.Add("d") = 3;
+
+	RPG_Assert(map.GetKeyByIndex(0) == "c");
+	RPG_Assert(map.GetKeyByIndex(1) == "a");
+	RPG_Assert(map.GetKeyByIndex(2) == "b");
+	RPG_Assert(map.GetKeyByIndex(3) == "d");
+
+	// Remove without keeping order moves last entry into removed index
+	map.Remove("a");
+	RPG_Assert(map.GetCount() == 3);
+	RPG_Assert(map.GetKeyByIndex(1) == "d" && map.GetValueByIndex(1) == 3);
+	RPG_Assert(map.FindKeyIndex("d") == 1);
+
+	// Remove keeping order shifts following entries
+	map.Remove("c", true);
+	RPG_Assert(map.GetCount() == 2);
+	RPG_Assert(map.GetKeyByIndex(0) == "d" && map.FindKeyIndex("d") == 0);
+	RPG_Assert(map.GetKeyByIndex(1) == "b" && map.FindKeyIndex("b") == 1);
+	RPG_Assert(!map.Exists("a") && !map.Exists("c"));
+}
+
+
+static void Test_RemoveReinsert() noexcept
+{
+	RpgMap<int, int> map;
+	map.SetMaxLoadFactor(0.9375f);
+
+	// Keys that share low bits to produce long probe runs
+	const int COUNT = 4096;
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		map.Add(i << 12) = i;
+	}
+
+	for (int i = 0; i < COUNT; i += 2)
+	{
+		map.Remove(i << 12);
+	}
+
+	RPG_Assert(map.GetCount() == COUNT / 2);
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		const int* value = map.GetValueByKey(i << 12);
+
+		if (i % 2 == 0)
+		{
+			RPG_Assert(value == nullptr);
+		}
+		else
+		{
+			RPG_Assert(value && *value == i);
+		}
+	}
+
+	for (int i = 0; i < COUNT; i += 2)
+	{
+		map.Add(i << 12) = i;
+	}
+
+	RPG_Assert(map.GetCount() == COUNT);
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		RPG_Assert(map[i << 12] == i);
+	}
+
+	while (!map.IsEmpty())
+	{
+		map.RemoveAt(0, (map.GetCount() % 3) == 0);
+	}
+
+	RPG_Assert(!map.Exists(0));
+
+	map.Add(7) = 8;
+	RPG_Assert(map.GetCount() == 1 && map[7] == 8);
+
+	map.Clear();
+	RPG_Assert(map.IsEmpty() && !map.Exists(7));
+}
+
+
+static void Test_Copy() noexcept
+{
+	RpgMap<int, int> map;
+
+	for (int i = 0; i < 100; ++i)
+	{
+		map.Add(i) = -i;
+	}
+
+	RpgMap<int, int> copy = map;
+	map.Clear(true);
+
+	RPG_Assert(copy.GetCount() == 100);
+
+	for (int i = 0; i < 100; ++i)
+	{
+		RPG_Assert(copy[i] == -i);
+	}
+
+	RpgMap<int, int> moved = std::move(copy);
+	RPG_Assert(moved.GetCount() == 100 && moved[99] == -99);
+}
 
 
 void RpgTest::Core::Test_DSA_Map() noexcept
 {
+	Test_AddFind();
+	Test_InsertionOrder();
+	Test_RemoveReinsert();
+	Test_Copy();
+}
+
+
+
+// Previous RpgMap lookup (linear scan over hashes), kept as benchmark baseline
+class FBenchmarkLinearMap
+{
+public:
+	inline int& Add(int key) noexcept
+	{
+		const uint64_t hash = Rpg_GetHash(key);
+		int index = FindIndex(hash);
+
+		if (index == RPG_INDEX_INVALID)
+		{
+			index = Hashes.GetCount();
+			Hashes.AddValue(hash);
+			Values.AddValue(0);
+		}
+
+		return Values[index];
+	}
+
+	inline const int* GetValueByKey(int key) const noexcept
+	{
+		const int index = FindIndex(Rpg_GetHash(key));
+		return (index != RPG_INDEX_INVALID) ? &Values[index] : nullptr;
+	}
+
+	inline void Remove(int key) noexcept
+	{
+		const int index = FindIndex(Rpg_GetHash(key));
+
+		if (index != RPG_INDEX_INVALID)
+		{
+			Hashes.RemoveAt(index, false);
+			Values.RemoveAt(index, false);
+		}
+	}
+
+private:
+	inline int FindIndex(uint64_t hashValue) const noexcept
+	{
+		for (int i = 0; i < Hashes.GetCount(); ++i)
+		{
+			if (Hashes[i] == hashValue)
+			{
+				return i;
+			}
+		}
+
+		return RPG_INDEX_INVALID;
+	}
+
+private:
+	RpgArray<uint64_t> Hashes;
+	RpgArray<int> Values;
+
+};
+
+
+template<typename TMap>
+static void Benchmark_Map(const char* name, int count) noexcept
+{
+	// Scattered keys
+	auto getKey = [](int i) { return static_cast<int>(static_cast<uint32_t>(i) * 2654435761u); };
+
+	RpgTimer timer;
+	timer.Start();
+
+	TMap map;
+
+	for (int i = 0; i < count; ++i)
+	{
+		map.Add(getKey(i)) = i;
+	}
+
+	const float addMs = timer.Tick() / 1000.0f;
+
+	int found = 0;
+
+	for (int i = 0; i < count; ++i)
+	{
+		found += map.GetValueByKey(getKey(i)) ? 1 : 0;
+		found += map.GetValueByKey(getKey(i + count)) ? 1 : 0;
+	}
+
+	const float findMs = timer.Tick() / 1000.0f;
+
+	for (int i = 0; i < count; ++i)
+	{
+		map.Remove(getKey(i));
+	}
+
+	const float removeMs = timer.Tick() / 1000.0f;
+
+	RPG_Assert(found == count);
+
+	RPG_CONSOLE_Log(RpgLogSystem, "  %s [%i]: add: %.3f ms, find (hit + miss): %.3f ms, remove: %.3f ms", name, count, addMs, findMs, removeMs);
+}
+
+
+void RpgTest::Core::Benchmark_DSA_Map() noexcept
+{
+	// Linear scan is O(n^2) per pass, larger counts take minutes
+	constexpr int LINEAR_MAX_COUNT = 10000;
+
+	RPG_CONSOLE_Log(RpgLogSystem, "Benchmark RpgMap (load factor %.3f):", RPG_MAP_DEFAULT_MAX_LOAD_FACTOR);
+
+	for (int count = 1000; count <= 1000000; count *= 10)
+	{
+		Benchmark_Map<RpgMap<int, int>>("RpgMap", count);
 
-}
\ No newline at end of file
+		if (count <= LINEAR_MAX_COUNT)
+		{
+			Benchmark_Map<FBenchmarkLinearMap>("Linear", count);
+		}
+		else
+		{
+			RPG_CONSOLE_Log(RpgLogSystem, "  Linear [%i]: skipped", count);
+		}
+	}
+}
@@ -1,7 +1,60 @@
 #include "RpgTestCore.h"
+#include "core/RpgNameTable.h"
 
 
-void RpgTest::Core::Test_String() noexcept
+
+static void Test_NameHash() noexcept
+{
+	// Name compares ignore case, hash must follow
+	RPG_Assert(RpgName("Bone_Root") == RpgName("bone_root"));
+	RPG_Assert(Rpg_GetHash(RpgName("Bone_Root")) == Rpg_GetHash(RpgName("bone_root")));
+	RPG_Assert(Rpg_GetHash(RpgName("ab")) != Rpg_GetHash(RpgName("ba")));
+}
+
+
+static void Test_NameId() noexcept
 {
+	const RpgNameId none;
+	RPG_Assert(none.IsNone());
+	RPG_Assert(RpgNameId("").IsNone());
+	RPG_Assert(RpgNameId(static_cast<const char*>(nullptr)).IsNone());
+
+	const RpgNameId spine("Spine");
+	RPG_Assert(!spine.IsNone());
+	RPG_Assert(spine == RpgNameId("spine"));
+	RPG_Assert(spine == RpgNameId(RpgName("SPINE")));
+	RPG_Assert(spine != RpgNameId("Spine1"));
+	RPG_Assert(Rpg_GetHash(spine) == Rpg_GetHash(RpgNameId("sPiNe")));
+
+	// Entry keeps casing of first interned string
+	RPG_Assert(spine.ToName() == "Spine");
+	RPG_Assert(RpgPlatformString::CStringCompare(RpgNameId("SPINE").GetBaseCString(), "Spine", false));
 
+	// Number suffix
+	const RpgNameId spine0("Spine_0");
+	const RpgNameId spine12("Spine_12");
+	RPG_Assert(spine0.GetIndex() == spine.GetIndex() && spine0.GetNumber() == 1);
+	RPG_Assert(spine12.GetIndex() == spine.GetIndex() && spine12.GetNumber() == 13);
+	RPG_Assert(spine0 != spine && spine0 != spine12);
+	RPG_Assert(Rpg_GetHash(spine0) != Rpg_GetHash(spine12));
+	RPG_Assert(spine12.ToName() == "Spine_12");
+
+	// Leading zero, missing separator or missing base stays in base string
+	RPG_Assert(RpgNameId("Spine_01").GetNumber() == 0);
+	RPG_Assert(RpgNameId("Spine12").GetNumber() == 0);
+	RPG_Assert(RpgNameId("_12").GetNumber() == 0);
+	RPG_Assert(RpgNameId("Spine_01").ToName() == "Spine_01");
+
+	// Find does not add into table
+	const int count = RpgNameTable::GetCount();
+	RPG_Assert(RpgNameId::Find("Test_NameId_NotInterned").IsNone());
+	RPG_Assert(RpgNameTable::GetCount() == count);
+	RPG_Assert(RpgNameId::Find("spine_7") == RpgNameId("Spine_7"));
+}
+
+
+void RpgTest::Core::Test_String() noexcept
+{
+	Test_NameHash();
+	Test_NameId();
 }
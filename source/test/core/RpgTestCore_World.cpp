@@ -0,0 +1,343 @@
+#include "RpgTestCore.h"
+#include "core/world/RpgWorld.h"
+#include "render/world/RpgRenderComponent.h"
+
+
+
+class RpgTestComponent_SnapshotBulk
+{
+	RPG_COMPONENT_TYPE("RpgTestComponent - SnapshotBulk");
+
+public:
+	int Value{ 0 };
+	float Scale{ 0.0f };
+
+
+	inline void Destroy() noexcept
+	{
+	}
+
+};
+
+
+class RpgTestComponent_SnapshotSerialized
+{
+	RPG_COMPONENT_TYPE("RpgTestComponent - SnapshotSerialized");
+
+public:
+	static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+	int Value{ 0 };
+	RpgArray<int> Values;
+
+
+	inline void Destroy() noexcept
+	{
+	}
+
+	inline void Serialize(RpgStreamWriter& writer) const noexcept
+	{
+		writer.Write(Value);
+		writer.WriteArray(Values);
+	}
+
+	inline void Deserialize(RpgStreamReader& reader) noexcept
+	{
+		reader.Read(Value);
+		reader.ReadArray(Values);
+	}
+
+};
+
+
+// Same name as RpgTestComponent_SnapshotSerialized with bumped version, saved data must be ignored
+class RpgTestComponent_SnapshotSerializedV2
+{
+	RPG_COMPONENT_TYPE("RpgTestComponent - SnapshotSerialized");
+
+public:
+	static constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+	int Value{ 0 };
+	RpgArray<int> Values;
+
+
+	inline void Destroy() noexcept
+	{
+	}
+
+	inline void Serialize(RpgStreamWriter& writer) const noexcept
+	{
+		writer.Write(Value);
+		writer.WriteArray(Values);
+	}
+
+	inline void Deserialize(RpgStreamReader& reader) noexcept
+	{
+		reader.Read(Value);
+		reader.ReadArray(Values);
+	}
+
+};
+
+
+
+#define RPG_TEST_SNAPSHOT_COUNT		200
+
+
+static bool TestNearlyEqual(float a, float b) noexcept
+{
+	return RpgMath::Abs(a - b) < 0.001f;
+}
+
+
+static int TestGetLiveGameObjectCount(const RpgWorld& world) noexcept
+{
+	RpgArray<RpgGameObjectID> gameObjects;
+	world.GameObject_GetAll(gameObjects);
+	RPG_Assert(gameObjects.GetCount() == world.GameObject_GetCount());
+
+	return gameObjects.GetCount();
+}
+
+
+// Saves RPG_TEST_SNAPSHOT_COUNT game objects. Game object 2 and 3 are children of 1, 4 is child of external parent, 5 is child of game object outside snapshot
+static void TestSaveSnapshot(RpgArray<uint8_t>& out_Bytes) noexcept
+{
+	RpgWorld world("TestSnapshotSave");
+	world.Component_Register<RpgTestComponent_SnapshotBulk>();
+	world.Component_Register<RpgTestComponent_SnapshotSerialized>();
+
+	RpgArray<RpgGameObjectID> gameObjects;
+
+	for (int i = 0; i < RPG_TEST_SNAPSHOT_COUNT; ++i)
+	{
+		RpgGameObjectID gameObject = world.GameObject_Create(RpgName::Format("Snapshot_%i", i), RpgTransform(RpgVector3(static_cast<float>(i), 0.0f, 0.0f)));
+		gameObjects.AddValue(gameObject);
+
+		RpgTestComponent_SnapshotBulk* bulk = world.GameObject_AddComponent<RpgTestComponent_SnapshotBulk>(gameObject);
+		bulk->Value = i;
+		bulk->Scale = i * 0.5f;
+
+		if (i % 3 == 0)
+		{
+			RpgTestComponent_SnapshotSerialized* serialized = world.GameObject_AddComponent<RpgTestComponent_SnapshotSerialized>(gameObject);
+			serialized->Value = -i;
+			serialized->Values.AddValue(i);
+			serialized->Values.AddValue(i + 1);
+		}
+	}
+
+	const RpgGameObjectID externalParent = world.GameObject_Create("External", RpgTransform(RpgVector3(1000.0f, 0.0f, 0.0f)));
+	const RpgGameObjectID unsavedParent = world.GameObject_Create("Unsaved", RpgTransform(RpgVector3(2000.0f, 0.0f, 0.0f)));
+
+	world.GameObject_SetParent(gameObjects[2], gameObjects[1]);
+	world.GameObject_SetParent(gameObjects[3], gameObjects[1]);
+	world.GameObject_SetParent(gameObjects[4], externalParent);
+	world.GameObject_SetParent(gameObjects[5], unsavedParent);
+	world.UpdateTransformHierarchy();
+
+	RpgBinaryStreamWriter writer;
+	world.Snapshot_Save(writer, gameObjects.GetData(), gameObjects.GetCount(), &externalParent, 1);
+
+	out_Bytes.Resize(static_cast<int>(writer.GetByteSize()));
+	RpgPlatformMemory::MemCopy(out_Bytes.GetData(), writer.GetByteData(), writer.GetByteSize());
+}
+
+
+static void Test_World_SnapshotRoundTrip(const RpgArray<uint8_t>& bytes) noexcept
+{
+	RpgWorld world("TestSnapshotLoad");
+
+	// Different registration order, snapshot component types are remapped by name
+	world.Component_Register<RpgTestComponent_SnapshotSerialized>();
+	world.Component_Register<RpgTestComponent_SnapshotBulk>();
+
+	// Destroyed slots are reused by load, loaded game object indices differ from saved ones
+	for (int i = 0; i < 16; ++i)
+	{
+		RpgGameObjectID gameObject = world.GameObject_Create(RpgName::Format("Destroyed_%i", i));
+		world.GameObject_Destroy(gameObject);
+	}
+
+	world.BeginFrame(0);
+
+	const RpgGameObjectID existing = world.GameObject_Create("Existing");
+	world.GameObject_AddComponent<RpgTestComponent_SnapshotBulk>(existing)->Value = 12345;
+
+	const RpgGameObjectID externalParent = world.GameObject_Create("External", RpgTransform(RpgVector3(100.0f, 0.0f, 0.0f)));
+
+	RpgArray<uint8_t> copy = bytes;
+	RpgBinaryStreamReader reader(copy);
+	RpgArray<RpgGameObjectID> loaded;
+
+	RPG_Assert(world.Snapshot_Load(reader, &loaded, &externalParent, 1));
+	RPG_Assert(!reader.HasError() && reader.GetRemainingByteSize() == 0);
+	RPG_Assert(loaded.GetCount() == RPG_TEST_SNAPSHOT_COUNT);
+	RPG_Assert(TestGetLiveGameObjectCount(world) == RPG_TEST_SNAPSHOT_COUNT + 2);
+	RPG_Assert(world.GameObject_GetComponent<RpgTestComponent_SnapshotBulk>(existing)->Value == 12345);
+
+	for (int i = 0; i < RPG_TEST_SNAPSHOT_COUNT; ++i)
+	{
+		const RpgGameObjectID gameObject = loaded[i];
+		RPG_Assert(world.GameObject_IsValid(gameObject));
+		RPG_Assert(world.GameObject_GetName(gameObject) == RpgName::Format("Snapshot_%i", i));
+
+		const RpgTestComponent_SnapshotBulk* bulk = world.GameObject_GetComponent<RpgTestComponent_SnapshotBulk>(gameObject);
+		RPG_Assert(bulk && bulk->Value == i && TestNearlyEqual(bulk->Scale, i * 0.5f) && bulk->GameObject == gameObject);
+
+		const RpgTestComponent_SnapshotSerialized* serialized = world.GameObject_GetComponent<RpgTestComponent_SnapshotSerialized>(gameObject);
+		RPG_Assert((serialized != nullptr) == (i % 3 == 0));
+
+		if (serialized)
+		{
+			RPG_Assert(serialized->Value == -i && serialized->Values.GetCount() == 2 && serialized->Values[1] == i + 1 && serialized->GameObject == gameObject);
+		}
+	}
+
+	// Parents inside snapshot and external parents are restored, parent outside both is saved as root
+	RPG_Assert(world.GameObject_GetParent(loaded[2]) == loaded[1]);
+	RPG_Assert(world.GameObject_GetParent(loaded[3]) == loaded[1]);
+	RPG_Assert(world.GameObject_GetParent(loaded[4]) == externalParent);
+	RPG_Assert(!world.GameObject_GetParent(loaded[5]).IsValid());
+
+	world.GameObject_SetWorldTransform(loaded[1], RpgTransform(RpgVector3(50.0f, 0.0f, 0.0f)));
+	world.GameObject_SetWorldTransform(externalParent, RpgTransform(RpgVector3(200.0f, 0.0f, 0.0f)));
+	world.UpdateTransformHierarchy();
+
+	RPG_Assert(TestNearlyEqual(world.GameObject_GetWorldTransform(loaded[2]).Position.X, 51.0f));
+	RPG_Assert(TestNearlyEqual(world.GameObject_GetWorldTransform(loaded[4]).Position.X, 200.0f - 996.0f));
+	RPG_Assert(TestNearlyEqual(world.GameObject_GetWorldTransform(loaded[5]).Position.X, 5.0f));
+}
+
+
+static void Test_World_SnapshotSchemaChanged(const RpgArray<uint8_t>& bytes) noexcept
+{
+	RpgWorld world("TestSnapshotSchema");
+	world.Component_Register<RpgTestComponent_SnapshotBulk>();
+	world.Component_Register<RpgTestComponent_SnapshotSerializedV2>();
+
+	RpgArray<uint8_t> copy = bytes;
+	RpgBinaryStreamReader reader(copy);
+	RpgArray<RpgGameObjectID> loaded;
+
+	RPG_Assert(world.Snapshot_Load(reader, &loaded));
+	RPG_Assert(loaded.GetCount() == RPG_TEST_SNAPSHOT_COUNT);
+
+	for (int i = 0; i < RPG_TEST_SNAPSHOT_COUNT; ++i)
+	{
+		RPG_Assert(world.GameObject_GetComponent<RpgTestComponent_SnapshotBulk>(loaded[i])->Value == i);
+		RPG_Assert(world.GameObject_GetComponent<RpgTestComponent_SnapshotSerializedV2>(loaded[i]) == nullptr);
+	}
+}
+
+
+static void Test_World_SnapshotCorrupted(const RpgArray<uint8_t>& bytes) noexcept
+{
+	RpgWorld world("TestSnapshotCorrupted");
+	world.Component_Register<RpgTestComponent_SnapshotBulk>();
+	world.Component_Register<RpgTestComponent_SnapshotSerialized>();
+
+	const RpgGameObjectID existing = world.GameObject_Create("Existing");
+
+	// Truncated inside header, inside game object blocks and inside component blocks
+	const int truncatedSizes[] = { 8, bytes.GetCount() / 4, bytes.GetCount() - 16 };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		RpgArray<uint8_t> truncated;
+		truncated.Resize(truncatedSizes[i]);
+		RpgPlatformMemory::MemCopy(truncated.GetData(), bytes.GetData(), truncatedSizes[i]);
+
+		RpgBinaryStreamReader reader(truncated);
+		RpgArray<RpgGameObjectID> loaded;
+		RPG_Assert(!world.Snapshot_Load(reader, &loaded));
+		RPG_Assert(loaded.IsEmpty());
+		RPG_Assert(TestGetLiveGameObjectCount(world) == 1 && world.GameObject_IsValid(existing));
+
+		world.BeginFrame(0);
+	}
+}
+
+
+// Mesh and material are saved by name and resolved from registered snapshot assets on load
+static void Test_World_SnapshotAssetReference() noexcept
+{
+	const RpgSharedMesh mesh = RpgMesh::s_CreateShared("TestSnapshotMesh");
+	const RpgSharedMaterial material = RpgMaterial::s_CreateShared("TestSnapshotMaterial", RpgRenderPipelineState());
+	const RpgSharedMesh unregisteredMesh = RpgMesh::s_CreateShared("TestSnapshotMeshUnregistered");
+
+	RPG_Assert(RpgWorldSnapshotAsset<RpgMesh>::Register(mesh));
+	RPG_Assert(RpgWorldSnapshotAsset<RpgMaterial>::Register(material));
+	RPG_Assert(!RpgWorldSnapshotAsset<RpgMesh>::Register(RpgMesh::s_CreateShared("TestSnapshotMesh")));
+
+	RpgArray<uint8_t> bytes;
+	{
+		RpgWorld world("TestSnapshotAssetSave");
+		world.Component_Register<RpgRenderComponent_Mesh>();
+
+		const RpgGameObjectID gameObject = world.GameObject_Create("MeshObject");
+		RpgRenderComponent_Mesh* meshComp = world.GameObject_AddComponent<RpgRenderComponent_Mesh>(gameObject);
+		meshComp->Mesh = mesh;
+		meshComp->Material = material;
+		meshComp->bIsVisible = true;
+		RPG_Assert(world.Snapshot_IsSupported(gameObject));
+
+		// Unregistered asset can not be resolved on load, game object must not be saved
+		const RpgGameObjectID unsupported = world.GameObject_Create("UnsupportedMeshObject");
+		world.GameObject_AddComponent<RpgRenderComponent_Mesh>(unsupported)->Mesh = unregisteredMesh;
+		RPG_Assert(!world.Snapshot_IsSupported(unsupported));
+
+		RpgBinaryStreamWriter writer;
+		world.Snapshot_Save(writer, &gameObject, 1);
+
+		bytes.Resize(static_cast<int>(writer.GetByteSize()));
+		RpgPlatformMemory::MemCopy(bytes.GetData(), writer.GetByteData(), writer.GetByteSize());
+	}
+
+	{
+		RpgWorld world("TestSnapshotAssetLoad");
+		world.Component_Register<RpgRenderComponent_Mesh>();
+
+		RpgArray<uint8_t> copy = bytes;
+		RpgBinaryStreamReader reader(copy);
+		RpgArray<RpgGameObjectID> loaded;
+
+		RPG_Assert(world.Snapshot_Load(reader, &loaded));
+		RPG_Assert(loaded.GetCount() == 1);
+
+		const RpgRenderComponent_Mesh* meshComp = world.GameObject_GetComponent<RpgRenderComponent_Mesh>(loaded[0]);
+		RPG_Assert(meshComp && meshComp->Mesh == mesh && meshComp->Material == material && meshComp->bIsVisible);
+	}
+
+	// Asset unregistered after save is cleared on load
+	RpgWorldSnapshotAsset<RpgMesh>::Unregister(mesh);
+	{
+		RpgWorld world("TestSnapshotAssetLoadUnregistered");
+		world.Component_Register<RpgRenderComponent_Mesh>();
+
+		RpgArray<uint8_t> copy = bytes;
+		RpgBinaryStreamReader reader(copy);
+		RpgArray<RpgGameObjectID> loaded;
+
+		RPG_Assert(world.Snapshot_Load(reader, &loaded));
+
+		const RpgRenderComponent_Mesh* meshComp = world.GameObject_GetComponent<RpgRenderComponent_Mesh>(loaded[0]);
+		RPG_Assert(meshComp && !meshComp->Mesh && meshComp->Material == material);
+	}
+
+	RpgWorldSnapshotAsset<RpgMaterial>::Unregister(material);
+	RPG_Assert(!RpgWorldSnapshotAsset<RpgMesh>::IsRegistered(mesh) && !RpgWorldSnapshotAsset<RpgMaterial>::IsRegistered(material));
+}
+
+
+void RpgTest::Core::Test_World_Snapshot() noexcept
+{
+	RpgArray<uint8_t> bytes;
+	TestSaveSnapshot(bytes);
+
+	Test_World_SnapshotRoundTrip(bytes);
+	Test_World_SnapshotSchemaChanged(bytes);
+	Test_World_SnapshotCorrupted(bytes);
+	Test_World_SnapshotAssetReference();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "physics/RpgPhysicsTypes.h"
+
+
+
+// Deterministic pseudo random values (xorshift), [0.0, 1.0)
+inline float TestRandom(uint32_t& state) noexcept
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return static_cast<float>(state & 0xFFFFFF) / static_cast<float>(0x1000000);
+}
+
+
+// Random vector, each component in [-extent, extent)
+inline RpgVector3 TestRandomVector(uint32_t& state, float extent) noexcept
+{
+	return RpgVector3(TestRandom(state) * 2.0f - 1.0f, TestRandom(state) * 2.0f - 1.0f, TestRandom(state) * 2.0f - 1.0f) * extent;
+}
+
+
+// Random sphere, box or capsule at <center>. Sizes are in [0.25, 1.25)
+inline RpgPhysicsCollision::FShape TestRandomShape(uint32_t& state, RpgPhysicsCollision::EShape type, const RpgVector3& center) noexcept
+{
+	RpgPhysicsCollision::FShape shape;
+	shape.Center = center;
+	shape.Type = type;
+
+	switch (type)
+	{
+		case RpgPhysicsCollision::SHAPE_SPHERE:
+			shape.Size = RpgVector4(0.25f + TestRandom(state));
+			break;
+
+		case RpgPhysicsCollision::SHAPE_BOX:
+			shape.Size = RpgVector4(0.25f + TestRandom(state), 0.25f + TestRandom(state), 0.25f + TestRandom(state), 0.0f);
+			shape.Rotation = RpgQuaternion::FromPitchYawRollDegree(TestRandom(state) * 360.0f, TestRandom(state) * 360.0f, TestRandom(state) * 360.0f);
+			break;
+
+		case RpgPhysicsCollision::SHAPE_CAPSULE:
+			shape.Size = RpgVector4(0.25f + TestRandom(state) * 0.5f, 0.25f + TestRandom(state), 0.0f, 0.0f);
+			break;
+
+		default:
+			break;
+	}
+
+	return shape;
+}
+
+
+// Random shape centered within [-2, 2) on each axis
+inline RpgPhysicsCollision::FShape TestRandomShape(uint32_t& state, RpgPhysicsCollision::EShape type) noexcept
+{
+	const RpgVector3 center = TestRandomVector(state, 2.0f);
+
+	return TestRandomShape(state, type, center);
+}
+
+
+
+namespace RpgTest
+{
+	namespace Physics
+	{
+		extern void Test_DynamicTree() noexcept;
+		extern void Test_Narrowphase() noexcept;
+		extern void Test_Trace() noexcept;
+
+		// Compare broadphase dynamic tree against brute force all pairs for 1k - 50k bodies. Results are written to console
+		extern void Benchmark_Broadphase() noexcept;
+
+		// Compare line traces one by one against packet traversal for 10k lines over 10k objects. Results are written to console
+		extern void Benchmark_Trace() noexcept;
+
+
+		inline void Execute() noexcept
+		{
+			Test_DynamicTree();
+			Test_Narrowphase();
+			Test_Trace();
+		}
+
+	};
+
+};
@@ -0,0 +1,322 @@
+#include "RpgTestPhysics.h"
+#include "physics/RpgPhysicsDynamicTree.h"
+#include "physics/RpgPhysicsTypes.h"
+#include "core/RpgConsoleSystem.h"
+#include "core/RpgTimer.h"
+
+
+
+static bool TestOverlapAABB(const RpgBoundingAABB& a, const RpgBoundingAABB& b) noexcept
+{
+	return !(a.Max.X < b.Min.X || a.Min.X > b.Max.X || a.Max.Y < b.Min.Y || a.Min.Y > b.Max.Y || a.Max.Z < b.Min.Z || a.Min.Z > b.Max.Z);
+}
+
+
+// Bodies are scattered on XZ plane with roughly constant density, half extents 64
+static RpgBoundingAABB TestBodyAABB(const RpgVector3& position) noexcept
+{
+	return RpgBoundingAABB(position - RpgVector3(64.0f), position + RpgVector3(64.0f));
+}
+
+
+static RpgVector3 TestBodyPosition(uint32_t& state, int count) noexcept
+{
+	const float extent = RpgMath::Sqrt(static_cast<float>(count)) * 200.0f;
+	return RpgVector3(TestRandom(state) * extent, TestRandom(state) * 100.0f, TestRandom(state) * extent);
+}
+
+
+
+static void Test_CreateMoveDestroy() noexcept
+{
+	constexpr int COUNT = 1000;
+	uint32_t state = 1234;
+
+	RpgPhysicsDynamicTree tree;
+	RpgArray<RpgVector3> positions(COUNT);
+	RpgArray<int> proxies(COUNT);
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		positions[i] = TestBodyPosition(state, COUNT);
+		proxies[i] = tree.CreateProxy(TestBodyAABB(positions[i]));
+	}
+
+	RPG_Assert(tree.GetProxyCount() == COUNT);
+	RPG_Assert(tree.GetNodeCount() == COUNT * 2 - 1);
+
+	for (int iteration = 0; iteration < 10; ++iteration)
+	{
+		for (int i = 0; i < COUNT; ++i)
+		{
+			if (TestRandom(state) < 0.1f)
+			{
+				const RpgVector3 displacement(TestRandom(state) * 60.0f - 30.0f, 0.0f, TestRandom(state) * 60.0f - 30.0f);
+				positions[i] += displacement;
+				tree.MoveProxy(proxies[i], TestBodyAABB(positions[i]), displacement);
+			}
+		}
+
+		for (int i = 0; i < COUNT / 20; ++i)
+		{
+			const int index = static_cast<int>(TestRandom(state) * COUNT);
+			tree.DestroyProxy(proxies[index]);
+			proxies[index] = tree.CreateProxy(TestBodyAABB(positions[index]));
+		}
+
+	#ifndef RPG_BUILD_SHIPPING
+		tree.Validate();
+	#endif // !RPG_BUILD_SHIPPING
+	}
+
+	// Fat AABB always contains tight AABB
+	for (int i = 0; i < COUNT; ++i)
+	{
+		const RpgBoundingAABB& fat = tree.GetFatAABB(proxies[i]);
+		const RpgBoundingAABB tight = TestBodyAABB(positions[i]);
+		RPG_Assert(fat.Min.X <= tight.Min.X && fat.Min.Y <= tight.Min.Y && fat.Min.Z <= tight.Min.Z);
+		RPG_Assert(fat.Max.X >= tight.Max.X && fat.Max.Y >= tight.Max.Y && fat.Max.Z >= tight.Max.Z);
+	}
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		tree.DestroyProxy(proxies[i]);
+	}
+
+	RPG_Assert(tree.GetProxyCount() == 0);
+	RPG_Assert(tree.GetNodeCount() == 0);
+	RPG_Assert(tree.GetHeight() == 0);
+}
+
+
+static void Test_GeneratePairs() noexcept
+{
+	constexpr int COUNT = 1000;
+	uint32_t state = 5678;
+
+	RpgPhysicsDynamicTree tree;
+	RpgArray<int> proxies(COUNT);
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		proxies[i] = tree.CreateProxy(TestBodyAABB(TestBodyPosition(state, COUNT)));
+	}
+
+	RpgArray<RpgPhysicsDynamicTree::FProxyPair> pairs;
+	tree.GeneratePairs(pairs);
+
+	// Sorted and unique
+	for (int i = 0; i < pairs.GetCount(); ++i)
+	{
+		RPG_Assert(pairs[i].FirstProxy < pairs[i].SecondProxy);
+		RPG_Assert(TestOverlapAABB(tree.GetFatAABB(pairs[i].FirstProxy), tree.GetFatAABB(pairs[i].SecondProxy)));
+
+		if (i > 0)
+		{
+			const RpgPhysicsDynamicTree::FProxyPair& prev = pairs[i - 1];
+			RPG_Assert(prev.FirstProxy < pairs[i].FirstProxy || (prev.FirstProxy == pairs[i].FirstProxy && prev.SecondProxy < pairs[i].SecondProxy));
+		}
+	}
+
+	// Same pair count as brute force
+	int bruteForceCount = 0;
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		for (int j = i + 1; j < COUNT; ++j)
+		{
+			bruteForceCount += TestOverlapAABB(tree.GetFatAABB(proxies[i]), tree.GetFatAABB(proxies[j])) ? 1 : 0;
+		}
+	}
+
+	RPG_Assert(bruteForceCount == pairs.GetCount());
+
+	// Query finds every proxy overlapping its own fat AABB
+	int queryCount = 0;
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		tree.QueryAABB(tree.GetFatAABB(proxies[i]),
+			[&queryCount, &proxies, i](int proxyId)
+			{
+				queryCount += (proxyId > proxies[i]) ? 1 : 0;
+				return true;
+			}
+		);
+	}
+
+	RPG_Assert(queryCount == pairs.GetCount());
+}
+
+
+static void Test_FilterMask() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	const FFilterMask character = FFilterMask::Make(CHANNEL_CHARACTER, DEFAULT_COLLISION_RESPONSE_CHANNELS_Character);
+	const FFilterMask blocker = FFilterMask::Make(CHANNEL_BLOCKER, DEFAULT_COLLISION_RESPONSE_CHANNELS_Blocker);
+	const FFilterMask ignoreAll = FFilterMask::Make(CHANNEL_CHARACTER, DEFAULT_COLLISION_RESPONSE_CHANNELS_IgnoreAll);
+
+	RPG_Assert(character.ChannelBit == GetChannelBit(CHANNEL_CHARACTER));
+	RPG_Assert(GetChannelBit(CHANNEL_NONE) == 0);
+	RPG_Assert(FFilterMask::Make(CHANNEL_NONE, DEFAULT_COLLISION_RESPONSE_CHANNELS_Character).ChannelBit == 0);
+
+	RPG_Assert(GetPairResponse(character, character) == RESPONSE_BLOCK);
+	RPG_Assert(GetPairResponse(character, blocker) == RESPONSE_BLOCK);
+	RPG_Assert(GetPairResponse(blocker, character) == RESPONSE_BLOCK);
+	RPG_Assert(GetPairResponse(blocker, blocker) == RESPONSE_IGNORE);
+	RPG_Assert(GetPairResponse(character, ignoreAll) == RESPONSE_IGNORE);
+
+	// Character overlaps trigger, trigger blocks character
+	FResponseChannels triggerResponses = DEFAULT_COLLISION_RESPONSE_CHANNELS_IgnoreAll;
+	triggerResponses[CHANNEL_CHARACTER] = RESPONSE_BLOCK;
+	const FFilterMask trigger = FFilterMask::Make(CHANNEL_TRIGGER, triggerResponses);
+	RPG_Assert(GetPairResponse(character, trigger) == RESPONSE_OVERLAP);
+	RPG_Assert(GetPairResponse(trigger, character) == RESPONSE_OVERLAP);
+
+	// Filtered inside tree traversal, within one tree and between two trees
+	RpgPhysicsDynamicTree characterTree;
+	RpgPhysicsDynamicTree blockerTree;
+	const int character0 = characterTree.CreateProxy(TestBodyAABB(RpgVector3(0.0f)), character.ChannelBit, character.ResponseMask);
+	const int character1 = characterTree.CreateProxy(TestBodyAABB(RpgVector3(10.0f)), character.ChannelBit, character.ResponseMask);
+	const int ignored = characterTree.CreateProxy(TestBodyAABB(RpgVector3(20.0f)), ignoreAll.ChannelBit, ignoreAll.ResponseMask);
+	const int blocker0 = blockerTree.CreateProxy(TestBodyAABB(RpgVector3(0.0f)), blocker.ChannelBit, blocker.ResponseMask);
+	const int blocker1 = blockerTree.CreateProxy(TestBodyAABB(RpgVector3(10.0f)), blocker.ChannelBit, blocker.ResponseMask);
+	RPG_Assert(ignored != RPG_INDEX_INVALID);
+
+	RpgArray<RpgPhysicsDynamicTree::FProxyPair> pairs;
+	characterTree.GeneratePairs(pairs);
+	RPG_Assert(pairs.GetCount() == 1);
+	RPG_Assert(pairs[0].FirstProxy == RpgMath::Min(character0, character1) && pairs[0].SecondProxy == RpgMath::Max(character0, character1));
+
+	blockerTree.GeneratePairs(pairs);
+	RPG_Assert(pairs.GetCount() == 0);
+
+	characterTree.GeneratePairs(blockerTree, pairs);
+	RPG_Assert(pairs.GetCount() == 4);
+
+	for (int i = 0; i < pairs.GetCount(); ++i)
+	{
+		RPG_Assert(pairs[i].FirstProxy != ignored);
+		RPG_Assert(pairs[i].SecondProxy == blocker0 || pairs[i].SecondProxy == blocker1);
+	}
+
+	int queryCount = 0;
+	characterTree.QueryAABB(TestBodyAABB(RpgVector3(0.0f)), [&queryCount](int) { ++queryCount; return true; }, character.ChannelBit);
+	RPG_Assert(queryCount == 3);
+
+	queryCount = 0;
+	characterTree.QueryAABB(TestBodyAABB(RpgVector3(0.0f)), [&queryCount](int) { ++queryCount; return true; }, blocker.ChannelBit);
+	RPG_Assert(queryCount == 0);
+}
+
+
+void RpgTest::Physics::Test_DynamicTree() noexcept
+{
+	Test_CreateMoveDestroy();
+	Test_GeneratePairs();
+	Test_FilterMask();
+}
+
+
+
+static void Benchmark_DynamicTree(int count) noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	uint32_t state = 4321;
+
+	// Half characters, half blockers
+	const FFilterMask characterMask = FFilterMask::Make(CHANNEL_CHARACTER, DEFAULT_COLLISION_RESPONSE_CHANNELS_Character);
+	const FFilterMask blockerMask = FFilterMask::Make(CHANNEL_BLOCKER, DEFAULT_COLLISION_RESPONSE_CHANNELS_Blocker);
+
+	RpgArray<RpgVector3> positions(count);
+	RpgArray<FFilterMask> filterMasks(count);
+
+	for (int i = 0; i < count; ++i)
+	{
+		positions[i] = TestBodyPosition(state, count);
+		filterMasks[i] = (i % 2 == 0) ? characterMask : blockerMask;
+	}
+
+
+	RpgTimer timer;
+	timer.Start();
+
+	RpgPhysicsDynamicTree tree;
+	RpgArray<int> proxies(count);
+	RpgArray<int> proxyBodies(count * 2);
+
+	for (int i = 0; i < count; ++i)
+	{
+		proxies[i] = tree.CreateProxy(TestBodyAABB(positions[i]), filterMasks[i].ChannelBit, filterMasks[i].ResponseMask);
+		proxyBodies[proxies[i]] = i;
+	}
+
+	const float buildMs = timer.Tick() / 1000.0f;
+
+	// Move 10% of bodies
+	for (int i = 0; i < count; i += 10)
+	{
+		const RpgVector3 displacement(TestRandom(state) * 60.0f - 30.0f, 0.0f, TestRandom(state) * 60.0f - 30.0f);
+		positions[i] += displacement;
+		tree.MoveProxy(proxies[i], TestBodyAABB(positions[i]), displacement);
+	}
+
+	const float moveMs = timer.Tick() / 1000.0f;
+
+	RpgArray<RpgPhysicsDynamicTree::FProxyPair> pairs;
+	tree.GeneratePairs(pairs);
+
+	int treePairsCount = 0;
+
+	for (int i = 0; i < pairs.GetCount(); ++i)
+	{
+		const int first = proxyBodies[pairs[i].FirstProxy];
+		const int second = proxyBodies[pairs[i].SecondProxy];
+
+		RPG_Assert(ShouldPair(filterMasks[first], filterMasks[second]));
+
+		if (TestOverlapAABB(TestBodyAABB(positions[first]), TestBodyAABB(positions[second])))
+		{
+			++treePairsCount;
+		}
+	}
+
+	const float pairsMs = timer.Tick() / 1000.0f;
+
+
+	// Brute force baseline: filter and bounds test of every pair
+	int allPairsCount = 0;
+
+	for (int i = 0; i < count; ++i)
+	{
+		const RpgBoundingAABB first = TestBodyAABB(positions[i]);
+
+		for (int j = i + 1; j < count; ++j)
+		{
+			if (ShouldPair(filterMasks[i], filterMasks[j]) && TestOverlapAABB(first, TestBodyAABB(positions[j])))
+			{
+				++allPairsCount;
+			}
+		}
+	}
+
+	const float allPairsMs = timer.Tick() / 1000.0f;
+
+	RPG_Assert(treePairsCount == allPairsCount);
+
+	RPG_CONSOLE_Log(RpgLogSystem, "  [%i]: brute force: %.3f ms (%i pairs) | tree: build: %.3f ms, move 10%%: %.3f ms, pairs: %.3f ms (%i pairs, %i fat), height: %i, area ratio: %.2f",
+		count, allPairsMs, allPairsCount, buildMs, moveMs, pairsMs, treePairsCount, pairs.GetCount(), tree.GetHeight(), tree.GetAreaRatio()
+	);
+}
+
+
+void RpgTest::Physics::Benchmark_Broadphase() noexcept
+{
+	RPG_CONSOLE_Log(RpgLogSystem, "Benchmark broadphase (dynamic tree vs brute force all pairs):");
+
+	Benchmark_DynamicTree(1000);
+	Benchmark_DynamicTree(10000);
+	Benchmark_DynamicTree(50000);
+}
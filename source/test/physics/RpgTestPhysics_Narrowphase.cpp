@@ -0,0 +1,241 @@
+#include "RpgTestPhysics.h"
+#include "physics/RpgPhysicsTypes.h"
+
+
+
+static RpgPhysicsCollision::FShape TestShapeSphere(const RpgVector3& center, float radius) noexcept
+{
+	RpgPhysicsCollision::FShape shape;
+	shape.Center = center;
+	shape.Size = RpgVector4(radius);
+	shape.Type = RpgPhysicsCollision::SHAPE_SPHERE;
+
+	return shape;
+}
+
+
+static RpgPhysicsCollision::FShape TestShapeBox(const RpgVector3& center, const RpgVector3& halfExtents, const RpgQuaternion& rotation) noexcept
+{
+	RpgPhysicsCollision::FShape shape;
+	shape.Center = center;
+	shape.Rotation = rotation;
+	shape.Size = RpgVector4(halfExtents.X, halfExtents.Y, halfExtents.Z, 0.0f);
+	shape.Type = RpgPhysicsCollision::SHAPE_BOX;
+
+	return shape;
+}
+
+
+static RpgPhysicsCollision::FShape TestShapeCapsule(const RpgVector3& center, float radius, float halfHeight) noexcept
+{
+	RpgPhysicsCollision::FShape shape;
+	shape.Center = center;
+	shape.Size = RpgVector4(radius, halfHeight, 0.0f, 0.0f);
+	shape.Type = RpgPhysicsCollision::SHAPE_CAPSULE;
+
+	return shape;
+}
+
+
+
+static void Test_SeparatingAxis() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	RpgVector3 axis;
+
+	// Sphere - sphere
+	{
+		const FShape first = TestShapeSphere(RpgVector3(0.0f, 0.0f, 0.0f), 1.0f);
+		const FShape second = TestShapeSphere(RpgVector3(3.0f, 0.0f, 0.0f), 1.0f);
+
+		RPG_Assert(Narrowphase::TestSeparatingAxis(first, second, RpgVector3::RIGHT));
+		RPG_Assert(!Narrowphase::TestSeparatingAxis(first, second, RpgVector3::UP));
+		RPG_Assert(Narrowphase::FindSeparatingAxis(first, second, axis));
+		RPG_Assert(Narrowphase::TestSeparatingAxis(first, second, axis));
+	}
+
+	// Rotated box - sphere. Box corner reaches 1.414 along x-axis
+	{
+		const FShape box = TestShapeBox(RpgVector3(0.0f, 0.0f, 0.0f), RpgVector3(1.0f), RpgQuaternion::FromPitchYawRollDegree(0.0f, 45.0f, 0.0f));
+
+		RPG_Assert(Narrowphase::TestSeparatingAxis(box, TestShapeSphere(RpgVector3(2.0f, 0.0f, 0.0f), 0.5f), RpgVector3::RIGHT));
+		RPG_Assert(!Narrowphase::TestSeparatingAxis(box, TestShapeSphere(RpgVector3(1.8f, 0.0f, 0.0f), 0.5f), RpgVector3::RIGHT));
+		RPG_Assert(!Narrowphase::FindSeparatingAxis(box, TestShapeSphere(RpgVector3(1.2f, 0.0f, 0.0f), 0.5f), axis));
+	}
+
+	// Box - box separated only by face axis of rotated box
+	{
+		const FShape first = TestShapeBox(RpgVector3(0.0f, 0.0f, 0.0f), RpgVector3(1.0f), RpgQuaternion::FromPitchYawRollDegree(0.0f, 45.0f, 0.0f));
+		const FShape second = TestShapeBox(RpgVector3(2.2f, 0.0f, 2.2f), RpgVector3(1.0f), RpgQuaternion());
+
+		RPG_Assert(!Narrowphase::TestSeparatingAxis(first, second, RpgVector3::RIGHT));
+		RPG_Assert(!Narrowphase::TestSeparatingAxis(first, second, RpgVector3::FORWARD));
+		RPG_Assert(Narrowphase::FindSeparatingAxis(first, second, axis));
+	}
+
+	// Capsule always along y-axis
+	{
+		const FShape capsule = TestShapeCapsule(RpgVector3(0.0f, 0.0f, 0.0f), 0.5f, 1.0f);
+
+		RPG_Assert(Narrowphase::FindSeparatingAxis(capsule, TestShapeSphere(RpgVector3(0.0f, 2.2f, 0.0f), 0.5f), axis));
+		RPG_Assert(!Narrowphase::FindSeparatingAxis(capsule, TestShapeSphere(RpgVector3(0.0f, 1.9f, 0.0f), 0.5f), axis));
+		RPG_Assert(Narrowphase::FindSeparatingAxis(capsule, TestShapeSphere(RpgVector3(1.1f, 1.0f, 0.0f), 0.5f), axis));
+	}
+}
+
+
+static void Test_OverlapShape() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	const RpgQuaternion rotation = RpgQuaternion::FromPitchYawRollDegree(0.0f, 45.0f, 0.0f);
+	FContactResult contact;
+	RpgVector3 axis;
+
+	// Shapes with separating axis never overlap
+	for (int i = 0; i < 32; ++i)
+	{
+		const float offset = 0.25f * static_cast<float>(i);
+		const FShape box = TestShapeBox(RpgVector3(0.0f, 0.0f, 0.0f), RpgVector3(1.0f), rotation);
+		const FShape shapes[2] =
+		{
+			TestShapeBox(RpgVector3(offset, 0.5f, offset * 0.5f), RpgVector3(0.5f), RpgQuaternion()),
+			TestShapeCapsule(RpgVector3(offset, 0.5f, 0.0f), 0.5f, 1.0f),
+		};
+
+		for (int s = 0; s < 2; ++s)
+		{
+			if (Narrowphase::FindSeparatingAxis(box, shapes[s], axis))
+			{
+				RPG_Assert(!Narrowphase::TestOverlap(box, shapes[s]));
+			}
+		}
+	}
+
+	// Overlapped shapes output contact
+	RPG_Assert(Narrowphase::TestOverlap(TestShapeBox(RpgVector3(0.0f, 0.0f, 0.0f), RpgVector3(1.0f), rotation), TestShapeCapsule(RpgVector3(1.0f, 0.0f, 0.0f), 0.5f, 1.0f), &contact));
+	RPG_Assert(contact.PenetrationDepth > 0.0f);
+
+	// Unsupported shape never overlaps
+	FShape mesh = TestShapeSphere(RpgVector3(0.0f, 0.0f, 0.0f), 1.0f);
+	mesh.Type = SHAPE_MESH_TRIANGLE;
+	RPG_Assert(!Narrowphase::TestOverlap(mesh, TestShapeSphere(RpgVector3(0.0f, 0.0f, 0.0f), 1.0f)));
+}
+
+
+static void Test_SphereSphere() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	FContactResult contact;
+
+	// Overlap uses sum of radius
+	RPG_Assert(Narrowphase::TestOverlap(TestShapeSphere(RpgVector3(0.0f, 0.0f, 0.0f), 1.0f), TestShapeSphere(RpgVector3(2.5f, 0.0f, 0.0f), 2.0f)));
+	RPG_Assert(!Narrowphase::TestOverlap(TestShapeSphere(RpgVector3(0.0f, 0.0f, 0.0f), 1.0f), TestShapeSphere(RpgVector3(3.5f, 0.0f, 0.0f), 2.0f)));
+
+	RPG_Assert(Narrowphase::TestOverlap(TestShapeSphere(RpgVector3(0.0f, 0.0f, 0.0f), 0.5f), TestShapeSphere(RpgVector3(0.9f, 0.0f, 0.0f), 0.5f), &contact));
+	RPG_Assert(RpgMath::Abs(contact.PenetrationDepth - 0.1f) < 0.001f);
+	RPG_Assert(RpgVector3::DotProduct(contact.SeparationDirection, RpgVector3::RIGHT) > 0.999f);
+
+	// Side by side capsules, closest points between segments
+	RPG_Assert(Narrowphase::TestOverlap(TestShapeCapsule(RpgVector3(0.0f, 0.0f, 0.0f), 0.5f, 1.0f), TestShapeCapsule(RpgVector3(0.9f, 1.5f, 0.0f), 0.5f, 1.0f), &contact));
+	RPG_Assert(RpgMath::Abs(contact.PenetrationDepth - 0.1f) < 0.001f);
+	RPG_Assert(!Narrowphase::TestOverlap(TestShapeCapsule(RpgVector3(0.0f, 0.0f, 0.0f), 0.5f, 1.0f), TestShapeCapsule(RpgVector3(0.5f, 3.1f, 0.0f), 0.5f, 1.0f)));
+}
+
+
+static void Test_AnalyticMatchGJK() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	constexpr EShape TYPES[3] = { SHAPE_SPHERE, SHAPE_BOX, SHAPE_CAPSULE };
+	uint32_t state = 2468;
+
+	for (int a = 0; a < 3; ++a)
+	{
+		for (int b = 0; b < 3; ++b)
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				const FShape first = TestRandomShape(state, TYPES[a]);
+				const FShape second = TestRandomShape(state, TYPES[b]);
+
+				FContactResult contact;
+				const bool bOverlapped = Narrowphase::TestOverlap(first, second, &contact);
+
+				// Skip grazing contacts, GJK has distance tolerance
+				if (bOverlapped && contact.PenetrationDepth < 0.01f)
+				{
+					continue;
+				}
+
+				RPG_Assert(bOverlapped == Narrowphase::TestOverlapGJK(first, second));
+				RPG_Assert(bOverlapped == Narrowphase::TestOverlap(first, second));
+
+				if (bOverlapped)
+				{
+					RPG_Assert(contact.PenetrationDepth > 0.0f);
+
+					// Moving second shape along separation direction resolves the overlap
+					FShape resolved = second;
+					resolved.Center += contact.SeparationDirection * (contact.PenetrationDepth + 0.01f);
+					RPG_Assert(!Narrowphase::TestOverlap(first, resolved));
+				}
+			}
+		}
+	}
+}
+
+
+static void Test_Batch4() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	uint32_t state = 1357;
+
+	for (int i = 0; i < 64; ++i)
+	{
+		FShape spheres[4];
+		FShape otherSpheres[4];
+		FShape capsules[4];
+		FShape otherCapsules[4];
+		const FShape* sphereRefs[4];
+		const FShape* otherSphereRefs[4];
+		const FShape* capsuleRefs[4];
+		const FShape* otherCapsuleRefs[4];
+
+		for (int l = 0; l < 4; ++l)
+		{
+			spheres[l] = TestRandomShape(state, SHAPE_SPHERE);
+			otherSpheres[l] = TestRandomShape(state, SHAPE_SPHERE);
+			capsules[l] = TestRandomShape(state, SHAPE_CAPSULE);
+			otherCapsules[l] = TestRandomShape(state, SHAPE_CAPSULE);
+			sphereRefs[l] = &spheres[l];
+			otherSphereRefs[l] = &otherSpheres[l];
+			capsuleRefs[l] = &capsules[l];
+			otherCapsuleRefs[l] = &otherCapsules[l];
+		}
+
+		const int sphereSphere = Narrowphase::TestOverlapBatch4_SphereSphere(sphereRefs, otherSphereRefs);
+		const int sphereCapsule = Narrowphase::TestOverlapBatch4_SphereCapsule(sphereRefs, capsuleRefs);
+		const int capsuleCapsule = Narrowphase::TestOverlapBatch4_CapsuleCapsule(capsuleRefs, otherCapsuleRefs);
+
+		for (int l = 0; l < 4; ++l)
+		{
+			RPG_Assert(((sphereSphere >> l) & 1) == (Narrowphase::TestOverlap(spheres[l], otherSpheres[l]) ? 1 : 0));
+			RPG_Assert(((sphereCapsule >> l) & 1) == (Narrowphase::TestOverlap(spheres[l], capsules[l]) ? 1 : 0));
+			RPG_Assert(((capsuleCapsule >> l) & 1) == (Narrowphase::TestOverlap(capsules[l], otherCapsules[l]) ? 1 : 0));
+		}
+	}
+}
+
+
+void RpgTest::Physics::Test_Narrowphase() noexcept
+{
+	Test_SeparatingAxis();
+	Test_OverlapShape();
+	Test_SphereSphere();
+	Test_AnalyticMatchGJK();
+	Test_Batch4();
+}
@@ -0,0 +1,545 @@
+#include "RpgTestPhysics.h"
+#include "physics/RpgPhysicsDynamicTree.h"
+#include "physics/RpgPhysicsTypes.h"
+#include "core/RpgConsoleSystem.h"
+#include "core/RpgThreadPool.h"
+#include "core/RpgTimer.h"
+
+
+
+// Radius of sphere that encloses shape
+static float TestShapeBoundRadius(const RpgPhysicsCollision::FShape& shape) noexcept
+{
+	switch (shape.Type)
+	{
+		case RpgPhysicsCollision::SHAPE_SPHERE:
+			return shape.Size.X;
+
+		case RpgPhysicsCollision::SHAPE_BOX:
+			return RpgVector3(shape.Size.X, shape.Size.Y, shape.Size.Z).GetMagnitude();
+
+		case RpgPhysicsCollision::SHAPE_CAPSULE:
+			return shape.Size.X + shape.Size.Y;
+
+		default:
+			break;
+	}
+
+	return 0.0f;
+}
+
+
+// Moving shape at location. Line is tested as point (sphere with zero radius)
+static RpgPhysicsCollision::FShape TestShapeAt(const RpgPhysicsCollision::FShape& shape, const RpgVector3& location) noexcept
+{
+	RpgPhysicsCollision::FShape moved = shape;
+	moved.Center = location;
+
+	if (shape.Type == RpgPhysicsCollision::SHAPE_NONE)
+	{
+		moved.Type = RpgPhysicsCollision::SHAPE_SPHERE;
+		moved.Size = RpgVector4(0.0f);
+	}
+
+	return moved;
+}
+
+
+static float TestPenetrationDepth(const RpgPhysicsCollision::FShape& first, const RpgPhysicsCollision::FShape& second) noexcept
+{
+	RpgPhysicsCollision::FContactResult contact;
+
+	return RpgPhysicsCollision::Narrowphase::TestOverlap(first, second, &contact) ? contact.PenetrationDepth : -1.0f;
+}
+
+
+
+// Sweep result must agree with narrowphase overlap: no overlap just before hit, overlap when pushed into contact normal at hit, no overlap along path that missed
+static void Test_SweepMatchOverlap() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	constexpr EShape MOVING_TYPES[4] = { SHAPE_NONE, SHAPE_SPHERE, SHAPE_BOX, SHAPE_CAPSULE };
+	constexpr EShape TARGET_TYPES[3] = { SHAPE_SPHERE, SHAPE_BOX, SHAPE_CAPSULE };
+
+	uint32_t state = 2024;
+
+	for (int m = 0; m < 4; ++m)
+	{
+		for (int t = 0; t < 3; ++t)
+		{
+			int hitCount = 0;
+
+			for (int i = 0; i < 200; ++i)
+			{
+				const FShape shape = TestRandomShape(state, MOVING_TYPES[m], RpgVector3::ZERO);
+				const FShape target = TestRandomShape(state, TARGET_TYPES[t], TestRandomVector(state, 1.0f));
+				const RpgVector3 start = TestRandomVector(state, 6.0f);
+				const RpgVector3 end = target.Center + TestRandomVector(state, 2.0f);
+				const RpgVector3 direction = (end - start).GetNormalize();
+				const float length = (end - start).GetMagnitude();
+
+				RpgPhysicsTrace::FResult result;
+
+				if (!RpgPhysicsTrace::TestSweep(shape, start, end, target, result))
+				{
+					for (int s = 0; s <= 64; ++s)
+					{
+						RPG_Assert(TestPenetrationDepth(TestShapeAt(shape, start + (end - start) * (s / 64.0f)), target) < 0.01f);
+					}
+
+					continue;
+				}
+
+				++hitCount;
+
+				RPG_Assert(result.Distance >= 0.0f && result.Distance <= length + RPG_MATH_EPS_LP);
+				RPG_Assert(RpgMath::Abs(result.ContactNormal.GetMagnitude() - 1.0f) < 0.01f);
+
+				if (result.Distance == 0.0f)
+				{
+					RPG_Assert(TestPenetrationDepth(TestShapeAt(shape, start), target) >= 0.0f);
+					continue;
+				}
+
+				RPG_Assert((result.HitLocation - (start + direction * result.Distance)).GetMagnitude() < 0.01f);
+				RPG_Assert(RpgVector3::DotProduct(result.ContactNormal, direction) <= RPG_MATH_EPS_LP);
+
+				if (result.Distance > 0.02f)
+				{
+					RPG_Assert(TestPenetrationDepth(TestShapeAt(shape, start + direction * (result.Distance - 0.02f)), target) < 0.005f);
+				}
+
+				RPG_Assert(TestPenetrationDepth(TestShapeAt(shape, result.HitLocation - result.ContactNormal * 0.02f), target) >= 0.0f);
+
+				// Contact lies on target surface
+				RPG_Assert(TestPenetrationDepth(TestShapeAt(FShape(), result.ContactLocation + result.ContactNormal * 0.02f), target) < 0.0f);
+				RPG_Assert(TestPenetrationDepth(TestShapeAt(FShape(), result.ContactLocation - result.ContactNormal * 0.02f), target) >= 0.0f);
+			}
+
+			RPG_Assert(hitCount > 0);
+		}
+	}
+}
+
+
+
+// Objects scattered in (extent * 2) x 10 x (extent * 2) area. Every third object only overlaps, channel TRIGGER is ignored by all objects
+struct FTestTraceScene
+{
+	RpgPhysicsDynamicTree Trees[2];
+	RpgArray<RpgPhysicsTrace::FSceneObject> TreeObjects[2];
+	RpgPhysicsTrace::FScene Scene;
+};
+
+
+static void TestBuildScene(FTestTraceScene& out_Scene, int count, float extent, uint32_t& state) noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	constexpr EShape TYPES[3] = { SHAPE_SPHERE, SHAPE_BOX, SHAPE_CAPSULE };
+	const FChannelMask allMask = static_cast<FChannelMask>(~GetChannelBit(CHANNEL_TRIGGER));
+
+	for (int i = 0; i < count; ++i)
+	{
+		const RpgVector3 center((TestRandom(state) * 2.0f - 1.0f) * extent, TestRandom(state) * 10.0f - 5.0f, (TestRandom(state) * 2.0f - 1.0f) * extent);
+
+		RpgPhysicsTrace::FSceneObject object;
+		object.Shape = TestRandomShape(state, TYPES[i % 3], center);
+		object.FilterMask.ChannelBit = GetChannelBit(CHANNEL_BLOCKER);
+		object.FilterMask.BlockMask = (i % 3 == 0) ? 0 : allMask;
+		object.FilterMask.ResponseMask = allMask;
+
+		// Objects are split into two trees, scene remaps both into one object array
+		const int treeIndex = i % 2;
+		const RpgVector3 radius(TestShapeBoundRadius(object.Shape));
+		const int proxyId = out_Scene.Trees[treeIndex].CreateProxy(RpgBoundingAABB(center - radius, center + radius), object.FilterMask.ChannelBit, object.FilterMask.ResponseMask);
+
+		if (proxyId >= out_Scene.TreeObjects[treeIndex].GetCount())
+		{
+			out_Scene.TreeObjects[treeIndex].Resize(proxyId + 1);
+		}
+
+		out_Scene.TreeObjects[treeIndex][proxyId] = object;
+	}
+
+	out_Scene.Scene.Clear();
+	out_Scene.Scene.AddTree(out_Scene.Trees[0], out_Scene.TreeObjects[0].GetData());
+	out_Scene.Scene.AddTree(out_Scene.Trees[1], out_Scene.TreeObjects[1].GetData());
+
+	RPG_Assert(out_Scene.Scene.Objects.GetCount() == count);
+}
+
+
+static RpgPhysicsTrace::FOption TestCharacterOption() noexcept
+{
+	RpgPhysicsTrace::FOption option;
+	option.Channel = RpgPhysicsCollision::CHANNEL_CHARACTER;
+
+	return option;
+}
+
+
+static RpgPhysicsTrace::FLine TestRandomLine(uint32_t& state, float extent) noexcept
+{
+	RpgPhysicsTrace::FLine line;
+	line.Start = RpgVector3((TestRandom(state) * 2.0f - 1.0f) * extent, TestRandom(state) * 12.0f - 6.0f, (TestRandom(state) * 2.0f - 1.0f) * extent);
+	line.End = line.Start + TestRandomVector(state, 20.0f);
+
+	return line;
+}
+
+
+static bool TestIsBlocking(const RpgPhysicsTrace::FSceneObject& object) noexcept
+{
+	return object.FilterMask.BlockMask != 0;
+}
+
+
+// Nearest blocking hit by testing every object
+static RpgPhysicsTrace::FResult TestSweepBruteForce(const RpgPhysicsTrace::FScene& scene, const RpgPhysicsCollision::FShape& shape, const RpgVector3& start, const RpgVector3& end) noexcept
+{
+	RpgPhysicsTrace::FResult nearest;
+
+	for (int i = 0; i < scene.Objects.GetCount(); ++i)
+	{
+		RpgPhysicsTrace::FResult result;
+
+		if (TestIsBlocking(scene.Objects[i]) && RpgPhysicsTrace::TestSweep(shape, start, end, scene.Objects[i].Shape, result) && (!nearest.IsHit() || result.Distance < nearest.Distance))
+		{
+			nearest = result;
+			nearest.ObjectIndex = i;
+		}
+	}
+
+	return nearest;
+}
+
+
+static void Test_LineScene() noexcept
+{
+	uint32_t state = 777;
+
+	FTestTraceScene test;
+	TestBuildScene(test, 600, 20.0f, state);
+
+	const RpgPhysicsTrace::FScene& scene = test.Scene;
+	const RpgPhysicsTrace::FOption option = TestCharacterOption();
+
+	constexpr int LINE_COUNT = 403;
+	RpgArray<RpgPhysicsTrace::FLine> lines(LINE_COUNT);
+	RpgArray<RpgPhysicsTrace::FResult> batchResults(LINE_COUNT);
+
+	for (int i = 0; i < LINE_COUNT; ++i)
+	{
+		lines[i] = TestRandomLine(state, 25.0f);
+	}
+
+	RpgPhysicsTrace::LineBatch(scene, lines.GetData(), LINE_COUNT, option, batchResults.GetData());
+
+	int hitCount = 0;
+
+	for (int i = 0; i < LINE_COUNT; ++i)
+	{
+		const RpgPhysicsTrace::FLine& line = lines[i];
+		const RpgPhysicsTrace::FResult one = RpgPhysicsTrace::LineOne(scene, line.Start, line.End, option);
+		const RpgPhysicsTrace::FResult expected = TestSweepBruteForce(scene, RpgPhysicsCollision::FShape(), line.Start, line.End);
+
+		RPG_Assert(one.IsHit() == expected.IsHit());
+		RPG_Assert(batchResults[i].IsHit() == one.IsHit());
+
+		if (!one.IsHit())
+		{
+			continue;
+		}
+
+		++hitCount;
+
+		RPG_Assert(one.bBlockingHit);
+		RPG_Assert(RpgMath::Abs(one.Distance - expected.Distance) < RPG_MATH_EPS_LP);
+		RPG_Assert(batchResults[i].ObjectIndex == one.ObjectIndex && batchResults[i].Distance == one.Distance);
+
+		// Many: overlaps sorted by distance, followed by the same blocking hit
+		const RpgPhysicsTrace::FResultArray many = RpgPhysicsTrace::LineMany(scene, line.Start, line.End, option);
+		RPG_Assert(many.GetCount() > 0);
+
+		const RpgPhysicsTrace::FResult& last = many[many.GetCount() - 1];
+		RPG_Assert(last.bBlockingHit && RpgMath::Abs(last.Distance - one.Distance) < RPG_MATH_EPS_LP);
+
+		for (int h = 0; h < many.GetCount() - 1; ++h)
+		{
+			RPG_Assert(!many[h].bBlockingHit);
+			RPG_Assert(many[h].Distance <= many[h + 1].Distance);
+		}
+	}
+
+	RPG_Assert(hitCount > 0);
+
+
+	// Everything blocks CHANNEL_NONE
+	const RpgPhysicsTrace::FOption noneOption;
+
+	for (int i = 0; i < LINE_COUNT; ++i)
+	{
+		const RpgPhysicsTrace::FResultArray many = RpgPhysicsTrace::LineMany(scene, lines[i].Start, lines[i].End, noneOption);
+		RPG_Assert(many.GetCount() <= 1);
+		RPG_Assert(many.GetCount() == 0 || many[0].bBlockingHit);
+	}
+
+
+	// No object responds to trigger channel
+	RpgPhysicsTrace::FOption triggerOption;
+	triggerOption.Channel = RpgPhysicsCollision::CHANNEL_TRIGGER;
+
+	for (int i = 0; i < LINE_COUNT; ++i)
+	{
+		RPG_Assert(!RpgPhysicsTrace::LineOne(scene, lines[i].Start, lines[i].End, triggerOption).IsHit());
+		RPG_Assert(RpgPhysicsTrace::LineMany(scene, lines[i].Start, lines[i].End, triggerOption).GetCount() == 0);
+	}
+
+	RpgPhysicsTrace::LineBatch(scene, lines.GetData(), LINE_COUNT, triggerOption, batchResults.GetData());
+
+	for (int i = 0; i < LINE_COUNT; ++i)
+	{
+		RPG_Assert(!batchResults[i].IsHit());
+	}
+}
+
+
+static void Test_SweepScene() noexcept
+{
+	using namespace RpgPhysicsCollision;
+
+	constexpr EShape TYPES[3] = { SHAPE_SPHERE, SHAPE_BOX, SHAPE_CAPSULE };
+
+	uint32_t state = 4242;
+
+	FTestTraceScene test;
+	TestBuildScene(test, 300, 20.0f, state);
+
+	const RpgPhysicsTrace::FScene& scene = test.Scene;
+	const RpgPhysicsTrace::FOption option = TestCharacterOption();
+
+	for (int i = 0; i < 150; ++i)
+	{
+		const FShape shape = TestRandomShape(state, TYPES[i % 3], RpgVector3::ZERO);
+		const RpgPhysicsTrace::FLine line = TestRandomLine(state, 25.0f);
+
+		const RpgPhysicsTrace::FResult one = RpgPhysicsTrace::SweepOne(scene, shape, line.Start, line.End, option);
+		const RpgPhysicsTrace::FResult expected = TestSweepBruteForce(scene, shape, line.Start, line.End);
+
+		RPG_Assert(one.IsHit() == expected.IsHit());
+
+		if (one.IsHit())
+		{
+			RPG_Assert(RpgMath::Abs(one.Distance - expected.Distance) < RPG_MATH_EPS_LP);
+
+			const RpgPhysicsTrace::FResultArray many = RpgPhysicsTrace::SweepMany(scene, shape, line.Start, line.End, option);
+			RPG_Assert(many.GetCount() > 0 && many[many.GetCount() - 1].ObjectIndex == one.ObjectIndex);
+		}
+	}
+}
+
+
+static void Test_SphereScene() noexcept
+{
+	uint32_t state = 99;
+
+	FTestTraceScene test;
+	TestBuildScene(test, 600, 20.0f, state);
+
+	const RpgPhysicsTrace::FScene& scene = test.Scene;
+	const RpgPhysicsTrace::FOption option = TestCharacterOption();
+
+	for (int i = 0; i < 200; ++i)
+	{
+		const RpgVector3 center = TestRandomLine(state, 25.0f).Start;
+		const float radius = 0.5f + TestRandom(state) * 2.0f;
+
+		RpgPhysicsCollision::FShape sphere;
+		sphere.Center = center;
+		sphere.Size = RpgVector4(radius);
+		sphere.Type = RpgPhysicsCollision::SHAPE_SPHERE;
+
+		int expectedCount = 0;
+		float expectedDepth = -1.0f;
+
+		for (int o = 0; o < scene.Objects.GetCount(); ++o)
+		{
+			const float depth = TestPenetrationDepth(sphere, scene.Objects[o].Shape);
+
+			if (depth >= 0.0f)
+			{
+				++expectedCount;
+
+				if (TestIsBlocking(scene.Objects[o]))
+				{
+					expectedDepth = RpgMath::Max(expectedDepth, depth);
+				}
+			}
+		}
+
+		const RpgPhysicsTrace::FResultArray many = RpgPhysicsTrace::SphereMany(scene, center, radius, option);
+		RPG_Assert(many.GetCount() == RpgMath::Min(expectedCount, RPG_PHYSICS_TRACE_MAX_HIT_RESULT));
+
+		for (int h = 0; h < many.GetCount() - 1; ++h)
+		{
+			RPG_Assert(many[h].Distance >= many[h + 1].Distance);
+		}
+
+		const RpgPhysicsTrace::FResult one = RpgPhysicsTrace::SphereOne(scene, center, radius, option);
+		RPG_Assert(one.IsHit() == (expectedDepth >= 0.0f));
+		RPG_Assert(!one.IsHit() || (one.bBlockingHit && one.Distance == expectedDepth));
+	}
+}
+
+
+
+// Trace lines with LineBatch on worker thread
+class FTestLineBatchTask : public RpgThreadTask
+{
+public:
+	const RpgPhysicsTrace::FScene* Scene{ nullptr };
+	const RpgPhysicsTrace::FLine* Lines{ nullptr };
+	int LineCount{ 0 };
+	RpgPhysicsTrace::FOption Option;
+	RpgArray<RpgPhysicsTrace::FResult> Results;
+
+public:
+	virtual void Execute() noexcept override
+	{
+		Results.Resize(LineCount);
+		RpgPhysicsTrace::LineBatch(*Scene, Lines, LineCount, Option, Results.GetData());
+	}
+
+	virtual const char* GetTaskName() const noexcept override
+	{
+		return "RpgTest_LineBatch";
+	}
+};
+
+
+// Several tasks trace the same scene concurrently, results must match single threaded trace
+static void Test_LineBatchConcurrent() noexcept
+{
+	uint32_t state = 2024;
+
+	FTestTraceScene test;
+	TestBuildScene(test, 2000, 40.0f, state);
+
+	const RpgPhysicsTrace::FOption option = TestCharacterOption();
+
+	constexpr int LINE_COUNT = 1024;
+	RpgArray<RpgPhysicsTrace::FLine> lines(LINE_COUNT);
+	RpgArray<RpgPhysicsTrace::FResult> expected(LINE_COUNT);
+
+	for (int i = 0; i < LINE_COUNT; ++i)
+	{
+		lines[i] = TestRandomLine(state, 45.0f);
+	}
+
+	RpgPhysicsTrace::LineBatch(test.Scene, lines.GetData(), LINE_COUNT, option, expected.GetData());
+
+	constexpr int TASK_COUNT = 8;
+	FTestLineBatchTask tasks[TASK_COUNT];
+	RpgThreadTask* submitTasks[TASK_COUNT];
+
+	for (int t = 0; t < TASK_COUNT; ++t)
+	{
+		tasks[t].Scene = &test.Scene;
+		tasks[t].Lines = lines.GetData();
+		tasks[t].LineCount = LINE_COUNT;
+		tasks[t].Option = option;
+		submitTasks[t] = &tasks[t];
+	}
+
+	RpgThreadPool::SubmitTasks(submitTasks, TASK_COUNT);
+
+	int hitCount = 0;
+
+	for (int t = 0; t < TASK_COUNT; ++t)
+	{
+		tasks[t].Wait();
+
+		for (int i = 0; i < LINE_COUNT; ++i)
+		{
+			const RpgPhysicsTrace::FResult& result = tasks[t].Results[i];
+			RPG_Assert(result.ObjectIndex == expected[i].ObjectIndex);
+
+			if (result.IsHit())
+			{
+				RPG_Assert(result.Distance == expected[i].Distance && result.bBlockingHit == expected[i].bBlockingHit);
+				RPG_Assert(result.ContactLocation.X == expected[i].ContactLocation.X && result.ContactLocation.Y == expected[i].ContactLocation.Y && result.ContactLocation.Z == expected[i].ContactLocation.Z);
+				++hitCount;
+			}
+		}
+	}
+
+	RPG_Assert(hitCount > 0);
+}
+
+
+
+void RpgTest::Physics::Test_Trace() noexcept
+{
+	Test_SweepMatchOverlap();
+	Test_LineScene();
+	Test_SweepScene();
+	Test_SphereScene();
+	Test_LineBatchConcurrent();
+}
+
+
+static void Benchmark_LineTrace(const char* name, const RpgPhysicsTrace::FScene& scene, const RpgArray<RpgPhysicsTrace::FLine>& lines) noexcept
+{
+	const RpgPhysicsTrace::FOption option;
+	RpgArray<RpgPhysicsTrace::FResult> results(lines.GetCount());
+
+	RpgTimer timer;
+	timer.Start();
+
+	for (int i = 0; i < lines.GetCount(); ++i)
+	{
+		results[i] = RpgPhysicsTrace::LineOne(scene, lines[i].Start, lines[i].End, option);
+	}
+
+	const float oneMs = timer.Tick() / 1000.0f;
+
+	RpgPhysicsTrace::LineBatch(scene, lines.GetData(), lines.GetCount(), option, results.GetData());
+
+	const float batchMs = timer.Tick() / 1000.0f;
+
+	RPG_CONSOLE_Log(RpgLogSystem, "  %s (%i lines): line one: %.3f ms | line batch: %.3f ms", name, lines.GetCount(), oneMs, batchMs);
+}
+
+
+void RpgTest::Physics::Benchmark_Trace() noexcept
+{
+	uint32_t state = 31337;
+
+	FTestTraceScene test;
+	TestBuildScene(test, 10000, 200.0f, state);
+
+	RPG_CONSOLE_Log(RpgLogSystem, "Benchmark trace (%i objects):", test.Scene.Objects.GetCount());
+
+	constexpr int LINE_COUNT = 10000;
+	RpgArray<RpgPhysicsTrace::FLine> lines(LINE_COUNT);
+
+	// Incoherent line of sight
+	for (int i = 0; i < LINE_COUNT; ++i)
+	{
+		lines[i] = TestRandomLine(state, 200.0f);
+	}
+
+	Benchmark_LineTrace("random", test.Scene, lines);
+
+	// Coherent ground probes, neighbor lines share packet
+	for (int i = 0; i < LINE_COUNT; ++i)
+	{
+		const RpgVector3 start(-200.0f + (i % 100) * 4.0f, 10.0f, -200.0f + (i / 100) * 4.0f);
+		lines[i].Start = start;
+		lines[i].End = start + RpgVector3::DOWN * 20.0f;
+	}
+
+	Benchmark_LineTrace("ground probe", test.Scene, lines);
+}